@@ -36,6 +36,7 @@ set(SDKLIB_HEADERS
     include/mega/autocomplete.h
     include/mega/serialize64.h
     include/mega/nodemanager.h
+    include/mega/nodetreesnapshot.h
     include/mega/setandelement.h
     include/mega/testhooks.h
     include/mega/share.h
@@ -58,13 +59,18 @@ set(SDKLIB_HEADERS
     include/mega/sync.h
     include/mega/syncfilter.h
     include/mega/syncinternals/mac_computation_state.h
+    include/mega/syncinternals/scannedfingerprints.h
+    include/mega/syncinternals/sortedchildindex.h
+    include/mega/syncinternals/statecachejournal.h
     include/mega/syncinternals/syncinternals_logging.h
     include/mega/syncinternals/syncinternals.h
     include/mega/syncinternals/synciuploadthrottlingmanager.h
+    include/mega/syncinternals/syncnamearena.h
     include/mega/syncinternals/syncuploadthrottlingfile.h
     include/mega/syncinternals/syncuploadthrottlingmanager.h
     include/mega/heartbeats.h
     include/mega/utils.h
+    include/mega/handlemultiindex.h
     include/mega/hashcash.h
     include/mega/utils_optional.h
     include/mega/account.h
@@ -75,10 +81,12 @@ set(SDKLIB_HEADERS
     include/mega/arguments.h
     include/mega/attrmap.h
     include/mega/sharenodekeys.h
+    include/mega/stringpool.h
     include/mega/request.h
     include/mega/fileattributefetch.h
     include/mega/version.h
     include/mega/node.h
+    include/mega/nodehandlemap.h
     include/mega/mediafileattribute.h
     include/mega/process.h
     include/mega/name_collision.h
@@ -145,12 +153,15 @@ set(SDKLIB_SOURCES
     src/request.cpp
     src/serialize64.cpp
     src/nodemanager.cpp
+    src/nodetreesnapshot.cpp
     src/setandelement.cpp
     src/share.cpp
     src/sharenodekeys.cpp
+    src/stringpool.cpp
     src/sync.cpp
     src/syncfilter.cpp
     src/syncinternals/syncinternals.cpp
+    src/syncinternals/syncnamearena.cpp
     src/syncinternals/syncuploadthrottlingfile.cpp
     src/syncinternals/syncuploadthrottlingmanager.cpp
     src/heartbeats.cpp
@@ -50,6 +50,7 @@
 #include "mega/megaapp.h"
 #include "mega/megaclient.h"
 #include "mega/node.h"
+#include "mega/nodetreesnapshot.h"
 #include "mega/pendingcontactrequest.h"
 #include "mega/proxy.h"
 #include "mega/pubkeyaction.h"
@@ -58,6 +59,7 @@
 #include "mega/serialize64.h"
 #include "mega/share.h"
 #include "mega/sharenodekeys.h"
+#include "mega/stringpool.h"
 #include "mega/sync.h"
 #include "mega/transfer.h"
 #include "mega/transferslot.h"
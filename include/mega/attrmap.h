@@ -26,29 +26,157 @@
 #include "utils.h"
 
 #include <optional>
+#include <stdexcept>
 #include <string_view>
+#include <tuple>
 
 namespace mega {
 
 // maps attribute names to attribute values
-struct attr_map : map<nameid, string>
+// Nodes have a handful of attributes, so they are kept sorted by name in a single vector instead of
+// a tree with an allocation per entry. The interface follows std::map, but insertions and removals
+// invalidate iterators and references.
+class attr_map
 {
+public:
+    using key_type = nameid;
+    using mapped_type = string;
+    using value_type = std::pair<nameid, string>;
+    using iterator = vector<value_type>::iterator;
+    using const_iterator = vector<value_type>::const_iterator;
+    using size_type = vector<value_type>::size_type;
+
     attr_map() {}
 
     attr_map(nameid key, string value)
     {
-        (*this)[key] = std::move(value);
+        mEntries.emplace_back(key, std::move(value));
     }
 
     attr_map(map<nameid, string>&& m)
     {
-        m.swap(*this);
+        mEntries.reserve(m.size());
+        for (auto& [key, value]: m)
+        {
+            mEntries.emplace_back(key, std::move(value));
+        }
+    }
+
+    iterator begin() { return mEntries.begin(); }
+    iterator end() { return mEntries.end(); }
+    const_iterator begin() const { return mEntries.begin(); }
+    const_iterator end() const { return mEntries.end(); }
+
+    size_type size() const { return mEntries.size(); }
+    bool empty() const { return mEntries.empty(); }
+    void clear() { mEntries.clear(); }
+    void reserve(size_type n) { mEntries.reserve(n); }
+
+    iterator find(nameid k)
+    {
+        auto it = lowerBound(k);
+        return it != mEntries.end() && it->first == k ? it : mEntries.end();
+    }
+
+    const_iterator find(nameid k) const
+    {
+        return const_cast<attr_map*>(this)->find(k);
     }
 
     bool contains(nameid k) const
     {
-        return this->find(k) != this->end();
+        return find(k) != end();
+    }
+
+    size_type count(nameid k) const
+    {
+        return contains(k) ? 1 : 0;
     }
+
+    string& operator[](nameid k)
+    {
+        return emplace(k).first->second;
+    }
+
+    string& at(nameid k)
+    {
+        auto it = find(k);
+        if (it == end())
+        {
+            throw std::out_of_range("attr_map::at");
+        }
+        return it->second;
+    }
+
+    const string& at(nameid k) const
+    {
+        return const_cast<attr_map*>(this)->at(k);
+    }
+
+    // the value is only constructed if the key is not present yet
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(nameid k, Args&&... args)
+    {
+        auto it = lowerBound(k);
+        if (it != mEntries.end() && it->first == k)
+        {
+            return {it, false};
+        }
+        return {mEntries.emplace(it, std::piecewise_construct,
+                                 std::forward_as_tuple(k),
+                                 std::forward_as_tuple(std::forward<Args>(args)...)),
+                true};
+    }
+
+    std::pair<iterator, bool> insert(value_type v)
+    {
+        return emplace(v.first, std::move(v.second));
+    }
+
+    iterator erase(const_iterator it)
+    {
+        return mEntries.erase(it);
+    }
+
+    size_type erase(nameid k)
+    {
+        auto it = find(k);
+        if (it == end())
+        {
+            return 0;
+        }
+        mEntries.erase(it);
+        return 1;
+    }
+
+    void swap(attr_map& other)
+    {
+        mEntries.swap(other.mEntries);
+    }
+
+    bool operator==(const attr_map& other) const
+    {
+        return mEntries == other.mEntries;
+    }
+
+    bool operator!=(const attr_map& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    iterator lowerBound(nameid k)
+    {
+        // linear search: faster than a binary one for a few entries
+        auto it = mEntries.begin();
+        while (it != mEntries.end() && it->first < k)
+        {
+            ++it;
+        }
+        return it;
+    }
+
+    vector<value_type> mEntries;
 };
 
 struct MEGA_API AttrMap
@@ -39,6 +39,11 @@ public:
     static string atob(const string&);
     static int atob(const char*, byte*, int);   // deprecated
 
+    // decode up to blen bytes from a base64 string delimited by any non-base64 character (for
+    // instance, the closing quote of a JSON value). If `end` is provided, it receives the position
+    // where decoding stopped
+    static int atob(const char* a, byte* b, int blen, const char** end);
+
     static void itoa(int64_t, string *);
     static int64_t atoi(string *);
 
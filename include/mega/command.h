@@ -524,6 +524,9 @@ protected:
     handle mPreviousHandleForAlert = UNDEF;
     NodeManager::MissingParentNodes mMissingParentNodes;
 
+    // nodes parsed but not added yet, to decrypt them in parallel (see MegaClient::addReadNodes())
+    std::vector<ReadNode> mReadNodes;
+
     // Field to temporarily save the received scsn
     handle mScsn;
     // sequence-tag, saved temporary while processing the response (it's received before nodes)
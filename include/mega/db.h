@@ -32,6 +32,7 @@
 namespace mega {
 // generic host transactional database access interface
 class DBTableTransactionCommitter;
+struct NodeTreeEntry;
 
 // Class to load serialized node from data base
 class NodeSerialized
@@ -80,6 +81,9 @@ class MEGA_API DbTable
 {
     PrnGen &rng;
 
+    // gives 'record' its dbid, if it has none yet
+    void assignDbid(uint32_t type, Cacheable* record);
+
 protected:
     bool mCheckAlwaysTransacted = false;
     DBTableTransactionCommitter* mTransactionCommitter = nullptr;
@@ -106,6 +110,14 @@ public:
     bool put(uint32_t, string*);
     bool put(uint32_t, Cacheable *, SymmCipher*);
 
+    // add or update several records with padding and encryption, as put() does for each one.
+    // They are serialized in order (so a record may refer to the dbid given to a previous one),
+    // then encrypted on up to 'threads' threads and written.  Returns the number written.
+    size_t putRecords(uint32_t type,
+                      const std::vector<Cacheable*>& records,
+                      SymmCipher* key,
+                      unsigned threads);
+
     // delete specific record
     virtual bool del(uint32_t) = 0;
 
@@ -140,6 +152,23 @@ struct NodeSearchLexicographicalOffset;
 struct NodeSearchCursorOffset;
 struct ListAllNodesParams;
 
+// Groups of secondary indexes of the 'nodes' table (see DBTableNodes::createIndexes)
+enum class NodesIndex
+{
+    PARENT, // children of a node, by type and name
+    FINGERPRINT, // nodes by fingerprint, with and without mtime
+    SEARCH, // shares, recents, listAllNodesByPage and searchNodes() by category
+    LEXICOGRAPHIC, // children of a node in lexicographical order
+    // full-text index of names, descriptions and tags for searchNodes(). It's optional (and may
+    // be unsupported by SQLite), so unlike the others it's ready only when it has been created
+    FULL_TEXT,
+    // every ancestor of each node (closure table), for isAncestor() and listAllNodesByPage().
+    // Optional too: ready only when it has been created
+    ANCESTORS,
+};
+
+class DBTableNodesReader;
+
 class MEGA_API DBTableNodes
 {
 public:
@@ -147,6 +176,9 @@ public:
     // add or update a node
     virtual bool put(Node* node) = 0;
 
+    // add or update several nodes, with fewer statements than calling put() for each one
+    virtual bool putBatch(const std::vector<Node*>& nodes) = 0;
+
     // remove one node from 'nodes' table
     virtual bool remove(NodeHandle nodehandle) = 0;
 
@@ -219,6 +251,9 @@ public:
     // count of items in 'nodes' table. Returns 0 if error
     virtual uint64_t getNumberOfNodes() = 0;
 
+    // handle, parent, type, share flags and name of every node (for NodeTreeSnapshot)
+    virtual bool getNodeTreeEntries(std::vector<NodeTreeEntry>& entries) = 0;
+
     // count of children nodes of by type
     virtual uint64_t getNumberOfChildrenByType(NodeHandle parentHandle, nodetype_t nodeType) = 0;
 
@@ -267,10 +302,50 @@ public:
                                     CancelToken cancelFlag) = 0;
 
     virtual void createIndexes(bool enableIndexesForSearching,
-                               bool enableIndexesForLexicographicalList) = 0;
+                               bool enableIndexesForLexicographicalList,
+                               bool enableFullTextIndex,
+                               bool enableAncestorIndex) = 0;
+
+    // Like createIndexes(), but the missing indexes are only scheduled, to be built one by one
+    // by createNextPendingIndex()
+    virtual void scheduleIndexes(bool enableIndexesForSearching,
+                                 bool enableIndexesForLexicographicalList,
+                                 bool enableFullTextIndex,
+                                 bool enableAncestorIndex) = 0;
+
+    // Builds the next index scheduled by scheduleIndexes(). Returns true while more are pending
+    virtual bool createNextPendingIndex() = 0;
+
+    // false while an index of the group is missing (dropped or scheduled, but not built yet)
+    virtual bool isIndexReady(NodesIndex index) const = 0;
+
+    // Drops the secondary indexes, so a bulk load (fetchnodes) only maintains the primary key
+    virtual void dropIndexesForBulkLoad() = 0;
 
     virtual void dropSearchDBIndexes() = 0;
     virtual void dropLexicographicDBIndexes() = 0;
+    virtual void dropFullTextDBIndex() = 0;
+    virtual void dropAncestorDBIndex() = 0;
+
+    // Borrows a read-only connection to the same DB, so look-ups can run in other threads
+    // concurrently with the writes of this one. nullptr if none is available or this connection
+    // has uncommitted changes of the nodes (which other connections don't see)
+    virtual std::unique_ptr<DBTableNodesReader> acquireReader() = 0;
+};
+
+// Read-only connection borrowed by DBTableNodes::acquireReader(), which is given back when
+// destroyed. It can be used from any thread, but only by one at a time
+class MEGA_API DBTableNodesReader
+{
+public:
+    virtual ~DBTableNodesReader() = default;
+
+    // Only the look-ups can be used (the connection can't write)
+    virtual DBTableNodes& table() = 0;
+
+    // false if the nodes have been modified by the main connection since the reader was
+    // acquired, so the results of the look-ups may not match the current state
+    virtual bool isStillValid() const = 0;
 };
 
 class MEGA_API DBTableTransactionCommitter
@@ -27,8 +27,12 @@
 
 #include "mega/db.h"
 
+#include <deque>
 #include <filesystem>
+#include <list>
+#include <map>
 #include <optional>
+#include <set>
 #include <sqlite3.h>
 
 namespace mega {
@@ -66,6 +70,66 @@ public:
     ~SqliteDbTable() override;
 };
 
+// LRU cache of the prepared statements of queries whose SQL is built at runtime. Each one is
+// identified by the kind of query and an id of its shape (the parts of the SQL that change
+// between calls, i.e. the order or the number of parameters; the values are bound), so calls
+// differing only in the values (i.e. the pages of a listing) reuse the same statement.
+class MEGA_API SqliteStatementCache
+{
+public:
+    enum class Query : uint8_t
+    {
+        GET_CHILDREN,
+        SEARCH_NODES,
+        SEARCH_NODES_FULL_TEXT,
+        SEARCH_NODES_CATEGORY,
+        LIST_ALL_NODES_BY_PAGE,
+    };
+
+    struct Stats
+    {
+        uint64_t prepares = 0; // statements that were missing, so the caller had to prepare them
+        uint64_t reuses = 0;
+        uint64_t evictions = 0;
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 32;
+
+    explicit SqliteStatementCache(size_t capacity = DEFAULT_CAPACITY);
+    ~SqliteStatementCache();
+
+    SqliteStatementCache(const SqliteStatementCache&) = delete;
+    SqliteStatementCache& operator=(const SqliteStatementCache&) = delete;
+
+    // Slot of the statement for the given shape, which becomes the most recently used one. If
+    // it's nullptr, the caller has to prepare the statement into it. The least recently used
+    // statement is finalized if the capacity is exceeded, so the slot is only valid until the
+    // next call
+    sqlite3_stmt*& acquire(Query query, size_t shapeId);
+
+    // finalizes all the statements (the stats are kept)
+    void clear();
+
+    size_t size() const;
+    size_t capacity() const;
+    const Stats& stats() const;
+
+private:
+    using Key = std::pair<Query, size_t>;
+
+    struct Entry
+    {
+        Key key;
+        sqlite3_stmt* stmt = nullptr;
+    };
+
+    // most recently used first
+    std::list<Entry> mEntries;
+    std::map<Key, std::list<Entry>::iterator> mIndex;
+    size_t mCapacity;
+    Stats mStats;
+};
+
 /**
  * This class implements DbTable iface (by deriving SqliteDbTable), and additionally
  * implements DbTableNodes iface too, so it allows to manage `nodes` table.
@@ -137,9 +201,11 @@ public:
     bool getNodeSizeTypeAndFlags(NodeHandle node, m_off_t& size, nodetype_t& nodeType, uint64_t &oldFlags) override;
     bool isAncestor(mega::NodeHandle node, mega::NodeHandle ancestor, CancelToken cancelFlag) override;
     uint64_t getNumberOfNodes() override;
+    bool getNodeTreeEntries(std::vector<NodeTreeEntry>& entries) override;
     uint64_t getNumberOfChildrenByType(NodeHandle parentHandle, nodetype_t nodeType) override;
 
     bool put(Node* node) override;
+    bool putBatch(const std::vector<Node*>& nodes) override;
     using SqliteDbTable::put; // for the other virtual overload
     bool remove(mega::NodeHandle nodehandle) override;
     bool removeNodes() override;
@@ -152,15 +218,33 @@ public:
                             CancelToken cancelFlag) override;
 
     void createIndexes(bool enableIndexesForSearching,
-                       bool enableIndexesForLexicographicalList) override;
+                       bool enableIndexesForLexicographicalList,
+                       bool enableFullTextIndex,
+                       bool enableAncestorIndex) override;
+    void scheduleIndexes(bool enableIndexesForSearching,
+                         bool enableIndexesForLexicographicalList,
+                         bool enableFullTextIndex,
+                         bool enableAncestorIndex) override;
+    bool createNextPendingIndex() override;
+    bool isIndexReady(NodesIndex index) const override;
+    void dropIndexesForBulkLoad() override;
     void dropSearchDBIndexes() override;
     void dropLexicographicDBIndexes() override;
+    void dropFullTextDBIndex() override;
+    void dropAncestorDBIndex() override;
+
+    std::unique_ptr<DBTableNodesReader> acquireReader() override;
+    void commit() override;
+    void abort() override;
 
     void remove() override;
     SqliteAccountState(PrnGen &rng, sqlite3*, FileSystemAccess &fsAccess, const mega::LocalPath &path, const bool checkAlwaysTransacted, DBErrorCallback dBErrorCallBack);
     void finalise();
     virtual ~SqliteAccountState();
 
+    // Prepared vs reused statements of the queries built at runtime
+    const SqliteStatementCache::Stats& getStatementCacheStats() const;
+
     // Callback registered by some long-time running queries, so they can be canceled
     // If the progress callback returns non-zero, the operation is interrupted
     static int progressHandler(void *);
@@ -180,6 +264,10 @@ public:
     // Gets the node size from node counter (blob)
     static void getSizeFromNodeCounter(sqlite3_context* context, int argc, sqlite3_value** argv);
 
+    // Method called when query uses 'foldtext'
+    // Gets the text folded to lower case and without accents, as stored in the full-text index
+    static void userFoldText(sqlite3_context* context, int argc, sqlite3_value** argv);
+
     /**
      * @brief This method is designed to apply all the filtering options in various methods that
      * perform a query to the database and use a NodeSearchFilter object.
@@ -195,6 +283,7 @@ private:
 
     // if add a new sqlite3_stmt update finalise()
     sqlite3_stmt* mStmtPutNode = nullptr;
+    sqlite3_stmt* mStmtPutNodesBatch = nullptr;
     sqlite3_stmt* mStmtUpdateNode = nullptr;
     sqlite3_stmt* mStmtUpdateNodeAndFlags = nullptr;
     sqlite3_stmt* mStmtTypeAndSizeNode = nullptr;
@@ -204,11 +293,10 @@ private:
     sqlite3_stmt* mStmtChildrenFromType = nullptr;
 
     sqlite3_stmt* mStmtNumChildren = nullptr;
-    std::map<size_t, sqlite3_stmt*> mStmtGetChildren;
     sqlite3_stmt* mStmtGetChildrenLexi = nullptr;
     sqlite3_stmt* mStmtGetChildrenLexiNoOffset = nullptr;
-    std::map<size_t, sqlite3_stmt*> mStmtSearchNodes;
-    std::map<size_t, sqlite3_stmt*> mStmtListAllNodesByPage;
+    // getChildren, searchNodes and listAllNodesByPage
+    SqliteStatementCache mStmtCache;
     sqlite3_stmt* mStmtNodeTagsBelow = nullptr;
     sqlite3_stmt* mStmtNodesByFpNoMtime = nullptr;
     sqlite3_stmt* mStmtNodeByFp = nullptr;
@@ -219,6 +307,7 @@ private:
     sqlite3_stmt* mStmtNodesWithPubLink = nullptr;
     sqlite3_stmt* mStmtChildNode = nullptr;
     sqlite3_stmt* mStmtIsAncestor = nullptr;
+    sqlite3_stmt* mStmtIsAncestorIndexed = nullptr;
     sqlite3_stmt* mStmtNumChild = nullptr;
     sqlite3_stmt* mStmtRecents = nullptr; // For getRecentNodes()
     sqlite3_stmt* mStmtFavourites = nullptr;
@@ -227,8 +316,42 @@ private:
     // (tests with a value of 1000 results on a callback every 1.2ms on a desktop PC)
     static const int NUM_VIRTUAL_MACHINE_INSTRUCTIONS = 1000;
 
+    // Whether the nodes of the categories (values of mimetypeStored) are few enough, compared to
+    // the nodes below the ancestors of the filter, for searchNodes() to start from them
+    bool isCategorySelective(const NodeSearchFilter& filter, const std::vector<int>& categories);
+
     // Helper method to drop index with the provided names
     void dropDBIndexes(const std::vector<std::string>& indicesToDelete);
+
+    // Names of the indexes and triggers of 'nodes' currently present in the database
+    std::set<std::string> getExistingIndexes();
+
+    // Secondary indexes (positions at the list of index definitions in sqlite.cpp) that are
+    // missing and will be built by createNextPendingIndex(), in order
+    std::deque<size_t> mPendingIndexes;
+
+    // Full-text index: a FTS5 table with the folded names, descriptions and tags, kept in sync
+    // with 'nodes' by triggers
+    bool mFullTextIndexReady = false;
+    bool mFullTextIndexPending = false;
+    bool createFullTextIndex();
+    void dropFullTextIndex();
+
+    // Ancestor index: a closure table with a row per node and each of its ancestors, kept in
+    // sync with 'nodes' by triggers
+    bool mAncestorIndexReady = false;
+    bool mAncestorIndexPending = false;
+    bool createAncestorIndex();
+    void dropAncestorIndex();
+
+    // Read-only connections for acquireReader(), shared with the borrowed ones so they can
+    // outlive this object (nullptr for the read-only connections themselves)
+    class ReaderPool;
+    class Reader;
+    std::shared_ptr<ReaderPool> mReaderPool;
+
+    // to be called before writing to 'nodes', so the readers are invalidated
+    void nodesWillChange();
 };
 
 class MEGA_API SqliteDbAccess : public DbAccess
@@ -358,6 +481,8 @@ private:
     bool addAndPopulateColumns(sqlite3* db, vector<NewColumn>&& newCols);
     bool stripExistingColumns(sqlite3* db, vector<NewColumn>& cols);
     bool addColumn(sqlite3* db, const string& name, const string& type);
+    // fill a column from other columns of each row (SQL expression)
+    bool populateColumn(sqlite3* db, const string& name, const string& expression);
     bool migrateDataToColumns(sqlite3* db, vector<NewColumn>&& cols);
 };
 
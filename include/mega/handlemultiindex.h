@@ -0,0 +1,324 @@
+/**
+ * @file mega/handlemultiindex.h
+ * @brief Hash index of objects by a handle, allowing repeated handles
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#ifndef MEGA_HANDLEMULTIINDEX_H
+#define MEGA_HANDLEMULTIINDEX_H 1
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace mega {
+
+// 64 bits of a key, to be hashed (the default is for integer handles)
+template<typename Key>
+struct HandleIndexBits
+{
+    uint64_t operator()(const Key& key) const
+    {
+        return static_cast<uint64_t>(key);
+    }
+};
+
+// Pointers to objects by a 64-bit key (an fsid, a node handle...), as a multimap would do, but
+// in a single open addressing table: no allocation per entry and about half the memory.
+// The same key may map to several objects, and they are visited in the order they were added,
+// as std::multimap does.
+// Adding or removing entries invalidates the ranges and iterators returned by values().
+template<typename Key, typename Value, typename KeyBits = HandleIndexBits<Key>>
+class HandleMultiIndex
+{
+    struct Slot
+    {
+        Key key{};
+
+        // nullptr for an empty slot
+        Value* value = nullptr;
+    };
+
+public:
+    // the objects with a key, as returned by values()
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value* const*;
+        using reference = Value* const&;
+
+        const_iterator() = default;
+
+        reference operator*() const
+        {
+            return mIndex->mSlots[mPos].value;
+        }
+
+        const_iterator& operator++()
+        {
+            mPos = mIndex->nextWithKey(mPos, mIndex->mSlots[mPos].key);
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return mPos == other.mPos;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return mPos != other.mPos;
+        }
+
+    private:
+        friend class HandleMultiIndex;
+
+        const_iterator(const HandleMultiIndex* index, size_t pos):
+            mIndex(index),
+            mPos(pos)
+        {}
+
+        const HandleMultiIndex* mIndex = nullptr;
+        size_t mPos = NPOS;
+    };
+
+    struct Range
+    {
+        const_iterator first;
+        const_iterator second;
+
+        const_iterator begin() const
+        {
+            return first;
+        }
+
+        const_iterator end() const
+        {
+            return second;
+        }
+
+        bool empty() const
+        {
+            return first == second;
+        }
+    };
+
+    // the objects indexed by 'key', in the order they were added
+    Range values(const Key& key) const
+    {
+        if (mSlots.empty())
+        {
+            return Range{end(), end()};
+        }
+
+        auto pos = home(key);
+        if (!mSlots[pos].value)
+        {
+            return Range{end(), end()};
+        }
+        if (mSlots[pos].key == key)
+        {
+            return Range{const_iterator(this, pos), end()};
+        }
+        return Range{const_iterator(this, nextWithKey(pos, key)), end()};
+    }
+
+    bool contains(const Key& key) const
+    {
+        return !values(key).empty();
+    }
+
+    // adds 'value' after any other object with the same key
+    void insert(const Key& key, Value* value)
+    {
+        assert(value);
+
+        if ((mSize + 1) * 4 > mSlots.size() * 3)
+        {
+            rehash(mSlots.empty() ? MIN_CAPACITY : mSlots.size() * 2);
+        }
+
+        auto pos = home(key);
+        while (mSlots[pos].value)
+        {
+            pos = (pos + 1) & mask();
+        }
+        mSlots[pos].key = key;
+        mSlots[pos].value = value;
+        ++mSize;
+    }
+
+    // removes the entry for exactly that key and object, returning whether there was one
+    bool erase(const Key& key, const Value* value)
+    {
+        if (mSlots.empty())
+        {
+            return false;
+        }
+
+        auto pos = home(key);
+        for (; mSlots[pos].value; pos = (pos + 1) & mask())
+        {
+            if (mSlots[pos].value == value && mSlots[pos].key == key)
+            {
+                break;
+            }
+        }
+
+        if (!mSlots[pos].value)
+        {
+            return false;
+        }
+
+        // Move back the entries after it that can't be reached otherwise. No tombstones are
+        // needed, and entries with the same key keep their relative order.
+        for (auto next = (pos + 1) & mask(); mSlots[next].value; next = (next + 1) & mask())
+        {
+            auto nextHome = home(mSlots[next].key);
+            if (((next - nextHome) & mask()) >= ((next - pos) & mask()))
+            {
+                mSlots[pos] = mSlots[next];
+                pos = next;
+            }
+        }
+        mSlots[pos] = Slot();
+        --mSize;
+
+        // give back the memory after a large tree is removed
+        if (mSlots.size() > MIN_CAPACITY && mSize * 8 < mSlots.size())
+        {
+            rehash(mSlots.size() / 2);
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        std::vector<Slot>().swap(mSlots);
+        mSize = 0;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return !mSize;
+    }
+
+    // bytes taken by the table
+    size_t memoryUsage() const
+    {
+        return sizeof(*this) + mSlots.capacity() * sizeof(Slot);
+    }
+
+private:
+    static constexpr size_t NPOS = ~size_t(0);
+
+    // always a power of two
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    const_iterator end() const
+    {
+        return const_iterator(this, NPOS);
+    }
+
+    size_t mask() const
+    {
+        return mSlots.size() - 1;
+    }
+
+    size_t home(const Key& key) const
+    {
+        // handles and fsids (often inode numbers) are far from uniform: mix all their bits
+        uint64_t h = KeyBits()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h) & mask();
+    }
+
+    // the next slot after 'pos' with 'key', or NPOS
+    size_t nextWithKey(size_t pos, const Key& key) const
+    {
+        for (pos = (pos + 1) & mask(); mSlots[pos].value; pos = (pos + 1) & mask())
+        {
+            if (mSlots[pos].key == key)
+            {
+                return pos;
+            }
+        }
+        return NPOS;
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> old(capacity);
+        old.swap(mSlots);
+
+        if (old.empty())
+        {
+            return;
+        }
+
+        // Start right after an empty slot, so each run of entries is added again from its
+        // beginning and entries with the same key keep their order.
+        size_t start = 0;
+        while (old[start].value)
+        {
+            ++start;
+        }
+
+        for (size_t i = 0; i < old.size(); ++i)
+        {
+            const auto& slot = old[(start + i) & (old.size() - 1)];
+            if (slot.value)
+            {
+                auto pos = home(slot.key);
+                while (mSlots[pos].value)
+                {
+                    pos = (pos + 1) & mask();
+                }
+                mSlots[pos] = slot;
+            }
+        }
+    }
+
+    std::vector<Slot> mSlots;
+    size_t mSize = 0;
+};
+
+} // namespace mega
+
+#endif
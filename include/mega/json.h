@@ -113,6 +113,11 @@ public:
     // copy JSON-delimited string
     static void copystring(string*, const char*);
 
+    // skip the contents of a JSON string, honoring escapes: ptr points after the opening quote.
+    // Returns the closing quote, or the terminating NUL if the string is incomplete.
+    // Vectorized (SSE2/AVX2/NEON) where available
+    static const char* skipString(const char* ptr);
+
     // Strip whitspace from a string in a JSON-safe manner.
     static string stripWhitespace(const string& text);
     static string stripWhitespace(const char* text);
@@ -1834,6 +1834,9 @@ public:
 
     std::atomic<bool> mEnableSearchDBIndexes{true};
     std::atomic<bool> mEnableLexicographicDBIndexes{false};
+    std::atomic<bool> mEnableFullTextSearchDBIndex{false};
+    std::atomic<bool> mEnableAncestorDBIndex{false};
+    std::atomic<bool> mEnableNodeTreeSnapshot{false};
 
     struct FolderLink {
         // public handle of the folder link ('&n=' param in the POST)
@@ -1906,6 +1909,31 @@ public:
     // close the local transfer cache
     void closetc(bool remove = false);
 
+    // Budget for the application of action packets in each call to exec(). A large catch-up is
+    // applied over several iterations, so it doesn't starve transfers and syncs.
+    struct ActionPacketsSlice
+    {
+        // limits per slice (0 means no limit)
+        unsigned maxPackets = 1000;
+        std::chrono::milliseconds maxTime{100};
+
+        // start a new slice (no limits are applied until the first slice is started)
+        void begin();
+
+        // one more action packet applied
+        void count();
+
+        // whether the budget of the current slice is spent
+        bool exhausted() const;
+
+        bool started = false;
+        unsigned packets = 0;
+        std::chrono::steady_clock::time_point firstPacketTime;
+
+        // packets are pending for the next slice
+        bool yielded = false;
+    } mActionPacketsSlice;
+
     // server-client command processing
     void sc_storeSn(JSON& json);
     void sc_purgeAndCommit();
@@ -1913,6 +1941,8 @@ public:
     // process an action packet
     bool sc_procActionPacket(JSON& json, std::shared_ptr<Node>& lastAPDeletedNode);
     void sc_updateStats();
+    // true if the remaining action packets have to wait for the next call to exec()
+    bool sc_sliceExhausted(const Node* lastAPDeletedNode);
     // process an action packet excluding a, i and st tags
     std::shared_ptr<Node> sc_procActionPacketWithoutCommonTags(JSON& json,
                                                                nameid name,
@@ -1966,6 +1996,9 @@ public:
     // remove caches
     void removeCaches();
 
+    // write the snapshot of the node tree committed to the DB, for the next session resumption
+    void saveNodeTreeSnapshot();
+
     // add node to vector and return index
     unsigned addnode(sharedNode_vector* v, std::shared_ptr<Node> n) const;
 
@@ -2095,6 +2128,10 @@ public:
     bool fetchingnodes;
     int fetchnodestag;
 
+    // decrypt the keys and attributes of the nodes received in `f` in batches, on the worker
+    // threads of mAsyncQueue. If false, each node is decrypted on the SDK thread as it's parsed
+    bool mParallelNodesDecryption = true;
+
     // set true after fetchnodes and catching up on actionpackets, stays true after that.
     std::atomic<bool> statecurrent;
 
@@ -2146,6 +2183,9 @@ public:
     // open/create "statecache" and "nodes" tables in DB
     void opensctable();
 
+    // path of the snapshot of the node tree, next to the DB
+    LocalPath mNodeTreeSnapshotPath;
+
     // opens (or creates if non existing) a status database table.
     //   if loadFromCache is true, it will load status from the table.
     void openStatusTable(bool loadFromCache);
@@ -2568,6 +2608,8 @@ public:
     // 0 -> no object found
     // 1 -> successful parsing
     // any other number -> parsing error
+    // if readNodes is provided, new nodes from fetchnodes are appended to it instead of
+    // being added right away; addReadNodes() must be called to add them
     int readnode(JSON*,
                  int,
                  putsource_t,
@@ -2576,7 +2618,25 @@ public:
                  bool applykeys,
                  NodeManager::MissingParentNodes& missingParentNodes,
                  handle& previousHandleForAlert,
-                 set<NodeHandle>* allParents);
+                 set<NodeHandle>* allParents,
+                 std::vector<ReadNode>* readNodes = nullptr);
+
+    // add a node created by readnode() to the NodeManager, applying its key
+    void addReadNode(ReadNode&,
+                     int notify,
+                     vector<NewNode>*,
+                     bool applykeys,
+                     NodeManager::MissingParentNodes& missingParentNodes,
+                     handle& previousHandleForAlert);
+
+    // decrypt the keys and attributes of the nodes deferred by readnode() on the worker
+    // threads, then add them in order (fetchnodes only)
+    void addReadNodes(std::vector<ReadNode>& readNodes,
+                      NodeManager::MissingParentNodes& missingParentNodes,
+                      handle& previousHandleForAlert);
+
+    // max number of nodes deferred by readnode() before calling addReadNodes()
+    static constexpr size_t MAX_READ_NODES_BATCH = 4096;
 
 #ifdef ENABLE_SYNC
     void postReadNodes(bool notify,
@@ -2816,6 +2876,15 @@ public:
     // Enable create DB indexes for queries listing nodes using lexicographical order
     // By default is false (reset to default value at locallogout)
     void enableLexicographicDBIndexes(bool enable);
+    // Enable create a full-text DB index for searches by name, description and tags
+    // By default is false
+    void enableFullTextSearchDBIndex(bool enable);
+    // Enable create a DB index with the ancestors of every node, for ancestor checks and
+    // listings below a node. By default is false
+    void enableAncestorDBIndex(bool enable);
+    // Enable the snapshot of the node tree, written when the session is saved and mapped when it's
+    // resumed. By default is false
+    void enableNodeTreeSnapshot(bool enable);
     // Drop DB indexes for queries used in search functionality
     // It should be call just after open the DB
     void dropSearchDBIndexes();
@@ -3005,6 +3074,7 @@ public:
         uint64_t transferStarts = 0, transferFinishes = 0;
         uint64_t transferTempErrors = 0, transferFails = 0;
         uint64_t prepwaitImmediate = 0, prepwaitZero = 0, prepwaitHttpio = 0, prepwaitFsaccess = 0, nonzeroWait = 0;
+        uint64_t scSlicesYielded = 0;
         CodeCounter::DurationSum csRequestWaitTime;
         CodeCounter::DurationSum transfersActiveTime;
         std::string report(bool reset, HttpIO* httpio, Waiter* waiter, const RequestDispatcher& reqs);
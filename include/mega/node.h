@@ -27,8 +27,12 @@
 #include "backofftimer.h"
 #include "file.h"
 #include "filefingerprint.h"
+#include "nodehandlemap.h"
 #include "syncfilter.h"
 #include "syncinternals/mac_computation_state.h"
+#include "syncinternals/scannedfingerprints.h"
+#include "syncinternals/sortedchildindex.h"
+#include "syncinternals/syncnamearena.h"
 #include "syncinternals/syncuploadthrottlingfile.h"
 #include "utils.h"
 
@@ -130,7 +134,7 @@ struct NodeCounter
     void operator += (const NodeCounter&);
     void operator -= (const NodeCounter&);
     std::string serialize() const;
-    NodeCounter(const std::string& blob);
+    NodeCounter(std::string_view blob);
     NodeCounter() = default;
 };
 
@@ -148,14 +152,21 @@ public:
     shared_ptr<Node> getNodeInRam(bool updatePositionAtLRU = true);
     NodeHandle getNodeHandle() const;
 
-    std::list<std::shared_ptr<Node> >::const_iterator mLRUPosition;
+    // true if the node is at NodeManager's cache LRU
+    bool isInCacheLRU() const;
+
+    // Hook for NodeManager's intrusive cache LRU. While the node is at the LRU,
+    // mLRUNode keeps it loaded in RAM
+    NodeManagerNode* mLRUPrev = nullptr;
+    NodeManagerNode* mLRUNext = nullptr;
+    std::shared_ptr<Node> mLRUNode;
 
 private:
     NodeHandle mNodeHandle;
     NodeManager& mNodeManager;
     weak_ptr<Node> mNode;
 };
-typedef std::map<NodeHandle, NodeManagerNode>::iterator NodePosition;
+typedef NodeHandleMap<NodeManagerNode>::iterator NodePosition;
 
 struct CommandChain
 {
@@ -261,6 +272,32 @@ struct MEGA_API Node : public NodeCore, FileFingerprint
     // try to resolve node key string
     bool applykey();
 
+    // node key and attributes decrypted ahead, off the SDK thread (see MegaClient::addReadNodes())
+    struct DecryptedKey
+    {
+        byte key[FILENODEKEYLENGTH];
+        bool foreign = false;
+        std::optional<AttrMap> attrs; // not set if the attributes could not be decrypted
+    };
+
+    // same as applykey(), with the key and attributes already decrypted
+    bool applykey(DecryptedKey& decrypted);
+
+    // decrypt a node key found by findStableKey() and, with it, the attribute string.
+    // Thread-safe (it only uses the provided cipher). Returns false if the key is invalid
+    static bool decryptKey(const char* encryptedKey,
+                           const byte* cipherKey,
+                           nodetype_t type,
+                           const string* attrstring,
+                           SymmCipher& sc,
+                           DecryptedKey& decrypted);
+
+    // locate the part of the node key that applykey() would decrypt, as long as the key
+    // to decrypt it can't change while the nodes of `f` are being added (legacy in-share
+    // keys can). Returns the encrypted key and copies the symmetric key into cipherKey,
+    // or returns nullptr
+    const char* findStableKey(byte* cipherKey, bool& foreign) const;
+
     // Returns false if the share key can't correctly decrypt the key and the
     // attributes of the node. Otherwise, it returns true. There are cases in
     // which it's not possible to check if the key is valid (for example when
@@ -276,6 +313,9 @@ struct MEGA_API Node : public NodeCore, FileFingerprint
     // decrypt attribute string, set fileattrs and save fingerprint
     void setattr();
 
+    // same as setattr(), with the attribute string already decrypted
+    void setattr(AttrMap&& decryptedAttrs);
+
     // display name (UTF-8)
     const char* displayname(LogCondition log = LOG_CONDITION_NONE) const;
 
@@ -379,7 +419,7 @@ struct MEGA_API Node : public NodeCore, FileFingerprint
     } changed;
 
 
-    void setKey(const string& key);
+    void setKey(string key);
     void setkey(const byte*);
     void setkeyfromjson(const char*);
 
@@ -411,7 +451,7 @@ struct MEGA_API Node : public NodeCore, FileFingerprint
     void setpubliclink(handle, m_time_t, m_time_t, bool, const string &authKey = {});
 
     bool serialize(string*) const override;
-    static std::shared_ptr<Node> unserialize(MegaClient& client, const string*, bool fromOldCache, std::list<std::unique_ptr<NewShare>>& ownNewshares);
+    static std::shared_ptr<Node> unserialize(MegaClient& client, std::string_view, bool fromOldCache, std::list<std::unique_ptr<NewShare>>& ownNewshares);
 
     Node(MegaClient&, NodeHandle, NodeHandle, nodetype_t, m_off_t, handle, const char*, m_time_t);
     ~Node();
@@ -512,6 +552,12 @@ struct MEGA_API Node : public NodeCore, FileFingerprint
     static bool isOfMimetype(MimeType_t mimetype, const std::string& ext);
     static MimeType_t getMimetype(const std::string& ext);
 
+    // category of a node with this name (MIME_TYPE_OTHERS if it has no extension)
+    static MimeType_t getMimetypeByName(const std::string& name);
+
+    // refresh the categories of the node from its name (done by setattr())
+    void updateMimetypes();
+
     bool isPhotoWithFileAttributes(bool checkPreview) const;
 
     bool isCreditCardNode() const;
@@ -528,6 +574,14 @@ private:
     // keeps track of counts of files, folder, versions, storage and version's storage
     NodeCounter mCounter;
 
+    // categories of the node by the extension of its name (bit 1 << MimeType_t for each one),
+    // kept up to date with the name so that checking them doesn't parse it every time
+    uint16_t mMimetypes = 0;
+
+    // common tail of both applykey(): key is nullptr if it couldn't be decrypted, and
+    // decryptedAttrs is nullptr if the attributes are still to be decrypted
+    bool applyDecryptedKey(const byte* key, std::optional<AttrMap>* decryptedAttrs);
+
     static nameid getExtensionNameId(const std::string& ext);
 };
 
@@ -560,6 +614,26 @@ inline bool Node::hasZeroKey(const string& nodekeydata)
 
 // END MEGA_API Node
 
+// node object received from the API, already created by MegaClient::readnode() but not yet
+// added to the NodeManager
+struct ReadNode
+{
+    std::shared_ptr<Node> node;
+    bool isNew = false;                  // false if it updates a node that was already known
+    handle parentHandle = UNDEF;         // as received
+    handle owner = 0;
+    nodetype_t type = TYPE_UNKNOWN;
+    m_time_t ctime = -1;
+    handle sharingUser = UNDEF;          // in-shares only
+    accesslevel_t shareAccess = ACCESS_UNKNOWN;
+    m_time_t shareTs = -1;
+    std::vector<byte> shareKey;          // empty if not received
+    int newNodeIndex = -1;               // related NewNode, if any
+
+    // set if the key and attributes were decrypted ahead (see MegaClient::addReadNodes())
+    std::optional<Node::DecryptedKey> decryptedKey;
+};
+
 class NodeData
 {
 public:
@@ -600,16 +674,17 @@ private:
     handle mParentHandle = 0;
     handle mUserHandle = 0;
     m_time_t mCtime = 0;
-    string mNodeKey;
+    // The views below point into the serialized buffer, which must outlive this object
+    std::string_view mNodeKey;
     char mIsExported = '\0';
     char mIsEncrypted = '\0';
-    string mFileAttributes;
-    string mAuthKey;
-    std::unique_ptr<byte[]> mShareKey;
+    std::string_view mFileAttributes;
+    std::string_view mAuthKey;
+    const byte* mShareKey = nullptr;
     int mShareDirection = INT_MAX; // valid values are -1 (outshares) and 0 (inshare)
-    std::list<std::vector<char>> mShares;
-    AttrMap mAttrs;
-    string mAttrString; // encrypted attrs
+    std::vector<std::string_view> mShares;
+    AttrMap mAttrs; // moved into the Node by createNode()
+    std::string_view mAttrString; // encrypted attrs
     handle mPubLinkHandle = 0;
     m_time_t mPubLinkEts = 0;
     m_time_t mPubLinkCts = 0;
@@ -648,10 +723,16 @@ struct MEGA_API LocalNodeCore
   : public Cacheable
 {
     // deserialize attributes from binary storage.
-    bool read(const string& source, uint32_t& parentID);
+    // The fingerprint the filesystem last reported is only kept by LocalNode, so it's returned
+    // apart (if requested).
+    bool read(const string& source,
+              uint32_t& parentID,
+              FileFingerprint* realScannedFingerprint = nullptr);
 
-    // serialize attributes to binary for storage.
-    bool write(string& destination, uint32_t parentID) const;
+    // serialize attributes to binary for storage (with a blank real scanned fingerprint if null).
+    bool write(string& destination,
+               uint32_t parentID,
+               const FileFingerprint* realScannedFingerprint = nullptr) const;
 
     // local filesystem node ID (inode...) for rename/move detection
     handle fsid_lastSynced = ::mega::UNDEF;
@@ -667,19 +748,23 @@ struct MEGA_API LocalNodeCore
     // null means either the entry has no shortname or it's the same as the (normal) longname
     std::unique_ptr<LocalPath> slocalname = nullptr;
 
-    // whether this node knew its shortname (otherwise it was loaded from an old db)
-    bool slocalname_in_db = false;
-
     // related cloud node, if any
     NodeHandle syncedCloudNodeHandle;
 
     // The fingerprint of the node and/or file we are synced with
-    FileFingerprint syncedFingerprint;
-    // The fingreprint scanned from file system
-    // In Android scannedFingerprint is modified to set proper mtime value (from download)
-    // (it isn't possible set mtime in file system)
-    FileFingerprint realScannedFingerprint;
+    const FileFingerprint& syncedFingerprint() const
+    {
+        return mSyncedFingerprint;
+    }
 
+private:
+    // Only set by read() and LocalNode::setSyncedFingerprint(), as the scanned fingerprints of
+    // the LocalNode may refer to it
+    FileFingerprint mSyncedFingerprint;
+
+    friend struct LocalNode;
+
+public:
     // FILENODE or FOLDERNODE
     nodetype_t type = TYPE_UNKNOWN;
 
@@ -687,53 +772,34 @@ struct MEGA_API LocalNodeCore
     // This is so users can, for example, change uppercase/lowercase and have that synchronized.
     bool namesSynchronized = false;
 
+    // whether this node knew its shortname (otherwise it was loaded from an old db)
+    bool slocalname_in_db = false;
+
 }; // LocalNodeCore
 
 struct MEGA_API LocalNode
   : public LocalNodeCore
 {
+    // The fields used by every pass of the sync over the tree come first, so visiting a node
+    // touches as few cache lines as possible.
+
     class Sync* sync = nullptr;
 
-    // UTF8 NFC version of LocalNodeCore::localname.
+    // parent linkage
+    LocalNode* parent = nullptr;
+
+    // UTF8 NFC version of LocalNodeCore::localname, in the name arena of the sync.
     // Not serialized.
     // Should be updated whenever localname is.
     // Does not match the corresponding Node's name,
     // as escapes/case may be involved.
-    string toName_of_localname;
+    SyncNameArena::Name toName_of_localname;
 
-    // parent linkage
-    LocalNode* parent = nullptr;
-
-    // children by name
-    localnode_map children;
+    // children by name, in the order the sync matches names (see Sync::computeSyncTriplets)
+    SortedChildIndex<LocalNode> children;
 
-    unique_ptr<LocalPath> cloneShortname() const;
-    localnode_map schildren;
-
-    // The last scan of the folder (for folders).
-    // Removed again when the folder is fully synced.
-    std::unique_ptr<vector<FSNode>> lastFolderScan;
-
-    // If we can regenerate the filsystem data at this node, no need to store it, save some RAM
-    void clearRegeneratableFolderScan(SyncPath& fullPath, vector<SyncRow>& childRows);
-
-    fsid_localnode_map::iterator fsid_lastSynced_it;
-
-    // we also need to track what fsid corresponded to our FSNode last time, even if not synced (not serialized)
-    // if it changes, we should rescan, in case of LocalNode pre-existing with no FSNode, then one appears.  Or, now it's different
-    handle fsid_asScanned = ::mega::UNDEF;
-    fsid_localnode_map::iterator fsid_asScanned_it;
-
-    // Fingerprint of the file as of the last scan.  TODO: does this make LocalNode too large?
-    FileFingerprint scannedFingerprint;
-
-    // related cloud node, if any
-    nodehandle_localnode_map::iterator syncedCloudNodeHandle_it;
-
-    // using a per-Localnode scan delay prevents self-notifications delaying the whole sync
-    dstime scanDelayUntil = 0;
-    unsigned expectedSelfNotificationCount = 0;
-    //dstime lastScanTime = 0;
+    // the child with this localname (not shortname), or children.end()
+    SortedChildIndex<LocalNode>::iterator findChild(const LocalPath& localname);
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -788,6 +854,11 @@ struct MEGA_API LocalNode
         unsigned fsidSyncedReused : 1;
         unsigned fsidScannedReused : 1;
 
+        // whether the node is in the Syncs indexes by synced fsid, scanned fsid and synced handle
+        unsigned inSyncedFsidIndex : 1;
+        unsigned inScannedFsidIndex : 1;
+        unsigned inNodeHandleIndex : 1;
+
         // we can't delete a node immediately in case it's involved in a move
         // that we haven't detected yet.  So we increment this counter
         // Once it's big enough then we are sure and can delete the LocalNode.
@@ -810,6 +881,77 @@ struct MEGA_API LocalNode
 #pragma warning(pop)
 #endif
 
+private:
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4201) // nameless struct
+#endif
+    struct
+    {
+        // The node's exclusion state.
+        ExclusionState mExclusionState;
+
+        // Whether we're an ignore file.
+        bool mIsIgnoreFile : 1;
+
+        // Whether we need to reload this node's ignore file.
+        bool mWaitingForIgnoreFileLoad : 1;
+    };
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+public:
+    unique_ptr<LocalPath> cloneShortname() const;
+
+    // children by shortname, only for those that have one (allocated when the first one is added)
+    unique_ptr<localnode_map> schildren;
+
+    // The last scan of the folder (for folders).
+    // Removed again when the folder is fully synced.
+    std::unique_ptr<vector<FSNode>> lastFolderScan;
+
+    // If we can regenerate the filsystem data at this node, no need to store it, save some RAM
+    void clearRegeneratableFolderScan(SyncPath& fullPath, vector<SyncRow>& childRows);
+
+    // we also need to track what fsid corresponded to our FSNode last time, even if not synced (not serialized)
+    // if it changes, we should rescan, in case of LocalNode pre-existing with no FSNode, then one appears.  Or, now it's different
+    handle fsid_asScanned = ::mega::UNDEF;
+
+    // Fingerprint of the file as of the last scan, and the one actually reported by the filesystem
+    // (the scanned one may have the synced mtime on Android, where the mtime of downloads can't
+    // be set).
+    const FileFingerprint& scannedFingerprint() const
+    {
+        return mScannedFingerprints.scanned(mSyncedFingerprint);
+    }
+
+    const FileFingerprint& realScannedFingerprint() const
+    {
+        return mScannedFingerprints.realScanned(mSyncedFingerprint);
+    }
+
+    void setScannedFingerprint(const FileFingerprint& fingerprint)
+    {
+        mScannedFingerprints.setScanned(fingerprint, mSyncedFingerprint);
+    }
+
+    void setRealScannedFingerprint(const FileFingerprint& fingerprint)
+    {
+        mScannedFingerprints.setRealScanned(fingerprint, mSyncedFingerprint);
+    }
+
+    void setSyncedFingerprint(const FileFingerprint& fingerprint);
+
+private:
+    ScannedFingerprints mScannedFingerprints;
+
+public:
+    // using a per-Localnode scan delay prevents self-notifications delaying the whole sync
+    dstime scanDelayUntil = 0;
+    unsigned expectedSelfNotificationCount = 0;
+    //dstime lastScanTime = 0;
+
     // Fields which are hardly ever used.
     // We keep the average memory use by only alloating these when used.
     struct RareFields
@@ -1157,25 +1299,6 @@ struct MEGA_API LocalNode
     void setSubtreeNeedsRefingerprint();
 
 private:
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable: 4201) // nameless struct
-#endif
-    struct
-    {
-        // The node's exclusion state.
-        ExclusionState mExclusionState;
-
-        // Whether we're an ignore file.
-        bool mIsIgnoreFile : 1;
-
-        // Whether we need to reload this node's ignore file.
-        bool mWaitingForIgnoreFileLoad : 1;
-    };
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-
     // Query whether a file is excluded by a name filter.
     ExclusionState calcExcluded(RemotePathPair namePath,
                                 nodetype_t applicableType,
@@ -1341,7 +1464,7 @@ public:
     }
 };
 
-bool isDoNotSyncFileName(const string& name);
+bool isDoNotSyncFileName(std::string_view name);
 #endif  // ENABLE_SYNC
 
 bool isPhotoVideoAudioByName(const string& filenameExtensionLowercaseNoDot);
@@ -0,0 +1,313 @@
+/**
+ * @file mega/nodehandlemap.h
+ * @brief Open-addressing hash map keyed by NodeHandle, with stable element addresses
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#ifndef MEGA_NODEHANDLEMAP_H
+#define MEGA_NODEHANDLEMAP_H 1
+
+#include "types.h"
+
+#include <deque>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mega {
+
+/**
+ * @brief Hash map from NodeHandle to T, used as the index of nodes in RAM (NodeManager::mNodes)
+ *
+ * Keys are looked up in a flat table of (handle, element index) slots with linear probing, so
+ * a lookup usually touches a single cache line instead of walking a tree. Elements are stored
+ * in a std::deque and never move: iterators remain valid until their element is erased, also
+ * across rehashes (Node::mNodePosition relies on it). The storage of erased elements is reused
+ * by later insertions.
+ *
+ * Iteration order is unspecified.
+ */
+template<typename T>
+class NodeHandleMap
+{
+public:
+    using key_type = NodeHandle;
+    using mapped_type = T;
+    using value_type = std::pair<const NodeHandle, T>;
+
+    class iterator
+    {
+    public:
+        iterator() = default;
+
+        value_type& operator*() const
+        {
+            return *mMap->mElements[mIndex];
+        }
+
+        value_type* operator->() const
+        {
+            return &**this;
+        }
+
+        iterator& operator++()
+        {
+            mIndex = mMap->nextElement(mIndex + 1);
+            return *this;
+        }
+
+        // any end() iterator (including default-constructed ones) compare equal
+        bool operator==(const iterator& other) const
+        {
+            return mIndex == other.mIndex && (mIndex == END || mMap == other.mMap);
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class NodeHandleMap;
+
+        iterator(NodeHandleMap* map, size_t index):
+            mMap(map),
+            mIndex(index)
+        {}
+
+        NodeHandleMap* mMap = nullptr;
+        size_t mIndex = END;
+    };
+
+    NodeHandleMap() = default;
+    NodeHandleMap(const NodeHandleMap&) = delete;
+    NodeHandleMap& operator=(const NodeHandleMap&) = delete;
+
+    iterator begin()
+    {
+        return iterator(this, nextElement(0));
+    }
+
+    iterator end()
+    {
+        return iterator(this, END);
+    }
+
+    iterator find(NodeHandle h)
+    {
+        size_t slot = findSlot(h.as8byte());
+        return slot == END ? end() : iterator(this, mSlots[slot].mIndex);
+    }
+
+    // Constructs T from args only if h is not in the map yet
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(NodeHandle h, Args&&... args)
+    {
+        const uint64_t key = h.as8byte();
+        if (size_t slot = findSlot(key); slot != END)
+        {
+            return {iterator(this, mSlots[slot].mIndex), false};
+        }
+
+        if ((mSize + 1) * MAX_LOAD_DEN > mSlots.size() * MAX_LOAD_NUM)
+        {
+            rehash(mSlots.empty() ? MIN_SLOTS : mSlots.size() * 2);
+        }
+
+        size_t index;
+        if (mFreeElements.empty())
+        {
+            index = mElements.size();
+            mElements.emplace_back();
+        }
+        else
+        {
+            index = mFreeElements.back();
+            mFreeElements.pop_back();
+        }
+
+        mElements[index].emplace(std::piecewise_construct,
+                                 std::forward_as_tuple(h),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+
+        size_t slot = idealSlot(key);
+        while (mSlots[slot].mIndex != END)
+        {
+            slot = (slot + 1) & (mSlots.size() - 1);
+        }
+        mSlots[slot] = {key, index};
+        ++mSize;
+
+        return {iterator(this, index), true};
+    }
+
+    void erase(iterator it)
+    {
+        assert(it.mMap == this && it.mIndex != END);
+        eraseSlot(findSlot(it->first.as8byte()));
+    }
+
+    size_t erase(NodeHandle h)
+    {
+        size_t slot = findSlot(h.as8byte());
+        if (slot == END)
+        {
+            return 0;
+        }
+
+        eraseSlot(slot);
+        return 1;
+    }
+
+    // Releases all the memory, not only the elements
+    void clear()
+    {
+        std::vector<Slot>().swap(mSlots);
+        std::deque<std::optional<value_type>>().swap(mElements);
+        std::vector<size_t>().swap(mFreeElements);
+        mSize = 0;
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return !mSize;
+    }
+
+    size_t bucket_count() const
+    {
+        return mSlots.size();
+    }
+
+private:
+    static constexpr size_t END = std::numeric_limits<size_t>::max();
+    static constexpr size_t MIN_SLOTS = 16;
+    // maximum load factor (3/4) before growing the table of slots
+    static constexpr size_t MAX_LOAD_NUM = 3;
+    static constexpr size_t MAX_LOAD_DEN = 4;
+
+    struct Slot
+    {
+        uint64_t mKey = 0;
+        // position of the element at mElements, END if the slot is empty
+        size_t mIndex = END;
+    };
+
+    std::vector<Slot> mSlots; // size is always 0 or a power of 2
+    std::deque<std::optional<value_type>> mElements;
+    std::vector<size_t> mFreeElements;
+    size_t mSize = 0;
+
+    size_t idealSlot(uint64_t key) const
+    {
+        // Fibonacci hashing: handles are usually random, but spread sequential ones (i.e. tests)
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> mShift);
+    }
+
+    size_t findSlot(uint64_t key) const
+    {
+        if (mSlots.empty())
+        {
+            return END;
+        }
+
+        for (size_t slot = idealSlot(key);; slot = (slot + 1) & (mSlots.size() - 1))
+        {
+            const Slot& s = mSlots[slot];
+            if (s.mIndex == END)
+            {
+                return END;
+            }
+            if (s.mKey == key)
+            {
+                return slot;
+            }
+        }
+    }
+
+    size_t nextElement(size_t index) const
+    {
+        while (index < mElements.size() && !mElements[index])
+        {
+            ++index;
+        }
+        return index < mElements.size() ? index : END;
+    }
+
+    void eraseSlot(size_t slot)
+    {
+        const size_t index = mSlots[slot].mIndex;
+        mElements[index].reset();
+        mFreeElements.push_back(index);
+        --mSize;
+
+        // backward-shift deletion: no tombstones, so lookups never degrade after erasures
+        const size_t mask = mSlots.size() - 1;
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask; mSlots[next].mIndex != END; next = (next + 1) & mask)
+        {
+            const size_t ideal = idealSlot(mSlots[next].mKey);
+            if (((next - ideal) & mask) >= ((next - hole) & mask))
+            {
+                mSlots[hole] = mSlots[next];
+                hole = next;
+            }
+        }
+        mSlots[hole] = Slot();
+    }
+
+    void rehash(size_t numSlots)
+    {
+        std::vector<Slot> oldSlots(numSlots);
+        oldSlots.swap(mSlots);
+
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < numSlots)
+        {
+            ++bits;
+        }
+        mShift = 64 - bits;
+
+        for (const Slot& s: oldSlots)
+        {
+            if (s.mIndex == END)
+            {
+                continue;
+            }
+
+            size_t slot = idealSlot(s.mKey);
+            while (mSlots[slot].mIndex != END)
+            {
+                slot = (slot + 1) & (numSlots - 1);
+            }
+            mSlots[slot] = s;
+        }
+    }
+
+    unsigned mShift = 64;
+};
+
+} // namespace
+
+#endif
@@ -24,17 +24,20 @@
 #define NODEMANAGER_H 1
 
 #include "node.h"
+#include "nodetreesnapshot.h"
 #include "types.h"
 
 #include <limits>
 #include <map>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
 namespace mega {
 
 class DBTableNodes;
+class DBTableNodesReader;
 struct FileFingerprint;
 class FingerprintContainer;
 class MegaClient;
@@ -374,7 +377,52 @@ public:
     // read children from DB and load them in memory
     sharedNode_list getChildren(const Node* parent, CancelToken cancelToken = CancelToken());
 
-    sharedNode_vector getChildren(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page);
+    /**
+     * @brief Rows read for a look-up from a read-only connection of the DB.
+     *
+     * Look-ups from app threads (getChildren, searchNodes and listAllNodesByPage) can be done in
+     * two steps, so the DB query neither waits for the SDK thread nor blocks it. First, prefetch*()
+     * reads the rows from a read-only connection without any lock of the SDK held (neither
+     * MegaApiImpl's sdkMutex nor mMutex). Then the look-up is called as usual, holding the same
+     * locks as any other access to the nodes, and the nodes are built from the prefetched rows.
+     * If no connection was available, or the nodes have been modified meanwhile, the rows are read
+     * again from the main connection.
+     *
+     * A prefetch can only be passed to the look-up it was made for, with the same parameters.
+     */
+    class DbPrefetch
+    {
+    public:
+        // out of line, as DBTableNodesReader and NodeSerialized are incomplete here
+        DbPrefetch();
+        DbPrefetch(DbPrefetch&&);
+        DbPrefetch& operator=(DbPrefetch&&);
+        ~DbPrefetch();
+
+    private:
+        friend class NodeManager;
+
+        std::unique_ptr<DBTableNodesReader> mReader;
+        std::vector<std::pair<NodeHandle, NodeSerialized>> mRows;
+        bool mFound = false;
+    };
+
+    DbPrefetch prefetchChildren(const NodeSearchFilter& filter,
+                                int order,
+                                CancelToken cancelFlag,
+                                const NodeSearchPage& page);
+    DbPrefetch prefetchSearch(const NodeSearchFilter& filter,
+                              int order,
+                              CancelToken cancelFlag,
+                              const NodeSearchPage& page);
+    DbPrefetch prefetchListAllNodesByPage(const ListAllNodesParams& params,
+                                          CancelToken cancelFlag);
+
+    sharedNode_vector getChildren(const NodeSearchFilter& filter,
+                                  int order,
+                                  CancelToken cancelFlag,
+                                  const NodeSearchPage& page,
+                                  DbPrefetch* prefetch = nullptr);
 
     // get up to "maxcount" nodes, not older than "since", ordered by creation time
     // Note: nodes are read from DB and loaded in memory
@@ -382,7 +430,11 @@ public:
                                      m_time_t since,
                                      bool excludeSensitives = false);
 
-    sharedNode_vector searchNodes(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page);
+    sharedNode_vector searchNodes(const NodeSearchFilter& filter,
+                                  int order,
+                                  CancelToken cancelFlag,
+                                  const NodeSearchPage& page,
+                                  DbPrefetch* prefetch = nullptr);
 
     sharedNode_vector listChildNodesLexicographically(
         const handle parenthandle,
@@ -413,7 +465,9 @@ public:
      *         result, no valid root resolved (e.g. rootnodes not yet
      *         populated), or end of pagination.
      */
-    sharedNode_vector listAllNodesByPage(const ListAllNodesParams& params, CancelToken cancelFlag);
+    sharedNode_vector listAllNodesByPage(const ListAllNodesParams& params,
+                                         CancelToken cancelFlag,
+                                         DbPrefetch* prefetch = nullptr);
 
     /*
      * @brief
@@ -515,6 +569,15 @@ public:
     // update the counter of 'n' when its parent is updated (from 'oldParent' to 'n.parent')
     void updateCounter(std::shared_ptr<Node> n, std::shared_ptr<Node> oldParent);
 
+    // The updates of tree counters (node moves, additions and versions) are accumulated per node
+    // instead of being propagated up to the root each time. They are merged and propagated, once
+    // per ancestor, by flushTreeCounters(): before each DB commit, or earlier if a counter pending
+    // an update is needed (see getNodeCounter())
+    void flushTreeCounters();
+
+    // counter of 'n' (and its subtree), including the updates not propagated yet
+    NodeCounter getNodeCounter(const Node& n);
+
     // true if 'h' is a rootnode: cloud, inbox or rubbish bin
     bool isRootNode(NodeHandle h) const;
 
@@ -527,7 +590,6 @@ public:
     // Remove fingerprint from mFingerprint
     void removeFingerprint(Node* node, bool unloadNode = false);
     FingerprintPosition invalidFingerprintPos();
-    std::list<std::shared_ptr<Node>>::const_iterator invalidCacheLRUPos() const;
 
     // Node has received last updates and it's ready to store in DB
     void saveNodeInDb(Node *node);
@@ -560,12 +622,28 @@ public:
     void checkOrphanNodes(MissingParentNodes& nodesWithMissingParent);
 
     // This method is called when initial fetch nodes is finished
-    // Initialize node counters and create indexes at DB
+    // Initialize node counters and schedule the creation of indexes at DB
     void initCompleted();
+
+    // Indexes at DB are created after fetchnodes (or after loading nodes from cache, if some is
+    // missing), one per call, so the SDK thread isn't blocked until all of them are ready.
+    // Returns true while more indexes are pending
+    bool createNextPendingIndex();
+    bool hasPendingIndexes() const;
     // Drop indexes used for search funtionalities
     // These indexes aren't required in some apps (S4)
     void dropSearchDBIndexes();
     void dropLexicographicDBIndexes();
+    void dropFullTextDBIndex();
+    void dropAncestorDBIndex();
+
+    // Map the snapshot of the node tree at 'path', if it was written for the state in the DB
+    // ('scsn'). Until the tree changes, children counts, ancestors, children by name, root nodes
+    // and shares are looked up in the snapshot instead of the DB
+    void openNodeTreeSnapshot(const LocalPath& path, handle scsn);
+    // Write the snapshot of the node tree in the DB, whose state is the one at 'scsn'
+    bool writeNodeTreeSnapshot(FileSystemAccess& fsAccess, const LocalPath& path, handle scsn);
+    void dropNodeTreeSnapshot();
 
     std::shared_ptr<Node> getNodeFromNodeManagerNode(NodeManagerNode& nodeManagerNode);
 
@@ -582,6 +660,17 @@ public:
 
     uint64_t getNumNodesAtCacheLRU() const;
 
+    struct CacheLRUStats
+    {
+        // lookups by handle resolved with nodes already loaded in RAM
+        uint64_t hits = 0;
+        // lookups by handle that required a query to the DB
+        uint64_t misses = 0;
+        // nodes unloaded from the cache LRU because it was full
+        uint64_t evictions = 0;
+    };
+    CacheLRUStats getCacheLRUStats() const;
+
     // true when the filesystem has been initialized
     // i.e., when nodes have been fully loaded from a fetchnodes or from cache
     bool ready();
@@ -660,19 +749,61 @@ private:
     };
 
     // Stores nodes that have been loaded in RAM from DB (not necessarily all of them)
-    std::map<NodeHandle, NodeManagerNode> mNodes;
+    NodeHandleMap<NodeManagerNode> mNodes;
+
+    // Guards mNodes for the lookups done without mMutex (getNodeByHandle() hits), so app threads
+    // don't wait for the SDK thread while it applies action packets. mNodes (its entries and the
+    // node each one refers to) is only changed holding mMutex and this one exclusively, so code
+    // holding mMutex can read it without taking this one.
+    std::shared_mutex mNodesLookupMutex;
+
+    // node loaded in RAM with this handle, if any, without taking mMutex
+    std::shared_ptr<Node> getLoadedNode(NodeHandle handle);
 
     // If the number of children of a node is greater than this threshold, skip the RAM scan
     size_t mChildScanDbThreshold{3000};
 
     uint64_t mCacheLRUMaxSize = std::numeric_limits<uint64_t>::max();
-    std::list<std::shared_ptr<Node> > mCacheLRU;
+
+    // Intrusive list of the nodes at the cache LRU, most recently used first. The hooks are
+    // stored at NodeManagerNode, so adding or refreshing a node doesn't allocate memory.
+    class NodeCacheLRU
+    {
+    public:
+        void pushFront(NodeManagerNode& nodeManagerNode, std::shared_ptr<Node> node);
+        // unlinks the node and returns the reference that was keeping it in RAM
+        std::shared_ptr<Node> remove(NodeManagerNode& nodeManagerNode);
+        // unlinks all the nodes, which are released once the list is empty
+        void clear();
+        NodeManagerNode* front() const;
+        NodeManagerNode* back() const;
+        uint64_t size() const;
+
+    private:
+        NodeManagerNode* mFront = nullptr;
+        NodeManagerNode* mBack = nullptr;
+        uint64_t mSize = 0;
+    } mCacheLRU;
+
+    std::atomic<uint64_t> mCacheLRUHits{0};
+    std::atomic<uint64_t> mCacheLRUMisses{0};
+    std::atomic<uint64_t> mCacheLRUEvictions{0};
 
     std::atomic<uint64_t> mNodesInRam;
 
     // nodes that have changed and are pending to notify to app and dump to DB
     sharedNode_vector mNodeNotify;
 
+    // tree counter updates not propagated to the ancestors yet
+    struct PendingTreeCounter
+    {
+        std::shared_ptr<Node> node;
+        NodeCounter delta;
+    };
+    std::map<NodeHandle, PendingTreeCounter> mPendingTreeCounters;
+    // nodes with pending updates and their ancestors: their counters are not up to date
+    std::set<NodeHandle> mOutdatedTreeCounters;
+
     // Stores nodes pending key application
     std::unordered_map<handle, std::weak_ptr<Node>> mNodePendingApplyKeys;
 
@@ -698,7 +829,8 @@ private:
     shared_ptr<Node> getNodeFromNodeSerialized(const NodeSerialized& nodeSerialized);
 
     // reads from DB and loads the node in memory
-    shared_ptr<Node> unserializeNode(const string*, bool fromOldCache);
+    // the node is decoded in place: d only has to stay valid during the call
+    shared_ptr<Node> unserializeNode(std::string_view d, bool fromOldCache);
 
     // returns the counter for the specified node, calculating it recursively and accessing to DB if it's neccesary
     NodeCounter calculateNodeCounter(const NodeHandle &nodehandle, nodetype_t parentType, std::shared_ptr<Node> node, bool isInRubbish);
@@ -718,23 +850,63 @@ private:
     // If a valid object is passed, it must be kept alive until this method returns.
     sharedNode_vector processUnserializedNodes(const std::vector<std::pair<NodeHandle, NodeSerialized>>& nodesFromTable, NodeHandle ancestorHandle = NodeHandle(), CancelToken cancelFlag = CancelToken());
 
+    // The look-ups below take the rows from 'prefetch', if any (see DbPrefetch)
     sharedNode_vector searchNodes_internal(const NodeSearchFilter& filter,
                                            int order,
                                            CancelToken cancelFlag,
-                                           const NodeSearchPage& page);
+                                           const NodeSearchPage& page,
+                                           DbPrefetch* prefetch = nullptr);
     sharedNode_vector processUnserializedNodes(const std::vector<std::pair<NodeHandle, NodeSerialized>>& nodesFromTable, CancelToken cancelFlag);
-    sharedNode_vector getChildren_internal(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page);
+    sharedNode_vector getChildren_internal(const NodeSearchFilter& filter,
+                                           int order,
+                                           CancelToken cancelFlag,
+                                           const NodeSearchPage& page,
+                                           DbPrefetch* prefetch = nullptr);
     sharedNode_vector getRecentNodes_internal(const NodeSearchPage& page, m_time_t since);
+    sharedNode_vector listAllNodesByPage_internal(const ListAllNodesParams& params,
+                                                  CancelToken cancelFlag,
+                                                  DbPrefetch* prefetch = nullptr);
+
+    using NodeRows = std::vector<std::pair<NodeHandle, NodeSerialized>>;
+    using DbLookUp = std::function<bool(DBTableNodes&, NodeRows&)>;
+
+    // Runs 'lookUp' on a read-only connection of the DB, if one is available. It must be called
+    // without holding mMutex, so the SDK thread isn't blocked meanwhile
+    DbPrefetch prefetch(const DbLookUp& lookUp);
+
+    // Rows of a look-up: the ones of 'prefetch', if it's still valid, or read from mTable
+    bool lookUpInDb(DbPrefetch* prefetch, NodeRows& rows, const DbLookUp& lookUp);
 
     // node temporary in memory, which will be removed upon write to DB
     std::shared_ptr<Node> mNodeToWriteInDb;
 
+    // nodes received by fetchnodes, pending to be written to the DB in batches
+    sharedNode_vector mFetchedNodesToPut;
+    // size of mFetchedNodesToPut that triggers the write. It bounds the memory held by the nodes
+    // that are not kept in RAM
+    static constexpr size_t FETCHED_NODES_PER_PUT = 1000;
+    // Writes mFetchedNodesToPut to the DB. Called before any other access to the DB, so it doesn't
+    // miss those nodes
+    void putFetchedNodesInDb_internal();
+
     // Stores (or updates) the node in the DB. It also tries to decrypt it for the last time before storing it.
     void putNodeInDb(Node* node) const;
+    // Same as putNodeInDb() for several nodes, which are written in batches. 'nodes' is cleared.
+    void putNodesInDb(sharedNode_vector& nodes) const;
+    // Last attempt to decrypt the node before storing it in the DB
+    void prepareNodeForDb(Node* node) const;
 
     // true when the NodeManager has been inicialized and contains a valid filesystem
     bool mInitialized = false;
 
+    // snapshot of the node tree loaded from the DB, dropped upon the first change
+    std::unique_ptr<NodeTreeSnapshot> mNodeTreeSnapshot;
+    void dropNodeTreeSnapshot_internal();
+
+    // true when some index at DB has been scheduled and it's not created yet
+    bool mPendingIndexes = false;
+    void scheduleIndexes();
+
     // flag that determines if null root nodes error has already been reported
     bool mNullRootNodesReported{false};
 
@@ -783,6 +955,7 @@ private:
     uint64_t getNodeCount_internal();
     NodeCounter getCounterOfRootNodes_internal();
     void updateCounter_internal(std::shared_ptr<Node> n, std::shared_ptr<Node> oldParent);
+    void flushTreeCounters_internal();
     bool setrootnode_internal(std::shared_ptr<Node> node);
     FingerprintPosition insertFingerprint_internal(Node* node);
     void removeFingerprint_internal(Node* node, bool unloadNode);
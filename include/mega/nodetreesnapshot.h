@@ -0,0 +1,115 @@
+/**
+ * @file mega/nodetreesnapshot.h
+ * @brief Read-only image of the node tree, memory-mapped on session resumption
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#ifndef MEGA_NODETREESNAPSHOT_H
+#define MEGA_NODETREESNAPSHOT_H 1
+
+#include "types.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mega {
+
+class FileSystemAccess;
+class LocalPath;
+
+// Structure of the tree of nodes, as read from the DB to build a NodeTreeSnapshot
+struct NodeTreeEntry
+{
+    NodeHandle handle;
+    NodeHandle parent;
+    nodetype_t type = TYPE_UNKNOWN;
+    int share = NO_SHARES; // ShareType_t bits
+    std::string name;
+};
+
+// Compact image of the node tree (handles, parents, types, share flags and names) written when
+// a session is saved and memory-mapped when it's resumed. Queries on the structure of the tree
+// are answered from it until the first change, without waiting for the DB (its page cache and
+// its indexes) to warm up.
+//
+// The file is only valid for the state committed to the DB at the same SCSN. Its content is
+// checked lazily: a corrupt file can produce wrong answers, but no out-of-bounds reads.
+class NodeTreeSnapshot
+{
+public:
+    ~NodeTreeSnapshot();
+
+    NodeTreeSnapshot(const NodeTreeSnapshot&) = delete;
+    NodeTreeSnapshot& operator=(const NodeTreeSnapshot&) = delete;
+
+    // write the snapshot of 'entries' for the state at 'scsn' (replaces any existing file)
+    static bool write(FileSystemAccess& fsAccess,
+                      const LocalPath& path,
+                      handle scsn,
+                      std::vector<NodeTreeEntry>&& entries);
+
+    // map the snapshot at 'path', if it's well formed and it was written at 'scsn'
+    static std::unique_ptr<NodeTreeSnapshot> open(const LocalPath& path, handle scsn);
+
+    size_t numNodes() const;
+
+    bool contains(NodeHandle h) const;
+
+    // number of children of 'parent' (of 'type' if defined), or nullopt if it's not in the snapshot
+    std::optional<size_t> numChildren(NodeHandle parent,
+                                      std::optional<nodetype_t> type = std::nullopt) const;
+
+    // whether 'ancestor' is above 'node', or nullopt if 'node' is not in the snapshot
+    std::optional<bool> isAncestor(NodeHandle node, NodeHandle ancestor) const;
+
+    // handle of the child of 'parent' with 'name' and 'type' (undefined if there is none), or
+    // nullopt if 'parent' is not in the snapshot
+    std::optional<NodeHandle>
+        childByNameType(NodeHandle parent, const std::string& name, nodetype_t type) const;
+
+    // handles of the root nodes (ROOTNODE, VAULTNODE and RUBBISHNODE) present in the snapshot
+    std::vector<NodeHandle> rootNodes() const;
+
+    // handles of the nodes with any of the 'shareType' bits
+    std::vector<NodeHandle> nodesWithSharesOrLink(ShareType_t shareType) const;
+
+private:
+    struct Header;
+    struct Record;
+
+    NodeTreeSnapshot(const char* data, size_t size);
+
+    const Header& header() const;
+    const Record* records() const;
+    const uint32_t* children() const;
+    const uint32_t* shared() const;
+    const char* names() const;
+
+    // record of 'h', or nullptr
+    const Record* find(NodeHandle h) const;
+
+    // mapped file
+    const char* mData = nullptr;
+    size_t mSize = 0;
+};
+
+} // namespace mega
+
+#endif
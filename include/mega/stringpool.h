@@ -0,0 +1,139 @@
+/**
+ * @file mega/stringpool.h
+ * @brief Immutable refcounted strings, optionally interned in a pool
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#ifndef MEGA_STRINGPOOL_H
+#define MEGA_STRINGPOOL_H 1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace mega {
+
+class StringPool;
+
+// Handle to an immutable string, shared by all its copies (copying it only increments a
+// counter). The string is freed when the last handle goes away and, if it was interned, it's
+// removed from its pool at the same time.
+// A default constructed handle is null: c_str() returns nullptr.
+class SharedString
+{
+public:
+    SharedString() = default;
+
+    // a string of its own, not interned
+    explicit SharedString(std::string_view s);
+
+    SharedString(const SharedString& other);
+    SharedString(SharedString&& other) noexcept;
+    SharedString& operator=(const SharedString& other);
+    SharedString& operator=(SharedString&& other) noexcept;
+    ~SharedString();
+
+    // null terminated, or nullptr for a null handle
+    const char* c_str() const;
+
+    std::string_view view() const;
+
+    size_t size() const;
+
+    bool isNull() const
+    {
+        return !mEntry;
+    }
+
+    // whether both handles share the same string
+    bool sharesWith(const SharedString& other) const
+    {
+        return mEntry == other.mEntry;
+    }
+
+    bool operator==(const SharedString& other) const
+    {
+        return mEntry == other.mEntry || (mEntry && other.mEntry && view() == other.view());
+    }
+
+    bool operator!=(const SharedString& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    friend class StringPool;
+
+    struct Entry;
+
+    explicit SharedString(Entry* entry);
+
+    void release();
+
+    Entry* mEntry = nullptr;
+};
+
+// Set of distinct strings, so values that repeat a lot (like node names) are stored only once.
+// It's thread safe, and it must outlive the strings interned in it.
+class StringPool
+{
+public:
+    StringPool() = default;
+    ~StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // handle to the copy of 's' in the pool (added if it's not there yet)
+    SharedString intern(std::string_view s);
+
+    struct Stats
+    {
+        // distinct strings in the pool
+        size_t strings = 0;
+
+        // handles to them
+        size_t references = 0;
+
+        // memory taken by the strings and the index (approximate)
+        size_t bytes = 0;
+    };
+
+    Stats stats() const;
+
+    // pool for the names of the nodes returned to the apps (MegaNode)
+    static StringPool& nodeNames();
+
+private:
+    friend class SharedString;
+
+    // remove 'entry' if its last handle is being released
+    void release(SharedString::Entry* entry);
+
+    mutable std::mutex mMutex;
+
+    // keys are views of the data of the entries
+    std::unordered_map<std::string_view, SharedString::Entry*> mEntries;
+};
+
+} // namespace mega
+
+#endif
@@ -32,6 +32,7 @@
 
 #ifdef ENABLE_SYNC
 #include "node.h"
+#include "syncinternals/statecachejournal.h"
 #include "syncinternals/syncinternals.h"
 #include "syncinternals/synciuploadthrottlingmanager.h"
 
@@ -543,6 +544,12 @@ public:
     // track how recent the last received fs noticiation was
     dstime lastFSNotificationTime = 0;
 
+    // the names (toName_of_localname) of all our LocalNodes.  Must outlive localroot.
+    SyncNameArena mLocalNodeNames;
+
+    // gives back the space of removed and renamed LocalNodes' names, if worthwhile
+    void compactLocalNodeNames();
+
     // root of local filesystem tree, holding the sync's root folder.  Never null except briefly in the destructor (to ensure efficient db usage)
     unique_ptr<LocalNode> localroot;
 
@@ -559,21 +566,24 @@ public:
     // syncing to an inbound share?
     bool inshare = false;
 
-    // insertion/update queue
-    localnode_set insertq;
+    // LocalNodes to be written to (or deleted from) statecachetable
+    StateCacheJournal<LocalNode> mStateCacheJournal;
 
-    // adds an entry to the delete queue - removes it from insertq
+    // adds a deletion to the journal - and drops any pending write of the node
     void statecachedel(LocalNode*);
 
-    // adds an entry to the insert queue - removes it from deleteq
+    // adds a write to the journal
     void statecacheadd(LocalNode*);
 
     // recursively add children
     void addstatecachechildren(uint32_t, idlocalnode_map*, LocalPath&, LocalNode*, int);
 
-    // Caches all synchronized LocalNode
+    // Caches all synchronized LocalNode (flushes the journal now)
     void cachenodes();
 
+    // Flushes the journal if it's due: busy syncs keep coalescing changes for a while
+    void cachenodesIfDue();
+
     // change state, signal to application
     void changestate(SyncError newSyncError, bool newEnableFlag, bool notifyApp, bool keepSyncDb);
 
@@ -0,0 +1,195 @@
+/**
+ * @file scannedfingerprints.h
+ * @brief The scanned fingerprints of a LocalNode, stored apart only when they differ from the
+ * synced one.
+ */
+
+#ifndef MEGA_SYNCINTERNALS_SCANNEDFINGERPRINTS_H
+#define MEGA_SYNCINTERNALS_SCANNEDFINGERPRINTS_H 1
+
+#ifdef ENABLE_SYNC
+
+#include "mega/filefingerprint.h"
+
+namespace mega
+{
+
+/**
+ * @class ScannedFingerprints
+ * @brief The fingerprint of the last scan of a file and the one the filesystem really reported.
+ *
+ * Both are the same, except on Android, where the mtime of downloaded files can't be set. And
+ * once a file is synced they are also the same as its synced fingerprint (for folders, they are
+ * all blank). So each one refers to the previous one (real scanned -> scanned -> synced) unless
+ * it differs, and only then a copy is allocated: 16 bytes instead of two fingerprints for most
+ * LocalNodes.
+ *
+ * The synced fingerprint is owned by the LocalNode, so it's passed to every call. It must not
+ * change without calling syncedChanging() first.
+ */
+class ScannedFingerprints
+{
+public:
+    ScannedFingerprints() = default;
+
+    ScannedFingerprints(const ScannedFingerprints&) = delete;
+    ScannedFingerprints& operator=(const ScannedFingerprints&) = delete;
+
+    ~ScannedFingerprints()
+    {
+        if (ownsScanned())
+        {
+            delete mScanned;
+        }
+        delete mRealScanned;
+    }
+
+    const FileFingerprint& scanned(const FileFingerprint& synced) const
+    {
+        if (!mScanned)
+        {
+            return blank();
+        }
+        return mScanned == sameAsSynced() ? synced : *mScanned;
+    }
+
+    const FileFingerprint& realScanned(const FileFingerprint& synced) const
+    {
+        return mRealScanned ? *mRealScanned : scanned(synced);
+    }
+
+    void setScanned(FileFingerprint fingerprint, const FileFingerprint& synced)
+    {
+        // the real one keeps its value, unless there was none yet
+        const auto& previous = scanned(synced);
+        if (!mRealScanned && !same(previous, blank()) && !same(fingerprint, previous))
+        {
+            mRealScanned = new FileFingerprint(previous);
+        }
+
+        if (same(fingerprint, blank()))
+        {
+            resetScanned(nullptr);
+        }
+        else if (same(fingerprint, synced))
+        {
+            resetScanned(sameAsSynced());
+        }
+        else if (ownsScanned())
+        {
+            *mScanned = fingerprint;
+        }
+        else
+        {
+            mScanned = new FileFingerprint(fingerprint);
+        }
+
+        dropRealScannedIfSame(synced);
+    }
+
+    void setRealScanned(FileFingerprint fingerprint, const FileFingerprint& synced)
+    {
+        if (same(fingerprint, scanned(synced)))
+        {
+            delete mRealScanned;
+            mRealScanned = nullptr;
+        }
+        else if (mRealScanned)
+        {
+            *mRealScanned = fingerprint;
+        }
+        else
+        {
+            mRealScanned = new FileFingerprint(fingerprint);
+        }
+    }
+
+    /**
+     * @brief To be called before the synced fingerprint changes from 'synced' to 'next'.
+     */
+    void syncedChanging(const FileFingerprint& synced, const FileFingerprint& next)
+    {
+        if (mScanned == sameAsSynced() && !same(synced, next))
+        {
+            mScanned = new FileFingerprint(synced);
+        }
+    }
+
+    /**
+     * @brief To be called after the synced fingerprint has changed, to share it again if possible.
+     */
+    void syncedChanged(const FileFingerprint& synced)
+    {
+        if (ownsScanned() && !same(synced, blank()) && same(*mScanned, synced))
+        {
+            resetScanned(sameAsSynced());
+        }
+        dropRealScannedIfSame(synced);
+    }
+
+    /**
+     * @brief Bytes allocated for fingerprints stored apart.
+     */
+    size_t allocatedBytes() const
+    {
+        return (ownsScanned() ? sizeof(FileFingerprint) : 0) +
+               (mRealScanned ? sizeof(FileFingerprint) : 0);
+    }
+
+    /**
+     * @brief Whether the fingerprints are exactly the same (FileFingerprint::operator== has a
+     * tolerance for mtime and ignores invalid fingerprints).
+     */
+    static bool same(const FileFingerprint& a, const FileFingerprint& b)
+    {
+        return a.size == b.size && a.mtime == b.mtime && a.isvalid == b.isvalid && a.crc == b.crc;
+    }
+
+private:
+    static const FileFingerprint& blank()
+    {
+        static const FileFingerprint fingerprint;
+        return fingerprint;
+    }
+
+    // marks a scanned fingerprint that is the synced one (never dereferenced)
+    static FileFingerprint* sameAsSynced()
+    {
+        static FileFingerprint marker;
+        return &marker;
+    }
+
+    bool ownsScanned() const
+    {
+        return mScanned && mScanned != sameAsSynced();
+    }
+
+    void resetScanned(FileFingerprint* scanned)
+    {
+        if (ownsScanned())
+        {
+            delete mScanned;
+        }
+        mScanned = scanned;
+    }
+
+    void dropRealScannedIfSame(const FileFingerprint& synced)
+    {
+        if (mRealScanned && same(*mRealScanned, scanned(synced)))
+        {
+            delete mRealScanned;
+            mRealScanned = nullptr;
+        }
+    }
+
+    // nullptr: blank, sameAsSynced(): the synced one, otherwise a copy of its own
+    FileFingerprint* mScanned = nullptr;
+
+    // nullptr: the scanned one
+    FileFingerprint* mRealScanned = nullptr;
+};
+
+} // namespace mega
+
+#endif // ENABLE_SYNC
+#endif // MEGA_SYNCINTERNALS_SCANNEDFINGERPRINTS_H
@@ -0,0 +1,461 @@
+/**
+ * @file sortedchildindex.h
+ * @brief Contiguous index of the children of a LocalNode, sorted by name.
+ */
+
+#ifndef MEGA_SYNCINTERNALS_SORTEDCHILDINDEX_H
+#define MEGA_SYNCINTERNALS_SORTEDCHILDINDEX_H 1
+
+#ifdef ENABLE_SYNC
+
+#include "mega/filesystem.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace mega
+{
+
+/**
+ * @class SortedChildIndex
+ * @brief Children of a folder, by name, in a single vector.
+ *
+ * The children are kept in the order the sync matches names (see Sync::computeSyncTriplets): by
+ * their normalized name, case insensitively if the sync is, and then by their localname. That
+ * way they can be merged with the sorted cloud and filesystem children in a single pass.
+ *
+ * Children added in order are appended. The others go to a short unsorted tail, which is merged
+ * once it's too long to be searched linearly, or when the children are needed in order. Removing
+ * the first child only skips it, so removing all of them in order is linear as well. Removing
+ * any other sorted child leaves an empty slot, skipped by the iterators and find(), so it doesn't
+ * move the rest of the children: the slots are dropped when the tail is merged, or once they are
+ * a good part of the vector.
+ *
+ * The order of iteration is only guaranteed after sort(). Adding or removing children
+ * invalidates the iterators.
+ *
+ * @tparam Child Node type with its LocalPath localname and its normalized name
+ * toName_of_localname (convertible to std::string_view), as LocalNode.
+ */
+template<typename Child>
+class SortedChildIndex
+{
+    // Iterates over the children of the vector, skipping the empty slots
+    template<typename Base>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Child*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::iterator_traits<Base>::pointer;
+        using reference = typename std::iterator_traits<Base>::reference;
+
+        Iterator() = default;
+
+        Iterator(Base it, Base end):
+            mIt(it),
+            mEnd(end)
+        {
+            skipEmpty();
+        }
+
+        // an iterator is also a const_iterator
+        template<typename Other,
+                 typename = std::enable_if_t<std::is_convertible_v<Other, Base> &&
+                                             !std::is_same_v<Other, Base>>>
+        Iterator(const Iterator<Other>& other):
+            mIt(other.base()),
+            mEnd(other.baseEnd())
+        {}
+
+        reference operator*() const
+        {
+            return *mIt;
+        }
+
+        Iterator& operator++()
+        {
+            ++mIt;
+            skipEmpty();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+
+        // there must be a child before
+        Iterator& operator--()
+        {
+            do
+            {
+                --mIt;
+            }
+            while (!*mIt);
+            return *this;
+        }
+
+        Iterator operator--(int)
+        {
+            auto result = *this;
+            --*this;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return mIt == other.mIt;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return mIt != other.mIt;
+        }
+
+        Base base() const
+        {
+            return mIt;
+        }
+
+        Base baseEnd() const
+        {
+            return mEnd;
+        }
+
+    private:
+        void skipEmpty()
+        {
+            while (mIt != mEnd && !*mIt)
+            {
+                ++mIt;
+            }
+        }
+
+        Base mIt{};
+        Base mEnd{};
+    };
+
+public:
+    using iterator = Iterator<typename std::vector<Child*>::iterator>;
+    using const_iterator = Iterator<typename std::vector<Child*>::const_iterator>;
+
+    /**
+     * @brief Compares two children (or a name and a child) in the order of the index.
+     */
+    static int compare(std::string_view name1,
+                       const LocalPath& localname1,
+                       std::string_view name2,
+                       const LocalPath& localname2,
+                       bool caseInsensitive)
+    {
+        if (int result = compareUtf(name1, false, name2, false, caseInsensitive))
+        {
+            return result;
+        }
+
+        if (localname1 < localname2)
+        {
+            return -1;
+        }
+
+        return localname2 < localname1 ? 1 : 0;
+    }
+
+    static int compare(const Child& child1, const Child& child2, bool caseInsensitive)
+    {
+        return compare(child1.toName_of_localname,
+                       child1.localname,
+                       child2.toName_of_localname,
+                       child2.localname,
+                       caseInsensitive);
+    }
+
+    iterator begin()
+    {
+        return iterator(mChildren.begin() + static_cast<std::ptrdiff_t>(mFirst), mChildren.end());
+    }
+
+    iterator end()
+    {
+        return iterator(mChildren.end(), mChildren.end());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(mChildren.cbegin() + static_cast<std::ptrdiff_t>(mFirst),
+                              mChildren.cend());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(mChildren.cend(), mChildren.cend());
+    }
+
+    size_t size() const
+    {
+        return mChildren.size() - mFirst - mErased;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief The child called 'localname', or end() if there is none.
+     *
+     * @param name The normalized version of 'localname', as in Child::toName_of_localname.
+     */
+    iterator find(const LocalPath& localname, std::string_view name, bool caseInsensitive)
+    {
+        // Binary search of the sorted children. An empty slot is taken as the next child, or as
+        // the end of the sorted children if there is none: the order is the same.
+        size_t low = mFirst;
+        size_t high = mSortedEnd;
+        while (low < high)
+        {
+            auto middle = low + (high - low) / 2;
+            auto next = middle;
+            while (next < high && !mChildren[next])
+            {
+                ++next;
+            }
+
+            if (next < high && compare(mChildren[next]->toName_of_localname,
+                                       mChildren[next]->localname,
+                                       name,
+                                       localname,
+                                       caseInsensitive) < 0)
+            {
+                low = next + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        while (low < mSortedEnd && !mChildren[low])
+        {
+            ++low;
+        }
+
+        if (low < mSortedEnd && mChildren[low]->localname == localname)
+        {
+            return iterator(mChildren.begin() + static_cast<std::ptrdiff_t>(low), mChildren.end());
+        }
+
+        auto sortedEnd = mChildren.begin() + static_cast<std::ptrdiff_t>(mSortedEnd);
+        auto it = std::find_if(sortedEnd,
+                               mChildren.end(),
+                               [&localname](const Child* child)
+                               {
+                                   return child->localname == localname;
+                               });
+        return iterator(it, mChildren.end());
+    }
+
+    /**
+     * @brief Adds 'child', in place of any other child with the same localname.
+     */
+    void insert(Child* child, bool caseInsensitive)
+    {
+        if (mSortedEnd == mChildren.size() &&
+            (empty() || compare(*mChildren.back(), *child, caseInsensitive) < 0))
+        {
+            // the usual case: the sync creates the children of a folder in this order
+            mChildren.push_back(child);
+            ++mSortedEnd;
+            return;
+        }
+
+        auto it = find(child->localname, child->toName_of_localname, caseInsensitive);
+        if (it != end())
+        {
+            *it = child;
+            return;
+        }
+
+        mChildren.push_back(child);
+
+        // merge the tail before searching it costs more than a binary search of all the children
+        auto unsorted = mChildren.size() - mSortedEnd;
+        if (unsorted > MAX_UNSORTED && unsorted * unsorted > size())
+        {
+            sort(caseInsensitive);
+        }
+    }
+
+    void erase(iterator it)
+    {
+        auto pos = static_cast<size_t>(it.base() - mChildren.begin());
+
+        if (pos >= mSortedEnd)
+        {
+            // the tail is not sorted: the last child can take this place
+            *it.base() = mChildren.back();
+            mChildren.pop_back();
+        }
+        else if (pos == mFirst)
+        {
+            // skipped, along with the empty slots after it
+            ++mFirst;
+            while (mFirst < mSortedEnd && !mChildren[mFirst])
+            {
+                ++mFirst;
+                --mErased;
+            }
+
+            // release the skipped entries once they are most of the vector
+            if (mFirst == mChildren.size())
+            {
+                clear();
+            }
+            else if (mFirst > MAX_UNSORTED && mFirst * 2 > mChildren.size())
+            {
+                compact();
+            }
+        }
+        else if (pos + 1 == mChildren.size())
+        {
+            // the last one, without a tail
+            mChildren.pop_back();
+            --mSortedEnd;
+        }
+        else
+        {
+            *it.base() = nullptr;
+            ++mErased;
+
+            if (mErased > MAX_UNSORTED && mErased * 4 > mChildren.size() - mFirst)
+            {
+                compact();
+            }
+        }
+
+        if (empty())
+        {
+            clear();
+            return;
+        }
+
+        // without a tail, the last child is the one to compare with when appending
+        if (mSortedEnd == mChildren.size())
+        {
+            while (!mChildren.back())
+            {
+                mChildren.pop_back();
+                --mSortedEnd;
+                --mErased;
+            }
+        }
+    }
+
+    void clear()
+    {
+        std::vector<Child*>().swap(mChildren);
+        mFirst = 0;
+        mSortedEnd = 0;
+        mErased = 0;
+    }
+
+    /**
+     * @brief Puts the children in order, merging the unsorted tail if there is one.
+     *
+     * The order is not part of the logical state of the index, so this is allowed on a const
+     * index (not concurrently, though).
+     */
+    void sort(bool caseInsensitive) const
+    {
+        if (mSortedEnd == mChildren.size())
+        {
+            return;
+        }
+
+        compact();
+
+        auto less = [caseInsensitive](const Child* a, const Child* b)
+        {
+            return compare(*a, *b, caseInsensitive) < 0;
+        };
+
+        auto first = mChildren.begin();
+        auto middle = mChildren.begin() + static_cast<std::ptrdiff_t>(mSortedEnd);
+        std::vector<Child*> tail(middle, mChildren.end());
+        std::sort(tail.begin(), tail.end(), less);
+
+        // From the back, each child of the tail goes right after the sorted children that are
+        // not greater: the tail is short, so comparing only there is much cheaper than merging.
+        auto sortedEnd = middle;
+        auto out = mChildren.end();
+        for (auto t = tail.rbegin(); t != tail.rend(); ++t)
+        {
+            auto pos = std::upper_bound(first, sortedEnd, *t, less);
+            out = std::move_backward(pos, sortedEnd, out);
+            *--out = *t;
+            sortedEnd = pos;
+        }
+        mSortedEnd = mChildren.size();
+    }
+
+    /**
+     * @brief Sorts all the children again, in the order of another case sensitivity.
+     *
+     * For the children of a LocalNode moved to a sync that differs from its own in that (see
+     * LocalTreeProcMove): they are out of order for the new sync, not only the unsorted tail.
+     */
+    void resort(bool caseInsensitive)
+    {
+        compact();
+
+        std::sort(mChildren.begin(),
+                  mChildren.end(),
+                  [caseInsensitive](const Child* a, const Child* b)
+                  {
+                      return compare(*a, *b, caseInsensitive) < 0;
+                  });
+        mSortedEnd = mChildren.size();
+    }
+
+    bool isSorted() const
+    {
+        return mSortedEnd == mChildren.size();
+    }
+
+private:
+    // below this, the unsorted tail, the skipped entries and the empty slots are left alone
+    static constexpr size_t MAX_UNSORTED = 16;
+
+    // drops the skipped entries and the empty slots
+    void compact() const
+    {
+        auto first = mChildren.begin() + static_cast<std::ptrdiff_t>(mFirst);
+        auto sortedEnd = mChildren.begin() + static_cast<std::ptrdiff_t>(mSortedEnd);
+        auto out = std::remove(first, sortedEnd, nullptr);
+        out = std::move(sortedEnd, mChildren.end(), out);
+        mChildren.erase(out, mChildren.end());
+        mChildren.erase(mChildren.begin(), first);
+
+        mSortedEnd -= mFirst + mErased;
+        mFirst = 0;
+        mErased = 0;
+    }
+
+    // [mFirst, mSortedEnd) is sorted, with mErased empty slots (never the first one, nor the last
+    // one if there is no tail), and [mSortedEnd, end) is the unsorted tail
+    mutable std::vector<Child*> mChildren;
+    mutable size_t mFirst = 0;
+    mutable size_t mSortedEnd = 0;
+    mutable size_t mErased = 0;
+};
+
+} // namespace mega
+
+#endif // ENABLE_SYNC
+#endif // MEGA_SYNCINTERNALS_SORTEDCHILDINDEX_H
@@ -0,0 +1,233 @@
+/**
+ * @file statecachejournal.h
+ * @brief Write-behind journal of the LocalNode changes to be saved in the sync's database.
+ */
+
+#ifndef MEGA_SYNCINTERNALS_STATECACHEJOURNAL_H
+#define MEGA_SYNCINTERNALS_STATECACHEJOURNAL_H 1
+
+#ifdef ENABLE_SYNC
+
+#include "mega/db.h"
+
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mega
+{
+
+/**
+ * @class StateCacheJournal
+ * @brief The records of a sync's state cache that need writing (or deleting), until they are
+ * flushed to the database.
+ *
+ * A busy sync (the first scan of a large folder, a mass rename...) changes the same LocalNodes
+ * over and over.  The journal keeps a single entry per record however many times it changes, and
+ * it's only flushed once due(): after a while, once many records are pending, or when the sync
+ * has settled.  Then all of them go to the database in one transaction, encrypted on several
+ * threads if there are many.
+ *
+ * @tparam Record The records, as LocalNode: a Cacheable with the parent it refers to in the
+ * database (its dbid is serialized with the record).
+ *
+ * Not thread safe: each sync uses its journal from the thread walking it.
+ */
+template<typename Record>
+class StateCacheJournal
+{
+public:
+    // records are written after waiting this long...
+    static constexpr dstime MAX_DELAY_DS = 50;
+
+    // ... or once there are this many, even if the sync is still busy
+    static constexpr size_t MAX_PENDING = 20000;
+
+    // from this many records in a flush, they are encrypted on several threads
+    static constexpr size_t PARALLEL_ENCRYPTION_MIN = 2048;
+    static constexpr unsigned MAX_ENCRYPTION_THREADS = 4;
+
+    struct Stats
+    {
+        // updates and deletions requested
+        uint64_t changes = 0;
+
+        // changes that didn't need writing on their own: a record updated again before the
+        // flush, or updated and then removed
+        uint64_t absorbed = 0;
+
+        // records actually written and deleted
+        uint64_t recordsWritten = 0;
+        uint64_t recordsDeleted = 0;
+
+        uint64_t flushes = 0;
+    };
+
+    /**
+     * @brief The record needs to be written (again).
+     */
+    void add(Record* record, dstime now)
+    {
+        const bool wasEmpty = empty();
+
+        ++mStats.changes;
+
+        if (!mUpdates.insert(record).second)
+        {
+            ++mStats.absorbed;
+        }
+        else if (wasEmpty)
+        {
+            mFirstChange = now;
+        }
+    }
+
+    /**
+     * @brief The record is gone: it's not written, and deleted from the database if it was there.
+     */
+    void remove(Record* record, dstime now)
+    {
+        const bool wasEmpty = empty();
+
+        if (mUpdates.erase(record))
+        {
+            ++mStats.absorbed;
+        }
+
+        if (record->dbid)
+        {
+            ++mStats.changes;
+            mDeletions.push_back(record->dbid);
+            record->dbid = 0;
+
+            if (wasEmpty)
+            {
+                mFirstChange = now;
+            }
+        }
+    }
+
+    /**
+     * @brief Whether the pending changes should be flushed now.
+     *
+     * @param idle Whether the sync has settled (nothing left to scan or sync).
+     */
+    bool due(dstime now, bool idle) const
+    {
+        return !empty() &&
+               (idle || size() >= MAX_PENDING || now - mFirstChange >= MAX_DELAY_DS);
+    }
+
+    /**
+     * @brief Deletes and writes every pending record, within the table's current transaction.
+     *
+     * Parents are written before their children, which need their dbid.  Records whose parent
+     * (other than 'root', which isn't stored) doesn't have one stay pending.
+     *
+     * @return The number of records written.
+     */
+    size_t flush(DbTable& table, uint32_t type, SymmCipher& key, const Record* root, dstime now)
+    {
+        for (auto dbid: mDeletions)
+        {
+            if (table.del(dbid))
+            {
+                ++mStats.recordsDeleted;
+            }
+        }
+        mDeletions.clear();
+
+        std::vector<std::pair<size_t, Record*>> byDepth;
+        byDepth.reserve(mUpdates.size());
+        for (auto* record: mUpdates)
+        {
+            size_t depth = 0;
+            for (auto* parent = record->parent; parent && parent != root; parent = parent->parent)
+            {
+                ++depth;
+            }
+            byDepth.emplace_back(depth, record);
+        }
+        std::stable_sort(byDepth.begin(),
+                         byDepth.end(),
+                         [](const auto& a, const auto& b)
+                         {
+                             return a.first < b.first;
+                         });
+
+        std::vector<Cacheable*> records;
+        records.reserve(byDepth.size());
+        std::unordered_set<const Record*> written;
+        std::set<Record*> stuck;
+        for (auto& [depth, record]: byDepth)
+        {
+            const Record* parent = record->parent;
+            if (parent == root || parent->dbid || written.count(parent))
+            {
+                written.insert(record);
+                records.push_back(record);
+            }
+            else
+            {
+                stuck.insert(record);
+            }
+        }
+
+        unsigned threads = 1;
+        if (records.size() >= PARALLEL_ENCRYPTION_MIN)
+        {
+            threads = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_ENCRYPTION_THREADS);
+        }
+
+        const auto count = table.putRecords(type, records, &key, threads);
+        mStats.recordsWritten += count;
+        ++mStats.flushes;
+
+        mUpdates.swap(stuck);
+        mFirstChange = now;
+
+        return count;
+    }
+
+    /**
+     * @brief Forgets every pending change (the database is gone).
+     */
+    void clear()
+    {
+        mUpdates.clear();
+        mDeletions.clear();
+    }
+
+    bool empty() const
+    {
+        return mUpdates.empty() && mDeletions.empty();
+    }
+
+    // records pending, to be written or deleted
+    size_t size() const
+    {
+        return mUpdates.size() + mDeletions.size();
+    }
+
+    const Stats& stats() const
+    {
+        return mStats;
+    }
+
+private:
+    std::set<Record*> mUpdates;
+    std::vector<uint32_t> mDeletions;
+
+    // when the oldest pending change was made
+    dstime mFirstChange = 0;
+
+    Stats mStats;
+};
+
+} // namespace mega
+
+#endif // ENABLE_SYNC
+#endif // MEGA_SYNCINTERNALS_STATECACHEJOURNAL_H
@@ -277,12 +277,12 @@ private:
         switch (mScannedOrSyncedCtxt)
         {
             case ScannedOrSyncedContext::SYNCED:
-                return localNode.syncedFingerprint;
+                return localNode.syncedFingerprint();
             case ScannedOrSyncedContext::SCANNED:
-                return localNode.scannedFingerprint;
+                return localNode.scannedFingerprint();
         }
         assert(false && "Unexpected ScannedOrSyncedContext value");
-        return localNode.scannedFingerprint; // Fallback to silence compiler warning
+        return localNode.scannedFingerprint(); // Fallback to silence compiler warning
     }
 
     /**
@@ -406,14 +406,13 @@ NodeMatchByFSIDResult areNodesMatchedByFsidEquivalent(const NodeMatchByFSIDAttri
  * searched node (already matched by FSID) a valid match, i.e., that the source and target nodes are
  * indeed equivalent.
  *
- * @return a const iterator to the fsid_localnode_map with the matched fsid or to the end if there
- * is no match.
+ * @return The first LocalNode with the fsid that the predicate accepts, or nullptr if there is
+ * no match.
  *
  * @see FindLocalNodeByFSIDPredicate
  */
-fsid_localnode_map::const_iterator
-    findLocalNodeByFsid_if(const fsid_localnode_map& fsidLocalnodeMap,
-                           FindLocalNodeByFSIDPredicate& predicate);
+LocalNode* findLocalNodeByFsid_if(const fsid_localnode_map& fsidLocalnodeMap,
+                                  FindLocalNodeByFSIDPredicate& predicate);
 
 /**
  * @brief Finds a LocalNode by its File System ID (FSID) in a specified map.
@@ -0,0 +1,152 @@
+/**
+ * @file syncnamearena.h
+ * @brief Storage for the names of the LocalNodes of a sync.
+ */
+
+#ifndef MEGA_SYNCINTERNALS_SYNCNAMEARENA_H
+#define MEGA_SYNCINTERNALS_SYNCNAMEARENA_H 1
+
+#ifdef ENABLE_SYNC
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace mega
+{
+
+/**
+ * @class SyncNameArena
+ * @brief The normalized names of the LocalNodes of a sync, packed in large blocks.
+ *
+ * A name in the arena takes its characters plus a 4-byte length, and the LocalNode keeps a
+ * single pointer to it: no allocation per name, and no 32-byte std::string in every LocalNode.
+ *
+ * Names that are released (renamed or removed nodes) leave gaps in the blocks. Once these are
+ * larger than the names in use, compact() copies the live names into new blocks.
+ *
+ * Not thread safe: each sync uses its arena from the thread walking it.
+ */
+class SyncNameArena
+{
+public:
+    /**
+     * @class Name
+     * @brief A name stored in an arena, or an empty one.
+     */
+    class Name
+    {
+    public:
+        Name() = default;
+
+        std::string_view view() const
+        {
+            return std::string_view(mData, size());
+        }
+
+        operator std::string_view() const
+        {
+            return view();
+        }
+
+        size_t size() const;
+
+        bool empty() const
+        {
+            return !mData;
+        }
+
+    private:
+        friend class SyncNameArena;
+
+        explicit Name(const char* data):
+            mData(data)
+        {}
+
+        const char* mData = nullptr;
+    };
+
+    SyncNameArena() = default;
+
+    SyncNameArena(const SyncNameArena&) = delete;
+    SyncNameArena& operator=(const SyncNameArena&) = delete;
+    SyncNameArena(SyncNameArena&&) = default;
+    SyncNameArena& operator=(SyncNameArena&&) = default;
+
+    /**
+     * @brief Replaces 'name' (which must be empty or from this arena) with a copy of 'value'.
+     */
+    void assign(Name& name, std::string_view value);
+
+    /**
+     * @brief Empties 'name', which must be empty or from this arena.
+     */
+    void release(Name& name);
+
+    /**
+     * @brief Whether compact() would give back a worthwhile amount of memory.
+     */
+    bool wantsCompaction() const;
+
+    /**
+     * @brief Copies the live names into new blocks and frees the old ones.
+     *
+     * @param forEachName Callable that calls its argument, a callable taking a Name&, for every
+     * Name in use (every LocalNode of the sync). None may be left out: their old storage goes.
+     */
+    template<typename ForEachName>
+    void compact(ForEachName&& forEachName)
+    {
+        SyncNameArena fresh;
+        forEachName(
+            [&fresh](Name& name)
+            {
+                Name copy;
+                fresh.assign(copy, name.view());
+                name = copy;
+            });
+        *this = std::move(fresh);
+    }
+
+    struct Stats
+    {
+        // names in use
+        size_t names = 0;
+
+        // bytes taken by the names in use
+        size_t usedBytes = 0;
+
+        // bytes of released names, until the next compaction
+        size_t releasedBytes = 0;
+
+        // bytes of all the blocks
+        size_t allocatedBytes = 0;
+    };
+
+    const Stats& stats() const
+    {
+        return mStats;
+    }
+
+private:
+    // bytes taken by a name of 'size' characters
+    static size_t footprint(size_t size)
+    {
+        return sizeof(uint32_t) + size;
+    }
+
+    std::vector<std::unique_ptr<char[]>> mBlocks;
+
+    // free space at the end of the last block
+    char* mFree = nullptr;
+    size_t mFreeSize = 0;
+
+    Stats mStats;
+};
+
+} // namespace mega
+
+#endif // ENABLE_SYNC
+#endif // MEGA_SYNCINTERNALS_SYNCNAMEARENA_H
@@ -64,6 +64,7 @@ namespace mega {
 #endif
 
 #include "mega/crypto/sodium.h"
+#include "mega/handlemultiindex.h"
 #include "mega/user_attribute_types.h"
 
 #include <chrono>
@@ -605,12 +606,19 @@ typedef enum { SYNCDEL_NONE, SYNCDEL_DELETED, SYNCDEL_INFLIGHT, SYNCDEL_BIN,
 typedef vector<LocalNode*> localnode_vector;
 
 // fsid is not necessarily unique because multiple filesystems may be involved
-// Hence, we use a multimap and check other parameters too when looking for a match.
-typedef multimap<handle, LocalNode*> fsid_localnode_map;
+// Hence, we use a multi-index and check other parameters too when looking for a match.
+// Hashed rather than a multimap, as there is an entry per synced file.
+typedef HandleMultiIndex<handle, LocalNode> fsid_localnode_map;
 
 // A similar type for looking up LocalNode by node handle, analagously
-// Keep the type separate by inheriting
-typedef multimap<NodeHandle, LocalNode*> nodehandle_localnode_map;
+struct NodeHandleIndexBits
+{
+    uint64_t operator()(NodeHandle h) const
+    {
+        return h.as8byte();
+    }
+};
+typedef HandleMultiIndex<NodeHandle, LocalNode, NodeHandleIndexBits> nodehandle_localnode_map;
 
 typedef set<LocalNode*> localnode_set;
 
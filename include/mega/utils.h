@@ -570,7 +570,7 @@ struct CacheableWriter
 
 struct CacheableReader
 {
-    CacheableReader(const string& d);
+    CacheableReader(std::string_view d);
     const char* ptr;
     const char* end;
     unsigned fieldnum;
@@ -1330,6 +1330,17 @@ bool likeCompare(const char* pattern,
                  const UChar32 esc = static_cast<UChar32>(ESCAPE_CHARACTER),
                  const bool stripAccents = true);
 
+/*
+ * Fold a UTF-8 string to lower case and strip its accents, character by character, the same way
+ * likeCompare() compares them. So if likeCompare() matches some text without wildcards within
+ * a string, the folded text is a substring of the folded string.
+ *
+ * @param text the UTF-8 string to fold
+ *
+ * @return the folded string
+ */
+std::string foldCaseAndAccents(const std::string& text);
+
 // Get the current process ID
 unsigned long getCurrentPid();
 
@@ -19088,6 +19088,36 @@ class MegaApi
          */
         unsigned long long getNumNodesAtCacheLRU() const;
 
+        /**
+         * @brief Returns the number of lookups of nodes by handle resolved with nodes in RAM
+         *
+         * Together with MegaApi::getNumCacheLRUMisses and MegaApi::getNumCacheLRUEvictions,
+         * it can be used to tune the size of the cache LRU (see MegaApi::setLRUCacheSize).
+         *
+         * @note This method doesn't lock SDK mutex
+         *
+         * @return Number of lookups by handle found in RAM since the MegaApi was created
+         */
+        unsigned long long getNumCacheLRUHits() const;
+
+        /**
+         * @brief Returns the number of lookups of nodes by handle that required a query to the DB
+         *
+         * @note This method doesn't lock SDK mutex
+         *
+         * @return Number of lookups by handle not found in RAM since the MegaApi was created
+         */
+        unsigned long long getNumCacheLRUMisses() const;
+
+        /**
+         * @brief Returns the number of nodes unloaded from the cache LRU because it was full
+         *
+         * @note This method doesn't lock SDK mutex
+         *
+         * @return Number of nodes evicted from the cache LRU since the MegaApi was created
+         */
+        unsigned long long getNumCacheLRUEvictions() const;
+
         enum
         {
             ORDER_NONE = 0,
@@ -21066,6 +21096,108 @@ class MegaApi
          */
         int enableLexicographicDBIndexes(bool enable);
 
+        /**
+         * @brief Enables or disables a full-text database index for searches by name, description
+         * and tags.
+         *
+         * Searches (MegaApi::search) filtering by name, description or tag need to check every node
+         * below the searched locations. With this index, the nodes containing the searched text are
+         * looked up directly, which is much faster in large accounts. It's only used when the
+         * searched text has at least 3 characters (not counting wildcards). The index takes
+         * additional space in the database, similar to the size of the names of all the nodes.
+         *
+         * The index is created after fetchnodes finishes, so searches don't use it right after
+         * login. It requires SQLite to be built with FTS5 (3.34 or newer): otherwise, it's not
+         * created and searches work as if it was disabled.
+         *
+         * @note By default, this option is disabled (`false`).
+         *
+         * @note This method must be called before login and fetchnodes and its value is not reset
+         * upon logout. If the index already exists, it will be removed when the database is opened.
+         *
+         * @param enable Set to `true` to enable the full-text index, or `false` to disable it.
+         * @return
+         * - `API_OK`      - Operation completed successfully.
+         * - `API_EACCESS` - The operation could not be performed because the user is already logged
+         * in.
+         */
+        int enableFullTextSearchDBIndex(bool enable);
+
+        /**
+         * @brief Enables or disables a database index with the ancestors of every node.
+         *
+         * Checking if a node is below another one, and listings restricted to the nodes below some
+         * folders (MegaApi::listAllNodesByPage), need to walk up the parents of each node in the
+         * database. With this index, each check is a single lookup, which is much faster in large
+         * accounts with deep folder structures. The index takes additional space in the database,
+         * proportional to the number of nodes multiplied by their average depth, and moving a
+         * folder takes longer, proportional to the number of nodes below it.
+         *
+         * The index is created after fetchnodes finishes, so it isn't used right after login.
+         *
+         * @note By default, this option is disabled (`false`).
+         *
+         * @note This method must be called before login and fetchnodes and its value is not reset
+         * upon logout. If the index already exists, it will be removed when the database is opened.
+         *
+         * @param enable Set to `true` to enable the ancestor index, or `false` to disable it.
+         * @return
+         * - `API_OK`      - Operation completed successfully.
+         * - `API_EACCESS` - The operation could not be performed because the user is already logged
+         * in.
+         */
+        int enableAncestorDBIndex(bool enable);
+
+        /**
+         * @brief Enables or disables the snapshot of the node tree used upon session resumption.
+         *
+         * When enabled, a compact image of the node tree (handles, parents, types, share flags and
+         * names) is written next to the local cache when the session is saved (logout keeping the
+         * session, or destruction of the MegaApi). When the session is resumed, the snapshot is
+         * memory-mapped and used to count children, check ancestors, find children by name and
+         * get the root nodes and the shared nodes, until the first change in the node tree. This
+         * shortens the time until the app is usable in large accounts, while the database is
+         * still warming up. The snapshot takes additional disk space, proportional to the number
+         * of nodes, and saving the session takes longer.
+         *
+         * A snapshot that doesn't match the state of the local cache is discarded.
+         *
+         * @note By default, this option is disabled (`false`).
+         *
+         * @note This method must be called before login and fetchnodes and its value is not reset
+         * upon logout. If the snapshot already exists, it will be removed when the database is
+         * opened.
+         *
+         * @param enable Set to `true` to enable the snapshot, or `false` to disable it.
+         * @return
+         * - `API_OK`      - Operation completed successfully.
+         * - `API_EACCESS` - The operation could not be performed because the user is already logged
+         * in.
+         */
+        int enableNodeTreeSnapshot(bool enable);
+
+        /**
+         * @brief Enables or disables the sharing of repeated names among MegaNode objects.
+         *
+         * When enabled, the names of the MegaNode objects created from then on are kept in a
+         * process-wide pool, so all the nodes with the same name (like "Thumbs.db" or "index.html"
+         * in backups) point to a single copy of it, released with the last of them. This reduces
+         * the memory taken by apps that keep large MegaNodeList objects, at the cost of a lookup
+         * in the pool for every new MegaNode. A name in the pool takes more memory than a copy of
+         * its own, so it only pays off when most of the names repeat (more than half of them).
+         *
+         * Only the names of MegaNode objects are shared: the nodes kept by the SDK are not affected.
+         *
+         * The setting applies to all the MegaApi instances in the process, and it can be changed
+         * at any time. MegaNode objects that already exist are not affected.
+         *
+         * @note By default, this option is disabled (`false`).
+         *
+         * @param enable Set to `true` to share the names of new MegaNode objects, or `false` to
+         * give each of them its own copy.
+         */
+        static void enableNodeNameInterning(bool enable);
+
         /**
          * @brief Generate an unique ViewID
          *
@@ -1047,13 +1047,22 @@ class MegaNodePrivate : public MegaNode, public Cacheable
         static string removeAppPrefixFromFingerprint(const char* appFingerprint, m_off_t* nodeSize = nullptr);
         static string addAppPrefixToFingerprint(const string& fingerprint, const m_off_t nodeSize);
 
+        // share the names of the nodes created from now on (see StringPool::nodeNames())
+        static void enableNameInterning(bool enable);
+
     protected:
         MegaNodePrivate(Node *node);
+        // sets 'name' to a copy of its own, or to the one in the pool of node names if interning
+        // is enabled (then kept alive by mInternedName)
+        void assignName(const char* newName);
+        static std::atomic<bool> sInternNames;
+
         const char* getAttrFrom(const char *attrName, const attr_map* attrMap) const;
         const char *getOfficialAttr(const char* attrName) const;
 
         int type;
-        const char *name;
+        const char *name = nullptr;
+        SharedString mInternedName;
         const char *fingerprint;
         const char *originalfingerprint;
         attr_map *customAttrs;
@@ -4418,6 +4427,9 @@ class MegaApiImpl : public MegaApp
 
         void setLRUCacheSize(unsigned long long size);
         unsigned long long getNumNodesAtCacheLRU() const;
+        unsigned long long getNumCacheLRUHits() const;
+        unsigned long long getNumCacheLRUMisses() const;
+        unsigned long long getNumCacheLRUEvictions() const;
         unsigned long long getNumNodes();
         unsigned long long getAccurateNumNodes();
 
@@ -4604,6 +4616,9 @@ public:
         bool setLanguage(const char* languageCode);
         int enableSearchDBIndexes(bool enable);
         int enableLexicographicDBIndexes(bool enable);
+        int enableFullTextSearchDBIndex(bool enable);
+        int enableAncestorDBIndex(bool enable);
+        int enableNodeTreeSnapshot(bool enable);
         string generateViewId();
         void setLanguagePreference(const char* languageCode, MegaRequestListener *listener = NULL);
         void getLanguagePreference(MegaRequestListener *listener = NULL);
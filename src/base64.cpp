@@ -51,34 +51,42 @@ unsigned char Base64::to64(byte c)
     return '_';
 }
 
-unsigned char Base64::from64(byte c)
+namespace {
+// character -> 6-bit value, 255 for anything that is not base64 (including NUL)
+struct From64Table
 {
-    if ((c >= 'A') && (c <= 'Z'))
-    {
-        return static_cast<unsigned char>(c - 'A');
-    }
+    byte values[256];
 
-    if ((c >= 'a') && (c <= 'z'))
+    constexpr From64Table():
+        values{}
     {
-        return static_cast<unsigned char>(c - 'a' + 26);
-    }
+        for (int i = 0; i < 256; i++)
+        {
+            values[i] = 255;
+        }
 
-    if ((c >= '0') && (c <= '9'))
-    {
-        return static_cast<unsigned char>(c - '0' + 52);
-    }
+        for (int i = 0; i < 26; i++)
+        {
+            values['A' + i] = static_cast<byte>(i);
+            values['a' + i] = static_cast<byte>(i + 26);
+        }
 
-    if (c == '-' || c == '+')
-    {
-        return static_cast<unsigned char>(62);
-    }
+        for (int i = 0; i < 10; i++)
+        {
+            values['0' + i] = static_cast<byte>(i + 52);
+        }
 
-    if (c == '_' || c == '/')
-    {
-        return static_cast<unsigned char>(63);
+        values['-'] = values['+'] = 62;
+        values['_'] = values['/'] = 63;
     }
+};
 
-    return static_cast<unsigned char>(255);
+constexpr From64Table from64Table;
+} // namespace
+
+unsigned char Base64::from64(byte c)
+{
+    return from64Table.values[c];
 }
 
 
@@ -101,20 +109,52 @@ std::string Base64::atob(const std::string &in)
 
 int Base64::atob(const char* a, byte* b, int blen)
 {
+    return atob(a, b, blen, nullptr);
+}
+
+int Base64::atob(const char* a, byte* b, int blen, const char** end)
+{
+    const byte* values = from64Table.values;
     byte c[4]={};
     int i;
     int p = 0;
 
+    // whole groups of 4 characters while they fit. Characters are checked one at a time so
+    // that nothing past the delimiter is read
+    while (blen - p >= 3)
+    {
+        unsigned c0, c1, c2, c3;
+        if ((c0 = values[static_cast<byte>(a[0])]) == 255 ||
+            (c1 = values[static_cast<byte>(a[1])]) == 255 ||
+            (c2 = values[static_cast<byte>(a[2])]) == 255 ||
+            (c3 = values[static_cast<byte>(a[3])]) == 255)
+        {
+            break;
+        }
+
+        const unsigned group = (c0 << 18) | (c1 << 12) | (c2 << 6) | c3;
+        b[p++] = static_cast<byte>(group >> 16);
+        b[p++] = static_cast<byte>(group >> 8);
+        b[p++] = static_cast<byte>(group);
+        a += 4;
+    }
+
     for (;;)
     {
         for (i = 0; i < 4; i++)
         {
-            if ((c[i] = from64(static_cast<byte>(*a++))) == 255)
+            if ((c[i] = values[static_cast<byte>(*a++)]) == 255)
             {
                 break;
             }
         }
 
+        if (end)
+        {
+            // the delimiter, or the first character not consumed
+            *end = a - (i < 4 ? 1 : 0);
+        }
+
         if ((p >= blen) || !i)
         {
             return p;
@@ -5912,7 +5912,7 @@ bool CommandGetUserQuota::procresult(Result r, JSON& json)
                         shared_ptr<Node> node = client->nodebyhandle(h);
                         if (node)
                         {
-                            NodeCounter counter = node->getCounter();
+                            NodeCounter counter = client->mNodeManager.getNodeCounter(*node);
                             const auto displayPath = node->displaypath();
                             LOG_debug
                                 << displayPath << " " << counter.storage << " " << ns->bytes << " "
@@ -7166,6 +7166,7 @@ CommandFetchNodes::CommandFetchNodes(MegaClient* client,
             mSt.clear();
             mPreviousHandleForAlert = UNDEF;
             mMissingParentNodes.clear();
+            mReadNodes.clear();
 
             // make sure the syncs don't see Nodes disappearing
             // they should only look at the nodes again once
@@ -7203,9 +7204,13 @@ CommandFetchNodes::CommandFetchNodes(MegaClient* client,
 
     // Parsing of chunk finished
     mFilters.emplace(">",
-                     [this](JSON*)
+                     [this, client](JSON*)
                      {
                          assert(mNodeTreeIsChanging.owns_lock());
+                         // nodes are not kept pending across chunks
+                         client->addReadNodes(mReadNodes,
+                                              mMissingParentNodes,
+                                              mPreviousHandleForAlert);
                          mNodeTreeIsChanging.unlock();
                          return JSONSplitter::CallbackResult::SUCCESS;
                      });
@@ -7223,12 +7228,17 @@ CommandFetchNodes::CommandFetchNodes(MegaClient* client,
                                  true,
                                  mMissingParentNodes,
                                  mPreviousHandleForAlert,
-                                 nullptr // allParents disabled because Syncs::triggerSync
+                                 nullptr, // allParents disabled because Syncs::triggerSync
                                  // does nothing when MegaClient::fetchingnodes is true
-                                 ) != 1)
+                                 client->mParallelNodesDecryption ? &mReadNodes : nullptr) != 1)
             {
                 return JSONSplitter::CallbackResult::FAILED;
             }
+
+            if (mReadNodes.size() >= MegaClient::MAX_READ_NODES_BATCH)
+            {
+                client->addReadNodes(mReadNodes, mMissingParentNodes, mPreviousHandleForAlert);
+            }
             return JSONSplitter::ResultFromBool(json->leaveobject());
         });
 
@@ -7238,6 +7248,7 @@ CommandFetchNodes::CommandFetchNodes(MegaClient* client,
     // End of node array
     f = mFilters.emplace("{[f", [this, client](JSON *json)
     {
+        client->addReadNodes(mReadNodes, mMissingParentNodes, mPreviousHandleForAlert);
         client->mergenewshares(0);
         client->mNodeManager.checkOrphanNodes(mMissingParentNodes);
 
@@ -7395,10 +7406,11 @@ CommandFetchNodes::CommandFetchNodes(MegaClient* client,
 
     // Parsing error
     mFilters.emplace("E",
-                     [client](JSON*)
+                     [this, client](JSON*)
                      {
                          WAIT_CLASS::bumpds();
                          client->fnstats.timeToLastByte = Waiter::ds - client->fnstats.startTime;
+                         mReadNodes.clear();
                          client->purgenodesusersabortsc(true);
 
                          client->fetchingnodes = false;
@@ -7618,7 +7630,7 @@ bool CommandFetchNodes::parsingFinished()
 
     client->mergenewshares(0);
 
-    client->mNodeManager.initCompleted();  // (nodes already written into DB)
+    client->mNodeManager.initCompleted();  // (writes the last nodes into DB)
 
     client->initsc();
     client->fetchnodestag = tag;
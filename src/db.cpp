@@ -23,6 +23,9 @@
 #include "mega/utils.h"
 #include "mega/logging.h"
 
+#include <atomic>
+#include <thread>
+
 namespace mega {
 DbTable::DbTable(PrnGen &rng, bool checkAlwaysTransacted, DBErrorCallback dBErrorCallBack)
     : rng(rng), mCheckAlwaysTransacted(checkAlwaysTransacted)
@@ -37,11 +40,8 @@ bool DbTable::put(uint32_t index, string* data)
     return put(index, (char*)data->data(), unsigned(data->size()));
 }
 
-// add or update record with padding and encryption
-bool DbTable::put(uint32_t type, Cacheable* record, SymmCipher* key)
+void DbTable::assignDbid(uint32_t type, Cacheable* record)
 {
-    string data;
-
     if (!record->dbid)
     {
         uint32_t previousNextid = nextid;
@@ -56,6 +56,14 @@ bool DbTable::put(uint32_t type, Cacheable* record, SymmCipher* key)
             assert(nextid >= previousNextid);
         }
     }
+}
+
+// add or update record with padding and encryption
+bool DbTable::put(uint32_t type, Cacheable* record, SymmCipher* key)
+{
+    string data;
+
+    assignDbid(type, record);
 
     if (!record->serialize(&data))
     {
@@ -73,6 +81,72 @@ bool DbTable::put(uint32_t type, Cacheable* record, SymmCipher* key)
     return put(record->dbid, &data);
 }
 
+size_t DbTable::putRecords(uint32_t type,
+                           const std::vector<Cacheable*>& records,
+                           SymmCipher* key,
+                           unsigned threads)
+{
+    // serialize here: records may refer to each other's dbids
+    std::vector<std::pair<uint32_t, string>> rows;
+    rows.reserve(records.size());
+    for (auto* record: records)
+    {
+        assignDbid(type, record);
+
+        string data;
+        if (!record->serialize(&data))
+        {
+            // as put(), carry on with the rest
+            LOG_warn << "Serialization failed: " << type;
+            continue;
+        }
+        rows.emplace_back(record->dbid, std::move(data));
+    }
+
+    // SymmCipher keeps the state of the encryption: each thread uses its own copy.
+    // (rng is only used for explicit IVs, so it's not touched here)
+    std::atomic<bool> encryptionFailed{false};
+    auto encrypt = [this, &rows, key, &encryptionFailed](size_t begin, size_t end)
+    {
+        SymmCipher cipher(*key);
+        for (auto i = begin; i < end; ++i)
+        {
+            if (!PaddedCBC::encrypt(rng, &rows[i].second, &cipher))
+            {
+                encryptionFailed.store(true);
+            }
+        }
+    };
+
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(rows.size())));
+    const size_t chunk = (rows.size() + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(encrypt, chunk * i, std::min(rows.size(), chunk * (i + 1)));
+    }
+    encrypt(0, std::min(rows.size(), chunk));
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+
+    if (encryptionFailed.load())
+    {
+        LOG_err << "Failed to CBC encrypt data"; // continue with unencrypted data intentionally
+    }
+
+    size_t written = 0;
+    for (auto& row: rows)
+    {
+        if (put(row.first, &row.second))
+        {
+            ++written;
+        }
+    }
+    return written;
+}
+
 // get next record, decrypt and unpad
 bool DbTable::next(uint32_t* type, string* data, SymmCipher* key)
 {
@@ -22,6 +22,7 @@
 #include "mega.h"
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <numeric>
 #include <sstream>
@@ -151,55 +152,51 @@ static int
                                   size2);
 }
 
-DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAccess, const string &name, const int flags, DBErrorCallback dBErrorCallBack)
+// Registers the functions and the collation used by the 'nodes' table and the queries on it,
+// which every connection to the DB needs
+static bool registerNodesFunctions(sqlite3* db)
 {
-    /**
-     * Deprecated columns (WARNING: do not use these names anymore for new columns):
-     * - size: file/folder size in Bytes (replaced by sizeVirtual, calculated from nodeCounter)
-     * - mimetype: node mimetype (replaced by mimetypeVirtual, calculated from node name)
-     */
-    sqlite3 *db = nullptr;
-    auto dbPath = databasePath(fsAccess, name, DB_VERSION);
-    if (!openDBAndCreateStatecache(&db, fsAccess, name, dbPath, flags))
-    {
-        return nullptr;
-    }
-
-    if (sqlite3_create_function(db, u8"getmimetype", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0, &SqliteAccountState::userGetMimetype, 0, 0) != SQLITE_OK)
+    struct Function
     {
-        LOG_err << "Data base error(sqlite3_create_function userGetMimetype): " << sqlite3_errmsg(db);
-        sqlite3_close(db);
-        return nullptr;
-    }
+        const char* name;
+        int numArgs;
+        int flags;
+        void (*function)(sqlite3_context*, int, sqlite3_value**);
+    };
 
-    if (sqlite3_create_function(db,
-                                u8"getFingerprintExcludingMtime",
-                                1,
-                                SQLITE_UTF8 | SQLITE_DETERMINISTIC,
-                                0,
-                                &SqliteAccountState::getFingerprintExcludingMtime,
-                                0,
-                                0) != SQLITE_OK)
-    {
-        LOG_err << "Data base error(sqlite3_create_function getFingerprintExcludingMtime): "
-                << sqlite3_errmsg(db);
-        sqlite3_close(db);
-        return nullptr;
-    }
+    const Function functions[]{
+        {"getmimetype",
+         1,
+         SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+         &SqliteAccountState::userGetMimetype},
+        {"getFingerprintExcludingMtime",
+         1,
+         SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+         &SqliteAccountState::getFingerprintExcludingMtime},
+        {"getSizeFromNodeCounter",
+         1,
+         SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+         &SqliteAccountState::getSizeFromNodeCounter},
+        {"foldtext", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, &SqliteAccountState::userFoldText},
+        {"regexp", 2, SQLITE_ANY, &SqliteAccountState::userRegexp},
+        {"matchFilter", 10, SQLITE_ANY, &SqliteAccountState::userMatchFilter},
+    };
 
-    if (sqlite3_create_function(db,
-                                u8"getSizeFromNodeCounter",
-                                1,
-                                SQLITE_UTF8 | SQLITE_DETERMINISTIC,
-                                0,
-                                &SqliteAccountState::getSizeFromNodeCounter,
-                                0,
-                                0) != SQLITE_OK)
+    for (const Function& function: functions)
     {
-        LOG_err << "Data base error(sqlite3_create_function getSizeFromNodeCounter): "
-                << sqlite3_errmsg(db);
-        sqlite3_close(db);
-        return nullptr;
+        if (sqlite3_create_function(db,
+                                    function.name,
+                                    function.numArgs,
+                                    function.flags,
+                                    nullptr,
+                                    function.function,
+                                    nullptr,
+                                    nullptr) != SQLITE_OK)
+        {
+            LOG_err << "Data base error(sqlite3_create_function " << function.name
+                    << "): " << sqlite3_errmsg(db);
+            return false;
+        }
     }
 
     if (sqlite3_create_collation(db,
@@ -210,6 +207,40 @@ DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAcc
     {
         LOG_err << "Data base error(sqlite3_create_collation NATURALNOCASE): "
                 << sqlite3_errmsg(db);
+        return false;
+    }
+
+#if __ANDROID__
+    // Android doesn't provide a temporal directory -> change default policy for temp
+    // store (FILE=1) to avoid failures on large queries, so it relies on MEMORY=2
+    if (sqlite3_exec(db, "PRAGMA temp_store=2;", nullptr, nullptr, nullptr))
+    {
+        LOG_err << "PRAGMA temp_store error " << sqlite3_errmsg(db);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAccess, const string &name, const int flags, DBErrorCallback dBErrorCallBack)
+{
+    /**
+     * Deprecated columns (WARNING: do not use these names anymore for new columns):
+     * - size: file/folder size in Bytes (replaced by sizeVirtual, calculated from nodeCounter)
+     * - mimetype: node mimetype (replaced by mimetypeVirtual, calculated from node name)
+     * - mimetypeVirtual: node mimetype calculated from node name on every read (replaced by
+     *   mimetypeStored, calculated when the node is written). It's kept in existing DBs, unused
+     */
+    sqlite3 *db = nullptr;
+    auto dbPath = databasePath(fsAccess, name, DB_VERSION);
+    if (!openDBAndCreateStatecache(&db, fsAccess, name, dbPath, flags))
+    {
+        return nullptr;
+    }
+
+    if (!registerNodesFunctions(db))
+    {
         sqlite3_close(db);
         return nullptr;
     }
@@ -218,7 +249,7 @@ DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAcc
     std::string sql =
         "CREATE TABLE IF NOT EXISTS nodes (nodehandle int64 PRIMARY KEY NOT NULL, "
         "parenthandle int64, name text, fingerprint BLOB, origFingerprint BLOB, "
-        "type tinyint, mimetypeVirtual tinyint AS (getmimetype(name)) VIRTUAL, "
+        "type tinyint, mimetypeStored tinyint, "
         "fingerprintVirtual BLOB AS (getFingerprintExcludingMtime(fingerprint)) VIRTUAL, "
         "sizeVirtual int64 AS (getSizeFromNodeCounter(counter)) VIRTUAL,"
         "share tinyint, fav tinyint, ctime int64, mtime int64 DEFAULT 0, "
@@ -244,10 +275,6 @@ DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAcc
          "tinyint DEFAULT 0",
          NodeData::COMPONENT_LABEL,
          NewColumn::extractDataFromNodeData<LabelType>},
-        {"mimetypeVirtual",
-         "tinyint AS (getmimetype(name)) VIRTUAL",
-         NodeData::COMPONENT_NONE,
-         nullptr},
         {"fingerprintVirtual",
          "BLOB AS (getFingerprintExcludingMtime(fingerprint)) VIRTUAL",
          NodeData::COMPONENT_NONE,
@@ -269,41 +296,37 @@ DbTable *SqliteDbAccess::openTableWithNodes(PrnGen &rng, FileSystemAccess &fsAcc
         return nullptr;
     }
 
-#if __ANDROID__
-    // Android doesn't provide a temporal directory -> change default policy for temp
-    // store (FILE=1) to avoid failures on large queries, so it relies on MEMORY=2
-    result = sqlite3_exec(db, "PRAGMA temp_store=2;", nullptr, nullptr, nullptr);
-    if (result)
+    // The category of each node is written along with it (see NodeRow). If the column is missing,
+    // the existing rows get it from their names, once
+    vector<NewColumn> mimetypeCol{{"mimetypeStored", "tinyint", NodeData::COMPONENT_NONE, nullptr}};
+    if (!stripExistingColumns(db, mimetypeCol) ||
+        (!mimetypeCol.empty() && !(addColumn(db, mimetypeCol[0].name, mimetypeCol[0].type) &&
+                                   populateColumn(db, mimetypeCol[0].name, "getmimetype(name)"))))
     {
-        LOG_err << "PRAGMA temp_store error " << sqlite3_errmsg(db);
         sqlite3_close(db);
         return nullptr;
     }
-#endif
 
-    result = sqlite3_create_function(db, "regexp", 2, SQLITE_ANY,0, &SqliteAccountState::userRegexp, 0, 0);
-    if (result)
+    // Indexes on mimetypeVirtual, replaced by the ones on mimetypeStored (see NODES_INDEXES). They
+    // would be updated for every node written, calling getmimetype() for each one
+    for (const char* index: {"listallnodesdefaultidx",
+                             "listallnodesmtimeidx",
+                             "listallnodessizeidx",
+                             "listallnodesfavidx",
+                             "listallnodesfavdescidx",
+                             "listallnodeslabelidx",
+                             "listallnodeslabeldescidx"})
     {
-        LOG_err << "Data base error(sqlite3_create_function userRegexp): " << sqlite3_errmsg(db);
-        sqlite3_close(db);
-        return nullptr;
+        const std::string dropIndex = std::string("DROP INDEX IF EXISTS ") + index;
+        if (sqlite3_exec(db, dropIndex.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            LOG_err << "Data base error while removing index " << index << ": "
+                    << sqlite3_errmsg(db);
+            sqlite3_close(db);
+            return nullptr;
+        }
     }
 
-    result = sqlite3_create_function(db,
-                                     "matchFilter",
-                                     10,
-                                     SQLITE_ANY,
-                                     0,
-                                     &SqliteAccountState::userMatchFilter,
-                                     0,
-                                     0);
-    if (result)
-    {
-        LOG_err << "Data base error(sqlite3_create_function userMatchFilter): "
-                << sqlite3_errmsg(db);
-        sqlite3_close(db);
-        return nullptr;
-    }
     return new SqliteAccountState(rng,
                                 db,
                                 fsAccess,
@@ -536,6 +559,20 @@ bool SqliteDbAccess::addColumn(sqlite3* db, const string& name, const string& ty
     return true;
 }
 
+bool SqliteDbAccess::populateColumn(sqlite3* db, const string& name, const string& expression)
+{
+    LOG_info << "Migrating Data base - populating column " << name;
+
+    string query("UPDATE nodes SET " + name + " = " + expression);
+    if (sqlite3_exec(db, query.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        LOG_err << "Db error while populating 'nodes." << name << "' column: " << sqlite3_errmsg(db);
+        return false;
+    }
+
+    return true;
+}
+
 bool SqliteDbAccess::migrateDataToColumns(sqlite3* db, vector<NewColumn>&& cols)
 {
     if (cols.empty()) return true;
@@ -1057,16 +1094,344 @@ void SqliteDbTable::errorHandler(int sqliteError, const string& operation, bool
     }
 }
 
+SqliteStatementCache::SqliteStatementCache(size_t capacity):
+    mCapacity(std::max<size_t>(capacity, 1))
+{}
+
+SqliteStatementCache::~SqliteStatementCache()
+{
+    clear();
+}
+
+sqlite3_stmt*& SqliteStatementCache::acquire(Query query, size_t shapeId)
+{
+    const Key key{query, shapeId};
+    if (auto it = mIndex.find(key); it != mIndex.end())
+    {
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        if (it->second->stmt)
+        {
+            ++mStats.reuses;
+        }
+        else
+        {
+            // the previous attempt to prepare it failed
+            ++mStats.prepares;
+        }
+        return it->second->stmt;
+    }
+
+    ++mStats.prepares;
+    mEntries.push_front(Entry{key, nullptr});
+    mIndex.emplace(key, mEntries.begin());
+
+    if (mEntries.size() > mCapacity)
+    {
+        Entry& lru = mEntries.back();
+        sqlite3_finalize(lru.stmt);
+        mIndex.erase(lru.key);
+        mEntries.pop_back();
+        ++mStats.evictions;
+    }
+
+    return mEntries.front().stmt;
+}
+
+void SqliteStatementCache::clear()
+{
+    for (Entry& entry: mEntries)
+    {
+        sqlite3_finalize(entry.stmt);
+    }
+    mEntries.clear();
+    mIndex.clear();
+}
+
+size_t SqliteStatementCache::size() const
+{
+    return mEntries.size();
+}
+
+size_t SqliteStatementCache::capacity() const
+{
+    return mCapacity;
+}
+
+const SqliteStatementCache::Stats& SqliteStatementCache::stats() const
+{
+    return mStats;
+}
+
+class SqliteAccountState::ReaderPool
+{
+public:
+    ReaderPool(PrnGen& rng, FileSystemAccess& fsAccess, const LocalPath& path):
+        mRng(rng),
+        mFsAccess(fsAccess),
+        mPath(path)
+    {}
+
+    // An idle reader, or a new one while there are less than MAX_READERS. nullptr otherwise
+    std::unique_ptr<SqliteAccountState> take();
+    void giveBack(std::unique_ptr<SqliteAccountState> reader);
+
+    // The main connection is being closed: the borrowed readers are invalidated, and closed
+    // when given back
+    void close();
+
+    // Incremented when the nodes are modified, and when the transaction of the main connection
+    // ends (once the changes are visible to the readers, or discarded)
+    uint64_t generation() const
+    {
+        return mGeneration;
+    }
+
+    bool hasUncommittedChanges() const
+    {
+        return mUncommittedChanges;
+    }
+
+    void nodesWillChange()
+    {
+        mUncommittedChanges = true;
+        ++mGeneration;
+    }
+
+    void transactionEnded()
+    {
+        ++mGeneration;
+        mUncommittedChanges = false;
+    }
+
+private:
+    // look-ups from app threads rarely overlap, so a few connections are enough
+    static constexpr size_t MAX_READERS = 3;
+
+    // in WAL mode the readers are only locked out briefly (i.e. while the WAL is reset)
+    static constexpr int BUSY_TIMEOUT_MS = 1000;
+
+    std::unique_ptr<SqliteAccountState> open();
+
+    PrnGen& mRng;
+    FileSystemAccess& mFsAccess;
+    const LocalPath mPath;
+
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<SqliteAccountState>> mIdle;
+    size_t mOpened = 0; // idle and borrowed
+    bool mClosed = false;
+
+    std::atomic<uint64_t> mGeneration{0};
+    std::atomic<bool> mUncommittedChanges{false};
+};
+
+class SqliteAccountState::Reader: public DBTableNodesReader
+{
+public:
+    Reader(std::shared_ptr<ReaderPool> pool,
+           std::unique_ptr<SqliteAccountState> table,
+           uint64_t generation):
+        mPool(std::move(pool)),
+        mTable(std::move(table)),
+        mGeneration(generation)
+    {}
+
+    ~Reader() override
+    {
+        mPool->giveBack(std::move(mTable));
+    }
+
+    DBTableNodes& table() override
+    {
+        return *mTable;
+    }
+
+    bool isStillValid() const override
+    {
+        return mPool->generation() == mGeneration;
+    }
+
+private:
+    std::shared_ptr<ReaderPool> mPool;
+    std::unique_ptr<SqliteAccountState> mTable;
+    const uint64_t mGeneration;
+};
+
+std::unique_ptr<SqliteAccountState> SqliteAccountState::ReaderPool::take()
+{
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+        if (mClosed)
+        {
+            return nullptr;
+        }
+
+        if (!mIdle.empty())
+        {
+            std::unique_ptr<SqliteAccountState> reader = std::move(mIdle.back());
+            mIdle.pop_back();
+            return reader;
+        }
+
+        if (mOpened >= MAX_READERS)
+        {
+            return nullptr;
+        }
+        ++mOpened;
+    }
+
+    std::unique_ptr<SqliteAccountState> reader = open();
+    if (!reader)
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+        --mOpened;
+    }
+
+    return reader;
+}
+
+void SqliteAccountState::ReaderPool::giveBack(std::unique_ptr<SqliteAccountState> reader)
+{
+    std::lock_guard<std::mutex> g(mMutex);
+    if (mClosed)
+    {
+        // closed when 'reader' goes out of scope
+        --mOpened;
+        return;
+    }
+
+    mIdle.push_back(std::move(reader));
+}
+
+void SqliteAccountState::ReaderPool::close()
+{
+    std::vector<std::unique_ptr<SqliteAccountState>> idle;
+    {
+        std::lock_guard<std::mutex> g(mMutex);
+        mClosed = true;
+        mOpened -= mIdle.size();
+        idle.swap(mIdle);
+    }
+
+    ++mGeneration;
+}
+
+std::unique_ptr<SqliteAccountState> SqliteAccountState::ReaderPool::open()
+{
+    sqlite3* db = nullptr;
+    int result = sqlite3_open_v2(mPath.toPath(false).c_str(),
+                                 &db,
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX,
+                                 nullptr);
+    if (result)
+    {
+        LOG_warn << "Failed to open read-only connection to " << mPath << " Error: "
+                 << (db ? sqlite3_errmsg(db) : std::to_string(result));
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+
+    if (!registerNodesFunctions(db))
+    {
+        sqlite3_close(db);
+        return nullptr;
+    }
+
+    // DB errors of the readers aren't notified: the look-up is repeated on the main connection
+    auto reader = std::make_unique<SqliteAccountState>(mRng, db, mFsAccess, mPath, false, nullptr);
+    reader->mReaderPool.reset();
+    return reader;
+}
+
 SqliteAccountState::SqliteAccountState(PrnGen &rng, sqlite3 *pdb, FileSystemAccess &fsAccess, const LocalPath &path, const bool checkAlwaysTransacted, DBErrorCallback dBErrorCallBack)
     : SqliteDbTable(rng, pdb, fsAccess, path, checkAlwaysTransacted, dBErrorCallBack)
+    , mReaderPool(std::make_shared<ReaderPool>(rng, fsAccess, path))
 {
 }
 
 SqliteAccountState::~SqliteAccountState()
 {
+    if (mReaderPool)
+    {
+        mReaderPool->close();
+    }
+
+    const auto& stats = mStmtCache.stats();
+    LOG_debug << "Statement cache: " << stats.prepares << " prepared, " << stats.reuses
+              << " reused, " << stats.evictions << " evicted";
+
     finalise();
 }
 
+std::unique_ptr<DBTableNodesReader> SqliteAccountState::acquireReader()
+{
+#if TARGET_OS_IPHONE
+    // without WAL, the readers and the writer would lock each other out
+    return nullptr;
+#else
+    if (!db || !mReaderPool)
+    {
+        return nullptr;
+    }
+
+    // the generation is read first, so the changes made after checking there aren't uncommitted
+    // ones invalidate the reader
+    const uint64_t generation = mReaderPool->generation();
+    if (mReaderPool->hasUncommittedChanges())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<SqliteAccountState> table = mReaderPool->take();
+    if (!table)
+    {
+        return nullptr;
+    }
+
+    // the optional indexes are committed along with the changes of the nodes, so the reader
+    // finds the same ones
+    table->mFullTextIndexReady = mFullTextIndexReady;
+    table->mAncestorIndexReady = mAncestorIndexReady;
+
+    return std::make_unique<Reader>(mReaderPool, std::move(table), generation);
+#endif
+}
+
+void SqliteAccountState::commit()
+{
+    SqliteDbTable::commit();
+
+    if (mReaderPool)
+    {
+        mReaderPool->transactionEnded();
+    }
+}
+
+void SqliteAccountState::abort()
+{
+    SqliteDbTable::abort();
+
+    if (mReaderPool)
+    {
+        mReaderPool->transactionEnded();
+    }
+}
+
+void SqliteAccountState::nodesWillChange()
+{
+    if (mReaderPool)
+    {
+        mReaderPool->nodesWillChange();
+    }
+}
+
+const SqliteStatementCache::Stats& SqliteAccountState::getStatementCacheStats() const
+{
+    return mStmtCache.stats();
+}
+
 int SqliteAccountState::progressHandler(void *param)
 {
     CancelToken* cancelFlag = static_cast<CancelToken*>(param);
@@ -1108,6 +1473,17 @@ bool SqliteAccountState::processSqlQueryNodes(sqlite3_stmt *stmt, std::vector<st
     return sqlResult == SQLITE_DONE;
 }
 
+namespace
+{
+// Closure table with a row per node and each of its ancestors (at 'depth' levels above it), up
+// to the first one not present in 'nodes' (as the recursive queries walking up the parents)
+const char* const ANCESTOR_TABLE = "nodesancestors";
+const char* const ANCESTOR_TABLE_INDEX = "nodesancestorsindex";
+const char* const ANCESTOR_TRIGGER_INSERT = "nodesancestorsinsert";
+const char* const ANCESTOR_TRIGGER_UPDATE = "nodesancestorsupdate";
+const char* const ANCESTOR_TRIGGER_DELETE = "nodesancestorsdelete";
+} // namespace
+
 bool SqliteAccountState::remove(NodeHandle nodehandle)
 {
     if (!db)
@@ -1116,6 +1492,7 @@ bool SqliteAccountState::remove(NodeHandle nodehandle)
     }
 
     checkTransaction();
+    nodesWillChange();
 
     char buf[64];
 
@@ -1135,9 +1512,18 @@ bool SqliteAccountState::removeNodes()
     }
 
     checkTransaction();
+    nodesWillChange();
 
-    int sqlResult = sqlite3_exec(db, "DELETE FROM nodes", 0, 0, NULL);
-    errorHandler(sqlResult, "Delete nodes", false);
+    if (mAncestorIndexReady)
+    {
+        // cheaper than detaching every node from its ancestors by the trigger
+        std::string sql = std::string("DELETE FROM ") + ANCESTOR_TABLE;
+        int sqlResult = sqlite3_exec(db, sql.c_str(), 0, 0, NULL);
+        errorHandler(sqlResult, "Delete ancestors", false);
+    }
+
+    int sqlResult = sqlite3_exec(db, "DELETE FROM nodes", 0, 0, NULL);
+    errorHandler(sqlResult, "Delete nodes", false);
 
     return sqlResult == SQLITE_OK;
 }
@@ -1150,6 +1536,7 @@ void SqliteAccountState::updateCounter(NodeHandle nodeHandle, const std::string&
     }
 
     checkTransaction();
+    nodesWillChange();
 
     int sqlResult = SQLITE_OK;
     if (!mStmtUpdateNode)
@@ -1185,6 +1572,7 @@ void SqliteAccountState::updateCounterAndFlags(NodeHandle nodeHandle, uint64_t f
     }
 
     checkTransaction();
+    nodesWillChange();
 
     int sqlResult = SQLITE_OK;
     if (!mStmtUpdateNodeAndFlags)
@@ -1216,173 +1604,514 @@ void SqliteAccountState::updateCounterAndFlags(NodeHandle nodeHandle, uint64_t f
     sqlite3_reset(mStmtUpdateNodeAndFlags);
 }
 
+namespace
+{
+struct NodesIndexDefinition
+{
+    const char* name;
+    const char* columns;
+    NodesIndex group;
+};
+
+// Secondary indexes of the 'nodes' table (the primary key already has an index by default)
+const NodesIndexDefinition NODES_INDEXES[] = {
+    {"parenthandleindex", "(parenthandle, type, name)", NodesIndex::PARENT},
+    {"fingerprintindex", "(fingerprint)", NodesIndex::FINGERPRINT},
+    {"fingerprintvirtualindex", "(fingerprintVirtual)", NodesIndex::FINGERPRINT},
+#if defined(__ANDROID__) || defined(USE_IOS)
+    {"origFingerprintindex", "(origFingerprint)", NodesIndex::FINGERPRINT},
+#endif
+    {"shareindex", "(share)", NodesIndex::SEARCH},
+    {"ctimeindex", "(type, ctime DESC)", NodesIndex::SEARCH},
+
+    // Column layout of listallnodes*mimeidx mirrors buildOrderByForListAll:
+    //   mimetypeStored  — equality seek for the mandatory MIME filter
+    //   <sort key(s)>   — covers ORDER BY without a filesort
+    //   nodehandle      — unique tiebreaker, avoids extra lookup
+
+    // Index for ORDER_DEFAULT_ASC / ORDER_DEFAULT_DESC.
+    // name COLLATE NATURALNOCASE must carry the collation to match
+    // "name COLLATE NATURALNOCASE" in the ORDER BY.
+    {"listallnodesdefaultmimeidx",
+     "(mimetypeStored, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_MODIFICATION_ASC / ORDER_MODIFICATION_DESC.
+    {"listallnodesmtimemimeidx",
+     "(mimetypeStored, mtime, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_SIZE_ASC / ORDER_SIZE_DESC.
+    {"listallnodessizemimeidx",
+     "(mimetypeStored, sizeVirtual, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_FAV_ASC (ORDER BY fav DESC, name ASC, nodehandle ASC).
+    {"listallnodesfavmimeidx",
+     "(mimetypeStored, fav DESC, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_FAV_DESC (ORDER BY fav ASC, name ASC, nodehandle ASC).
+    {"listallnodesfavdescmimeidx",
+     "(mimetypeStored, fav ASC, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_LABEL_ASC
+    // (ORDER BY CASE WHEN label=0 THEN 1 ELSE 0 END ASC, label ASC, name ASC).
+    // The expression column lets SQLite cover the ORDER BY expression without a filesort.
+    {"listallnodeslabelmimeidx",
+     "(mimetypeStored, (CASE WHEN label = 0 THEN 1 ELSE 0 END), label, "
+     "name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+    // Index for ORDER_LABEL_DESC (ORDER BY label DESC, name ASC, nodehandle ASC).
+    {"listallnodeslabeldescmimeidx",
+     "(mimetypeStored, label DESC, name COLLATE NATURALNOCASE, nodehandle)",
+     NodesIndex::SEARCH},
+
+    {"lexicopraphicindex", "(parenthandle, name, type, nodehandle)", NodesIndex::LEXICOGRAPHIC},
+};
+
+// Full-text index of names, descriptions and tags (folded with 'foldtext'), with the handle of
+// the node as rowid. The trigram tokenizer allows to look for any substring of 3+ characters.
+const char* const FULL_TEXT_TABLE = "nodesfts";
+const char* const FULL_TEXT_TRIGGER_INSERT = "nodesftsinsert";
+const char* const FULL_TEXT_TRIGGER_UPDATE = "nodesftsupdate";
+const char* const FULL_TEXT_TRIGGER_DELETE = "nodesftsdelete";
+
+// Runs the statements inside a savepoint: all or nothing
+int execInSavepoint(sqlite3* db, const char* savepoint, const std::vector<std::string>& statements)
+{
+    const std::string name = savepoint;
+    int result = sqlite3_exec(db, ("SAVEPOINT " + name).c_str(), nullptr, nullptr, nullptr);
+    if (result)
+    {
+        return result;
+    }
+
+    for (const auto& sql: statements)
+    {
+        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+        if (result)
+        {
+            LOG_warn << "Data base error at " << name << ": " << sqlite3_errmsg(db);
+            sqlite3_exec(db, ("ROLLBACK TO " + name).c_str(), nullptr, nullptr, nullptr);
+            sqlite3_exec(db, ("RELEASE " + name).c_str(), nullptr, nullptr, nullptr);
+            return result;
+        }
+    }
+
+    return sqlite3_exec(db, ("RELEASE " + name).c_str(), nullptr, nullptr, nullptr);
+}
+
+// Names of the indexes of NODES_INDEXES that belong to the group
+std::vector<std::string> indexNames(NodesIndex group)
+{
+    std::vector<std::string> names;
+    for (const NodesIndexDefinition& index: NODES_INDEXES)
+    {
+        if (index.group == group)
+        {
+            names.emplace_back(index.name);
+        }
+    }
+    return names;
+}
+} // namespace
+
 void SqliteAccountState::createIndexes(bool enableIndexesForSearching,
-                                       bool enableIndexesForLexicographicalList)
+                                       bool enableIndexesForLexicographicalList,
+                                       bool enableFullTextIndex,
+                                       bool enableAncestorIndex)
 {
+    scheduleIndexes(enableIndexesForSearching,
+                    enableIndexesForLexicographicalList,
+                    enableFullTextIndex,
+                    enableAncestorIndex);
+    while (createNextPendingIndex())
+        ;
+}
+
+void SqliteAccountState::scheduleIndexes(bool enableIndexesForSearching,
+                                         bool enableIndexesForLexicographicalList,
+                                         bool enableFullTextIndex,
+                                         bool enableAncestorIndex)
+{
+    mPendingIndexes.clear();
+    mFullTextIndexPending = false;
+    mAncestorIndexPending = false;
     if (!db)
     {
         return;
     }
 
-    // Create index for column that is not primary key (which already has an index by default)
-    std::string sql =
-        "CREATE INDEX IF NOT EXISTS parenthandleindex on nodes (parenthandle, type, name)";
+    const std::set<std::string> existingIndexes = getExistingIndexes();
+    for (size_t i = 0; i < std::size(NODES_INDEXES); ++i)
+    {
+        const NodesIndexDefinition& index = NODES_INDEXES[i];
+        if ((index.group == NodesIndex::SEARCH && !enableIndexesForSearching) ||
+            (index.group == NodesIndex::LEXICOGRAPHIC && !enableIndexesForLexicographicalList) ||
+            existingIndexes.count(index.name))
+        {
+            continue;
+        }
+
+        mPendingIndexes.push_back(i);
+    }
+
+    // the triggers are created along with the table, once it's populated
+    mFullTextIndexReady = existingIndexes.count(FULL_TEXT_TRIGGER_INSERT) > 0;
+    mFullTextIndexPending = enableFullTextIndex && !mFullTextIndexReady;
+    mAncestorIndexReady = existingIndexes.count(ANCESTOR_TRIGGER_INSERT) > 0;
+    mAncestorIndexPending = enableAncestorIndex && !mAncestorIndexReady;
+
+    LOG_debug << "DB indexes scheduled: "
+              << mPendingIndexes.size() + mFullTextIndexPending + mAncestorIndexPending;
+}
+
+bool SqliteAccountState::createNextPendingIndex()
+{
+    if (!db)
+    {
+        return false;
+    }
+
+    if (mPendingIndexes.empty())
+    {
+        if (mFullTextIndexPending)
+        {
+            // not retried if it fails (i.e. SQLite built without FTS5): searches scan the nodes
+            mFullTextIndexPending = false;
+            nodesWillChange(); // the readers don't see the index until it's committed
+            mFullTextIndexReady = createFullTextIndex();
+            return mAncestorIndexPending;
+        }
+        if (mAncestorIndexPending)
+        {
+            // not retried either: isAncestor() and listAllNodesByPage() walk up the parents
+            mAncestorIndexPending = false;
+            nodesWillChange();
+            mAncestorIndexReady = createAncestorIndex();
+        }
+        return false;
+    }
+
+    const NodesIndexDefinition& index = NODES_INDEXES[mPendingIndexes.front()];
+    const std::string sql = std::string("CREATE INDEX IF NOT EXISTS ") + index.name +
+                            " on nodes " + index.columns;
+
+    const auto start = std::chrono::steady_clock::now();
     int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
     if (result)
     {
-        LOG_err << "Data base error while creating index (parenthandleindex): " << sqlite3_errmsg(db);
+        LOG_err << "Data base error while creating index (" << index.name
+                << "): " << sqlite3_errmsg(db);
+    }
+    else
+    {
+        LOG_debug << "DB index " << index.name << " created in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count()
+                  << " ms";
     }
 
-    sql = "CREATE INDEX IF NOT EXISTS fingerprintindex on nodes (fingerprint)";
-    result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-    if (result)
+    // an index that fails to be created is not retried, as with the previous
+    // CREATE INDEX at the end of fetchnodes. Queries still work without it.
+    mPendingIndexes.pop_front();
+    return !mPendingIndexes.empty() || mFullTextIndexPending || mAncestorIndexPending;
+}
+
+bool SqliteAccountState::isIndexReady(NodesIndex index) const
+{
+    if (index == NodesIndex::FULL_TEXT)
     {
-        LOG_err << "Data base error while creating index (fingerprintindex): " << sqlite3_errmsg(db);
+        return mFullTextIndexReady;
     }
 
-    sql = "CREATE INDEX IF NOT EXISTS fingerprintvirtualindex on nodes (fingerprintVirtual)";
-    result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-    if (result)
+    if (index == NodesIndex::ANCESTORS)
     {
-        LOG_err << "Data base error while creating index (fingerprintvirtualindex): "
-                << sqlite3_errmsg(db);
+        return mAncestorIndexReady;
     }
 
-#if defined( __ANDROID__) || defined(USE_IOS)
-    sql = "CREATE INDEX IF NOT EXISTS origFingerprintindex on nodes (origFingerprint)";
-    result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-    if (result)
+    return std::none_of(mPendingIndexes.begin(),
+                        mPendingIndexes.end(),
+                        [index](size_t i)
+                        {
+                            return NODES_INDEXES[i].group == index;
+                        });
+}
+
+void SqliteAccountState::dropIndexesForBulkLoad()
+{
+    mPendingIndexes.clear();
+    mFullTextIndexPending = false;
+    mAncestorIndexPending = false;
+    if (!db)
     {
-        LOG_err << "Data base error while creating index (origFingerprintindex): " << sqlite3_errmsg(db);
+        return;
     }
-#endif
 
-    if (enableIndexesForSearching)
+    checkTransaction();
+    nodesWillChange();
+
+    // DROP INDEX fails while there are statements in progress
+    finalise();
+
+    const std::set<std::string> existingIndexes = getExistingIndexes();
+    for (size_t i = 0; i < std::size(NODES_INDEXES); ++i)
     {
-        sql = "CREATE INDEX IF NOT EXISTS shareindex on nodes (share)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
+        const NodesIndexDefinition& index = NODES_INDEXES[i];
+        if (!existingIndexes.count(index.name))
         {
-            LOG_err << "Data base error while creating index (shareindex): " << sqlite3_errmsg(db);
+            continue;
         }
 
-        sql = "CREATE INDEX IF NOT EXISTS ctimeindex on nodes (type, ctime DESC)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
+        const std::string sql = std::string("DROP INDEX ") + index.name;
+        if (int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+            result != SQLITE_OK)
         {
-            LOG_err << "Data base error while creating index (ctimeindex): " << sqlite3_errmsg(db);
+            errorHandler(result, std::string("Drop index (") + index.name + ")", false);
+            continue;
         }
 
-        // Column layout mirrors buildOrderByForListAll:
-        //   mimetypeVirtual — equality seek for the mandatory MIME filter
-        //   <sort key(s)>   — covers ORDER BY without a filesort
-        //   nodehandle      — unique tiebreaker, avoids extra lookup
+        // reported as not ready until it's built again
+        mPendingIndexes.push_back(i);
+    }
 
-        // Index for ORDER_DEFAULT_ASC / ORDER_DEFAULT_DESC.
-        // name COLLATE NATURALNOCASE must carry the collation to match
-        // "name COLLATE NATURALNOCASE" in the ORDER BY.
-        sql = "CREATE INDEX IF NOT EXISTS listallnodesdefaultidx on nodes "
-              "(mimetypeVirtual, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
-        {
-            LOG_err << "Data base error while creating index (listallnodesdefaultidx): "
-                    << sqlite3_errmsg(db);
-        }
+    // without triggers, the bulk load doesn't update them either
+    dropFullTextIndex();
+    dropAncestorIndex();
+}
 
-        // Index for ORDER_MODIFICATION_ASC / ORDER_MODIFICATION_DESC.
-        sql = "CREATE INDEX IF NOT EXISTS listallnodesmtimeidx on nodes "
-              "(mimetypeVirtual, mtime, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
-        {
-            LOG_err << "Data base error while creating index (listallnodesmtimeidx): "
-                    << sqlite3_errmsg(db);
-        }
+bool SqliteAccountState::createFullTextIndex()
+{
+    using namespace std::string_literals;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::string columns = "rowid, name, description, tags";
+    const std::string insertNew =
+        "INSERT INTO "s + FULL_TEXT_TABLE + " (" + columns + ") VALUES (new.nodehandle, "
+        "foldtext(new.name), foldtext(new.description), foldtext(new.tags)); ";
+    const std::string deleteNew =
+        "DELETE FROM "s + FULL_TEXT_TABLE + " WHERE rowid = new.nodehandle; ";
+    const std::string deleteOld =
+        "DELETE FROM "s + FULL_TEXT_TABLE + " WHERE rowid = old.nodehandle; ";
+
+    // INSERT OR REPLACE into 'nodes' doesn't fire the delete trigger for the replaced row
+    const std::vector<std::string> statements{
+        "CREATE VIRTUAL TABLE IF NOT EXISTS "s + FULL_TEXT_TABLE +
+            " USING fts5(name, description, tags, tokenize = 'trigram')",
+        "DELETE FROM "s + FULL_TEXT_TABLE,
+        "INSERT INTO "s + FULL_TEXT_TABLE + " (" + columns +
+            ") SELECT nodehandle, foldtext(name), foldtext(description), foldtext(tags) "
+            "FROM nodes",
+        "CREATE TRIGGER IF NOT EXISTS "s + FULL_TEXT_TRIGGER_INSERT +
+            " AFTER INSERT ON nodes BEGIN " + deleteNew + insertNew + "END",
+        "CREATE TRIGGER IF NOT EXISTS "s + FULL_TEXT_TRIGGER_UPDATE +
+            " AFTER UPDATE OF name, description, tags ON nodes BEGIN " + deleteOld + insertNew +
+            "END",
+        "CREATE TRIGGER IF NOT EXISTS "s + FULL_TEXT_TRIGGER_DELETE +
+            " AFTER DELETE ON nodes BEGIN " + deleteOld + "END"};
+
+    // all or nothing: the index is only used once the triggers exist
+    if (int result = execInSavepoint(db, "fulltextindex", statements); result != SQLITE_OK)
+    {
+        // i.e. FTS5 or its trigram tokenizer (SQLite 3.34+) not available
+        LOG_warn << "Full-text index not created";
+        return false;
+    }
 
-        // Index for ORDER_SIZE_ASC / ORDER_SIZE_DESC.
-        sql = "CREATE INDEX IF NOT EXISTS listallnodessizeidx on nodes "
-              "(mimetypeVirtual, sizeVirtual, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
-        {
-            LOG_err << "Data base error while creating index (listallnodessizeidx): "
-                    << sqlite3_errmsg(db);
-        }
+    LOG_debug << "DB full-text index created in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms";
 
-        // Index for ORDER_FAV_ASC (ORDER BY fav DESC, name ASC, nodehandle ASC).
-        sql = "CREATE INDEX IF NOT EXISTS listallnodesfavidx on nodes "
-              "(mimetypeVirtual, fav DESC, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
-        {
-            LOG_err << "Data base error while creating index (listallnodesfavidx): "
-                    << sqlite3_errmsg(db);
-        }
+    return true;
+}
 
-        // Index for ORDER_FAV_DESC (ORDER BY fav ASC, name ASC, nodehandle ASC).
-        sql = "CREATE INDEX IF NOT EXISTS listallnodesfavdescidx on nodes "
-              "(mimetypeVirtual, fav ASC, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
-        {
-            LOG_err << "Data base error while creating index (listallnodesfavdescidx): "
-                    << sqlite3_errmsg(db);
-        }
+void SqliteAccountState::dropFullTextIndex()
+{
+    using namespace std::string_literals;
 
-        // Index for ORDER_LABEL_ASC
-        // (ORDER BY CASE WHEN label=0 THEN 1 ELSE 0 END ASC, label ASC, name ASC).
-        // The expression column lets SQLite cover the ORDER BY expression without a filesort.
-        sql = "CREATE INDEX IF NOT EXISTS listallnodeslabelidx on nodes "
-              "(mimetypeVirtual, (CASE WHEN label = 0 THEN 1 ELSE 0 END), label, "
-              "name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
+    mFullTextIndexReady = false;
+    nodesWillChange();
+
+    const std::vector<std::string> statements{
+        "DROP TRIGGER IF EXISTS "s + FULL_TEXT_TRIGGER_INSERT,
+        "DROP TRIGGER IF EXISTS "s + FULL_TEXT_TRIGGER_UPDATE,
+        "DROP TRIGGER IF EXISTS "s + FULL_TEXT_TRIGGER_DELETE,
+        "DROP TABLE IF EXISTS "s + FULL_TEXT_TABLE};
+
+    for (const auto& sql: statements)
+    {
+        if (int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+            result != SQLITE_OK)
         {
-            LOG_err << "Data base error while creating index (listallnodeslabelidx): "
-                    << sqlite3_errmsg(db);
+            errorHandler(result, "Drop full-text index", false);
         }
+    }
+}
 
-        // Index for ORDER_LABEL_DESC (ORDER BY label DESC, name ASC, nodehandle ASC).
-        sql = "CREATE INDEX IF NOT EXISTS listallnodeslabeldescidx on nodes "
-              "(mimetypeVirtual, label DESC, name COLLATE NATURALNOCASE, nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
+bool SqliteAccountState::createAncestorIndex()
+{
+    using namespace std::string_literals;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::string table = ANCESTOR_TABLE;
+
+    // Detaches the subtree of a node (the node and the rows having it as ancestor) from the
+    // ancestors of the node. The reads and the deletions of each statement touch different rows
+    const auto detach = [&table](const std::string& node)
+    {
+        return "DELETE FROM " + table + " WHERE nodehandle IN (SELECT nodehandle FROM " + table +
+               " WHERE ancestor = " + node + ") AND ancestor IN (SELECT ancestor FROM " + table +
+               " WHERE nodehandle = " + node + "); DELETE FROM " + table +
+               " WHERE nodehandle = " + node + "; ";
+    };
+
+    // Attaches the subtree of the new node below its parent and the ancestors of the parent.
+    // Children inserted before their parent (i.e. orphans) are attached too
+    const std::string attachNew =
+        "INSERT OR REPLACE INTO " + table +
+        " (nodehandle, ancestor, depth) SELECT S.nodehandle, A.ancestor, S.depth + A.depth FROM "
+        "(SELECT new.nodehandle AS nodehandle, 0 AS depth UNION ALL SELECT nodehandle, depth FROM " +
+        table +
+        " WHERE ancestor = new.nodehandle) AS S, "
+        "(SELECT new.parenthandle AS ancestor, 1 AS depth UNION ALL SELECT ancestor, depth + 1 "
+        "FROM " +
+        table + " WHERE nodehandle = new.parenthandle) AS A; ";
+
+    // put() updates nodes with INSERT OR REPLACE, so the insert trigger handles moves too. It
+    // only does something when the parent changes, which is checked with the row at depth 1.
+    // Deleted nodes keep the links from their subtree to them, but not to their ancestors,
+    // so the results match walking up the parents until one is missing
+    const std::vector<std::string> statements{
+        "CREATE TABLE IF NOT EXISTS " + table +
+            " (nodehandle INTEGER NOT NULL, ancestor INTEGER NOT NULL, depth INTEGER NOT NULL, "
+            "PRIMARY KEY (nodehandle, ancestor)) WITHOUT ROWID",
+        "CREATE INDEX IF NOT EXISTS "s + ANCESTOR_TABLE_INDEX + " ON " + table +
+            " (ancestor, nodehandle)",
+        "DELETE FROM " + table,
+        "INSERT INTO " + table +
+            " (nodehandle, ancestor, depth) WITH RECURSIVE up(nodehandle, ancestor, depth) AS "
+            "(SELECT nodehandle, parenthandle, 1 FROM nodes UNION ALL SELECT up.nodehandle, "
+            "N.parenthandle, up.depth + 1 FROM up INNER JOIN nodes AS N ON "
+            "(N.nodehandle = up.ancestor)) SELECT nodehandle, ancestor, depth FROM up",
+        "CREATE TRIGGER IF NOT EXISTS "s + ANCESTOR_TRIGGER_INSERT +
+            " AFTER INSERT ON nodes WHEN NOT EXISTS (SELECT 1 FROM " + table +
+            " WHERE nodehandle = new.nodehandle AND ancestor = new.parenthandle AND depth = 1) "
+            "BEGIN " +
+            detach("new.nodehandle") + attachNew + "END",
+        "CREATE TRIGGER IF NOT EXISTS "s + ANCESTOR_TRIGGER_UPDATE +
+            " AFTER UPDATE OF parenthandle ON nodes WHEN old.parenthandle IS NOT "
+            "new.parenthandle BEGIN " +
+            detach("new.nodehandle") + attachNew + "END",
+        "CREATE TRIGGER IF NOT EXISTS "s + ANCESTOR_TRIGGER_DELETE +
+            " AFTER DELETE ON nodes BEGIN " + detach("old.nodehandle") + "END"};
+
+    // all or nothing: the index is only used once the triggers exist
+    if (int result = execInSavepoint(db, "ancestorindex", statements); result != SQLITE_OK)
+    {
+        errorHandler(result, "Create ancestor index", false);
+        return false;
+    }
+
+    LOG_debug << "DB ancestor index created in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms";
+
+    return true;
+}
+
+void SqliteAccountState::dropAncestorIndex()
+{
+    using namespace std::string_literals;
+
+    mAncestorIndexReady = false;
+    nodesWillChange();
+
+    const std::vector<std::string> statements{
+        "DROP TRIGGER IF EXISTS "s + ANCESTOR_TRIGGER_INSERT,
+        "DROP TRIGGER IF EXISTS "s + ANCESTOR_TRIGGER_UPDATE,
+        "DROP TRIGGER IF EXISTS "s + ANCESTOR_TRIGGER_DELETE,
+        "DROP TABLE IF EXISTS "s + ANCESTOR_TABLE};
+
+    for (const auto& sql: statements)
+    {
+        if (int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+            result != SQLITE_OK)
         {
-            LOG_err << "Data base error while creating index (listallnodeslabeldescidx): "
-                    << sqlite3_errmsg(db);
+            errorHandler(result, "Drop ancestor index", false);
         }
     }
-    if (enableIndexesForLexicographicalList)
+}
+
+std::set<std::string> SqliteAccountState::getExistingIndexes()
+{
+    std::set<std::string> indexes;
+
+    sqlite3_stmt* stmt = nullptr;
+    const char* query = "SELECT name FROM sqlite_master WHERE type IN ('index', 'trigger') AND "
+                        "tbl_name = 'nodes'";
+    if (int result = sqlite3_prepare_v2(db, query, -1, &stmt, nullptr); result != SQLITE_OK)
     {
-        sql = "CREATE INDEX IF NOT EXISTS lexicopraphicindex on nodes (parenthandle, name, type, "
-              "nodehandle)";
-        result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
-        if (result)
+        errorHandler(result, "Get indexes", false);
+        return indexes;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+        if (auto name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)))
         {
-            LOG_err << "Data base error while creating index (lexicopraphicindex): "
-                    << sqlite3_errmsg(db);
+            indexes.emplace(name);
         }
     }
+    sqlite3_finalize(stmt);
+
+    return indexes;
 }
 
 void SqliteAccountState::dropSearchDBIndexes()
 {
-    dropDBIndexes({"shareindex",
-                   "favindex",
-                   "ctimeindex",
-                   "listallnodesdefaultidx",
-                   "listallnodesmtimeidx",
-                   "listallnodessizeidx",
-                   "listallnodesfavidx",
-                   "listallnodesfavdescidx",
-                   "listallnodeslabelidx",
-                   "listallnodeslabeldescidx"});
+    std::vector<std::string> indexes = indexNames(NodesIndex::SEARCH);
+    // no longer created, but it may remain in old DBs
+    indexes.emplace_back("favindex");
+    dropDBIndexes(indexes);
 }
 
 void SqliteAccountState::dropLexicographicDBIndexes()
 {
-    dropDBIndexes({"lexicopraphicindex"});
+    dropDBIndexes(indexNames(NodesIndex::LEXICOGRAPHIC));
+}
+
+void SqliteAccountState::dropFullTextDBIndex()
+{
+    if (!db)
+    {
+        return;
+    }
+
+    assert(!inTransaction());
+    // Finalise all statements
+    finalise();
+    begin();
+    dropFullTextIndex();
+    commit();
+}
+
+void SqliteAccountState::dropAncestorDBIndex()
+{
+    if (!db)
+    {
+        return;
+    }
+
+    assert(!inTransaction());
+    // Finalise all statements
+    finalise();
+    begin();
+    dropAncestorIndex();
+    commit();
 }
 
 void SqliteAccountState::dropDBIndexes(const std::vector<std::string>& indicesToDelete)
@@ -1430,6 +2159,11 @@ void SqliteAccountState::dropDBIndexes(const std::vector<std::string>& indicesTo
 
 void SqliteAccountState::remove()
 {
+    if (mReaderPool)
+    {
+        mReaderPool->close();
+    }
+
     finalise();
 
     SqliteDbTable::remove();
@@ -1440,6 +2174,9 @@ void SqliteAccountState::finalise()
     sqlite3_finalize(mStmtPutNode);
     mStmtPutNode = nullptr;
 
+    sqlite3_finalize(mStmtPutNodesBatch);
+    mStmtPutNodesBatch = nullptr;
+
     sqlite3_finalize(mStmtUpdateNode);
     mStmtUpdateNode = nullptr;
 
@@ -1458,29 +2195,13 @@ void SqliteAccountState::finalise()
     sqlite3_finalize(mStmtNumChildren);
     mStmtNumChildren = nullptr;
 
-    for (auto& s : mStmtGetChildren)
-    {
-        sqlite3_finalize(s.second);
-    }
-    mStmtGetChildren.clear();
-
     sqlite3_finalize(mStmtGetChildrenLexi);
     mStmtGetChildrenLexi = nullptr;
 
     sqlite3_finalize(mStmtGetChildrenLexiNoOffset);
     mStmtGetChildrenLexiNoOffset = nullptr;
 
-    for (auto& s : mStmtSearchNodes)
-    {
-        sqlite3_finalize(s.second);
-    }
-    mStmtSearchNodes.clear();
-
-    for (auto& s: mStmtListAllNodesByPage)
-    {
-        sqlite3_finalize(s.second);
-    }
-    mStmtListAllNodesByPage.clear();
+    mStmtCache.clear();
 
     sqlite3_finalize(mStmtNodeTagsBelow);
     mStmtNodeTagsBelow = nullptr;
@@ -1497,30 +2218,197 @@ void SqliteAccountState::finalise()
     sqlite3_finalize(mStmtNodesWithInshares);
     mStmtNodesWithInshares = nullptr;
 
-    sqlite3_finalize(mStmtNodesWithOutshares);
-    mStmtNodesWithOutshares = nullptr;
+    sqlite3_finalize(mStmtNodesWithOutshares);
+    mStmtNodesWithOutshares = nullptr;
+
+    sqlite3_finalize(mStmtNodesWithPendingOutshares);
+    mStmtNodesWithPendingOutshares = nullptr;
+
+    sqlite3_finalize(mStmtNodesWithPubLink);
+    mStmtNodesWithPubLink = nullptr;
+
+    sqlite3_finalize(mStmtChildNode);
+    mStmtChildNode = nullptr;
+
+    sqlite3_finalize(mStmtIsAncestor);
+    mStmtIsAncestor = nullptr;
+
+    sqlite3_finalize(mStmtIsAncestorIndexed);
+    mStmtIsAncestorIndexed = nullptr;
+
+    sqlite3_finalize(mStmtNumChild);
+    mStmtNumChild = nullptr;
+
+    sqlite3_finalize(mStmtRecents);
+    mStmtRecents = nullptr;
+
+    sqlite3_finalize(mStmtFavourites);
+    mStmtFavourites = nullptr;
+}
+
+namespace
+{
+
+// Columns written by SqliteAccountState::put() and putBatch(), in this order
+const char* const NODES_PUT_COLUMNS = "nodehandle, parenthandle, name, fingerprint, "
+                                      "origFingerprint, type, share, fav, ctime, mtime, flags, "
+                                      "counter, node, label, description, tags, mimetypeStored";
+constexpr int NUM_NODES_PUT_COLUMNS = 17;
+
+// Rows per statement in SqliteAccountState::putBatch(). It keeps the number of parameters
+// below 999, the default SQLITE_MAX_VARIABLE_NUMBER for SQLite versions prior to 3.32.0.
+// DISABLED_SqliteNodesPerfTest.PerfPutVsPutBatch measures it against one statement per row
+constexpr size_t NODES_PER_BATCH_PUT = 55;
+static_assert(NODES_PER_BATCH_PUT * NUM_NODES_PUT_COLUMNS < 999);
+
+std::string buildNodesPutQuery(size_t numRows)
+{
+    std::string placeholders = "(?";
+    for (int i = 1; i < NUM_NODES_PUT_COLUMNS; ++i)
+    {
+        placeholders += ", ?";
+    }
+    placeholders += ")";
+
+    std::string query = std::string("INSERT OR REPLACE INTO nodes (") + NODES_PUT_COLUMNS +
+                        ") VALUES " + placeholders;
+    for (size_t i = 1; i < numRows; ++i)
+    {
+        query += ", " + placeholders;
+    }
+    return query;
+}
+
+// Values of the columns of a node for the "nodes" table. Text and blobs are bound with
+// SQLITE_STATIC, so the instance must outlive the execution of the statement.
+class NodeRow
+{
+public:
+    explicit NodeRow(Node& node):
+        mNode(node)
+    {
+        node.serialize(&mSerialized);
+        assert(mSerialized.size());
+
+        mName = node.displayname(Node::LOG_CONDITION_DISABLE_NO_KEY);
+        node.FileFingerprint::serialize(&mFingerprint);
+
+        attr_map::const_iterator attrIt = node.attrs.map.find(makeNameid("c0"));
+        if (attrIt != node.attrs.map.end())
+        {
+            mOrigFingerprint = attrIt->second;
+        }
+
+        // node->attrstring has value => node is encrypted
+        nameid favId = AttrMap::string2nameid("fav");
+        auto favIt = node.attrs.map.find(favId);
+        mFav = (favIt != node.attrs.map.end() &&
+                favIt->second == "1"); // test 'fav' attr value (only "1" is valid)
+
+        mCounter = node.getCounter().serialize();
+
+        static nameid labelId = AttrMap::string2nameid("lbl");
+        auto labelIt = node.attrs.map.find(labelId);
+        mLabel = (labelIt == node.attrs.map.end()) ? LBL_UNKNOWN : std::atoi(labelIt->second.c_str());
+
+        nameid descriptionId = AttrMap::string2nameid(MegaClient::NODE_ATTRIBUTE_DESCRIPTION);
+        if (auto descriptionIt = node.attrs.map.find(descriptionId);
+            descriptionIt != node.attrs.map.end())
+        {
+            mDescription = &descriptionIt->second;
+        }
 
-    sqlite3_finalize(mStmtNodesWithPendingOutshares);
-    mStmtNodesWithPendingOutshares = nullptr;
+        nameid tagId = AttrMap::string2nameid(MegaClient::NODE_ATTRIBUTE_TAGS);
+        if (auto tagIt = node.attrs.map.find(tagId); tagIt != node.attrs.map.end())
+        {
+            mTags = &tagIt->second;
+        }
 
-    sqlite3_finalize(mStmtNodesWithPubLink);
-    mStmtNodesWithPubLink = nullptr;
+        // the row is written when the node changes, so this is the only time the category of
+        // the node is evaluated for the DB (searches read the stored value)
+        mMimetype = Node::getMimetypeByName(mName);
+    }
 
-    sqlite3_finalize(mStmtChildNode);
-    mStmtChildNode = nullptr;
+    // Binds the row to the parameters [firstParam, firstParam + NUM_NODES_PUT_COLUMNS)
+    int bind(sqlite3_stmt* stmt, int firstParam) const
+    {
+        int p = firstParam;
+        int result = SQLITE_OK;
+        auto check = [&result](int r)
+        {
+            if (result == SQLITE_OK)
+            {
+                result = r;
+            }
+        };
+
+        check(sqlite3_bind_int64(stmt, p++, static_cast<sqlite3_int64>(mNode.nodehandle)));
+        check(sqlite3_bind_int64(stmt, p++, static_cast<sqlite3_int64>(mNode.parenthandle)));
+        check(sqlite3_bind_text(stmt,
+                                p++,
+                                mName.c_str(),
+                                static_cast<int>(mName.length()),
+                                SQLITE_STATIC));
+        check(sqlite3_bind_blob(stmt,
+                                p++,
+                                mFingerprint.data(),
+                                static_cast<int>(mFingerprint.size()),
+                                SQLITE_STATIC));
+        check(sqlite3_bind_blob(stmt,
+                                p++,
+                                mOrigFingerprint.data(),
+                                static_cast<int>(mOrigFingerprint.size()),
+                                SQLITE_STATIC));
+        check(sqlite3_bind_int(stmt, p++, mNode.type));
+        check(sqlite3_bind_int(stmt, p++, mNode.getShareType()));
+        check(sqlite3_bind_int(stmt, p++, mFav));
+        check(sqlite3_bind_int64(stmt, p++, mNode.ctime));
+        check(sqlite3_bind_int64(stmt, p++, mNode.mtime));
+        check(sqlite3_bind_int64(stmt, p++, static_cast<sqlite3_int64>(mNode.getDBFlags())));
+        check(sqlite3_bind_blob(stmt,
+                                p++,
+                                mCounter.data(),
+                                static_cast<int>(mCounter.size()),
+                                SQLITE_STATIC));
+        check(sqlite3_bind_blob(stmt,
+                                p++,
+                                mSerialized.data(),
+                                static_cast<int>(mSerialized.size()),
+                                SQLITE_STATIC));
+        check(sqlite3_bind_int(stmt, p++, mLabel));
+
+        for (const std::string* text: {mDescription, mTags})
+        {
+            check(text ? sqlite3_bind_text(stmt,
+                                           p,
+                                           text->c_str(),
+                                           static_cast<int>(text->length()),
+                                           SQLITE_STATIC) :
+                         sqlite3_bind_null(stmt, p));
+            ++p;
+        }
 
-    sqlite3_finalize(mStmtIsAncestor);
-    mStmtIsAncestor = nullptr;
+        check(sqlite3_bind_int(stmt, p++, mMimetype));
 
-    sqlite3_finalize(mStmtNumChild);
-    mStmtNumChild = nullptr;
+        assert(p == firstParam + NUM_NODES_PUT_COLUMNS);
+        return result;
+    }
 
-    sqlite3_finalize(mStmtRecents);
-    mStmtRecents = nullptr;
+private:
+    const Node& mNode;
+    std::string mSerialized;
+    std::string mName;
+    std::string mFingerprint;
+    std::string mOrigFingerprint;
+    std::string mCounter;
+    bool mFav = false;
+    int mLabel = LBL_UNKNOWN;
+    const std::string* mDescription = nullptr;
+    const std::string* mTags = nullptr;
+    MimeType_t mMimetype = MimeType_t::MIME_TYPE_UNKNOWN;
+};
 
-    sqlite3_finalize(mStmtFavourites);
-    mStmtFavourites = nullptr;
-}
+} // anonymous namespace (put helpers)
 
 bool SqliteAccountState::put(Node *node)
 {
@@ -1530,114 +2418,97 @@ bool SqliteAccountState::put(Node *node)
     }
 
     checkTransaction();
+    nodesWillChange();
 
     int sqlResult = SQLITE_OK;
     if (!mStmtPutNode)
     {
         sqlResult =
-            sqlite3_prepare_v2(db,
-                               "INSERT OR REPLACE INTO nodes (nodehandle, parenthandle, "
-                               "name, fingerprint, origFingerprint, type, share, fav, ctime, "
-                               "mtime, flags, counter, node, label, description, tags) "
-                               "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
-                               -1,
-                               &mStmtPutNode,
-                               NULL);
+            sqlite3_prepare_v2(db, buildNodesPutQuery(1).c_str(), -1, &mStmtPutNode, NULL);
     }
 
     if (sqlResult == SQLITE_OK)
     {
-        string nodeSerialized;
-        node->serialize(&nodeSerialized);
-        assert(nodeSerialized.size());
-
-        sqlite3_bind_int64(mStmtPutNode, 1, static_cast<sqlite3_int64>(node->nodehandle));
-        sqlite3_bind_int64(mStmtPutNode, 2, static_cast<sqlite3_int64>(node->parenthandle));
-
-        std::string name = node->displayname(Node::LOG_CONDITION_DISABLE_NO_KEY);
-        sqlite3_bind_text(mStmtPutNode, 3, name.c_str(), static_cast<int>(name.length()), SQLITE_STATIC);
-
-        string fp;
-        node->FileFingerprint::serialize(&fp);
-        sqlite3_bind_blob(mStmtPutNode, 4, fp.data(), static_cast<int>(fp.size()), SQLITE_STATIC);
-
-        std::string origFingerprint;
-        attr_map::const_iterator attrIt = node->attrs.map.find(makeNameid("c0"));
-        if (attrIt != node->attrs.map.end())
+        NodeRow row(*node);
+        if ((sqlResult = row.bind(mStmtPutNode, 1)) == SQLITE_OK)
         {
-           origFingerprint = attrIt->second;
+            sqlResult = sqlite3_step(mStmtPutNode);
         }
-        sqlite3_bind_blob(mStmtPutNode, 5, origFingerprint.data(), static_cast<int>(origFingerprint.size()), SQLITE_STATIC);
+    }
 
-        sqlite3_bind_int(mStmtPutNode, 6, node->type);
+    errorHandler(sqlResult, "Put node", false);
 
-        int shareType = node->getShareType();
-        sqlite3_bind_int(mStmtPutNode, 7, shareType);
+    sqlite3_reset(mStmtPutNode);
 
-        // node->attrstring has value => node is encrypted
-        nameid favId = AttrMap::string2nameid("fav");
-        auto favIt = node->attrs.map.find(favId);
-        bool fav = (favIt != node->attrs.map.end() && favIt->second == "1"); // test 'fav' attr value (only "1" is valid)
-        sqlite3_bind_int(mStmtPutNode, 8, fav);
-        sqlite3_bind_int64(mStmtPutNode, 9, node->ctime);
-        sqlite3_bind_int64(mStmtPutNode, 10, node->mtime);
-        sqlite3_bind_int64(mStmtPutNode, 11, static_cast<sqlite3_int64>(node->getDBFlags()));
-        std::string nodeCountersBlob = node->getCounter().serialize();
-        sqlite3_bind_blob(mStmtPutNode,
-                          12,
-                          nodeCountersBlob.data(),
-                          static_cast<int>(nodeCountersBlob.size()),
-                          SQLITE_STATIC);
-        sqlite3_bind_blob(mStmtPutNode,
-                          13,
-                          nodeSerialized.data(),
-                          static_cast<int>(nodeSerialized.size()),
-                          SQLITE_STATIC);
+    return sqlResult == SQLITE_DONE;
+}
 
-        static nameid labelId = AttrMap::string2nameid("lbl");
-        auto labelIt = node->attrs.map.find(labelId);
-        int label = (labelIt == node->attrs.map.end()) ? LBL_UNKNOWN : std::atoi(labelIt->second.c_str());
-        sqlite3_bind_int(mStmtPutNode, 14, label);
+bool SqliteAccountState::putBatch(const std::vector<Node*>& nodes)
+{
+    if (!db)
+    {
+        return false;
+    }
 
-        nameid descriptionId = AttrMap::string2nameid(MegaClient::NODE_ATTRIBUTE_DESCRIPTION);
-        if (auto descriptionIt = node->attrs.map.find(descriptionId);
-            descriptionIt != node->attrs.map.end())
-        {
-            const std::string& description = descriptionIt->second;
-            sqlite3_bind_text(mStmtPutNode,
-                              15,
-                              description.c_str(),
-                              static_cast<int>(description.length()),
-                              SQLITE_STATIC);
-        }
-        else
-        {
-            sqlite3_bind_null(mStmtPutNode, 15);
-        }
+    checkTransaction();
+    nodesWillChange();
 
-        nameid tagId = AttrMap::string2nameid(MegaClient::NODE_ATTRIBUTE_TAGS);
-        if (auto tagIt = node->attrs.map.find(tagId); tagIt != node->attrs.map.end())
+    size_t i = 0;
+    int sqlResult = SQLITE_DONE;
+    if (nodes.size() >= NODES_PER_BATCH_PUT && !mStmtPutNodesBatch)
+    {
+        sqlResult = sqlite3_prepare_v2(db,
+                                       buildNodesPutQuery(NODES_PER_BATCH_PUT).c_str(),
+                                       -1,
+                                       &mStmtPutNodesBatch,
+                                       NULL);
+        if (sqlResult != SQLITE_OK)
         {
-            const std::string& tag = tagIt->second;
-            sqlite3_bind_text(mStmtPutNode,
-                              16,
-                              tag.c_str(),
-                              static_cast<int>(tag.length()),
-                              SQLITE_STATIC);
+            errorHandler(sqlResult, "Put nodes batch", false);
+            sqlResult = SQLITE_DONE; // fallback to one statement per node
         }
-        else
+    }
+
+    if (mStmtPutNodesBatch)
+    {
+        std::vector<NodeRow> rows;
+        rows.reserve(NODES_PER_BATCH_PUT);
+        for (; i + NODES_PER_BATCH_PUT <= nodes.size() && sqlResult == SQLITE_DONE;
+             i += NODES_PER_BATCH_PUT)
         {
-            sqlite3_bind_null(mStmtPutNode, 16);
-        }
+            rows.clear();
+            sqlResult = SQLITE_OK;
+            for (size_t j = 0; j < NODES_PER_BATCH_PUT && sqlResult == SQLITE_OK; ++j)
+            {
+                rows.emplace_back(*nodes[i + j]);
+                sqlResult =
+                    rows.back().bind(mStmtPutNodesBatch,
+                                     1 + static_cast<int>(j) * NUM_NODES_PUT_COLUMNS);
+            }
 
-        sqlResult = sqlite3_step(mStmtPutNode);
+            if (sqlResult == SQLITE_OK)
+            {
+                sqlResult = sqlite3_step(mStmtPutNodesBatch);
+            }
+
+            errorHandler(sqlResult, "Put nodes batch", false);
+            sqlite3_reset(mStmtPutNodesBatch);
+        }
     }
 
-    errorHandler(sqlResult, "Put node", false);
+    if (sqlResult != SQLITE_DONE)
+    {
+        return false;
+    }
 
-    sqlite3_reset(mStmtPutNode);
+    // remaining nodes, not enough to fill a batch
+    bool result = true;
+    for (; i < nodes.size(); ++i)
+    {
+        result = put(nodes[i]) && result;
+    }
 
-    return sqlResult == SQLITE_DONE;
+    return result;
 }
 
 bool SqliteAccountState::getNode(NodeHandle nodehandle, NodeSerialized &nodeSerialized)
@@ -1970,7 +2841,7 @@ bool SqliteAccountState::getChildren(const mega::NodeSearchFilter& filter,
     // There are multiple criteria used in ORDER BY clause.
     // For every order type a new statement is created
     const size_t cacheId = OrderByClause::getId(order);
-    sqlite3_stmt*& stmt = mStmtGetChildren[cacheId];
+    sqlite3_stmt*& stmt = mStmtCache.acquire(SqliteStatementCache::Query::GET_CHILDREN, cacheId);
 
     int sqlResult = SQLITE_OK;
     static const QueryTagId idParentHand{1};
@@ -1992,7 +2863,7 @@ bool SqliteAccountState::getChildren(const mega::NodeSearchFilter& filter,
             "FROM nodes "
             "WHERE (parenthandle = " + idParentHand + ") "
             "AND (flags & " + idVerFlag + ") = 0 " // bound to versionFlag to skip, or 0 to include
-            "AND matchFilter(" + idFilter + ", flags, type, ctime, mtime, mimetypeVirtual, name, description, tags, fav)"
+            "AND matchFilter(" + idFilter + ", flags, type, ctime, mtime, mimetypeStored, name, description, tags, fav)"
             "ORDER BY \n" +
             OrderByClause::get(order) + " \n" +
             "LIMIT " + idPageSize + " OFFSET " + idPageOff;
@@ -2293,6 +3164,196 @@ auto SqliteAccountState::getNodeTagsBelow(CancelToken cancelToken,
     return std::optional<decltype(tags)>(std::in_place, std::move(tags));
 }
 
+namespace
+{
+// Longest sequence of characters without wildcards of a pattern for likeCompare(), unescaped
+std::string longestLiteral(const std::string& pattern)
+{
+    std::string longest;
+    std::string current;
+    bool escaped = false;
+    for (char c: pattern)
+    {
+        if (!escaped && c == ESCAPE_CHARACTER)
+        {
+            escaped = true;
+            continue;
+        }
+
+        if (!escaped && (c == WILDCARD_MATCH_ALL || c == WILDCARD_MATCH_ONE))
+        {
+            if (current.size() > longest.size())
+            {
+                longest.swap(current);
+            }
+            current.clear();
+            continue;
+        }
+
+        escaped = false;
+        current.push_back(c);
+    }
+
+    return current.size() > longest.size() ? current : longest;
+}
+
+// FTS5 condition matching (a superset of) the nodes whose 'column' matches 'pattern'.
+// Empty if the full-text index can't be used: trigrams need at least 3 characters.
+std::string fullTextCondition(const char* column, const std::string& pattern)
+{
+    const std::string literal = foldCaseAndAccents(longestLiteral(pattern));
+    const auto numChars = std::count_if(literal.begin(),
+                                        literal.end(),
+                                        [](char c)
+                                        {
+                                            // not a continuation byte of UTF-8
+                                            return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+                                        });
+    if (numChars < 3)
+    {
+        return {};
+    }
+
+    std::string condition = std::string(column) + " : \"";
+    for (char c: literal)
+    {
+        if (c == '"')
+        {
+            condition.push_back('"');
+        }
+        condition.push_back(c);
+    }
+    condition.push_back('"');
+    return condition;
+}
+
+// FTS5 query for the text filters of 'filter', or empty if the nodes have to be scanned instead.
+// The query may match more nodes than the filter (matchFilter() is still applied to them).
+std::string buildFullTextQuery(const NodeSearchFilter& filter)
+{
+    std::vector<std::string> conditions;
+    size_t numTextFilters = 0;
+    auto addCondition = [&conditions, &numTextFilters](const char* column,
+                                                       const std::string& pattern)
+    {
+        ++numTextFilters;
+        if (std::string condition = fullTextCondition(column, pattern); !condition.empty())
+        {
+            conditions.push_back(std::move(condition));
+        }
+    };
+
+    if (filter.hasName())
+        addCondition("name", filter.byName());
+    if (filter.hasDescription())
+        addCondition("description", filter.byDescription());
+    if (filter.hasTag())
+        addCondition("tags", filter.byTag());
+
+    if (conditions.empty())
+    {
+        return {};
+    }
+
+    if (filter.useAndForTextQuery())
+    {
+        // any of the conditions is enough to narrow down the candidates
+        return joinStrings(conditions.begin(), conditions.end(), " AND ");
+    }
+
+    // with OR, a filter that can't use the index could match any node
+    return conditions.size() == numTextFilters ?
+               joinStrings(conditions.begin(), conditions.end(), " OR ") :
+               std::string();
+}
+
+// Values of mimetypeStored accepted by the category filter, as userMatchFilter() evaluates it
+// (the group categories are never stored, only the ones they include)
+constexpr size_t MAX_SEARCH_CATEGORIES = 4; // MIME_TYPE_ALL_DOCS
+
+std::vector<int> storedCategoriesOf(const NodeSearchFilter& filter)
+{
+    std::vector<int> categories;
+    for (int c = MIME_TYPE_PHOTO; c <= MIME_TYPE_OTHERS; ++c)
+    {
+        if (c != MIME_TYPE_ALL_DOCS && filter.isValidCategory(static_cast<MimeType_t>(c), FILENODE))
+        {
+            categories.push_back(c);
+        }
+    }
+    assert(categories.size() <= MAX_SEARCH_CATEGORIES);
+    return categories;
+}
+
+// Walking up from a candidate costs a lookup per level, walking down costs about one per node, so
+// the candidates have to be a fraction of the nodes below the ancestors to be worth it
+constexpr uint64_t CATEGORY_WALK_UP_COST = 4;
+} // namespace
+
+bool SqliteAccountState::isCategorySelective(const NodeSearchFilter& filter,
+                                             const std::vector<int>& categories)
+{
+    // nodes below the ancestors, from their counters (all the nodes if they are not calculated)
+    uint64_t nodesBelow = 0;
+    sqlite3_stmt* stmt = nullptr;
+    int sqlResult =
+        sqlite3_prepare_v2(db, "SELECT counter FROM nodes WHERE nodehandle = ?", -1, &stmt, NULL);
+    for (handle ancestor: filter.byAncestorHandles())
+    {
+        if (sqlResult != SQLITE_OK || ancestor == UNDEF)
+        {
+            continue;
+        }
+
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(ancestor));
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_bytes(stmt, 0) > 0)
+        {
+            NodeCounter counter(
+                std::string_view(static_cast<const char*>(sqlite3_column_blob(stmt, 0)),
+                                 static_cast<size_t>(sqlite3_column_bytes(stmt, 0))));
+            nodesBelow += counter.files + counter.folders;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (!nodesBelow)
+    {
+        nodesBelow = getNumberOfNodes();
+    }
+
+    // the index tells how many candidates there are, without counting beyond the limit
+    const uint64_t maxCandidates = nodesBelow / CATEGORY_WALK_UP_COST;
+    uint64_t candidates = maxCandidates;
+    sqlResult = sqlite3_prepare_v2(db,
+                                   "SELECT count(*) FROM (SELECT 1 FROM nodes "
+                                   "WHERE mimetypeStored IN (?1, ?2, ?3, ?4) LIMIT ?5)",
+                                   -1,
+                                   &stmt,
+                                   NULL);
+    for (int i = 0; i < static_cast<int>(MAX_SEARCH_CATEGORIES) && sqlResult == SQLITE_OK; ++i)
+    {
+        const size_t c = std::min(static_cast<size_t>(i), categories.size() - 1);
+        sqlResult = sqlite3_bind_int(stmt, i + 1, categories[c]);
+    }
+    if (sqlResult == SQLITE_OK)
+    {
+        sqlResult =
+            sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(maxCandidates));
+    }
+    if (sqlResult == SQLITE_OK && (sqlResult = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        candidates = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+    }
+    else
+    {
+        errorHandler(sqlResult, "Count nodes by category", true);
+    }
+    sqlite3_finalize(stmt);
+
+    return candidates < maxCandidates;
+}
+
 bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
                                      int order,
                                      vector<pair<NodeHandle, NodeSerialized>>& nodes,
@@ -2308,10 +3369,28 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
                                  SqliteAccountState::progressHandler,
                                  static_cast<void*>(&cancelFlag));
 
+    // With the full-text index, the candidates are the nodes matching the text filters, which are
+    // kept only if they are below the ancestors. Likewise with the index on mimetypeStored for the
+    // nodes of a category, if they are few. Otherwise, all the nodes below the ancestors are
+    // scanned. The shares included by the filter are not counted, so they are always scanned.
+    const std::string fullTextQuery =
+        mFullTextIndexReady ? buildFullTextQuery(filter) : std::string();
+    const bool useFullText = !fullTextQuery.empty();
+    const std::vector<int> categories =
+        filter.hasCategory() ? storedCategoriesOf(filter) : std::vector<int>();
+    const bool useCategoryIndex = !useFullText && !categories.empty() &&
+                                  filter.includedShares() == NO_SHARES &&
+                                  isIndexReady(NodesIndex::SEARCH) &&
+                                  isCategorySelective(filter, categories);
+
     // There are multiple criteria used in ORDER BY clause.
     // For every order type a new statement is created
     size_t cacheId = OrderByClause::getId(order);
-    sqlite3_stmt*& stmt = mStmtSearchNodes[cacheId];
+    sqlite3_stmt*& stmt = mStmtCache.acquire(
+        useFullText      ? SqliteStatementCache::Query::SEARCH_NODES_FULL_TEXT :
+        useCategoryIndex ? SqliteStatementCache::Query::SEARCH_NODES_CATEGORY :
+                           SqliteStatementCache::Query::SEARCH_NODES,
+        cacheId);
 
     static const QueryTagId idVerFlag{1};
     static const QueryTagId idName{2};
@@ -2324,6 +3403,11 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
     static const QueryTagId idSensFlag{9};
     static const QueryTagId idIncShares{10};
     static const QueryTagId idFilter{11};
+    static const QueryTagId idFullText{12};
+    static const QueryTagId idCategories[MAX_SEARCH_CATEGORIES]{QueryTagId{13},
+                                                                QueryTagId{14},
+                                                                QueryTagId{15},
+                                                                QueryTagId{16}};
 
     int sqlResult = SQLITE_OK;
     if (!stmt)
@@ -2347,7 +3431,7 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
                                                                              "ctime",
                                                                              "mtime",
                                                                              "share",
-                                                                             "mimetypeVirtual",
+                                                                             "mimetypeStored",
                                                                              "fav",
                                                                              "label",
                                                                              "description",
@@ -2408,9 +3492,47 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
                 " AND (P.flags & " + idSensFlag + ") = 0) "
                 "AND P.type != " + filenodeStr + "))";
 
+        // Walks up from every candidate while nodesCTE would have walked down to it, until
+        // reaching the ancestors
+        auto nodesUp = [](const std::string& candidates)
+        {
+            return
+            "nodesUp(nodehandle, parenthandle) \n"s
+            "AS (SELECT nodehandle, parenthandle \n"
+                "FROM nodes \n"
+                "WHERE nodehandle IN (" + candidates + ") \n"
+                "UNION ALL \n"
+                "SELECT U.nodehandle, P.parenthandle \n"
+                "FROM nodesUp AS U \n"
+                "INNER JOIN nodes AS P \n"
+                "ON (P.nodehandle = U.parenthandle \n"
+                "AND U.parenthandle NOT IN (SELECT nodehandle FROM ancestors) \n"
+                "AND (P.flags & " + idVerFlag + " = 0) \n" // Versions aren't taken in consideration
+                "AND (" + idSens + " != " + onlyTrueStr + // Sensitive nodes
+                " OR " + idSens + " = " + onlyTrueStr +
+                " AND (P.flags & " + idSensFlag + ") = 0) "
+                "AND P.type != " + filenodeStr + "))";
+        };
+
+        static const std::string nodesUpFullText =
+            nodesUp("SELECT rowid FROM nodesfts WHERE nodesfts MATCH "s + idFullText);
+
+        static const std::string nodesUpCategory =
+            nodesUp("SELECT nodehandle FROM nodes WHERE mimetypeStored IN ("s +
+                    idCategories[0] + ", " + idCategories[1] + ", " + idCategories[2] + ", " +
+                    idCategories[3] + ") AND type = " + filenodeStr);
+
+        // Same rows as nodesCTE restricted to the candidates
+        static const std::string nodesCTEFromCandidates =
+            "nodesCTE(" + columnsForNodeAndFilters + ") \n"
+            "AS (SELECT " + columnsForNodeAndFilters + " \n"
+                "FROM nodes \n"
+                "WHERE nodehandle IN (SELECT nodehandle FROM nodesUp \n"
+                    "WHERE parenthandle IN (SELECT nodehandle FROM ancestors)))";
+
         static const std::string whereClause =
             "matchFilter("s + idFilter +
-            ", flags, type, ctime, mtime, mimetypeVirtual, name, description, tags, fav)";
+            ", flags, type, ctime, mtime, mimetypeStored, name, description, tags, fav)";
 
         static const std::string nodesAfterFilters =
             "nodesAfterFilters (" + columnsForNodeAndOrderBy + ") \n"
@@ -2429,7 +3551,9 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
             "WITH \n\n" +
             ancestors + ", \n\n" +
             nodesOfShares + ", \n\n" +
-            nodesCTE + ", \n\n" +
+            (useFullText      ? nodesUpFullText + ", \n\n" + nodesCTEFromCandidates :
+             useCategoryIndex ? nodesUpCategory + ", \n\n" + nodesCTEFromCandidates :
+                                nodesCTE) + ", \n\n" +
             nodesAfterFilters + "\n\n" +
             "SELECT " + columnsForNodeAndOrderBy + " \n"
             "FROM nodesAfterFilters GROUP BY nodehandle\n" // Avoid duplicates after union of nodesOfShares and nodesCTE
@@ -2460,6 +3584,22 @@ bool SqliteAccountState::searchNodes(const NodeSearchFilter& filter,
     bindPointer(sqlResult, stmt, idFilter, &filterCopy, NodeSearchFilterPtrStr);
     bindValue(sqlResult, stmt, idSens, filter.bySensitivity(), sqlite3_bind_int);
     bindValue(sqlResult, stmt, idSensFlag, sensitivityFlag, sqlite3_bind_int64);
+    if (useFullText)
+    {
+        bindText(sqlResult, stmt, idFullText, fullTextQuery);
+    }
+    if (useCategoryIndex)
+    {
+        // the slots left are filled with a repeated category
+        for (size_t i = 0; i < MAX_SEARCH_CATEGORIES; ++i)
+        {
+            bindValue(sqlResult,
+                      stmt,
+                      idCategories[i],
+                      categories[std::min(i, categories.size() - 1)],
+                      sqlite3_bind_int);
+        }
+    }
 
     const bool result = (sqlResult == SQLITE_OK) && processSqlQueryNodes(stmt, nodes);
 
@@ -2532,7 +3672,7 @@ static const QueryTagId kLaIdPageSize{1};
 constexpr size_t kListAllMaxRoots = kListAllMaxLocationHandles;
 constexpr size_t kListAllMaxExcludes = kListAllMaxLocationHandles;
 
-// Cache key for mStmtListAllNodesByPage. Each input is one
+// Shape id for the statement cache of listAllNodesByPage. Each input is one
 // "digit" in a positional number, with a different base per
 // digit (its declared range). Every valid combination maps
 // to a unique key — distinct SQL shapes never collide on one
@@ -2542,21 +3682,26 @@ constexpr size_t kListAllMaxExcludes = kListAllMaxLocationHandles;
 // locationScope is omitted: it only picks rootnodes; SQL
 // depends only on numRoots.
 //
+// useAncestorIndex picks the subtree condition (closure table
+// lookup or walk up the parents).
+//
 // Example — first page of photos (mimeType=1, order=1,
-// hasCursor=0, sens=0, numRoots=1, numExcludes=0):
+// hasCursor=0, sens=0, numRoots=1, numExcludes=0, ancestors=0):
 //   key = 1
 //   key = key * 21 + 1 = 22     // order, base 21
 //   key = key * 2  + 0 = 44     // hasCursor, base 2
 //   key = key * 2  + 0 = 88     // excludeSensitive, base 2
 //   key = key * 3  + 0 = 264    // numRoots-1, base 3
 //   key = key * 4  + 0 = 1056   // numExcludes, base 4
-// → 1056
+//   key = key * 2  + 0 = 2112   // useAncestorIndex, base 2
+// → 2112
 inline size_t computeListAllCacheId(MimeType_t mimeType,
                                     int order,
                                     bool hasCursor,
                                     bool excludeSensitive,
                                     size_t numRoots,
-                                    size_t numExcludes)
+                                    size_t numExcludes,
+                                    bool useAncestorIndex)
 {
     static_assert(OrderByClause::FAV_DESC == 20, "FAV_DESC changed; update kListAllOrderStride");
     constexpr size_t kListAllOrderStride = static_cast<size_t>(OrderByClause::FAV_DESC) + 1;
@@ -2571,6 +3716,7 @@ inline size_t computeListAllCacheId(MimeType_t mimeType,
     key = key * 2 + (excludeSensitive ? 1u : 0u);
     key = key * kListAllMaxRoots + (numRoots - 1);
     key = key * (kListAllMaxExcludes + 1) + numExcludes;
+    key = key * 2 + (useAncestorIndex ? 1u : 0u);
     return key;
 }
 
@@ -3007,6 +4153,26 @@ std::string buildUpWalkExists(int filesRootParam,
            ")";
 }
 
+// Same as buildUpWalkExists without sensitivity nor excludes, with a lookup at the ancestor
+// index (closure table) instead of walking up the parents:
+//   EXISTS (SELECT 1 FROM nodesancestors WHERE nodehandle = n.nodehandle AND ancestor IN (?3))
+std::string buildAncestorIndexExists(int filesRootParam, size_t numRoots)
+{
+    assert(numRoots >= 1);
+
+    std::string rootInList;
+    for (size_t i = 0; i < numRoots; ++i)
+    {
+        if (i > 0)
+            rootInList += ", ";
+        rootInList += "?";
+        rootInList += std::to_string(filesRootParam + static_cast<int>(i));
+    }
+
+    return std::string("EXISTS (SELECT 1 FROM ") + ANCESTOR_TABLE +
+           " WHERE nodehandle = n.nodehandle AND ancestor IN (" + rootInList + "))";
+}
+
 // Builds a single-route SELECT for listAllNodesByPage given a mime filter condition
 // (either a literal value for grouped/CTE routes or a bound parameter for simple ones).
 //
@@ -3025,7 +4191,7 @@ std::string buildUpWalkExists(int filesRootParam,
 //
 //   SELECT nodehandle, counter, node, type, sizeVirtual, mtime, name, label, fav
 //   FROM nodes AS n
-//   WHERE mimetypeVirtual = ?2
+//   WHERE mimetypeStored = ?2
 //     AND (n.flags & 1) = 0
 //     AND EXISTS (
 //       WITH RECURSIVE up(h, sensSeen) AS (
@@ -3046,7 +4212,7 @@ std::string buildUpWalkExists(int filesRootParam,
 //
 //   SELECT nodehandle, counter, node, type, sizeVirtual, mtime, name, label, fav
 //   FROM nodes AS n
-//   WHERE mimetypeVirtual = ?2
+//   WHERE mimetypeStored = ?2
 //     AND (n.flags & 1) = 0
 //     AND EXISTS (
 //       WITH RECURSIVE up(h, sensSeen, excSeen) AS (
@@ -3083,16 +4249,18 @@ std::string buildListAllRouteSelect(const std::string& mimeFilterClause,
                                     size_t numRoots,
                                     bool excludeSensitive,
                                     int excludeHandleParam,
-                                    size_t numExcludes)
+                                    size_t numExcludes,
+                                    bool useAncestorIndex)
 {
     std::vector<std::string> conditions;
     conditions.push_back(mimeFilterClause);
     conditions.push_back("(n.flags & " + std::to_string(1ULL << Node::FLAGS_IS_VERSION) + ") = 0");
-    conditions.push_back(buildUpWalkExists(filesRootParam,
-                                           numRoots,
-                                           excludeSensitive,
-                                           excludeHandleParam,
-                                           numExcludes));
+    conditions.push_back(useAncestorIndex ? buildAncestorIndexExists(filesRootParam, numRoots) :
+                                            buildUpWalkExists(filesRootParam,
+                                                              numRoots,
+                                                              excludeSensitive,
+                                                              excludeHandleParam,
+                                                              numExcludes));
 
     if (hasCursor)
     {
@@ -3118,7 +4286,8 @@ std::string buildGroupedListAllQuery(MimeType_t mimeType,
                                      size_t numRoots,
                                      bool excludeSensitive,
                                      int excludeHandleParam,
-                                     size_t numExcludes)
+                                     size_t numExcludes,
+                                     bool useAncestorIndex)
 {
     assert(isGroupMimeTypeForListAll(mimeType));
 
@@ -3136,7 +4305,7 @@ std::string buildGroupedListAllQuery(MimeType_t mimeType,
         }
 
         ctes += routeName + " AS (\n" +
-                buildListAllRouteSelect("mimetypeVirtual = " +
+                buildListAllRouteSelect("mimetypeStored = " +
                                             std::to_string(static_cast<int>(routeMimeTypes[i])),
                                         order,
                                         hasCursor,
@@ -3145,7 +4314,8 @@ std::string buildGroupedListAllQuery(MimeType_t mimeType,
                                         numRoots,
                                         excludeSensitive,
                                         excludeHandleParam,
-                                        numExcludes) +
+                                        numExcludes,
+                                        useAncestorIndex) +
                 "\n)";
         merged += "SELECT " + listAllNodesResultCols() + " \nFROM " + routeName + "\n";
     }
@@ -3238,13 +4408,19 @@ bool SqliteAccountState::listAllNodesByPage(
     // Group mime types use literal per-route WHERE clauses in CTEs — no parameter slot needed.
     const bool mimeFilterNeedsParam = !isGroupMimeType;
 
+    // The ancestor index has no information about sensitivity nor the exclusions between the
+    // node and the root, so it's only used without them
+    const bool useAncestorIndex = mAncestorIndexReady && !params.excludeSensitive && !numExcludes;
+
     const size_t cacheId = computeListAllCacheId(params.mimeType,
                                                  params.order,
                                                  hasCursor,
                                                  params.excludeSensitive,
                                                  numRoots,
-                                                 numExcludes);
-    sqlite3_stmt*& stmt = mStmtListAllNodesByPage[cacheId];
+                                                 numExcludes,
+                                                 useAncestorIndex);
+    sqlite3_stmt*& stmt =
+        mStmtCache.acquire(SqliteStatementCache::Query::LIST_ALL_NODES_BY_PAGE, cacheId);
 
     // Slot layout: ?1=pageSize, optional mimeFilter, numRoots contiguous filesRoot slots,
     // numExcludes contiguous exclude-handle slots, then the optional cursor slots.
@@ -3267,11 +4443,12 @@ bool SqliteAccountState::listAllNodesByPage(
                                              numRoots,
                                              params.excludeSensitive,
                                              excludeHandleParam,
-                                             numExcludes);
+                                             numExcludes,
+                                             useAncestorIndex);
         }
         else
         {
-            query = buildListAllRouteSelect("mimetypeVirtual = ?" + std::to_string(mimeFilterParam),
+            query = buildListAllRouteSelect("mimetypeStored = ?" + std::to_string(mimeFilterParam),
                                             params.order,
                                             hasCursor,
                                             cursorStartParam,
@@ -3279,7 +4456,8 @@ bool SqliteAccountState::listAllNodesByPage(
                                             numRoots,
                                             params.excludeSensitive,
                                             excludeHandleParam,
-                                            numExcludes);
+                                            numExcludes,
+                                            useAncestorIndex);
         }
         sqlResult = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr);
         if (sqlResult != SQLITE_OK)
@@ -3615,11 +4793,17 @@ bool SqliteAccountState::isAncestor(NodeHandle node, NodeHandle ancestor, Cancel
         return result;
     }
 
-    std::string sqlQuery = "WITH nodesCTE(nodehandle, parenthandle) "
-            "AS (SELECT nodehandle, parenthandle FROM nodes WHERE nodehandle = ? "
-            "UNION ALL SELECT A.nodehandle, A.parenthandle FROM nodes AS A INNER JOIN nodesCTE "
-            "AS E ON (A.nodehandle = E.parenthandle)) "
-            "SELECT * FROM nodesCTE WHERE parenthandle = ?";
+    // with the ancestor index, a lookup by its primary key instead of walking up the parents
+    const bool useAncestorIndex = mAncestorIndexReady;
+    sqlite3_stmt*& stmt = useAncestorIndex ? mStmtIsAncestorIndexed : mStmtIsAncestor;
+
+    std::string sqlQuery = useAncestorIndex ?
+        std::string("SELECT 1 FROM ") + ANCESTOR_TABLE + " WHERE nodehandle = ? AND ancestor = ?" :
+        "WITH nodesCTE(nodehandle, parenthandle) "
+        "AS (SELECT nodehandle, parenthandle FROM nodes WHERE nodehandle = ? "
+        "UNION ALL SELECT A.nodehandle, A.parenthandle FROM nodes AS A INNER JOIN nodesCTE "
+        "AS E ON (A.nodehandle = E.parenthandle)) "
+        "SELECT * FROM nodesCTE WHERE parenthandle = ?";
 
     if (cancelFlag.exists())
     {
@@ -3627,24 +4811,22 @@ bool SqliteAccountState::isAncestor(NodeHandle node, NodeHandle ancestor, Cancel
     }
 
     int sqlResult = SQLITE_OK;
-    if (!mStmtIsAncestor)
+    if (!stmt)
     {
-        sqlResult = sqlite3_prepare_v2(db, sqlQuery.c_str(), -1, &mStmtIsAncestor, NULL);
+        sqlResult = sqlite3_prepare_v2(db, sqlQuery.c_str(), -1, &stmt, NULL);
     }
 
     if (sqlResult == SQLITE_OK)
     {
-        if ((sqlResult = sqlite3_bind_int64(mStmtIsAncestor,
-                                            1,
-                                            static_cast<sqlite3_int64>(node.as8byte()))) ==
+        if ((sqlResult = sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(node.as8byte()))) ==
             SQLITE_OK)
         {
-            if ((sqlResult = sqlite3_bind_int64(mStmtIsAncestor,
+            if ((sqlResult = sqlite3_bind_int64(stmt,
                                                 2,
                                                 static_cast<sqlite3_int64>(ancestor.as8byte()))) ==
                 SQLITE_OK)
             {
-                if ((sqlResult = sqlite3_step(mStmtIsAncestor)) == SQLITE_ROW)
+                if ((sqlResult = sqlite3_step(stmt)) == SQLITE_ROW)
                 {
                     result = true;
                 }
@@ -3660,7 +4842,7 @@ bool SqliteAccountState::isAncestor(NodeHandle node, NodeHandle ancestor, Cancel
         errorHandler(sqlResult, "Is ancestor", true);
     }
 
-    sqlite3_reset(mStmtIsAncestor);
+    sqlite3_reset(stmt);
 
     return result;
 }
@@ -3693,6 +4875,48 @@ uint64_t SqliteAccountState::getNumberOfNodes()
     return count;
 }
 
+bool SqliteAccountState::getNodeTreeEntries(std::vector<NodeTreeEntry>& entries)
+{
+    if (!db)
+    {
+        return false;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    int sqlResult =
+        sqlite3_prepare_v2(db,
+                           "SELECT nodehandle, parenthandle, type, share, name FROM nodes",
+                           -1,
+                           &stmt,
+                           NULL);
+    if (sqlResult == SQLITE_OK)
+    {
+        while ((sqlResult = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            NodeTreeEntry entry;
+            entry.handle.set6byte(static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)));
+            entry.parent.set6byte(static_cast<uint64_t>(sqlite3_column_int64(stmt, 1)));
+            entry.type = static_cast<nodetype_t>(sqlite3_column_int(stmt, 2));
+            entry.share = sqlite3_column_int(stmt, 3);
+            if (const unsigned char* name = sqlite3_column_text(stmt, 4))
+            {
+                entry.name.assign(reinterpret_cast<const char*>(name),
+                                  static_cast<size_t>(sqlite3_column_bytes(stmt, 4)));
+            }
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    if (sqlResult != SQLITE_DONE)
+    {
+        errorHandler(sqlResult, "Get node tree entries", false);
+    }
+
+    sqlite3_finalize(stmt);
+
+    return sqlResult == SQLITE_DONE;
+}
+
 uint64_t SqliteAccountState::getNumberOfChildrenByType(NodeHandle parentHandle, nodetype_t nodeType)
 {
     uint64_t count = 0;
@@ -3778,6 +5002,30 @@ void SqliteAccountState::getSizeFromNodeCounter(sqlite3_context* context,
     sqlite3_result_int64(context, nc.storage);
 }
 
+void SqliteAccountState::userFoldText(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+    if (argc != 1)
+    {
+        LOG_err << "Invalid parameters for userFoldText";
+        assert(argc == 1);
+        sqlite3_result_null(context);
+        return;
+    }
+
+    const auto text = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+    if (!text)
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+
+    const std::string folded = foldCaseAndAccents(text);
+    sqlite3_result_text(context,
+                        folded.c_str(),
+                        static_cast<int>(folded.size()),
+                        SQLITE_TRANSIENT);
+}
+
 void SqliteAccountState::userGetMimetype(sqlite3_context* context, int argc, sqlite3_value** argv)
 {
     if (argc != 1)
@@ -3789,10 +5037,7 @@ void SqliteAccountState::userGetMimetype(sqlite3_context* context, int argc, sql
     }
 
     const char* fileName = reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
-    string ext;
-    int result = (fileName && *fileName && Node::getExtension(ext, fileName) && !ext.empty()) ?
-                 Node::getMimetype(ext) : MimeType_t::MIME_TYPE_OTHERS;
-    sqlite3_result_int(context, result);
+    sqlite3_result_int(context, Node::getMimetypeByName(fileName ? fileName : ""));
 }
 
 void SqliteAccountState::getFingerprintExcludingMtime(sqlite3_context* context,
@@ -3841,7 +5086,7 @@ void SqliteAccountState::userMatchFilter(sqlite3_context* context, int argc, sql
     if (argc != 10)
     {
         LOG_err << "Invalid parameters for userMatchFilter. Expected (in this order): filter*, "
-                   "flags, type, ctime, mtime, mimetypeVirtual, name, description, tags, fav";
+                   "flags, type, ctime, mtime, mimetypeStored, name, description, tags, fav";
         assert(false);
         return;
     }
@@ -374,6 +374,15 @@ int compareUtf(const string& s1, bool unescaping1, const string& s2, bool unesca
                 caseInsensitive ? Utils::toUpper: detail::identity);
 }
 
+int compareUtf(std::string_view s1, bool unescaping1, std::string_view s2, bool unescaping2, bool caseInsensitive)
+{
+    return detail::compareUtf(unicodeCodepointIterator(s1.data(), s1.size()),
+                              unescaping1,
+                              unicodeCodepointIterator(s2.data(), s2.size()),
+                              unescaping2,
+                              caseInsensitive ? Utils::toUpper : detail::identity);
+}
+
 int compareUtf(const string& s1, bool unescaping1, const LocalPath& s2, bool unescaping2, bool caseInsensitive)
 {
     return detail::compareUtf(unicodeCodepointIterator(s1),
@@ -28,6 +28,7 @@
 
 #include <cctype>
 #include <cstdint>
+#include <cstring>
 
 #ifdef _WIN32
 #include <locale.h>
@@ -37,15 +38,164 @@
 #include <locale.h>
 #endif
 
+// The vectorized scanners load whole aligned blocks, which can't cross a page boundary, so they
+// may read some bytes around the string safely. AddressSanitizer reports those reads anyway.
+#if defined(__SANITIZE_ADDRESS__)
+#define MEGA_JSON_SCALAR_SCAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MEGA_JSON_SCALAR_SCAN
+#endif
+#endif
+
+#ifndef MEGA_JSON_SCALAR_SCAN
+#if defined(__AVX2__)
+#define MEGA_JSON_AVX2_SCAN
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MEGA_JSON_SSE2_SCAN
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MEGA_JSON_NEON_SCAN
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace mega {
 
+namespace {
+
+#if defined(MEGA_JSON_AVX2_SCAN) || defined(MEGA_JSON_SSE2_SCAN)
+// index of the least significant bit set (mask != 0)
+unsigned lowestBitSet(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+template<size_t BLOCK>
+const char* alignDown(const char* p)
+{
+    return reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(BLOCK - 1));
+}
+
+// first '"', '\\' or NUL at or after p
+#if defined(MEGA_JSON_AVX2_SCAN)
+const char* findStringSpecial(const char* p)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i zero = _mm256_setzero_si256();
+    auto matches = [&](const char* block)
+    {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                                    _mm256_cmpeq_epi8(v, backslash)),
+                                    _mm256_cmpeq_epi8(v, zero));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(m));
+    };
+
+    const char* block = alignDown<32>(p);
+    uint32_t mask = matches(block) & (~uint32_t(0) << (p - block));
+    while (!mask)
+    {
+        block += 32;
+        mask = matches(block);
+    }
+    return block + lowestBitSet(mask);
+}
+#elif defined(MEGA_JSON_SSE2_SCAN)
+const char* findStringSpecial(const char* p)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i zero = _mm_setzero_si128();
+    auto matches = [&](const char* block)
+    {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                              _mm_cmpeq_epi8(v, backslash)),
+                                 _mm_cmpeq_epi8(v, zero));
+        return static_cast<uint32_t>(_mm_movemask_epi8(m));
+    };
+
+    const char* block = alignDown<16>(p);
+    uint32_t mask = matches(block) & (~uint32_t(0) << (p - block));
+    while (!mask)
+    {
+        block += 16;
+        mask = matches(block);
+    }
+    return block + lowestBitSet(mask);
+}
+#elif defined(MEGA_JSON_NEON_SCAN)
+const char* findStringSpecial(const char* p)
+{
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    auto matches = [&](const char* block)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                vceqzq_u8(v));
+        // 4 bits per byte
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(m), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+    };
+
+    const char* block = alignDown<16>(p);
+    uint64_t mask = matches(block) & (~uint64_t(0) << ((p - block) * 4));
+    while (!mask)
+    {
+        block += 16;
+        mask = matches(block);
+    }
+    return block + (__builtin_ctzll(mask) >> 2);
+}
+#else
+const char* findStringSpecial(const char* p)
+{
+    return p + strcspn(p, "\"\\");
+}
+#endif
+
+} // namespace
+
+const char* JSON::skipString(const char* ptr)
+{
+    for (;;)
+    {
+        ptr = findStringSpecial(ptr);
+        if (*ptr != '\\')
+        {
+            return ptr;
+        }
+
+        // escaped character, unless the data ends here
+        if (!*++ptr)
+        {
+            return ptr;
+        }
+        ++ptr;
+    }
+}
+
 // store array or object in string s
 // reposition after object
 bool JSON::storeobject(string* s)
 {
     int openobject[2] = { 0 };
     const char* ptr;
-    bool escaped = false;
 
     while (*(const signed char*)pos > 0 && *pos <= ' ')
     {
@@ -80,13 +230,7 @@ bool JSON::storeobject(string* s)
         }
         else if (*ptr == '"')
         {
-            ptr++;
-
-            while (*ptr && (escaped || *ptr != '"'))
-            {
-                escaped = *ptr == '\\' && !escaped;
-                ptr++;
-            }
+            ptr = skipString(ptr + 1);
 
             if (!*ptr)
             {
@@ -348,10 +492,19 @@ int JSON::storebinary(byte* dst, int dstlen)
 
     if (*pos == '"')
     {
-        l = Base64::atob(pos + 1, dst, dstlen);
+        // decode straight from the buffer and continue from where decoding stopped (normally,
+        // the closing quote) instead of scanning the string again
+        const char* end;
+        l = Base64::atob(pos + 1, dst, dstlen, &end);
 
-        // skip string
-        storeobject();
+        end = skipString(end);
+        if (!*end)
+        {
+            LOG_err << "Parse error (storebinary)";
+            return l;
+        }
+
+        pos = end + 1;
     }
 
     return l;
@@ -367,10 +520,8 @@ bool JSON::storebinary(string* dst)
 
     if (*pos == '"')
     {
-        const char* ptr;
-
-        ptr = strchr(pos + 1, '"');
-        if (!ptr)
+        const char* ptr = skipString(pos + 1);
+        if (!*ptr)
         {
             LOG_err << "Parse error (storebinary)";
             return false;
@@ -380,8 +531,7 @@ bool JSON::storebinary(string* dst)
         dst->resize(
             static_cast<size_t>(Base64::atob(pos + 1, (byte*)dst->data(), int(dst->size()))));
 
-        // skip string
-        storeobject();
+        pos = ptr + 1;
     }
 
     return true;
@@ -1526,22 +1676,13 @@ bool JSONSplitter::isStarting()
 
 int JSONSplitter::strEnd()
 {
-    const char* ptr = mPos;
-    while ((ptr = strchr(ptr + 1, '"')) != nullptr)
+    const char* ptr = JSON::skipString(mPos + 1);
+    if (!*ptr)
     {
-        const char *e = ptr;
-        while (*(--e) == '\\')
-        {
-            // noop
-        }
-
-        if ((ptr - e) & 1)
-        {
-            return int(ptr + 1 - mPos);
-        }
+        return -1;
     }
 
-    return -1;
+    return int(ptr + 1 - mPos);
 }
 
 int JSONSplitter::numEnd()
@@ -4497,6 +4497,26 @@ int MegaApi::enableLexicographicDBIndexes(bool enable)
     return pImpl->enableLexicographicDBIndexes(enable);
 }
 
+int MegaApi::enableFullTextSearchDBIndex(bool enable)
+{
+    return pImpl->enableFullTextSearchDBIndex(enable);
+}
+
+int MegaApi::enableAncestorDBIndex(bool enable)
+{
+    return pImpl->enableAncestorDBIndex(enable);
+}
+
+int MegaApi::enableNodeTreeSnapshot(bool enable)
+{
+    return pImpl->enableNodeTreeSnapshot(enable);
+}
+
+void MegaApi::enableNodeNameInterning(bool enable)
+{
+    MegaNodePrivate::enableNameInterning(enable);
+}
+
 const char* MegaApi::generateViewId()
 {
     return strdup(pImpl->generateViewId().c_str());
@@ -4909,6 +4929,21 @@ unsigned long long MegaApi::getNumNodesAtCacheLRU() const
     return pImpl->getNumNodesAtCacheLRU();
 }
 
+unsigned long long MegaApi::getNumCacheLRUHits() const
+{
+    return pImpl->getNumCacheLRUHits();
+}
+
+unsigned long long MegaApi::getNumCacheLRUMisses() const
+{
+    return pImpl->getNumCacheLRUMisses();
+}
+
+unsigned long long MegaApi::getNumCacheLRUEvictions() const
+{
+    return pImpl->getNumCacheLRUEvictions();
+}
+
 int MegaApi::isWaiting()
 {
     return pImpl->isWaiting();
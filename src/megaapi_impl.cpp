@@ -98,12 +98,14 @@ std::unique_ptr<GfxProc> createGfxProc(MegaGfxProcessor* processor)
 }
 namespace mega {
 
+std::atomic<bool> MegaNodePrivate::sInternNames{false};
+
 MegaNodePrivate::MegaNodePrivate(const char *name, int type, int64_t size, int64_t ctime, int64_t mtime, uint64_t nodehandle,
                                  const string *nodekey, const string *fileattrstring, const char *fingerprint, const char *originalFingerprint, MegaHandle owner, MegaHandle parentHandle,
                                  const char *privateauth, const char *publicauth, bool ispublic, bool isForeign, const char *chatauth, bool isNodeKeyDecrypted)
 : MegaNode()
 {
-    this->name = MegaApi::strdup(name);
+    assignName(name);
     this->fingerprint = MegaApi::strdup(fingerprint);
     this->originalfingerprint = MegaApi::strdup(originalFingerprint);
     this->customAttrs = NULL;
@@ -154,7 +156,7 @@ MegaNodePrivate::MegaNodePrivate(const char *name, int type, int64_t size, int64
 MegaNodePrivate::MegaNodePrivate(MegaNode *node)
 : MegaNode()
 {
-    this->name = MegaApi::strdup(node->getName());
+    assignName(node->getName());
     this->fingerprint = MegaApi::strdup(node->getFingerprint());
     this->originalfingerprint = MegaApi::strdup(node->getOriginalFingerprint());
     this->customAttrs = NULL;
@@ -252,7 +254,7 @@ MegaNodePrivate::MegaNodePrivate(MegaNode *node)
 MegaNodePrivate::MegaNodePrivate(Node *node)
 : MegaNode()
 {
-    this->name = MegaApi::strdup(node->displayname());
+    assignName(node->displayname());
     this->fingerprint = NULL;
     this->originalfingerprint = NULL;
     this->children = NULL;
@@ -1093,6 +1095,31 @@ const char* MegaNodePrivate::getS4() const
     return mS4.c_str();
 }
 
+void MegaNodePrivate::enableNameInterning(bool enable)
+{
+    sInternNames = enable;
+}
+
+void MegaNodePrivate::assignName(const char* newName)
+{
+    if (mInternedName.isNull())
+    {
+        delete[] name;
+    }
+    mInternedName = SharedString();
+    name = nullptr;
+
+    if (newName && sInternNames)
+    {
+        mInternedName = StringPool::nodeNames().intern(newName);
+        name = mInternedName.c_str();
+    }
+    else
+    {
+        name = MegaApi::strdup(newName);
+    }
+}
+
 string MegaNodePrivate::addAppPrefixToFingerprint(const string& fp, const m_off_t nodeSize)
 {
     if (fp.empty())
@@ -2373,10 +2400,7 @@ void MegaNodePrivate::setChildren(MegaNodeList* newChildren)
 
 void MegaNodePrivate::setName(const char *newName)
 {
-    if (name)
-        delete [] name;
-
-    name = MegaApi::strdup(newName);
+    assignName(newName);
 }
 
 string *MegaNodePrivate::getPublicAuth()
@@ -2391,7 +2415,10 @@ const char *MegaNodePrivate::getChatAuth()
 
 MegaNodePrivate::~MegaNodePrivate()
 {
-    delete[] name;
+    if (mInternedName.isNull())
+    {
+        delete[] name;
+    }
     delete[] fingerprint;
     delete[] originalfingerprint;
     delete [] chatAuth;
@@ -11068,9 +11095,12 @@ bool MegaApiImpl::userComparatorDefaultASC (User *i, User *j)
 
 m_off_t MegaApiImpl::sizeDifference(Node* i, Node* j)
 {
-    assert(i->type == FOLDERNODE || i->size == i->getCounter().storage);
-    assert(j->type == FOLDERNODE || j->size == j->getCounter().storage);
-    return i->getCounter().storage - j->getCounter().storage;
+    NodeManager& nodeManager = i->client->mNodeManager;
+    const m_off_t iStorage = nodeManager.getNodeCounter(*i).storage;
+    const m_off_t jStorage = nodeManager.getNodeCounter(*j).storage;
+    assert(i->type == FOLDERNODE || i->size == iStorage);
+    assert(j->type == FOLDERNODE || j->size == jStorage);
+    return iStorage - jStorage;
 }
 
 char *MegaApiImpl::escapeFsIncompatible(const char *filename, const char *dstPath)
@@ -12969,6 +12999,42 @@ int MegaApiImpl::enableLexicographicDBIndexes(bool enable)
     return API_OK;
 }
 
+int MegaApiImpl::enableFullTextSearchDBIndex(bool enable)
+{
+    if (client->loggedin() != sessiontype_t::NOTLOGGEDIN)
+    {
+        LOG_warn << "This method should be called before login";
+        return API_EACCESS;
+    }
+
+    client->enableFullTextSearchDBIndex(enable);
+    return API_OK;
+}
+
+int MegaApiImpl::enableAncestorDBIndex(bool enable)
+{
+    if (client->loggedin() != sessiontype_t::NOTLOGGEDIN)
+    {
+        LOG_warn << "This method should be called before login";
+        return API_EACCESS;
+    }
+
+    client->enableAncestorDBIndex(enable);
+    return API_OK;
+}
+
+int MegaApiImpl::enableNodeTreeSnapshot(bool enable)
+{
+    if (client->loggedin() != sessiontype_t::NOTLOGGEDIN)
+    {
+        LOG_warn << "This method should be called before login";
+        return API_EACCESS;
+    }
+
+    client->enableNodeTreeSnapshot(enable);
+    return API_OK;
+}
+
 string MegaApiImpl::generateViewId()
 {
     return MegaClient::generateViewId(client->rng);
@@ -13310,24 +13376,21 @@ MegaNodeList* MegaApiImpl::search(const MegaSearchFilter* filter, int order, Can
 
     sharedNode_vector searchResults;
 
-    // search
+    // search (sdkMutex is taken by searchInNodeManager(), after the DB look-up)
+    switch (filter->byLocation())
     {
-        SdkMutexGuard g(sdkMutex);
-
-        switch (filter->byLocation())
-        {
-        case MegaApi::SEARCH_TARGET_ALL:
-        case MegaApi::SEARCH_TARGET_ROOTNODE: // Search on Cloud root and Vault, excluding Rubbish
-        case MegaApi::SEARCH_TARGET_INSHARE:
-        case MegaApi::SEARCH_TARGET_OUTSHARE:
-        case MegaApi::SEARCH_TARGET_PUBLICLINK:
-            searchResults = searchInNodeManager(filter, order, cancelToken, searchPage);
-            break;
-        default:
-            LOG_err << "Search not implemented for Location " << filter->byLocation();
-        }
-    } // end scope for mutex guard
+    case MegaApi::SEARCH_TARGET_ALL:
+    case MegaApi::SEARCH_TARGET_ROOTNODE: // Search on Cloud root and Vault, excluding Rubbish
+    case MegaApi::SEARCH_TARGET_INSHARE:
+    case MegaApi::SEARCH_TARGET_OUTSHARE:
+    case MegaApi::SEARCH_TARGET_PUBLICLINK:
+        searchResults = searchInNodeManager(filter, order, cancelToken, searchPage);
+        break;
+    default:
+        LOG_err << "Search not implemented for Location " << filter->byLocation();
+    }
 
+    SdkMutexGuard g(sdkMutex);
     MegaNodeListPrivate* nodeList = new MegaNodeListPrivate(searchResults);
 
     return nodeList;
@@ -13393,7 +13456,15 @@ sharedNode_vector MegaApiImpl::searchInNodeManager(const MegaSearchFilter* filte
     }
 
     const NodeSearchPage& np = searchPage ? NodeSearchPage(searchPage->startingOffset(), searchPage->size()) : NodeSearchPage(0, 0);
-    sharedNode_vector results = client->mNodeManager.searchNodes(nf, order, cancelToken, np);
+
+    // The DB is read without sdkMutex, concurrently with the SDK thread, and the nodes are built
+    // holding it (see NodeManager::DbPrefetch)
+    NodeManager::DbPrefetch prefetch =
+        client->mNodeManager.prefetchSearch(nf, order, cancelToken, np);
+
+    SdkMutexGuard g(sdkMutex);
+    sharedNode_vector results =
+        client->mNodeManager.searchNodes(nf, order, cancelToken, np, &prefetch);
     return results;
 }
 
@@ -13629,8 +13700,14 @@ MegaNodeList* MegaApiImpl::listAllNodesByPage(const MegaListAllNodesFilter* filt
     if (!params)
         return new MegaNodeListPrivate();
 
+    // The DB is read without sdkMutex, concurrently with the SDK thread, and the nodes are built
+    // holding it (see NodeManager::DbPrefetch)
+    NodeManager::DbPrefetch prefetch =
+        client->mNodeManager.prefetchListAllNodesByPage(*params, cancelToken);
+
     SdkMutexGuard g(sdkMutex);
-    sharedNode_vector results = client->mNodeManager.listAllNodesByPage(*params, cancelToken);
+    sharedNode_vector results =
+        client->mNodeManager.listAllNodesByPage(*params, cancelToken, &prefetch);
     return new MegaNodeListPrivate(results);
 }
 
@@ -13657,7 +13734,7 @@ long long MegaApiImpl::getSize(MegaNode *n)
         return 0;
     }
 
-    NodeCounter nodeCounter = node->getCounter();
+    NodeCounter nodeCounter = client->mNodeManager.getNodeCounter(*node);
     return nodeCounter.storage;
 }
 
@@ -19027,13 +19104,18 @@ MegaNodeList *MegaApiImpl::getChildren(const MegaSearchFilter* filter, int order
         return new MegaNodeListPrivate();
     }
 
-    SdkMutexGuard guard(sdkMutex);
-
     NodeSearchFilter nf = searchToNodeFilter(*filter);
 
     const NodeSearchPage& np = searchPage ? NodeSearchPage(searchPage->startingOffset(), searchPage->size()) : NodeSearchPage(0u, 0u);
-    sharedNode_vector results = client->mNodeManager.getChildren(nf, order, cancelToken, np);
 
+    // The DB is read without sdkMutex, concurrently with the SDK thread, and the nodes are built
+    // holding it (see NodeManager::DbPrefetch)
+    NodeManager::DbPrefetch prefetch =
+        client->mNodeManager.prefetchChildren(nf, order, cancelToken, np);
+
+    SdkMutexGuard guard(sdkMutex);
+    sharedNode_vector results =
+        client->mNodeManager.getChildren(nf, order, cancelToken, np, &prefetch);
     return new MegaNodeListPrivate(results);
 }
 
@@ -26086,7 +26168,7 @@ void MegaApiImpl::getFolderInfo(MegaNode* node, MegaRequestListener* listener)
                 return API_EARGS;
             }
 
-            NodeCounter nc = node->getCounter();
+            NodeCounter nc = client->mNodeManager.getNodeCounter(*node);
             std::unique_ptr<MegaFolderInfo> folderInfo = std::make_unique<MegaFolderInfoPrivate>(
                 (int)nc.files,
                 node->type == FOLDERNODE ? ((int)nc.folders - 1) : (int)nc.folders,
@@ -27299,6 +27381,21 @@ unsigned long long MegaApiImpl::getNumNodesAtCacheLRU() const
     return client->mNodeManager.getNumNodesAtCacheLRU();
 }
 
+unsigned long long MegaApiImpl::getNumCacheLRUHits() const
+{
+    return client->mNodeManager.getCacheLRUStats().hits;
+}
+
+unsigned long long MegaApiImpl::getNumCacheLRUMisses() const
+{
+    return client->mNodeManager.getCacheLRUStats().misses;
+}
+
+unsigned long long MegaApiImpl::getNumCacheLRUEvictions() const
+{
+    return client->mNodeManager.getCacheLRUStats().evictions;
+}
+
 bool MegaApiImpl::isSyncStalled()
 {
     // no need to lock sdkMutex for these simple flags
@@ -849,6 +849,21 @@ void MegaClient::enableLexicographicDBIndexes(bool enable)
     mEnableLexicographicDBIndexes = enable;
 }
 
+void MegaClient::enableFullTextSearchDBIndex(bool enable)
+{
+    mEnableFullTextSearchDBIndex = enable;
+}
+
+void MegaClient::enableAncestorDBIndex(bool enable)
+{
+    mEnableAncestorDBIndex = enable;
+}
+
+void MegaClient::enableNodeTreeSnapshot(bool enable)
+{
+    mEnableNodeTreeSnapshot = enable;
+}
+
 void MegaClient::dropSearchDBIndexes()
 {
     mNodeManager.dropSearchDBIndexes();
@@ -2237,6 +2252,8 @@ void MegaClient::exec()
 
     WAIT_CLASS::bumpds();
 
+    mActionPacketsSlice.begin();
+
     if (overquotauntil && overquotauntil < Waiter::ds)
     {
         overquotauntil = 0;
@@ -3607,6 +3624,12 @@ void MegaClient::exec()
             mNotifiedSumSize = sum;
             app->storagesum_changed(mNotifiedSumSize);
         }
+
+        // indexes at DB aren't maintained during fetchnodes: create them now, one per iteration
+        if (mNodeManager.hasPendingIndexes())
+        {
+            mNodeManager.createNextPendingIndex();
+        }
     }
 
 #ifdef MEGA_MEASURE_CODE
@@ -3687,6 +3710,18 @@ int MegaClient::preparewait()
         if (nextDispatchTransfersDs)
             nds = std::max(nextDispatchTransfersDs, Waiter::ds.load());
 
+        // indexes at DB pending to be created after fetchnodes
+        if (!fetchingnodes && mNodeManager.hasPendingIndexes())
+        {
+            nds = Waiter::ds;
+        }
+
+        // action packets pending from the previous slice
+        if (mActionPacketsSlice.yielded && !scpaused)
+        {
+            nds = Waiter::ds;
+        }
+
         for (pendinghttp_map::iterator it = pendinghttp.begin(); it != pendinghttp.end(); it++)
         {
             if (it->second->isbtactive)
@@ -4991,8 +5026,10 @@ void MegaClient::locallogout(bool removecaches, [[maybe_unused]] bool keepSyncsC
     // Clear cached request progress.
     mRequestProgress.reset();
 
+    saveNodeTreeSnapshot();
     sctable.reset();
     mNodeManager.setTable(nullptr);
+    mNodeTreeSnapshotPath.clear();
 
     statusTable.reset();
 
@@ -5174,6 +5211,38 @@ void MegaClient::locallogout(bool removecaches, [[maybe_unused]] bool keepSyncsC
     mReqHashcashToken.clear();
 }
 
+void MegaClient::saveNodeTreeSnapshot()
+{
+    if (!mEnableNodeTreeSnapshot || !sctable || !mNodeManager.ready() ||
+        mNodeTreeSnapshotPath.empty())
+    {
+        return;
+    }
+
+    // it's replaced below, and a mapped file can't be replaced in some platforms
+    mNodeManager.dropNodeTreeSnapshot();
+
+    // the snapshot must describe the state committed to the DB, which is the one found upon
+    // resumption: uncommitted changes would be rolled back anyway when the DB is closed
+    sctable->abort();
+    sctable->begin();
+
+    string data;
+    if (!sctable->get(CACHEDSCSN, &data) || data.size() != sizeof(handle))
+    {
+        return;
+    }
+    const handle committedScsn = MemAccess::get<handle>(data.data());
+
+    if (NodeTreeSnapshot::open(mNodeTreeSnapshotPath, committedScsn))
+    {
+        LOG_debug << "Node tree snapshot is up to date";
+        return;
+    }
+
+    mNodeManager.writeNodeTreeSnapshot(*fsaccess, mNodeTreeSnapshotPath, committedScsn);
+}
+
 void MegaClient::removeCaches()
 {
     mJourneyId->resetCacheAndValues();
@@ -5185,6 +5254,11 @@ void MegaClient::removeCaches()
         sctable.reset();
     }
 
+    if (!mNodeTreeSnapshotPath.empty() && fsaccess->fileExistsAt(mNodeTreeSnapshotPath))
+    {
+        fsaccess->unlinklocal(mNodeTreeSnapshotPath);
+    }
+
     if (statusTable)
     {
         statusTable->remove();
@@ -5345,6 +5419,12 @@ bool MegaClient::procsc(JSON& json)
 
         if (insca)
         {
+            if (sc_sliceExhausted(lastAPDeletedNode.get()))
+            {
+                // resume from this action packet in the next call to exec()
+                return false;
+            }
+
             if (!sc_checkActionPacketPreservePos(json, lastAPDeletedNode.get()))
             {
                 return false;
@@ -5375,6 +5455,8 @@ void MegaClient::sc_storeSn(JSON& json)
 
 void MegaClient::sc_purgeAndCommit()
 {
+    // folder counters are written once per transaction
+    mNodeManager.flushTreeCounters();
     notifypurge();
     if (sctable)
     {
@@ -5388,6 +5470,9 @@ void MegaClient::sc_purgeAndCommit()
 
 void MegaClient::sc_procEoo(std::unique_lock<recursive_mutex>& nodeTreeIsChanging, bool originalAC)
 {
+    // the app is notified from here on
+    mNodeManager.flushTreeCounters();
+
     if (!useralerts.isDeletedSharedNodesStashEmpty())
     {
         useralerts.purgeNodeVersionsFromStash();
@@ -5404,7 +5489,7 @@ void MegaClient::sc_procEoo(std::unique_lock<recursive_mutex>& nodeTreeIsChangin
     {
         if (fetchingnodes)
         {
-            notifypurge();
+            notifypurge(); // tree counters were flushed above
             if (sctable)
             {
                 LOG_debug << "DB transaction COMMIT (sessionid: "
@@ -5585,6 +5670,68 @@ void MegaClient::sc_updateStats()
     {
         fnstats.actionPackets++;
     }
+
+    mActionPacketsSlice.count();
+}
+
+bool MegaClient::sc_sliceExhausted(const Node* lastAPDeletedNode)
+{
+    // a move ("d" followed by "t") is not split across slices, so other threads never see the
+    // node detached from the tree
+    if (lastAPDeletedNode || !mActionPacketsSlice.exhausted())
+    {
+        return false;
+    }
+
+    if (!mActionPacketsSlice.yielded)
+    {
+        mActionPacketsSlice.yielded = true;
+        ++performanceStats.scSlicesYielded;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - mActionPacketsSlice.firstPacketTime);
+        LOG_debug << clientname << "Action packets applied in this iteration: "
+                  << mActionPacketsSlice.packets << " (" << elapsed.count()
+                  << " ms). Continuing in the next one";
+        if (!statecurrent)
+        {
+            LOG_debug << clientname << "Action packets applied while catching up: "
+                      << fnstats.actionPackets;
+        }
+    }
+
+    return true;
+}
+
+void MegaClient::ActionPacketsSlice::begin()
+{
+    started = true;
+    packets = 0;
+    yielded = false;
+}
+
+void MegaClient::ActionPacketsSlice::count()
+{
+    if (!packets++)
+    {
+        firstPacketTime = std::chrono::steady_clock::now();
+    }
+}
+
+bool MegaClient::ActionPacketsSlice::exhausted() const
+{
+    // at least one action packet is applied per slice, so the processing always progresses
+    if (!started || !packets)
+    {
+        return false;
+    }
+
+    if (maxPackets && packets >= maxPackets)
+    {
+        return true;
+    }
+
+    return maxTime.count() && std::chrono::steady_clock::now() - firstPacketTime >= maxTime;
 }
 
 std::shared_ptr<Node> MegaClient::sc_procActionPacketWithoutCommonTags(JSON& json,
@@ -10572,7 +10719,8 @@ int MegaClient::readnode(JSON* j,
                          bool applykeys,
                          mega::NodeManager::MissingParentNodes& missingParentNodes,
                          handle& previousHandleForAlert,
-                         set<NodeHandle>* allParents)
+                         set<NodeHandle>* allParents,
+                         std::vector<ReadNode>* readNodes)
 {
     std::shared_ptr<Node> n;
 
@@ -10704,6 +10852,11 @@ int MegaClient::readnode(JSON* j,
 
         if (!warnlevel())
         {
+            ReadNode rn;
+            rn.parentHandle = ph;
+            rn.owner = u;
+            rn.type = t;
+
             // 'notify' is false only while processing fetchnodes command
             // In that case, we can skip the lookup, since nodes are all new ones,
             // (they will not be found in DB)
@@ -10782,10 +10935,6 @@ int MegaClient::readnode(JSON* j,
                     }
                 }
 
-                string fas;
-
-                JSON::copystring(&fas, fa);
-
                 // fallback timestamps
                 if (!(ts + 1))
                 {
@@ -10797,7 +10946,8 @@ int MegaClient::readnode(JSON* j,
                     sts = ts;
                 }
 
-                n = std::make_shared<Node>(*this, NodeHandle().set6byte(h), NodeHandle().set6byte(ph), t, s, u, fas.c_str(), ts);
+                // the file attributes are copied by Node straight from the JSON buffer
+                n = std::make_shared<Node>(*this, NodeHandle().set6byte(h), NodeHandle().set6byte(ph), t, s, u, fa, ts);
                 n->changed.newnode = true;
                 n->changed.modifiedByThisClient = modifiedByThisClient;
 
@@ -10825,97 +10975,248 @@ int MegaClient::readnode(JSON* j,
                     }
                 }
 
-                // NodeManager takes n ownership
-                mNodeManager.addNode(n, notify != 0, fetchingnodes, missingParentNodes);
-
-                if (!ISUNDEF(su))   // node represents an incoming share
-                {
-                    newshares.push_back(new NewShare(h, 0, su, rl, sts, sk ? buf.data() : NULL));
-                    if (sk) // only if the key is valid, add it to the repository
-                    {
-                        mNewKeyRepository[NodeHandle().set6byte(h)] = std::move(buf);
-                    }
-                }
-                else if (t == FOLDERNODE && !notify && !loggedIntoFolder() && !ISUNDEF(u) &&
-                         u != me) // 'notify' is false only while processing fetchnodes command.
+                rn.isNew = true;
+                rn.ctime = ts;
+                rn.sharingUser = su;
+                rn.shareAccess = rl;
+                rn.shareTs = sts;
+                if (sk)
                 {
-                    // Foreign folder node which is not an inshare. We may still have a sharekey for
-                    // it (nested share). If set, new pushed nodes can take it into acount and
-                    // encrypt the node key for it.
-                    auto shareKey = mKeyManager.getShareKey(h);
-                    if (shareKey.size() && mKeyManager.isShareKeyTrusted(h))
-                    {
-                        // So the node has the sharekey but without being an inshare (no user data)
-                        newshares.push_back(
-                            new NewShare(h,
-                                         0,
-                                         UNDEF,
-                                         ACCESS_UNKNOWN,
-                                         0,
-                                         reinterpret_cast<const byte*>(shareKey.data())));
-                    }
+                    rn.shareKey = std::move(buf);
                 }
+                rn.newNodeIndex = nni;
+            }
 
-                if (u != me && !ISUNDEF(u) && !fetchingnodes && !loggedIntoFolder())
-                {
-                    useralerts.noteSharedNode(u, t, ts, n.get(), name_id::put);
-                }
+            rn.node = std::move(n);
 
-                if (nn && nni >= 0 && nni < int(nn->size()))
-                {
-                    auto& nn_nni = (*nn)[static_cast<size_t>(nni)];
-                    nn_nni.added = true;
-                    nn_nni.mAddedHandle = h;
-                }
+            if (readNodes && rn.isNew && applykeys && !notify)
+            {
+                // its key and attributes will be decrypted along with the next nodes
+                readNodes->push_back(std::move(rn));
             }
-
-            if (applykeys)
+            else
             {
-                n->applykey();
+                addReadNode(rn, notify, nn, applykeys, missingParentNodes, previousHandleForAlert);
             }
+        }
 
-            if (!n->keyApplied())
+        return 1;
+    }
+
+    return 0;
+}
+
+void MegaClient::addReadNode(ReadNode& rn,
+                             int notify,
+                             vector<NewNode>* nn,
+                             bool applykeys,
+                             NodeManager::MissingParentNodes& missingParentNodes,
+                             handle& previousHandleForAlert)
+{
+    std::shared_ptr<Node> n = std::move(rn.node);
+    const handle h = n->nodehandle;
+    const handle ph = rn.parentHandle;
+    const nodetype_t t = rn.type;
+
+    if (rn.isNew)
+    {
+        const handle u = rn.owner;
+        const handle su = rn.sharingUser;
+
+        // NodeManager takes n ownership
+        mNodeManager.addNode(n, notify != 0, fetchingnodes, missingParentNodes);
+
+        if (!ISUNDEF(su))   // node represents an incoming share
+        {
+            newshares.push_back(new NewShare(h, 0, su, rn.shareAccess, rn.shareTs, rn.shareKey.empty() ? NULL : rn.shareKey.data()));
+            if (!rn.shareKey.empty()) // only if the key is valid, add it to the repository
             {
-                mNodeManager.addNodePendingApplykey(n);
+                mNewKeyRepository[NodeHandle().set6byte(h)] = std::move(rn.shareKey);
             }
-
-            if (notify)
+        }
+        else if (t == FOLDERNODE && !notify && !loggedIntoFolder() && !ISUNDEF(u) &&
+                 u != me) // 'notify' is false only while processing fetchnodes command.
+        {
+            // Foreign folder node which is not an inshare. We may still have a sharekey for
+            // it (nested share). If set, new pushed nodes can take it into acount and
+            // encrypt the node key for it.
+            auto shareKey = mKeyManager.getShareKey(h);
+            if (shareKey.size() && mKeyManager.isShareKeyTrusted(h))
             {
-                // node is save in DB at notifypurge
-                mNodeManager.notifyNode(n);
+                // So the node has the sharekey but without being an inshare (no user data)
+                newshares.push_back(
+                    new NewShare(h,
+                                 0,
+                                 UNDEF,
+                                 ACCESS_UNKNOWN,
+                                 0,
+                                 reinterpret_cast<const byte*>(shareKey.data())));
             }
-            else // Only need to save in DB if node is not notified
+        }
+
+        if (u != me && !ISUNDEF(u) && !fetchingnodes && !loggedIntoFolder())
+        {
+            useralerts.noteSharedNode(u, t, rn.ctime, n.get(), name_id::put);
+        }
+
+        if (nn && rn.newNodeIndex >= 0 && rn.newNodeIndex < int(nn->size()))
+        {
+            auto& nn_nni = (*nn)[static_cast<size_t>(rn.newNodeIndex)];
+            nn_nni.added = true;
+            nn_nni.mAddedHandle = h;
+        }
+    }
+
+    if (applykeys)
+    {
+        if (rn.decryptedKey)
+        {
+            n->applykey(*rn.decryptedKey);
+        }
+        else
+        {
+            n->applykey();
+        }
+    }
+
+    if (!n->keyApplied())
+    {
+        mNodeManager.addNodePendingApplykey(n);
+    }
+
+    if (notify)
+    {
+        // node is save in DB at notifypurge
+        mNodeManager.notifyNode(n);
+    }
+    else // Only need to save in DB if node is not notified
+    {
+        mNodeManager.saveNodeInDb(n.get());
+    }
+
+    n = nullptr;    // ownership is taken by NodeManager upon addNode()
+
+    // update-alerts for shared-nodes management
+    if (!ISUNDEF(ph) && !loggedIntoFolder())
+    {
+        if (useralerts.isHandleInAlertsAsRemoved(h) && ISUNDEF(previousHandleForAlert))
+        {
+            useralerts.setNewNodeAlertToUpdateNodeAlert(nodebyhandle(ph).get());
+            useralerts.removeNodeAlerts(nodebyhandle(h).get());
+            previousHandleForAlert = h;
+        }
+        else if ((t == FILENODE) || (t == FOLDERNODE))
+        {
+            if (previousHandleForAlert == ph)
             {
-                mNodeManager.saveNodeInDb(n.get());
+                useralerts.removeNodeAlerts(nodebyhandle(h).get());
+                previousHandleForAlert = h;
             }
+            // otherwise, the added TYPE_NEWSHAREDNODE is kept
+        }
+    }
+}
 
-            n = nullptr;    // ownership is taken by NodeManager upon addNode()
+void MegaClient::addReadNodes(std::vector<ReadNode>& readNodes,
+                              NodeManager::MissingParentNodes& missingParentNodes,
+                              handle& previousHandleForAlert)
+{
+    if (readNodes.empty())
+    {
+        return;
+    }
 
-            // update-alerts for shared-nodes management
-            if (!ISUNDEF(ph) && !loggedIntoFolder())
+    struct Job
+    {
+        ReadNode* readNode;
+        const char* encryptedKey;
+        byte cipherKey[SymmCipher::KEYLENGTH];
+        bool foreign;
+    };
+
+    // shared with the worker threads: the ones that start after all the jobs are done
+    // (or after this function returned) must find nothing left to do
+    struct Batch
+    {
+        std::vector<Job> jobs;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t done = 0;
+    };
+    auto batch = std::make_shared<Batch>();
+
+    // the keys are looked up here, since the share keys and the nodes are not thread-safe
+    batch->jobs.reserve(readNodes.size());
+    for (ReadNode& rn: readNodes)
+    {
+        Job job;
+        job.readNode = &rn;
+        if ((job.encryptedKey = rn.node->findStableKey(job.cipherKey, job.foreign)))
+        {
+            batch->jobs.push_back(job);
+        }
+    }
+
+    static constexpr size_t JOBS_PER_TASK = 64;
+    static const auto runJobs = [](Batch& b, SymmCipher& sc)
+    {
+        size_t first;
+        while ((first = b.next.fetch_add(JOBS_PER_TASK)) < b.jobs.size())
+        {
+            size_t last = std::min(first + JOBS_PER_TASK, b.jobs.size());
+            for (size_t i = first; i < last; ++i)
             {
-                if (useralerts.isHandleInAlertsAsRemoved(h) && ISUNDEF(previousHandleForAlert))
+                Job& job = b.jobs[i];
+                const Node& n = *job.readNode->node;
+                Node::DecryptedKey decrypted;
+                decrypted.foreign = job.foreign;
+                if (Node::decryptKey(job.encryptedKey, job.cipherKey, n.type, n.attrstring.get(), sc, decrypted))
                 {
-                    useralerts.setNewNodeAlertToUpdateNodeAlert(nodebyhandle(ph).get());
-                    useralerts.removeNodeAlerts(nodebyhandle(h).get());
-                    previousHandleForAlert = h;
-                }
-                else if ((t == FILENODE) || (t == FOLDERNODE))
-                {
-                    if (previousHandleForAlert == ph)
-                    {
-                        useralerts.removeNodeAlerts(nodebyhandle(h).get());
-                        previousHandleForAlert = h;
-                    }
-                    // otherwise, the added TYPE_NEWSHAREDNODE is kept
+                    job.readNode->decryptedKey = std::move(decrypted);
                 }
             }
+
+            std::lock_guard<std::mutex> g(b.mutex);
+            b.done += last - first;
+            if (b.done == b.jobs.size())
+            {
+                b.cv.notify_one();
+            }
         }
+    };
 
-        return 1;
+    size_t tasks = (batch->jobs.size() + JOBS_PER_TASK - 1) / JOBS_PER_TASK;
+    for (size_t i = 1; i < tasks; ++i)
+    {
+        mAsyncQueue.push(
+            [batch](SymmCipher& sc)
+            {
+                runJobs(*batch, sc);
+            },
+            false);
     }
 
-    return 0;
+    // this thread takes its share too (all of it, if the workers are busy)
+    SymmCipher sc;
+    runJobs(*batch, sc);
+    {
+        std::unique_lock<std::mutex> g(batch->mutex);
+        batch->cv.wait(g,
+                       [&batch]()
+                       {
+                           return batch->done == batch->jobs.size();
+                       });
+    }
+
+    LOG_verbose << "Decrypted " << batch->jobs.size() << " of " << readNodes.size()
+                << " nodes in parallel";
+
+    for (ReadNode& rn: readNodes)
+    {
+        addReadNode(rn, 0, nullptr, true, missingParentNodes, previousHandleForAlert);
+    }
+    readNodes.clear();
 }
 
 #ifdef ENABLE_SYNC
@@ -12364,6 +12665,22 @@ void MegaClient::opensctable()
                 {
                     mNodeManager.dropLexicographicDBIndexes();
                 }
+                if (!mEnableFullTextSearchDBIndex)
+                {
+                    mNodeManager.dropFullTextDBIndex();
+                }
+                if (!mEnableAncestorDBIndex)
+                {
+                    mNodeManager.dropAncestorDBIndex();
+                }
+
+                mNodeTreeSnapshotPath =
+                    dbaccess->databasePath(*fsaccess, dbname, DbAccess::DB_VERSION);
+                mNodeTreeSnapshotPath.append(LocalPath::fromRelativePath(".tree"));
+                if (!mEnableNodeTreeSnapshot && fsaccess->fileExistsAt(mNodeTreeSnapshotPath))
+                {
+                    fsaccess->unlinklocal(mNodeTreeSnapshotPath);
+                }
 
                 // DB connection always has a transaction started (applies to both tables, statecache and nodes)
                 // We only commit once we have an up to date SCSN and the table state matches it.
@@ -15344,6 +15661,11 @@ bool MegaClient::fetchsc(DbTable* stateCacheTable)
         // nodes are not loaded, proceed to load them only after Users and PCRs are loaded,
         // since Node::unserialize() will call mergenewshare(), and the latter requires
         // Users and PCRs to be available
+        if (mEnableNodeTreeSnapshot)
+        {
+            mNodeManager.openNodeTreeSnapshot(mNodeTreeSnapshotPath, cachedscsn);
+        }
+
         if (!mNodeManager.loadNodes())
         {
             return false;
@@ -19429,7 +19751,7 @@ std::shared_ptr<Node> MegaClient::nodebyfingerprint(LocalNode* localNode)
                    remoteNodes.end(),
                    [&](std::shared_ptr<Node> remoteNode) -> bool
                    {
-                       return localNode->toName_of_localname == remoteNode->displayname();
+                       return localNode->toName_of_localname.view() == remoteNode->displayname();
                    });
 
     if (remoteNode != remoteNodes.end())
@@ -20588,7 +20910,8 @@ std::string MegaClient::PerformanceStats::report(bool reset, HttpIO* httpio, Wai
         << " transfers active time: " << transfersActiveTime.report(reset) << "\n"
         << " transfer starts/finishes: " << transferStarts << " " << transferFinishes << "\n"
         << " transfer temperror/fails: " << transferTempErrors << " " << transferFails << "\n"
-        << " nowait reason: immedate: " << prepwaitImmediate << " zero: " << prepwaitZero << " httpio: " << prepwaitHttpio << " fsaccess: " << prepwaitFsaccess << " nonzero waits: " << nonzeroWait << "\n";
+        << " nowait reason: immedate: " << prepwaitImmediate << " zero: " << prepwaitZero << " httpio: " << prepwaitHttpio << " fsaccess: " << prepwaitFsaccess << " nonzero waits: " << nonzeroWait << "\n"
+        << " sc slices yielded: " << scSlicesYielded << "\n";
     if (auto curlhttpio = dynamic_cast<CurlHttpIO*>(httpio))
     {
         s << curlhttpio->countCurlHttpIOAddevents.report(reset) << "\n"
@@ -20605,6 +20928,7 @@ std::string MegaClient::PerformanceStats::report(bool reset, HttpIO* httpio, Wai
     {
         transferStarts = transferFinishes = transferTempErrors = transferFails = 0;
         prepwaitImmediate = prepwaitZero = prepwaitHttpio = prepwaitFsaccess = nonzeroWait = 0;
+        scSlicesYielded = 0;
     }
     return s.str();
 }
@@ -22669,12 +22993,13 @@ void MegaClient::preparePasswordManagerNodeData(attr_map& attrs, const AttrMap&
     auto auxDataAttrMap = data;
     if (auxDataAttrMap.map.contains(AttrMap::string2nameid(PWM_ATTR_PASSWORD_TOTP)))
     {
-        const auto totp =
-            auxDataAttrMap.map.extract(AttrMap::string2nameid(PWM_ATTR_PASSWORD_TOTP));
+        const auto totpName = AttrMap::string2nameid(PWM_ATTR_PASSWORD_TOTP);
+        const auto totp = std::move(auxDataAttrMap.map[totpName]);
+        auxDataAttrMap.map.erase(totpName);
         auxstr = auxDataAttrMap.getjson();
         if (!auxDataAttrMap.map.empty())
         {
-            auxstr += ",\"" + AttrMap::nameid2string(totp.key()) + "\":" + totp.mapped();
+            auxstr += ",\"" + AttrMap::nameid2string(totpName) + "\":" + totp;
         }
     }
 
@@ -25686,6 +26011,12 @@ void MegaClient::processScMessageInStreaming()
 void MegaClient::setStreamingContinue()
 {
     mStreamingContinue = true;
+    if (scStreamingParser.isLastReceived())
+    {
+        // processing was paused and it's resumed now
+        return;
+    }
+
     scStreamingParser.setLastReceived();
     app->notify_network_activity(NetworkActivityChannel::SC,
                                  NetworkActivityType::REQUEST_RECEIVED,
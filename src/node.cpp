@@ -381,15 +381,7 @@ bool Node::isPhoto(const std::string& ext)
 
 bool Node::isPhotoWithFileAttributes(bool checkPreview) const
 {
-    std::string ext;
-    if (!Node::getExtension(ext, displayname()))
-    {
-        return false;
-    }
-
-    // evaluate according to the webclient rules, so that we get exactly the same bucketing.
-    return (isPhoto(ext)
-            && (!checkPreview || Node::hasfileattribute(&fileattrstring, GfxProc::PREVIEW)));
+    return isIncludedForMimetype(MimeType_t::MIME_TYPE_PHOTO, checkPreview);
 }
 
 bool Node::isVideo(const std::string& ext)
@@ -497,6 +489,54 @@ MimeType_t Node::getMimetype(const std::string& ext)
     return MimeType_t::MIME_TYPE_OTHERS;
 }
 
+MimeType_t Node::getMimetypeByName(const std::string& name)
+{
+    std::string ext;
+    if (name.empty() || !getExtension(ext, name) || ext.empty())
+    {
+        return MimeType_t::MIME_TYPE_OTHERS;
+    }
+    return getMimetype(ext);
+}
+
+// categories an extension belongs to, as a bit (1 << MimeType_t) for each one: an extension can
+// be in more than one (i.e. "csv" is a spreadsheet and also miscellaneous)
+static uint16_t getMimetypesOfExtension(const std::string& ext)
+{
+    static const MimeType_t categories[]{MimeType_t::MIME_TYPE_PHOTO,
+                                         MimeType_t::MIME_TYPE_AUDIO,
+                                         MimeType_t::MIME_TYPE_VIDEO,
+                                         MimeType_t::MIME_TYPE_DOCUMENT,
+                                         MimeType_t::MIME_TYPE_PDF,
+                                         MimeType_t::MIME_TYPE_PRESENTATION,
+                                         MimeType_t::MIME_TYPE_ARCHIVE,
+                                         MimeType_t::MIME_TYPE_PROGRAM,
+                                         MimeType_t::MIME_TYPE_MISC,
+                                         MimeType_t::MIME_TYPE_SPREADSHEET};
+
+    uint16_t mimetypes = 0;
+    for (MimeType_t category: categories)
+    {
+        if (Node::isOfMimetype(category, ext))
+        {
+            mimetypes = static_cast<uint16_t>(mimetypes | (1 << category));
+        }
+    }
+    return mimetypes;
+}
+
+void Node::updateMimetypes()
+{
+    mMimetypes = 0;
+
+    auto it = attrs.map.find('n');
+    std::string ext;
+    if (it != attrs.map.end() && getExtension(ext, it->second) && !ext.empty())
+    {
+        mMimetypes = getMimetypesOfExtension(ext);
+    }
+}
+
 nameid Node::getExtensionNameId(const std::string& ext)
 {
     if (ext.length() > 8)
@@ -513,7 +553,7 @@ void Node::setkeyfromjson(const char* k)
 {
     string tmp;
     JSON::copystring(&tmp, k);
-    setKey(tmp);
+    setKey(std::move(tmp));
 }
 
 // update node key (already decrypted) and attempt to decrypt attributes
@@ -521,28 +561,27 @@ void Node::setkey(const byte* newkey)
 {
     if (newkey)
     {
-        string tmp(reinterpret_cast<const char*>(newkey), (type == FILENODE) ? FILENODEKEYLENGTH : FOLDERNODEKEYLENGTH);
-        setKey(tmp);
+        setKey(string(reinterpret_cast<const char*>(newkey), (type == FILENODE) ? FILENODEKEYLENGTH : FOLDERNODEKEYLENGTH));
     }
 
     setattr();
 }
 
 // set the node key (encrypted or decrypted)
-void Node::setKey(const string& key)
+void Node::setKey(string key)
 {
     if (keyApplied())
         client->mNodeManager.decreaseNumNodesAppliedKey();
 
-    nodekeydata = key;
+    nodekeydata = std::move(key);
     if (keyApplied())
         client->mNodeManager.increaseNumNodesAppliedKey();
     assert(client->mNodeManager.getNumNodesKeyApplied() >= 0);
 }
 
-std::shared_ptr<Node> Node::unserialize(MegaClient& client, const std::string* d, bool fromOldCache, std::list<std::unique_ptr<NewShare>>& ownNewshares)
+std::shared_ptr<Node> Node::unserialize(MegaClient& client, std::string_view d, bool fromOldCache, std::list<std::unique_ptr<NewShare>>& ownNewshares)
 {
-    NodeData nd(d->data(), d->size(), NodeData::COMPONENT_ALL);
+    NodeData nd(d.data(), d.size(), NodeData::COMPONENT_ALL);
     return nd.createNode(client, fromOldCache, ownNewshares);
 }
 
@@ -819,15 +858,27 @@ void Node::setattr()
         return;
     }
 
-    AttrMap oldAttrs(attrs);
-    attrs.map.clear();
-    attrs.fromjson(reinterpret_cast<char*>(buf) + 5);
+    AttrMap decryptedAttrs;
+    decryptedAttrs.fromjson(reinterpret_cast<char*>(buf) + 5);
+    delete[] buf;
 
-    auto it = attrs.map.find('n');
-    if (it != std::end(attrs.map))
+    auto it = decryptedAttrs.map.find('n');
+    if (it != std::end(decryptedAttrs.map))
         LocalPath::utf8_normalize(&it->second);
 
+    setattr(std::move(decryptedAttrs));
+}
+
+void Node::setattr(AttrMap&& decryptedAttrs)
+{
+    AttrMap oldAttrs(std::move(attrs));
+    attrs = std::move(decryptedAttrs);
+
     changed.name = attrs.hasDifferentValue('n', oldAttrs.map);
+    if (changed.name)
+    {
+        updateMimetypes();
+    }
     changed.favourite = attrs.hasDifferentValue(AttrMap::string2nameid("fav"), oldAttrs.map);
     changed.sensitive = attrs.hasDifferentValue(AttrMap::string2nameid("sen"), oldAttrs.map);
 
@@ -842,8 +893,6 @@ void Node::setattr()
 
     setfingerprint();
 
-    delete[] buf;
-
     attrstring.reset();
 }
 
@@ -1099,18 +1148,33 @@ bool Node::isIncludedForMimetype(MimeType_t mimetype, bool checkPreview) const
         return false;
     }
 
-    if (mimetype == MimeType_t::MIME_TYPE_PHOTO)
-    {
-        return isPhotoWithFileAttributes(checkPreview);
-    }
-
-    std::string extension;
-    if (!getExtension(extension, displayname()))
-    {
-        return MimeType_t::MIME_TYPE_OTHERS == mimetype;
+    // a node that is not decrypted yet has no name
+    const uint16_t mimetypes = attrstring ? 0 : mMimetypes;
+    auto bit = [](MimeType_t category)
+    {
+        return static_cast<uint16_t>(1 << category);
+    };
+
+    switch (mimetype)
+    {
+        case MimeType_t::MIME_TYPE_PHOTO:
+            // evaluate according to the webclient rules, so that we get exactly the same bucketing.
+            return (mimetypes & bit(mimetype)) &&
+                   (!checkPreview || Node::hasfileattribute(&fileattrstring, GfxProc::PREVIEW));
+        case MimeType_t::MIME_TYPE_ALL_DOCS:
+            return mimetypes &
+                   (bit(MimeType_t::MIME_TYPE_DOCUMENT) | bit(MimeType_t::MIME_TYPE_PDF) |
+                    bit(MimeType_t::MIME_TYPE_PRESENTATION) |
+                    bit(MimeType_t::MIME_TYPE_SPREADSHEET));
+        case MimeType_t::MIME_TYPE_ALL_VISUAL_MEDIA:
+            return mimetypes & (bit(MimeType_t::MIME_TYPE_PHOTO) | bit(MimeType_t::MIME_TYPE_VIDEO));
+        case MimeType_t::MIME_TYPE_OTHERS:
+            return !mimetypes;
+        case MimeType_t::MIME_TYPE_UNKNOWN:
+            return false;
+        default:
+            return mimetypes & bit(mimetype);
     }
-
-    return Node::isOfMimetype(mimetype, extension);
 }
 
 bool isPhotoVideoAudioByName(const string& filenameExtensionLowercaseNoDot)
@@ -1245,13 +1309,154 @@ bool Node::applykey()
     byte key[FILENODEKEYLENGTH];
     unsigned keylength = (type == FILENODE) ? FILENODEKEYLENGTH : FOLDERNODEKEYLENGTH;
 
-    if (client->decryptkey(k, key, static_cast<int>(keylength), sc, 0, nodehandle))
+    bool decrypted = client->decryptkey(k, key, static_cast<int>(keylength), sc, 0, nodehandle);
+    return applyDecryptedKey(decrypted ? key : nullptr, nullptr);
+}
+
+bool Node::applykey(DecryptedKey& decrypted)
+{
+    assert(type <= FOLDERNODE);
+
+    if (keyApplied() || !nodekeydata.size())
+    {
+        return false;
+    }
+
+    if (decrypted.foreign)
+    {
+        foreignkey = true;
+    }
+
+    return applyDecryptedKey(decrypted.key, &decrypted.attrs);
+}
+
+const char* Node::findStableKey(byte* cipherKey, bool& foreign) const
+{
+    if (type > FOLDERNODE || keyApplied() || !nodekeydata.size())
+    {
+        return nullptr;
+    }
+
+    // same lookup as applykey()
+    int l = -1;
+    size_t t = 0;
+    handle h;
+    const byte* sk = client->key.key;
+    std::string shareKey;
+    handle me = client->loggedIntoFolder() ? client->mNodeManager.getRootNodeFiles().as8byte() : client->me;
+
+    foreign = false;
+    const char* k = nullptr;
+    while ((t = nodekeydata.find_first_of(':', t)) != string::npos)
     {
+        h = 0;
+
+        l = Base64::atob(nodekeydata.c_str() + (nodekeydata.find_last_of('/', t) + 1), (byte*)&h, sizeof h);
+        t++;
+
+        if (h != me)
+        {
+            if (l == MegaClient::USERHANDLE)
+            {
+                continue; // another user
+            }
+
+            if (!client->mKeyManager.generation())
+            {
+                // legacy share keys can arrive with the nodes of `f` themselves
+                return nullptr;
+            }
+
+            shareKey = client->mKeyManager.getShareKey(h);
+            if (shareKey.size() != SymmCipher::KEYLENGTH)
+            {
+                continue;
+            }
+
+            sk = reinterpret_cast<const byte*>(shareKey.data());
+            foreign = true;
+        }
+
+        k = nodekeydata.c_str() + t;
+        break;
+    }
+
+    if (!k)
+    {
+        if (l >= 0)
+        {
+            return nullptr;
+        }
+        k = nodekeydata.c_str();
+    }
+
+    // RSA-encrypted keys are decrypted on the SDK thread
+    size_t sl = strcspn(k, "\"/");
+    if (sl > 4 * FILENODEKEYLENGTH / 3 + 1)
+    {
+        return nullptr;
+    }
+
+    memcpy(cipherKey, sk, SymmCipher::KEYLENGTH);
+    return k;
+}
+
+bool Node::decryptKey(const char* encryptedKey,
+                      const byte* cipherKey,
+                      nodetype_t type,
+                      const string* attrstring,
+                      SymmCipher& sc,
+                      DecryptedKey& decrypted)
+{
+    // same as MegaClient::decryptkey() and setattr()
+    const int keylength = (type == FILENODE) ? FILENODEKEYLENGTH : FOLDERNODEKEYLENGTH;
+    if (Base64::atob(encryptedKey, decrypted.key, keylength) != keylength)
+    {
+        return false;
+    }
+    sc.setkey(cipherKey);
+    sc.ecb_decrypt(decrypted.key, static_cast<size_t>(keylength));
+
+    decrypted.attrs.reset();
+    if (attrstring)
+    {
+        sc.setkey(decrypted.key, type);
+        std::unique_ptr<byte[]> buf(decryptattr(&sc, attrstring->c_str(), attrstring->size()));
+        if (buf)
+        {
+            decrypted.attrs.emplace();
+            decrypted.attrs->fromjson(reinterpret_cast<char*>(buf.get()) + 5);
+
+            auto it = decrypted.attrs->map.find('n');
+            if (it != decrypted.attrs->map.end())
+            {
+                LocalPath::utf8_normalize(&it->second);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Node::applyDecryptedKey(const byte* key, std::optional<AttrMap>* decryptedAttrs)
+{
+    if (key)
+    {
+        unsigned keylength = (type == FILENODE) ? FILENODEKEYLENGTH : FOLDERNODEKEYLENGTH;
+
         std::string undecryptedKey = nodekeydata;
         client->mNodeManager.increaseNumNodesAppliedKey();
         nodekeydata.assign((const char*)key, keylength);
         bool keyApplied{true};
-        setattr();
+        if (!decryptedAttrs)
+        {
+            setattr();
+        }
+        else if (*decryptedAttrs)
+        {
+            setattr(std::move(**decryptedAttrs));
+        }
+
         if (attrstring)
         {
             if (foreignkey)
@@ -1546,7 +1751,7 @@ bool NodeData::readComponents()
                 return false;
             }
 
-            mNodeKey.assign(ptr, static_cast<size_t>(nodeKeyLen));
+            mNodeKey = std::string_view(ptr, static_cast<size_t>(nodeKeyLen));
             ptr += nodeKeyLen;
         }
     }
@@ -1571,7 +1776,7 @@ bool NodeData::readComponents()
             {
                 return false;
             }
-            mFileAttributes.assign(ptr, faLen);
+            mFileAttributes = std::string_view(ptr, faLen);
         }
         ptr += faLen;
     }
@@ -1599,7 +1804,7 @@ bool NodeData::readComponents()
             {
                 return false;
             }
-            mAuthKey.assign(ptr, static_cast<size_t>(authKeySize));
+            mAuthKey = std::string_view(ptr, static_cast<size_t>(authKeySize));
             ptr += authKeySize;
         }
     }
@@ -1643,8 +1848,7 @@ bool NodeData::readComponents()
             {
                 return false;
             }
-            mShareKey.reset(new byte[SymmCipher::KEYLENGTH]);
-            std::copy(ptr, ptr + SymmCipher::KEYLENGTH, mShareKey.get());
+            mShareKey = reinterpret_cast<const byte*>(ptr);
         }
         ptr += SymmCipher::KEYLENGTH;
 
@@ -1668,8 +1872,7 @@ bool NodeData::readComponents()
                 {
                     return false;
                 }
-                mShares.emplace_back(shareSize);
-                std::copy(ptr, ptr + shareSize, mShares.back().data());
+                mShares.emplace_back(ptr, shareSize);
             }
 
             ptr += shareSize;
@@ -1736,7 +1939,7 @@ bool NodeData::readComponents()
             {
                 return false;
             }
-            mNodeKey.assign(ptr, length);
+            mNodeKey = std::string_view(ptr, length);
         }
         ptr += length;
 
@@ -1755,7 +1958,7 @@ bool NodeData::readComponents()
             {
                 return false;
             }
-            mAttrString.assign(ptr, length);
+            mAttrString = std::string_view(ptr, length);
         }
         ptr += length;
     }
@@ -1851,14 +2054,18 @@ std::shared_ptr<Node> NodeData::createNode(MegaClient& client,
                                                      mType,
                                                      mSize,
                                                      mUserHandle,
-                                                     mFileAttributes.c_str(),
+                                                     nullptr,
                                                      mCtime);
 
+    // the serialized file attributes keep their terminating NUL, which is not
+    // part of the string (see Node::serialize())
+    n->fileattrstring.assign(mFileAttributes.substr(0, mFileAttributes.find('\0')));
+
     // read inshare, outshares, or pending shares
     for (const auto& s : mShares)
     {
         const char* ptr = s.data();
-        NewShare* newShare = Share::unserialize(mShareDirection, mHandle, mShareKey.get(), &ptr, ptr + s.size());
+        NewShare* newShare = Share::unserialize(mShareDirection, mHandle, mShareKey, &ptr, ptr + s.size());
 
         if (!newShare)
         {
@@ -1879,7 +2086,7 @@ std::shared_ptr<Node> NodeData::createNode(MegaClient& client,
         }
     }
 
-    n->attrs = mAttrs;
+    n->attrs = std::move(mAttrs);
 
     if (fromOldCache)
     {
@@ -1895,9 +2102,12 @@ std::shared_ptr<Node> NodeData::createNode(MegaClient& client,
     }
     // else from new cache, names has been normalized before to store in DB
 
+    n->updateMimetypes();
+
     if (mIsExported)
     {
-        n->plink.reset(new PublicLink(mPubLinkHandle, mPubLinkCts, mPubLinkEts, mPubLinkTakenDown, mAuthKey.c_str()));
+        n->plink.reset(new PublicLink(mPubLinkHandle, mPubLinkCts, mPubLinkEts, mPubLinkTakenDown, nullptr));
+        n->plink->mAuthKey.assign(mAuthKey);
     }
 
     if (mIsEncrypted)
@@ -1905,7 +2115,7 @@ std::shared_ptr<Node> NodeData::createNode(MegaClient& client,
         n->attrstring.reset(new string(mAttrString));
     }
 
-    n->setKey(mNodeKey); // it can be decrypted or encrypted
+    n->setKey(string(mNodeKey)); // it can be decrypted or encrypted
 
     if (!n->keyApplied())
     {
@@ -1973,8 +2183,10 @@ void LocalNode::setnameparent(LocalNode* newparent, const LocalPath& newlocalpat
         if (parentChange || localnameChange)
         {
             // remove existing child linkage for localname
-            auto it = parent->children.find(localname);
-            if (it != parent->children.end() && it->second == this)
+            auto it = parent->children.find(localname,
+                                             toName_of_localname,
+                                             parent->sync->mCaseInsensitive);
+            if (it != parent->children.end() && *it == this)
             {
                 parent->children.erase(it);
             }
@@ -1984,10 +2196,17 @@ void LocalNode::setnameparent(LocalNode* newparent, const LocalPath& newlocalpat
             parentChange || shortnameChange))
         {
             // remove existing child linkage for slocalname
-            auto it = parent->schildren.find(*slocalname);
-            if (it != parent->schildren.end() && it->second == this)
+            if (auto& schildren = parent->schildren)
             {
-                parent->schildren.erase(it);
+                auto it = schildren->find(*slocalname);
+                if (it != schildren->end() && it->second == this)
+                {
+                    schildren->erase(it);
+                    if (schildren->empty())
+                    {
+                        schildren.reset();
+                    }
+                }
             }
         }
     }
@@ -2005,7 +2224,7 @@ void LocalNode::setnameparent(LocalNode* newparent, const LocalPath& newlocalpat
     {
         // set new name
         localname = newlocalpath;
-        toName_of_localname = localname.toName(*sync->syncs.fsaccess);
+        sync->mLocalNodeNames.assign(toName_of_localname, localname.toName(*sync->syncs.fsaccess));
     }
 
     if (shortnameChange)
@@ -2030,11 +2249,11 @@ void LocalNode::setnameparent(LocalNode* newparent, const LocalPath& newlocalpat
     if (parent && (parentChange || localnameChange))
     {
         #ifndef NDEBUG
-            auto it = parent->children.find(localname);
+            auto it = parent->children.find(localname, toName_of_localname, parent->sync->mCaseInsensitive);
             assert(it == parent->children.end());   // check we are not about to orphan the old one at this location... if we do then how did we get a clash in the first place?
         #endif
 
-        parent->children[localname] = this;
+        parent->children.insert(this, parent->sync->mCaseInsensitive);
     }
 
     // add to parent map by shortname
@@ -2042,7 +2261,11 @@ void LocalNode::setnameparent(LocalNode* newparent, const LocalPath& newlocalpat
     {
         // it's quite possible that the new folder still has an older LocalNode with clashing shortname, that represents a file/folder since moved, but which we don't know about yet.
         // just assign the new one, we forget the old reference.  The other LocalNode will not remove this one since the LocalNode* will not match.
-        parent->schildren[*slocalname] = this;
+        if (!parent->schildren)
+        {
+            parent->schildren.reset(new localnode_map);
+        }
+        (*parent->schildren)[*slocalname] = this;
     }
 
     // reset treestate
@@ -2085,7 +2308,7 @@ void LocalNode::moveContentTo(LocalNode* ln,
 {
     vector<LocalNode*> workingList;
     workingList.reserve(children.size());
-    for (auto& c : children) workingList.push_back(c.second);
+    workingList.assign(children.begin(), children.end());
     for (auto& c : workingList)
     {
         LocalPath newpath{fullPath};
@@ -2156,16 +2379,15 @@ LocalNode::LocalNode(Sync* csync)
 , parentSetContainsConflicts(false)
 , fsidSyncedReused(false)
 , fsidScannedReused(false)
+, inSyncedFsidIndex(false)
+, inScannedFsidIndex(false)
+, inNodeHandleIndex(false)
 , confirmDeleteCount(0)
 , certainlyOrphaned(0)
 , neverScanned(0)
 , localFSCannotStoreThisName(0)
 , mIsIgnoreFile(false)
 {
-    fsid_lastSynced_it = sync->syncs.localnodeBySyncedFsid.end();
-    fsid_asScanned_it = sync->syncs.localnodeByScannedFsid.end();
-    syncedCloudNodeHandle_it = sync->syncs.localnodeByNodeHandle.end();
-
     sync->syncs.totalLocalNodes++;
 }
 
@@ -2220,7 +2442,7 @@ void LocalNode::init(nodetype_t ctype, LocalNode* cparent, const LocalPath& cful
     else
     {
         localname = cfullpath;
-        toName_of_localname = localname.toName(*sync->syncs.fsaccess);
+        sync->mLocalNodeNames.assign(toName_of_localname, localname.toName(*sync->syncs.fsaccess));
         slocalname.reset(shortname && *shortname != localname ? shortname.release() : nullptr);
 
         mExclusionState = ES_INCLUDED;
@@ -2396,10 +2618,10 @@ void LocalNode::initiateScanBlocked(bool folderBlocked, bool containsFingerprint
                     << "Directory scan has become inaccessible for path: " << getLocalPath();
 
         // Mark all immediate children as requiring refingerprinting.
-        for (auto& childIt : children)
+        for (auto* child : children)
         {
-            if (childIt.second->type == FILENODE)
-                childIt.second->recomputeFingerprint = true;
+            if (child->type == FILENODE)
+                child->recomputeFingerprint = true;
         }
     }
 
@@ -2439,7 +2661,7 @@ bool LocalNode::checkForScanBlocked(FSNode* fsNode)
             LOG_verbose << sync->syncname << "Recovered from being scan blocked: " << getLocalPath();
 
             type = fsNode->type; // original scan may not have been able to discern type, fix it now
-            realScannedFingerprint = FileFingerprint();
+            setRealScannedFingerprint(FileFingerprint());
             setScannedFsid(UNDEF, sync->syncs.localnodeByScannedFsid, fsNode->localname, FileFingerprint());
             sync->statecacheadd(this);
 
@@ -2496,7 +2718,7 @@ void LocalNode::clearRegeneratableFolderScan(SyncPath& fullPath, vector<SyncRow>
             if (row.syncNode && row.fsNode)
             {
                 if (row.syncNode->type == FILENODE &&
-                    !scannedFingerprint.isvalid)
+                    !scannedFingerprint().isvalid)
                 {
                     return;
                 }
@@ -2530,18 +2752,18 @@ bool LocalNode::syncRequired() const
 
 void LocalNode::propagateAnySubtreeFlags()
 {
-    for (auto& child : children)
+    for (auto* child : children)
     {
-        if (child.second->type != FILENODE)
+        if (child->type != FILENODE)
         {
             if (scanAgain == TREE_ACTION_SUBTREE)
             {
-                child.second->scanDelayUntil = std::max<dstime>(child.second->scanDelayUntil,  scanDelayUntil);
+                child->scanDelayUntil = std::max<dstime>(child->scanDelayUntil,  scanDelayUntil);
             }
 
-            child.second->scanAgain = propagateSubtreeFlag(scanAgain, child.second->scanAgain);
-            child.second->checkMovesAgain = propagateSubtreeFlag(checkMovesAgain, child.second->checkMovesAgain);
-            child.second->syncAgain = propagateSubtreeFlag(syncAgain, child.second->syncAgain);
+            child->scanAgain = propagateSubtreeFlag(scanAgain, child->scanAgain);
+            child->checkMovesAgain = propagateSubtreeFlag(checkMovesAgain, child->checkMovesAgain);
+            child->syncAgain = propagateSubtreeFlag(syncAgain, child->syncAgain);
         }
     }
     if (scanAgain == TREE_ACTION_SUBTREE) scanAgain = TREE_ACTION_HERE;
@@ -2549,7 +2771,7 @@ void LocalNode::propagateAnySubtreeFlags()
     if (syncAgain == TREE_ACTION_SUBTREE) syncAgain = TREE_ACTION_HERE;
 }
 
-bool isDoNotSyncFileName(const string& name)
+bool isDoNotSyncFileName(std::string_view name)
 {
     return name == "desktop.ini" // on windows, automatically updated by Explorer based on folder content
            || name == ".DS_Store" // on mac, contains some info about contents of that folder
@@ -2607,9 +2829,9 @@ bool LocalNode::processBackgroundFolderScan(SyncRow& row, SyncPath& fullPath)
                 }
             }
 
-            for (auto& childIt : children)
+            for (auto* childPtr : children)
             {
-                auto& child = *childIt.second;
+                auto& child = *childPtr;
 
                 bool useSyncedFP = child.oneTimeUseSyncedFingerprintInScan;
                 child.oneTimeUseSyncedFingerprintInScan = false;
@@ -2630,16 +2852,16 @@ bool LocalNode::processBackgroundFolderScan(SyncRow& row, SyncPath& fullPath)
                     continue;
                 }
 
-                if (child.scannedFingerprint.isvalid)
+                if (child.scannedFingerprint().isvalid)
                 {
                     // as-scanned by this instance is more accurate if available
-                    priorScanChildren.emplace(childIt.first, child.getScannedFSDetails());
+                    priorScanChildren.emplace(child.localname, child.getScannedFSDetails());
                 }
-                else if (useSyncedFP && child.fsid_lastSynced != UNDEF && child.syncedFingerprint.isvalid)
+                else if (useSyncedFP && child.fsid_lastSynced != UNDEF && child.syncedFingerprint().isvalid)
                 {
                     // But otherwise, already-synced syncs on startup should not re-fingerprint
                     // files that match the synced fingerprint by fsid/size/mtime (for quick startup)
-                    priorScanChildren.emplace(childIt.first, child.getLastSyncedFSDetails());
+                    priorScanChildren.emplace(child.localname, child.getLastSyncedFSDetails());
                 }
             }
 
@@ -2816,9 +3038,9 @@ void LocalNode::recursiveSetAndReportTreestate(treestate_t ts, bool recurse, boo
 
     if (recurse)
     {
-        for (auto& i : children)
+        for (auto* child : children)
         {
-            i.second->recursiveSetAndReportTreestate(ts, recurse, reportToApp);
+            child->recursiveSetAndReportTreestate(ts, recurse, reportToApp);
         }
     }
 }
@@ -2863,14 +3085,16 @@ treestate_t LocalNode::checkTreestate(bool notifyChangeToApp)
 // set fsid - assume that an existing assignment of the same fsid is no longer current and revoke
 void LocalNode::setSyncedFsid(handle newfsid, fsid_localnode_map& fsidnodes, const LocalPath& fsName, std::unique_ptr<LocalPath> newshortname)
 {
-    if (fsid_lastSynced_it != fsidnodes.end())
+    if (inSyncedFsidIndex)
     {
         if (newfsid == fsid_lastSynced && localname == fsName)
         {
             return;
         }
 
-        fsidnodes.erase(fsid_lastSynced_it);
+        [[maybe_unused]] auto erased = fsidnodes.erase(fsid_lastSynced, this);
+        assert(erased);
+        inSyncedFsidIndex = false;
     }
 
     fsid_lastSynced = newfsid;
@@ -2887,13 +3111,10 @@ void LocalNode::setSyncedFsid(handle newfsid, fsid_localnode_map& fsidnodes, con
 
     // LOG_verbose << "localnode " << this << " fsid " << toHandle(fsid_lastSynced) << " localname " << fsName.toPath() << " parent " << parent;
 
-    if (fsid_lastSynced == UNDEF)
-    {
-        fsid_lastSynced_it = fsidnodes.end();
-    }
-    else
+    if (fsid_lastSynced != UNDEF)
     {
-        fsid_lastSynced_it = fsidnodes.insert(std::make_pair(fsid_lastSynced, this));
+        fsidnodes.insert(fsid_lastSynced, this);
+        inSyncedFsidIndex = true;
     }
 
 //    assert(localname.empty() || name.empty() || (!parent && parent_dbid == UNDEF) || parent_dbid == 0 ||
@@ -2905,57 +3126,66 @@ void LocalNode::setScannedFsid(handle newfsid,
                                [[maybe_unused]] const LocalPath& fsName,
                                const FileFingerprint& scanfp)
 {
-    if (fsid_asScanned_it != fsidnodes.end())
+    if (inScannedFsidIndex)
     {
-        fsidnodes.erase(fsid_asScanned_it);
+        [[maybe_unused]] auto erased = fsidnodes.erase(fsid_asScanned, this);
+        assert(erased);
+        inScannedFsidIndex = false;
     }
 
     fsid_asScanned = newfsid;
     fsidScannedReused = false;
 
-    scannedFingerprint = scanfp;
+    setScannedFingerprint(scanfp);
 
-    if (fsid_asScanned == UNDEF)
+    if (fsid_asScanned != UNDEF)
     {
-        fsid_asScanned_it = fsidnodes.end();
+        fsidnodes.insert(fsid_asScanned, this);
+        inScannedFsidIndex = true;
     }
-    else
+
+    assert(fsid_asScanned == UNDEF || 0 == compareUtf(localname, true, fsName, true, true));
+}
+
+void LocalNode::setSyncedFingerprint(const FileFingerprint& fingerprint)
+{
+    mScannedFingerprints.syncedChanging(mSyncedFingerprint, fingerprint);
+
+    // may be our own scanned fingerprint
+    if (&fingerprint != &mSyncedFingerprint)
     {
-        fsid_asScanned_it = fsidnodes.insert(std::make_pair(fsid_asScanned, this));
+        mSyncedFingerprint = fingerprint;
     }
 
-    assert(fsid_asScanned == UNDEF || 0 == compareUtf(localname, true, fsName, true, true));
+    mScannedFingerprints.syncedChanged(mSyncedFingerprint);
 }
 
 void LocalNode::setSyncedNodeHandle(NodeHandle h)
 {
-    if (syncedCloudNodeHandle_it != sync->syncs.localnodeByNodeHandle.end())
+    if (inNodeHandleIndex)
     {
         if (h == syncedCloudNodeHandle)
         {
             return;
         }
 
-        assert(syncedCloudNodeHandle_it->first == syncedCloudNodeHandle);
-
         // too verbose for million-node syncs
         //LOG_verbose << sync->syncname << "removing synced handle " << syncedCloudNodeHandle << " for " << localnodedisplaypath(*sync->syncs.fsaccess);
 
-        sync->syncs.localnodeByNodeHandle.erase(syncedCloudNodeHandle_it);
+        [[maybe_unused]] auto erased = sync->syncs.localnodeByNodeHandle.erase(syncedCloudNodeHandle, this);
+        assert(erased);
+        inNodeHandleIndex = false;
     }
 
     syncedCloudNodeHandle = h;
 
-    if (syncedCloudNodeHandle == UNDEF)
-    {
-        syncedCloudNodeHandle_it = sync->syncs.localnodeByNodeHandle.end();
-    }
-    else
+    if (syncedCloudNodeHandle != UNDEF)
     {
         // too verbose for million-node syncs
         //LOG_verbose << sync->syncname << "adding synced handle " << syncedCloudNodeHandle << " for " << localnodedisplaypath(*sync->syncs.fsaccess);
 
-        syncedCloudNodeHandle_it = sync->syncs.localnodeByNodeHandle.insert(std::make_pair(syncedCloudNodeHandle, this));
+        sync->syncs.localnodeByNodeHandle.insert(syncedCloudNodeHandle, this);
+        inNodeHandleIndex = true;
     }
 
 //    assert(localname.empty() || name.empty() || (!parent && parent_dbid == UNDEF) || parent_dbid == 0 ||
@@ -2964,7 +3194,8 @@ void LocalNode::setSyncedNodeHandle(NodeHandle h)
 
 LocalNode::~LocalNode()
 {
-    if (!sync->mDestructorRunning && dbid)
+    // (also when not in the db yet, as it may have a write pending)
+    if (!sync->mDestructorRunning)
     {
         sync->statecachedel(this);
     }
@@ -2990,17 +3221,17 @@ LocalNode::~LocalNode()
         sync->syncs.mMoveInvolvedLocalNodes.erase(this);
 
         // remove from fsidnode map, if present
-        if (fsid_lastSynced_it != sync->syncs.localnodeBySyncedFsid.end())
+        if (inSyncedFsidIndex)
         {
-            sync->syncs.localnodeBySyncedFsid.erase(fsid_lastSynced_it);
+            sync->syncs.localnodeBySyncedFsid.erase(fsid_lastSynced, this);
         }
-        if (fsid_asScanned_it != sync->syncs.localnodeByScannedFsid.end())
+        if (inScannedFsidIndex)
         {
-            sync->syncs.localnodeByScannedFsid.erase(fsid_asScanned_it);
+            sync->syncs.localnodeByScannedFsid.erase(fsid_asScanned, this);
         }
-        if (syncedCloudNodeHandle_it != sync->syncs.localnodeByNodeHandle.end())
+        if (inNodeHandleIndex)
         {
-            sync->syncs.localnodeByNodeHandle.erase(syncedCloudNodeHandle_it);
+            sync->syncs.localnodeByNodeHandle.erase(syncedCloudNodeHandle, this);
         }
     }
 
@@ -3014,16 +3245,17 @@ LocalNode::~LocalNode()
     }
 
     deleteChildren();
+
+    sync->mLocalNodeNames.release(toName_of_localname);
 }
 
 void LocalNode::deleteChildren()
 {
-    for (localnode_map::iterator it = children.begin(); it != children.end(); )
+    while (!children.empty())
     {
-        // the destructor removes the child from our `children` map
-        delete it++->second;
+        // the destructor removes the child from our `children` index (from the end, that's cheap)
+        delete *std::prev(children.end());
     }
-    assert(children.empty());
 }
 
 
@@ -3057,11 +3289,11 @@ void LocalNode::setSubtreeNeedsRefingerprint()
     recomputeFingerprint = true;
     oneTimeUseSyncedFingerprintInScan = false;
 
-    for (auto& child : children)
+    for (auto* child : children)
     {
         if (type != FILENODE)  // no need to set it for file versions
         {
-            child.second->setSubtreeNeedsRefingerprint();
+            child->setSubtreeNeedsRefingerprint();
         }
     }
 }
@@ -3144,24 +3376,39 @@ string LocalNode::debugGetParentList()
 // locate child by localname or slocalname
 LocalNode* LocalNode::childbyname(LocalPath* localChildName)
 {
-    localnode_map::iterator it;
+    if (!localChildName)
+    {
+        return nullptr;
+    }
 
-    if (!localChildName || ((it = children.find(*localChildName)) == children.end() &&
-                            (it = schildren.find(*localChildName)) == schildren.end()))
+    auto it = findChild(*localChildName);
+    if (it != children.end())
+    {
+        return *it;
+    }
+
+    if (!schildren)
     {
         return nullptr;
     }
+    auto sit = schildren->find(*localChildName);
+    return sit != schildren->end() ? sit->second : nullptr;
+}
 
-    return it->second;
+SortedChildIndex<LocalNode>::iterator LocalNode::findChild(const LocalPath& localChildName)
+{
+    return children.find(localChildName,
+                         localChildName.toName(*sync->syncs.fsaccess),
+                         sync->mCaseInsensitive);
 }
 
 LocalNode* LocalNode::findChildWithSyncedNodeHandle(NodeHandle h)
 {
-    for (auto& c : children)
+    for (auto* c : children)
     {
-        if (c.second->syncedCloudNodeHandle == h)
+        if (c->syncedCloudNodeHandle == h)
         {
-            return c.second;
+            return c;
         }
     }
     return nullptr;
@@ -3177,8 +3424,8 @@ FSNode LocalNode::getLastSyncedFSDetails() const
     n.type = type;
     n.fsid = fsid_lastSynced;
     n.isSymlink = false;  // todo: store localndoes for symlinks but don't use them?
-    n.fingerprint = syncedFingerprint;
-    assert(syncedFingerprint.isvalid || type != FILENODE);
+    n.fingerprint = mSyncedFingerprint;
+    assert(mSyncedFingerprint.isvalid || type != FILENODE);
     return n;
 }
 
@@ -3191,8 +3438,8 @@ FSNode LocalNode::getScannedFSDetails() const
     n.type = type;
     n.fsid = fsid_asScanned;
     n.isSymlink = false;  // todo: store localndoes for symlinks but don't use them?
-    n.fingerprint = scannedFingerprint;
-    assert(scannedFingerprint.isvalid || type != FILENODE);
+    n.fingerprint = scannedFingerprint();
+    assert(scannedFingerprint().isvalid || type != FILENODE);
     return n;
 }
 
@@ -3201,9 +3448,9 @@ bool LocalNode::hasPendingTransfers() const
     return transferSP != nullptr ||
            std::any_of(std::begin(children),
                        std::end(children),
-                       [](const auto& p)
+                       [](const LocalNode* child)
                        {
-                           return p.second && p.second->hasPendingTransfers();
+                           return child && child->hasPendingTransfers();
                        });
 }
 
@@ -3367,10 +3614,12 @@ bool LocalNode::transferResetUnlessMatched(const direction_t dir,
 // - corresponding Node handle
 // - local name
 // - fingerprint crc/mtime (filenodes only)
-bool LocalNodeCore::write(string& destination, uint32_t parentID) const
+bool LocalNodeCore::write(string& destination,
+                          uint32_t parentID,
+                          const FileFingerprint* realScannedFingerprint) const
 {
     // We need size even if we're not synced.
-    auto size = syncedFingerprint.isvalid ? syncedFingerprint.size : 0;
+    auto size = mSyncedFingerprint.isvalid ? mSyncedFingerprint.size : 0;
 
     CacheableWriter w(destination);
     w.serializei64(type ? -type : size);
@@ -3380,10 +3629,10 @@ bool LocalNodeCore::write(string& destination, uint32_t parentID) const
     w.serializestring(localname.platformEncoded());
     if (type == FILENODE)
     {
-        if (syncedFingerprint.isvalid)
+        if (mSyncedFingerprint.isvalid)
         {
-            w.serializebinary((byte*)syncedFingerprint.crc.data(), sizeof(syncedFingerprint.crc));
-            w.serializecompressedi64(syncedFingerprint.mtime);
+            w.serializebinary((byte*)mSyncedFingerprint.crc.data(), sizeof(mSyncedFingerprint.crc));
+            w.serializecompressedi64(mSyncedFingerprint.mtime);
         }
         else
         {
@@ -3409,7 +3658,7 @@ bool LocalNodeCore::write(string& destination, uint32_t parentID) const
     if (type == FILENODE)
     {
         // Difference between realScannedFingerprint and scannedFingerprint is only mtime
-        w.serializecompressedi64(realScannedFingerprint.mtime);
+        w.serializecompressedi64(realScannedFingerprint ? realScannedFingerprint->mtime : 0);
     }
 
     return true;
@@ -3454,7 +3703,7 @@ bool LocalNode::serialize(string* d) const
 #endif
 
     auto parentID = parent ? parent->dbid : 0;
-    auto result = LocalNodeCore::write(*d, parentID);
+    auto result = LocalNodeCore::write(*d, parentID, &realScannedFingerprint());
 
 #ifdef DEBUG
     // Quick (de)serizliation check.
@@ -3475,7 +3724,9 @@ bool LocalNode::serialize(string* d) const
     return result;
 }
 
-bool LocalNodeCore::read(const string& source, uint32_t& parentID)
+bool LocalNodeCore::read(const string& source,
+                         uint32_t& parentID,
+                         FileFingerprint* realScannedFingerprint)
 {
     if (source.size() < sizeof(m_off_t)         // type/size combo
                       + sizeof(handle)          // fsid
@@ -3533,28 +3784,28 @@ bool LocalNodeCore::read(const string& source, uint32_t& parentID)
     assert(!r.hasdataleft());
 
     type = nodeType;
-    this->syncedFingerprint.size = size;
+    this->mSyncedFingerprint.size = size;
     this->fsid_lastSynced = fsid;
     localname = LocalPath::fromPlatformEncodedRelative(name);
     this->slocalname.reset(shortname.empty() ? nullptr : new LocalPath(LocalPath::fromPlatformEncodedRelative(shortname)));
     this->slocalname_in_db = 0 != expansionflags[0];
     this->namesSynchronized = ns;
 
-    memcpy(this->syncedFingerprint.crc.data(), crc, sizeof crc);
+    memcpy(this->mSyncedFingerprint.crc.data(), crc, sizeof crc);
 
-    this->syncedFingerprint.mtime = mtime;
-    this->syncedFingerprint.isvalid = mtime != 0;
+    this->mSyncedFingerprint.mtime = mtime;
+    this->mSyncedFingerprint.isvalid = mtime != 0;
 
     // previously we scanned and created the LocalNode, but we had not set syncedFingerprint
     this->syncedCloudNodeHandle.set6byte(h);
 
     bool hasRealScannedFingerprint = expansionflags[2];
-    if (hasRealScannedFingerprint)
+    if (hasRealScannedFingerprint && realScannedFingerprint)
     {
-        memcpy(this->realScannedFingerprint.crc.data(), crc, sizeof crc);
-        this->realScannedFingerprint.mtime = extraMtime;
-        this->realScannedFingerprint.isvalid = extraMtime != 0;
-        this->realScannedFingerprint.size = size;
+        memcpy(realScannedFingerprint->crc.data(), crc, sizeof crc);
+        realScannedFingerprint->mtime = extraMtime;
+        realScannedFingerprint->isvalid = extraMtime != 0;
+        realScannedFingerprint->size = size;
     }
 
     return true;
@@ -3564,9 +3815,12 @@ unique_ptr<LocalNode> LocalNode::unserialize(Sync& sync, const string& source, u
 {
     auto node = std::make_unique<LocalNode>(&sync);
 
-    if (!node->read(source, parentID))
+    FileFingerprint realScannedFingerprint;
+    if (!node->read(source, parentID, &realScannedFingerprint))
         return nullptr;
 
+    node->setRealScannedFingerprint(realScannedFingerprint);
+
     return node;
 }
 
@@ -3743,7 +3997,7 @@ ExclusionState LocalNode::calcExcluded(RemotePathPair namePath,
         }
 
         // Update path so that it's applicable to the next node's path filters.
-        namePath.second.prependWithSeparator(node->toName_of_localname);
+        namePath.second.prependWithSeparator(RemotePath(string(node->toName_of_localname.view())));
     }
 
     // If no rule matches, file's included.
@@ -3810,9 +4064,9 @@ void LocalNode::setRecomputeExclusionState(bool includingThisOne, bool scan)
     {
         auto& node = *pending.front();
 
-        for (auto& childIt : node.children)
+        for (auto* childPtr : node.children)
         {
-            auto& child = *childIt.second;
+            auto& child = *childPtr;
 
             if (child.mExclusionState == ES_UNKNOWN)
                 continue;
@@ -4020,7 +4274,7 @@ std::string NodeCounter::serialize() const
     return nodeCountersBlob;
 }
 
-NodeCounter::NodeCounter(const std::string &blob)
+NodeCounter::NodeCounter(std::string_view blob)
 {
     CacheableReader r(blob);
     if (blob.size() == 28) // 4 + 4 + 8 + 4 + 8
@@ -4087,8 +4341,7 @@ bool CloudNode::isIgnoreFile() const
 }
 
 NodeManagerNode::NodeManagerNode(NodeManager& nodeManager, NodeHandle nodeHandle)
-    : mLRUPosition(nodeManager.invalidCacheLRUPos())
-    , mNodeHandle(nodeHandle)
+    : mNodeHandle(nodeHandle)
     , mNodeManager(nodeManager)
 {
 }
@@ -4115,4 +4368,9 @@ NodeHandle NodeManagerNode::getNodeHandle() const
     return mNodeHandle;
 }
 
+bool NodeManagerNode::isInCacheLRU() const
+{
+    return mLRUNode != nullptr;
+}
+
 } // namespace
@@ -165,6 +165,7 @@ void NodeManager::setTable_internal(DBTableNodes *table)
 {
     assert(mMutex.owns_lock());
     mTable = table;
+    mNodeTreeSnapshot.reset();
 }
 
 void NodeManager::reset()
@@ -231,6 +232,7 @@ void NodeManager::notifyNode(std::shared_ptr<Node> n, sharedNode_vector* nodesTo
 void NodeManager::notifyNode_internal(std::shared_ptr<Node> n, sharedNode_vector* nodesToReport)
 {
     assert(mMutex.owns_lock());
+    dropNodeTreeSnapshot_internal();
     n->applykey();
 
     if (!mClient.fetchingnodes)
@@ -319,6 +321,8 @@ bool NodeManager::addNode_internal(std::shared_ptr<Node> node, bool notify, bool
     // 'notify' is false when loading nodes from API or DB. True when node is received from
     // actionpackets and/or from response of CommandPutnodes
 
+    dropNodeTreeSnapshot_internal();
+
     bool rootNode = isFromRootNodeType(*node.get());
 
     // getRootNodeFiles() is always set for folder links before adding any node (upon login)
@@ -343,10 +347,13 @@ bool NodeManager::addNode_internal(std::shared_ptr<Node> node, bool notify, bool
         mNodeToWriteInDb = node;
 
         // when keepNodeInMemory is true, NodeManager::addChild is called by Node::setParent (from NodeManager::saveNodeInRAM)
-        auto pair = mNodes.emplace(node->nodeHandle(), NodeManagerNode(*this, node->nodeHandle()));
-        // The NodeManagerNode could have been added by NodeManager::addChild() but, in that case, mNode would be invalid
-        auto& nodePosition = pair.first;
-        nodePosition->second.mAllChildrenHandleLoaded = true; // Receive a new node, children aren't received yet or they are stored in nodesWithMissingParents
+        {
+            std::unique_lock lookupLock(mNodesLookupMutex);
+            auto pair = mNodes.emplace(node->nodeHandle(), NodeManagerNode(*this, node->nodeHandle()));
+            // The NodeManagerNode could have been added by NodeManager::addChild() but, in that case, mNode would be invalid
+            auto& nodePosition = pair.first;
+            nodePosition->second.mAllChildrenHandleLoaded = true; // Receive a new node, children aren't received yet or they are stored in nodesWithMissingParents
+        }
         addChild_internal(node->parentHandle(), node->nodeHandle(), nullptr);
     }
 
@@ -394,6 +401,23 @@ void NodeManager::reportNullRootNodes(const size_t rootNodesSize)
 
 std::shared_ptr<Node> NodeManager::getNodeByHandle(NodeHandle handle)
 {
+    if (handle.isUndef()) return nullptr;
+
+    // Nodes already loaded in RAM are resolved without mMutex, so app threads don't
+    // wait for the SDK thread to finish processing action packets
+    if (std::shared_ptr<Node> node = getLoadedNode(handle))
+    {
+        // Refreshing the position at LRU is best effort: skipped if mMutex is busy
+        std::unique_lock<MutexType> g(mMutex, std::try_to_lock);
+        if (g.owns_lock() && node->mNodePosition != mNodes.end())
+        {
+            insertNodeCacheLRU_internal(node);
+        }
+
+        ++mCacheLRUHits;
+        return node;
+    }
+
     LockGuard g(mMutex);
     return getNodeByHandle_internal(handle);
 }
@@ -409,8 +433,13 @@ std::shared_ptr<Node> NodeManager::getNodeByHandle_internal(NodeHandle handle)
     }
 
     std::shared_ptr<Node> node = getNodeInRAM(handle);
-    if (!node)
+    if (node)
     {
+        ++mCacheLRUHits;
+    }
+    else
+    {
+        ++mCacheLRUMisses;
         node = getNodeFromDataBase(handle);
     }
 
@@ -488,6 +517,7 @@ sharedNode_list NodeManager::getChildren_internal(const Node* parent, CancelToke
         std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
         NodeSearchFilter nf;
         nf.byAncestors({parent->nodehandle, UNDEF, UNDEF});
+        putFetchedNodesInDb_internal();
         mTable->getChildren(nf,
                             0 /*Order none*/,
                             nodesFromTable,
@@ -574,6 +604,7 @@ sharedNode_vector NodeManager::listChildNodesLexicographically_internal(
 
     // db look-up
     std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
+    putFetchedNodesInDb_internal();
     if (!mTable->listChildNodesLexicographically(parentHandle,
                                                  nodesFromTable,
                                                  cancelFlag,
@@ -588,13 +619,84 @@ sharedNode_vector NodeManager::listChildNodesLexicographically_internal(
     return nodes;
 }
 
-sharedNode_vector NodeManager::getChildren(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page)
+NodeManager::DbPrefetch::DbPrefetch() = default;
+NodeManager::DbPrefetch::DbPrefetch(DbPrefetch&&) = default;
+NodeManager::DbPrefetch& NodeManager::DbPrefetch::operator=(DbPrefetch&&) = default;
+NodeManager::DbPrefetch::~DbPrefetch() = default;
+
+NodeManager::DbPrefetch NodeManager::prefetch(const DbLookUp& lookUp)
+{
+    DbPrefetch prefetch;
+    {
+        LockGuard g(mMutex);
+        if (!mTable || mNodes.empty())
+        {
+            return prefetch;
+        }
+
+        prefetch.mReader = mTable->acquireReader();
+    }
+
+    // The reader is only used by this thread. Nothing else is accessed, so no lock is needed
+    if (prefetch.mReader)
+    {
+        prefetch.mFound = lookUp(prefetch.mReader->table(), prefetch.mRows);
+    }
+
+    return prefetch;
+}
+
+bool NodeManager::lookUpInDb(DbPrefetch* prefetch, NodeRows& rows, const DbLookUp& lookUp)
+{
+    assert(mMutex.owns_lock() && mTable);
+
+    // it invalidates the prefetch, if any, when there are fetched nodes pending to be written
+    putFetchedNodesInDb_internal();
+
+    if (prefetch && prefetch->mReader)
+    {
+        // the nodes read from the DB are merged with the ones in RAM, so they must be in sync
+        const bool valid = prefetch->mReader->isStillValid();
+        prefetch->mReader.reset(); // give the connection back
+        if (valid)
+        {
+            rows = std::move(prefetch->mRows);
+            return prefetch->mFound;
+        }
+
+        LOG_verbose << "DB look-up outdated by the changes made meanwhile. Repeating it";
+    }
+
+    return lookUp(*mTable, rows);
+}
+
+NodeManager::DbPrefetch NodeManager::prefetchChildren(const NodeSearchFilter& filter,
+                                                      int order,
+                                                      CancelToken cancelFlag,
+                                                      const NodeSearchPage& page)
+{
+    return prefetch(
+        [&](DBTableNodes& table, NodeRows& rows)
+        {
+            return table.getChildren(filter, order, rows, cancelFlag, page);
+        });
+}
+
+sharedNode_vector NodeManager::getChildren(const NodeSearchFilter& filter,
+                                           int order,
+                                           CancelToken cancelFlag,
+                                           const NodeSearchPage& page,
+                                           DbPrefetch* prefetch)
 {
     LockGuard g(mMutex);
-    return getChildren_internal(filter, order, cancelFlag, page);
+    return getChildren_internal(filter, order, cancelFlag, page, prefetch);
 }
 
-sharedNode_vector NodeManager::getChildren_internal(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page)
+sharedNode_vector NodeManager::getChildren_internal(const NodeSearchFilter& filter,
+                                                    int order,
+                                                    CancelToken cancelFlag,
+                                                    const NodeSearchPage& page,
+                                                    DbPrefetch* prefetch)
 {
     assert(mMutex.owns_lock());
 
@@ -616,8 +718,13 @@ sharedNode_vector NodeManager::getChildren_internal(const NodeSearchFilter& filt
     }
 
     // db look-up
-    vector<pair<NodeHandle, NodeSerialized>> nodesFromTable;
-    if (!mTable->getChildren(filter, order, nodesFromTable, cancelFlag, page))
+    NodeRows nodesFromTable;
+    if (!lookUpInDb(prefetch,
+                    nodesFromTable,
+                    [&](DBTableNodes& table, NodeRows& rows)
+                    {
+                        return table.getChildren(filter, order, rows, cancelFlag, page);
+                    }))
     {
         return sharedNode_vector();
     }
@@ -686,6 +793,7 @@ sharedNode_vector NodeManager::getRecentNodes_internal(const NodeSearchPage& pag
     }
 
     std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
+    putFetchedNodesInDb_internal();
     mTable->getRecentNodes(page, since, nodesFromTable);
 
     return processUnserializedNodes(nodesFromTable);
@@ -701,6 +809,8 @@ uint64_t NodeManager::getNodeCount_internal()
 {
     assert(mMutex.owns_lock());
 
+    flushTreeCounters_internal();
+
     if (mNodes.empty())
     {
         return 0;
@@ -748,6 +858,7 @@ uint64_t NodeManager::getNodeCount_internal()
 #ifndef NDEBUG
     if (mNodes.size())
     {
+        putFetchedNodesInDb_internal();
         uint64_t countDb = mTable ? mTable->getNumberOfNodes() : 0;
         if (!(mTable || count == countDb))
         {
@@ -784,6 +895,8 @@ auto NodeManager::getNodeTagsBelow(CancelToken cancelToken,
 
     std::optional<std::set<std::string>> accumulatedTags;
 
+    putFetchedNodesInDb_internal();
+
     // Try and retrieve the tags below the specified nodes.
     for (const auto& handle: handles)
     {
@@ -805,16 +918,33 @@ auto NodeManager::getNodeTagsBelow(CancelToken cancelToken,
     return accumulatedTags;
 }
 
-sharedNode_vector NodeManager::searchNodes(const NodeSearchFilter& filter, int order, CancelToken cancelFlag, const NodeSearchPage& page)
+NodeManager::DbPrefetch NodeManager::prefetchSearch(const NodeSearchFilter& filter,
+                                                    int order,
+                                                    CancelToken cancelFlag,
+                                                    const NodeSearchPage& page)
+{
+    return prefetch(
+        [&](DBTableNodes& table, NodeRows& rows)
+        {
+            return table.searchNodes(filter, order, rows, cancelFlag, page);
+        });
+}
+
+sharedNode_vector NodeManager::searchNodes(const NodeSearchFilter& filter,
+                                           int order,
+                                           CancelToken cancelFlag,
+                                           const NodeSearchPage& page,
+                                           DbPrefetch* prefetch)
 {
     LockGuard g(mMutex);
-    return searchNodes_internal(filter, order, cancelFlag, page);
+    return searchNodes_internal(filter, order, cancelFlag, page, prefetch);
 }
 
 sharedNode_vector NodeManager::searchNodes_internal(const NodeSearchFilter& filter,
                                                     int order,
                                                     CancelToken cancelFlag,
-                                                    const NodeSearchPage& page)
+                                                    const NodeSearchPage& page,
+                                                    DbPrefetch* prefetch)
 {
     assert(mMutex.owns_lock());
 
@@ -841,8 +971,13 @@ sharedNode_vector NodeManager::searchNodes_internal(const NodeSearchFilter& filt
     }
 
     // db look-up
-    vector<pair<NodeHandle, NodeSerialized>> nodesFromTable;
-    if (!mTable->searchNodes(filter, order, nodesFromTable, cancelFlag, page))
+    NodeRows nodesFromTable;
+    if (!lookUpInDb(prefetch,
+                    nodesFromTable,
+                    [&](DBTableNodes& table, NodeRows& rows)
+                    {
+                        return table.searchNodes(filter, order, rows, cancelFlag, page);
+                    }))
     {
         return sharedNode_vector();
     }
@@ -852,10 +987,53 @@ sharedNode_vector NodeManager::searchNodes_internal(const NodeSearchFilter& filt
     return nodes;
 }
 
+NodeManager::DbPrefetch NodeManager::prefetchListAllNodesByPage(const ListAllNodesParams& params,
+                                                                CancelToken cancelFlag)
+{
+    // The roots are resolved along with borrowing the reader: if they change later, so do the
+    // nodes, and the prefetched rows aren't used
+    DbPrefetch prefetch;
+    std::vector<NodeHandle> filesRoots;
+    {
+        LockGuard g(mMutex);
+        if (!mTable || mNodes.empty())
+        {
+            return prefetch;
+        }
+
+        filesRoots = resolveListAllRoots(params);
+        if (filesRoots.empty())
+        {
+            return prefetch;
+        }
+
+        prefetch.mReader = mTable->acquireReader();
+    }
+
+    if (prefetch.mReader)
+    {
+        prefetch.mFound = prefetch.mReader->table().listAllNodesByPage(params,
+                                                                       filesRoots,
+                                                                       prefetch.mRows,
+                                                                       cancelFlag);
+    }
+
+    return prefetch;
+}
+
 sharedNode_vector NodeManager::listAllNodesByPage(const ListAllNodesParams& params,
-                                                  CancelToken cancelFlag)
+                                                  CancelToken cancelFlag,
+                                                  DbPrefetch* prefetch)
 {
     LockGuard g(mMutex);
+    return listAllNodesByPage_internal(params, cancelFlag, prefetch);
+}
+
+sharedNode_vector NodeManager::listAllNodesByPage_internal(const ListAllNodesParams& params,
+                                                           CancelToken cancelFlag,
+                                                           DbPrefetch* prefetch)
+{
+    assert(mMutex.owns_lock());
 
     if (!mTable || mNodes.empty())
     {
@@ -874,8 +1052,13 @@ sharedNode_vector NodeManager::listAllNodesByPage(const ListAllNodesParams& para
         return sharedNode_vector();
     }
 
-    vector<pair<NodeHandle, NodeSerialized>> nodesFromTable;
-    if (!mTable->listAllNodesByPage(params, filesRoots, nodesFromTable, cancelFlag))
+    NodeRows nodesFromTable;
+    if (!lookUpInDb(prefetch,
+                    nodesFromTable,
+                    [&](DBTableNodes& table, NodeRows& rows)
+                    {
+                        return table.listAllNodesByPage(params, filesRoots, rows, cancelFlag);
+                    }))
     {
         return sharedNode_vector();
     }
@@ -978,6 +1161,7 @@ sharedNode_vector NodeManager::getNodesByFingerprint_internal(const FileFingerpr
     // Look for nodes at DB
     std::string fingerprintNoMtimeStr;
     fingerprint.FileFingerprint::serializeExcludingMtime(&fingerprintNoMtimeStr);
+    putFetchedNodesInDb_internal();
     mTable->getNodesByFingerprintNoMtime(fingerprintNoMtimeStr, nodesFromTable);
 
     /*
@@ -1039,6 +1223,7 @@ sharedNode_vector NodeManager::getNodesByOrigFingerprint_internal(const std::str
     }
 
     std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
+    putFetchedNodesInDb_internal();
     mTable->getNodesByOrigFingerprint(fingerprint, nodesFromTable);
 
     nodes = processUnserializedNodes(nodesFromTable, parent ? parent->nodeHandle() : NodeHandle(), CancelToken());
@@ -1073,6 +1258,7 @@ std::shared_ptr<Node> NodeManager::getNodeByFingerprint_internal(FileFingerprint
     std::string fingerprintString;
     fingerprint.FileFingerprint::serialize(&fingerprintString);
     NodeHandle handle;
+    putFetchedNodesInDb_internal();
     mTable->getNodeByFingerprint(fingerprintString, nodeSerialized, handle);
     auto itNode = mNodes.find(handle);
     std::shared_ptr<Node> node = itNode != mNodes.end() ? itNode->second.getNodeInRam() : nullptr;
@@ -1123,9 +1309,11 @@ std::shared_ptr<Node> NodeManager::childNodeByNameType_internal(const Node* pare
 
     // Traverse more than mChildScanDbThreshold children would
     // cost more time than query DB. So skip the RAM scan in this case
+    // (unless the index by parent is still pending to be created)
     const bool skipRamScan =
         parent->mNodePosition->second.mChildren ?
-            parent->mNodePosition->second.mChildren->size() > mChildScanDbThreshold :
+            parent->mNodePosition->second.mChildren->size() > mChildScanDbThreshold &&
+                mTable->isIndexReady(NodesIndex::PARENT) :
             false;
 
     if (!skipRamScan && parent->mNodePosition->second.mChildren)
@@ -1159,7 +1347,16 @@ std::shared_ptr<Node> NodeManager::childNodeByNameType_internal(const Node* pare
         return nullptr; // There is no match
     }
 
+    if (mNodeTreeSnapshot)
+    {
+        if (auto child = mNodeTreeSnapshot->childByNameType(parent->nodeHandle(), name, nodeType))
+        {
+            return child->isUndef() ? nullptr : getNodeByHandle_internal(*child);
+        }
+    }
+
     std::pair<NodeHandle, NodeSerialized> nodeSerialized;
+    putFetchedNodesInDb_internal();
     if (!mTable->childNodeByNameType(parent->nodeHandle(), name, nodeType, nodeSerialized))
     {
         return nullptr;  // Not found at DB either
@@ -1260,6 +1457,7 @@ sharedNode_vector NodeManager::getRootNodes_internal()
     }
     else    // nodes not loaded yet
     {
+        putFetchedNodesInDb_internal();
         if (mClient.loggedIntoFolder())
         {
             NodeSerialized nodeSerialized;
@@ -1276,7 +1474,22 @@ sharedNode_vector NodeManager::getRootNodes_internal()
         else
         {
             std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
-            mTable->getRootNodes(nodesFromTable);
+            if (mNodeTreeSnapshot)
+            {
+                // by primary key, rather than by type
+                for (NodeHandle h: mNodeTreeSnapshot->rootNodes())
+                {
+                    nodesFromTable.emplace_back(h, NodeSerialized());
+                    if (!mTable->getNode(h, nodesFromTable.back().second))
+                    {
+                        nodesFromTable.pop_back();
+                    }
+                }
+            }
+            else
+            {
+                mTable->getRootNodes(nodesFromTable);
+            }
 
             for (const auto& nHandleSerialized : nodesFromTable)
             {
@@ -1308,7 +1521,21 @@ sharedNode_vector NodeManager::getNodesWithSharesOrLink_internal(ShareType_t sha
         return sharedNode_vector();
     }
 
+    if (mNodeTreeSnapshot)
+    {
+        sharedNode_vector nodes;
+        for (NodeHandle h: mNodeTreeSnapshot->nodesWithSharesOrLink(shareType))
+        {
+            if (shared_ptr<Node> n = getNodeByHandle_internal(h))
+            {
+                nodes.push_back(std::move(n));
+            }
+        }
+        return nodes;
+    }
+
     std::vector<std::pair<NodeHandle, NodeSerialized>> nodesFromTable;
+    putFetchedNodesInDb_internal();
     mTable->getNodesWithSharesOrLink(nodesFromTable, shareType);
 
     return processUnserializedNodes(nodesFromTable);
@@ -1318,7 +1545,7 @@ shared_ptr<Node> NodeManager::getNodeFromNodeSerialized(const NodeSerialized &no
 {
     assert(mMutex.owns_lock());
 
-    shared_ptr<Node> node = unserializeNode(&nodeSerialized.mNode, false);
+    shared_ptr<Node> node = unserializeNode(nodeSerialized.mNode, false);
     if (!node)
     {
         assert(false);
@@ -1358,6 +1585,28 @@ void NodeManager::updateTreeCounter(std::shared_ptr<Node> origin, NodeCounter nc
 {
     assert(mMutex.owns_lock());
 
+    if (!nodesToReport && origin)
+    {
+        // accumulate it, to be propagated by flushTreeCounters_internal()
+        auto& pending = mPendingTreeCounters[origin->nodeHandle()];
+        pending.node = origin;
+        if (operation == INCREASE)
+        {
+            pending.delta += nc;
+        }
+        else
+        {
+            pending.delta -= nc;
+        }
+
+        // ancestors already marked were marked along with theirs
+        for (auto n = origin.get(); n && mOutdatedTreeCounters.insert(n->nodeHandle()).second;
+             n = n->parent.get())
+        {}
+
+        return;
+    }
+
     while (origin)
     {
         NodeCounter ancestorCounter = origin->getCounter();
@@ -1377,6 +1626,77 @@ void NodeManager::updateTreeCounter(std::shared_ptr<Node> origin, NodeCounter nc
     }
 }
 
+void NodeManager::flushTreeCounters()
+{
+    LockGuard g(mMutex);
+    flushTreeCounters_internal();
+}
+
+NodeCounter NodeManager::getNodeCounter(const Node& n)
+{
+    LockGuard g(mMutex);
+
+    if (mOutdatedTreeCounters.count(n.nodeHandle()))
+    {
+        flushTreeCounters_internal();
+    }
+
+    return n.getCounter();
+}
+
+void NodeManager::flushTreeCounters_internal()
+{
+    assert(mMutex.owns_lock());
+
+    if (mPendingTreeCounters.empty())
+    {
+        return;
+    }
+
+    // deepest nodes first: the delta of each node is merged into its parent's before the parent
+    // is updated, so every ancestor is updated once
+    std::map<std::pair<size_t, NodeHandle>, PendingTreeCounter, std::greater<>> byDepth;
+    for (auto& [h, pending]: mPendingTreeCounters)
+    {
+        size_t depth = 0;
+        for (const Node* p = pending.node->parent.get(); p; p = p->parent.get())
+        {
+            ++depth;
+        }
+        byDepth.emplace(std::make_pair(depth, h), std::move(pending));
+    }
+    mPendingTreeCounters.clear();
+    mOutdatedTreeCounters.clear();
+
+    while (!byDepth.empty())
+    {
+        auto it = byDepth.begin();
+        const size_t depth = it->first.first;
+        PendingTreeCounter pending = std::move(it->second);
+        byDepth.erase(it);
+
+        const NodeCounter& delta = pending.delta;
+        if (!delta.storage && !delta.versionStorage && !delta.files && !delta.folders &&
+            !delta.versions)
+        {
+            // updates cancelled out (i.e. moves between siblings): nothing to propagate
+            continue;
+        }
+
+        NodeCounter counter = pending.node->getCounter();
+        counter += delta;
+        setNodeCounter(pending.node, counter, true, nullptr);
+
+        if (auto& parent = pending.node->parent)
+        {
+            assert(depth);
+            auto& pendingParent = byDepth[std::make_pair(depth - 1, parent->nodeHandle())];
+            pendingParent.node = parent;
+            pendingParent.delta += delta;
+        }
+    }
+}
+
 NodeCounter NodeManager::calculateNodeCounter(const NodeHandle& nodehandle, nodetype_t parentType, std::shared_ptr<Node> node, bool isInRubbish)
 {
     assert(mMutex.owns_lock());
@@ -1399,6 +1719,7 @@ NodeCounter NodeManager::calculateNodeCounter(const NodeHandle& nodehandle, node
     }
     else
     {
+        putFetchedNodesInDb_internal();
         if (!mTable->getNodeSizeTypeAndFlags(nodehandle, nodeSize, nodeType, flags))
         {
             assert(false);
@@ -1474,6 +1795,7 @@ std::vector<NodeHandle> NodeManager::getFavouritesNodeHandles_internal(NodeHandl
         return nodeHandles;
     }
 
+    putFetchedNodesInDb_internal();
     mTable->getFavouritesHandles(node, count, nodeHandles);
     return nodeHandles;
 }
@@ -1500,6 +1822,15 @@ size_t NodeManager::getNumberOfChildrenFromNode_internal(NodeHandle parentHandle
         return parentIt->second.mChildren ? parentIt->second.mChildren->size() : 0;
     }
 
+    if (mNodeTreeSnapshot)
+    {
+        if (auto numChildren = mNodeTreeSnapshot->numChildren(parentHandle))
+        {
+            return *numChildren;
+        }
+    }
+
+    putFetchedNodesInDb_internal();
     return static_cast<size_t>(mTable->getNumberOfChildren(parentHandle));
 }
 
@@ -1521,6 +1852,15 @@ size_t NodeManager::getNumberOfChildrenByType_internal(NodeHandle parentHandle,
 
     assert(nodeType == FILENODE || nodeType == FOLDERNODE);
 
+    if (mNodeTreeSnapshot)
+    {
+        if (auto numChildren = mNodeTreeSnapshot->numChildren(parentHandle, nodeType))
+        {
+            return *numChildren;
+        }
+    }
+
+    putFetchedNodesInDb_internal();
     return static_cast<size_t>(mTable->getNumberOfChildrenByType(parentHandle, nodeType));
 }
 
@@ -1540,6 +1880,15 @@ bool NodeManager::isAncestor_internal(NodeHandle nodehandle, NodeHandle ancestor
         return false;
     }
 
+    if (mNodeTreeSnapshot)
+    {
+        if (auto isAncestor = mNodeTreeSnapshot->isAncestor(nodehandle, ancestor))
+        {
+            return *isAncestor;
+        }
+    }
+
+    putFetchedNodesInDb_internal();
     return mTable->isAncestor(nodehandle, ancestor, cancelFlag);
 }
 
@@ -1555,9 +1904,9 @@ void NodeManager::removeChanges_internal()
 
     if (mNodesInRam <= mCacheLRU.size() + rootnodes.mRootNodes.size())
     {
-        for (auto& node: mCacheLRU)
+        for (NodeManagerNode* n = mCacheLRU.front(); n; n = n->mLRUNext)
         {
-            memset(&(node->changed), 0, sizeof node->changed);
+            memset(&(n->mLRUNode->changed), 0, sizeof n->mLRUNode->changed);
         }
 
         for (auto& [_, node]: rootnodes.mRootNodes)
@@ -1589,17 +1938,30 @@ void NodeManager::cleanNodes_internal()
     assert(mMutex.owns_lock());
 
     mFingerPrintsNoMtime.clear();
-    mNodes.clear();
-    mCacheLRU.clear();
+    mCacheLRU.clear(); // before mNodes, which holds the hooks of the LRU
+    {
+        std::unique_lock lookupLock(mNodesLookupMutex);
+        mNodes.clear();
+    }
     mNodeToWriteInDb.reset();
+    mFetchedNodesToPut.clear();
     mNodeNotify.clear();
     mNodePendingApplyKeys.clear();
+    mPendingTreeCounters.clear();
+    mOutdatedTreeCounters.clear();
+    mNodeTreeSnapshot.reset();
 
     rootnodes.clear();
 
-    if (mTable) mTable->removeNodes();
+    if (mTable)
+    {
+        mTable->removeNodes();
+        // the next fetchnodes is a bulk load: indexes are created again after it
+        mTable->dropIndexesForBulkLoad();
+    }
 
     mInitialized = false;
+    mPendingIndexes = false;
 
     mAppliedKeyNodeCount = 0;
     mNodesInRam = 0;
@@ -1614,12 +1976,12 @@ std::shared_ptr<Node> NodeManager::getNodeFromBlob(const std::string* nodeSerial
 std::shared_ptr<Node> NodeManager::getNodeFromBlob_internal(const std::string* nodeSerialized)
 {
     assert(mMutex.owns_lock());
-    return unserializeNode(nodeSerialized, true);
+    return unserializeNode(*nodeSerialized, true);
 }
 
 // parse serialized node and return Node object - updates nodes hash and parent
 // mismatch vector
-shared_ptr<Node> NodeManager::unserializeNode(const std::string *d, bool fromOldCache)
+shared_ptr<Node> NodeManager::unserializeNode(std::string_view d, bool fromOldCache)
 {
     assert(mMutex.owns_lock());
 
@@ -1628,12 +1990,15 @@ shared_ptr<Node> NodeManager::unserializeNode(const std::string *d, bool fromOld
     if (shared_ptr<Node> n = Node::unserialize(mClient, d, fromOldCache, ownNewshares))
     {
 
-        auto pair = mNodes.emplace(n->nodeHandle(), NodeManagerNode(*this, n->nodeHandle()));
-        // The NodeManagerNode could have been added in the initial fetch nodes (without session)
-        // Now, the node is loaded from DB, NodeManagerNode is updated with correct values
-        auto& nodePosition = pair.first;
-        nodePosition->second.setNode(n);
-        n->mNodePosition = nodePosition;
+        {
+            std::unique_lock lookupLock(mNodesLookupMutex);
+            auto pair = mNodes.emplace(n->nodeHandle(), NodeManagerNode(*this, n->nodeHandle()));
+            // The NodeManagerNode could have been added in the initial fetch nodes (without session)
+            // Now, the node is loaded from DB, NodeManagerNode is updated with correct values
+            auto& nodePosition = pair.first;
+            nodePosition->second.setNode(n);
+            n->mNodePosition = nodePosition;
+        }
 
         insertNodeCacheLRU_internal(n);
 
@@ -1767,6 +2132,12 @@ void NodeManager::notifyPurge()
         unsigned removed = 0;
         unsigned added = 0;
 
+        // nodes to be added/updated in DB, they are written in batches
+        sharedNode_vector nodesToPut;
+
+        // the buffered nodes are written before, not to recreate any node removed below
+        putFetchedNodesInDb_internal();
+
         // check all notified nodes for removed status and purge
         for (size_t i = 0; i < nodesToReport.size(); i++)
         {
@@ -1796,11 +2167,26 @@ void NodeManager::notifyPurge()
 
             if (n->changed.removed)
             {
+                // keep DB consistent before it's queried (children) and the node is removed
+                putNodesInDb(nodesToPut);
+
+                if (mOutdatedTreeCounters.count(n->nodeHandle()))
+                {
+                    // its counter is about to be subtracted from its ancestors
+                    flushTreeCounters_internal();
+                }
+
                 NodeHandle h = n->nodeHandle();
 
                 // This will also require notifying/updating parents back to the root.  Report and
-                // update them in this same operation, to ensure consistency in case of commit
-                updateTreeCounter(n->parent, n->getCounter(), DECREASE, &nodesToReport);
+                // update them in this same operation, to ensure consistency in case of commit.
+                // When the parent is being removed too, its own counter (which includes this
+                // node) is subtracted from the ancestors instead: a deleted subtree updates them
+                // once rather than once per node
+                if (!n->parent || !n->parent->changed.removed)
+                {
+                    updateTreeCounter(n->parent, n->getCounter(), DECREASE, &nodesToReport);
+                }
 
                 if (n->parent)
                 {
@@ -1817,8 +2203,11 @@ void NodeManager::notifyPurge()
 
                 removeFingerprint(n.get());
                 removeNodeCacheLRU_internal(n.get());
-                mNodes.erase(n->mNodePosition);
-                n->mNodePosition = mNodes.end();
+                {
+                    std::unique_lock lookupLock(mNodesLookupMutex);
+                    mNodes.erase(n->mNodePosition);
+                    n->mNodePosition = mNodes.end();
+                }
 
                 mTable->remove(h);
 
@@ -1826,12 +2215,14 @@ void NodeManager::notifyPurge()
             }
             else
             {
-                putNodeInDb(n.get());
+                nodesToPut.push_back(std::move(n));
 
                 added += 1;
             }
         }
 
+        putNodesInDb(nodesToPut);
+
         if (removed)
         {
             LOG_verbose << mClient.clientname << "Removed " << removed << " nodes from database";
@@ -1871,6 +2262,8 @@ bool NodeManager::loadNodes_internal()
         getChildren_internal(node.get());
     }
 
+    // indexes could be missing if the app was closed before creating all of them
+    scheduleIndexes();
     mInitialized = true;
     return true;
 }
@@ -1894,12 +2287,15 @@ void NodeManager::saveNodeInRAM(std::shared_ptr<Node> node, bool isRootnode, Mis
 {
     assert(mMutex.owns_lock());
 
-    auto pair = mNodes.emplace(node->nodeHandle(), NodeManagerNode(*this, node->nodeHandle()));
-    // The NodeManagerNode could have been added by NodeManager::addChild() but, in that case, mNode would be invalid
-    auto& nodePosition = pair.first;
-    nodePosition->second.setNode(node);
-    nodePosition->second.mAllChildrenHandleLoaded = true; // Receive a new node, children aren't received yet or they are stored a mNodesWithMissingParents
-    node->mNodePosition = nodePosition;
+    {
+        std::unique_lock lookupLock(mNodesLookupMutex);
+        auto pair = mNodes.emplace(node->nodeHandle(), NodeManagerNode(*this, node->nodeHandle()));
+        // The NodeManagerNode could have been added by NodeManager::addChild() but, in that case, mNode would be invalid
+        auto& nodePosition = pair.first;
+        nodePosition->second.setNode(node);
+        nodePosition->second.mAllChildrenHandleLoaded = true; // Receive a new node, children aren't received yet or they are stored a mNodesWithMissingParents
+        node->mNodePosition = nodePosition;
+    }
 
     insertNodeCacheLRU_internal(node);
 
@@ -1944,6 +2340,8 @@ int NodeManager::getNumVersions(NodeHandle nodeHandle)
 {
     LockGuard g(mMutex);
 
+    flushTreeCounters_internal();
+
     Node *node = getNodeByHandle_internal(nodeHandle).get();
     if (!node || node->type != FILENODE)
     {
@@ -2056,6 +2454,76 @@ void NodeManager::dropLexicographicDBIndexes()
     mTable->dropLexicographicDBIndexes();
 }
 
+void NodeManager::dropFullTextDBIndex()
+{
+    assert(mNodeNotify.empty());
+    if (!mTable || mNodesInRam > 0)
+    {
+        LOG_err << "DB isn't opened yet or nodes has been already loaded";
+        return;
+    }
+
+    mTable->dropFullTextDBIndex();
+}
+
+void NodeManager::dropAncestorDBIndex()
+{
+    assert(mNodeNotify.empty());
+    if (!mTable || mNodesInRam > 0)
+    {
+        LOG_err << "DB isn't opened yet or nodes has been already loaded";
+        return;
+    }
+
+    mTable->dropAncestorDBIndex();
+}
+
+void NodeManager::openNodeTreeSnapshot(const LocalPath& path, handle scsn)
+{
+    LockGuard g(mMutex);
+    assert(mNodes.empty());
+    mNodeTreeSnapshot = NodeTreeSnapshot::open(path, scsn);
+}
+
+bool NodeManager::writeNodeTreeSnapshot(FileSystemAccess& fsAccess,
+                                        const LocalPath& path,
+                                        handle scsn)
+{
+    LockGuard g(mMutex);
+
+    if (!mTable)
+    {
+        assert(false);
+        return false;
+    }
+
+    std::vector<NodeTreeEntry> entries;
+    putFetchedNodesInDb_internal();
+    if (!mTable->getNodeTreeEntries(entries))
+    {
+        return false;
+    }
+
+    return NodeTreeSnapshot::write(fsAccess, path, scsn, std::move(entries));
+}
+
+void NodeManager::dropNodeTreeSnapshot()
+{
+    LockGuard g(mMutex);
+    dropNodeTreeSnapshot_internal();
+}
+
+void NodeManager::dropNodeTreeSnapshot_internal()
+{
+    assert(mMutex.owns_lock());
+
+    if (mNodeTreeSnapshot)
+    {
+        LOG_debug << "Node tree snapshot released";
+        mNodeTreeSnapshot.reset();
+    }
+}
+
 std::shared_ptr<Node> NodeManager::getNodeFromNodeManagerNode(NodeManagerNode& nodeManagerNode)
 {
     LockGuard g(mMutex);
@@ -2113,6 +2581,16 @@ uint64_t NodeManager::getNumNodesAtCacheLRU() const
     return mCacheLRU.size();
 }
 
+NodeManager::CacheLRUStats NodeManager::getCacheLRUStats() const
+{
+    // no locking, counters are atomic
+    CacheLRUStats stats;
+    stats.hits = mCacheLRUHits;
+    stats.misses = mCacheLRUMisses;
+    stats.evictions = mCacheLRUEvictions;
+    return stats;
+}
+
 void NodeManager::initCompleted_internal()
 {
     assert(mMutex.owns_lock());
@@ -2123,6 +2601,9 @@ void NodeManager::initCompleted_internal()
         return;
     }
 
+    // end of fetchnodes: the rest of the nodes received
+    putFetchedNodesInDb_internal();
+
     sharedNode_vector rootNodes = getRootNodesAndInshares();
     for (auto& node: rootNodes)
     {
@@ -2136,7 +2617,7 @@ void NodeManager::initCompleted_internal()
         }
     }
 
-    mTable->createIndexes(mClient.mEnableSearchDBIndexes, mClient.mEnableLexicographicDBIndexes);
+    scheduleIndexes();
     mInitialized = true;
 }
 
@@ -2145,6 +2626,36 @@ bool NodeManager::ready()
     return mInitialized;
 }
 
+void NodeManager::scheduleIndexes()
+{
+    assert(mMutex.owns_lock());
+
+    mTable->scheduleIndexes(mClient.mEnableSearchDBIndexes,
+                            mClient.mEnableLexicographicDBIndexes,
+                            mClient.mEnableFullTextSearchDBIndex,
+                            mClient.mEnableAncestorDBIndex);
+    mPendingIndexes = true;
+}
+
+bool NodeManager::createNextPendingIndex()
+{
+    LockGuard g(mMutex);
+
+    if (!mTable || !mInitialized || !mPendingIndexes)
+    {
+        return false;
+    }
+
+    mPendingIndexes = mTable->createNextPendingIndex();
+    return mPendingIndexes;
+}
+
+bool NodeManager::hasPendingIndexes() const
+{
+    LockGuard g(mMutex);
+    return mInitialized && mPendingIndexes;
+}
+
 bool NodeManager::isFromRootNodeType(const Node& node) const
 {
     return node.type == ROOTNODE || node.type == RUBBISHNODE || node.type == VAULTNODE;
@@ -2156,11 +2667,24 @@ void NodeManager::removeNodePendingApplyKeys(const Node* node)
     removeNodePendingApplyKeys_internal(node);
 }
 
+std::shared_ptr<Node> NodeManager::getLoadedNode(NodeHandle handle)
+{
+    std::shared_lock lookupLock(mNodesLookupMutex);
+    auto it = mNodes.find(handle);
+    return it != mNodes.end() ? it->second.getNodeInRam(false) : nullptr;
+}
+
 void NodeManager::insertNodeCacheLRU_internal(std::shared_ptr<Node> node)
 {
     assert(mMutex.owns_lock() && "Mutex should be locked by this thread");
+    NodeManagerNode& nodeManagerNode = node->mNodePosition->second;
+    if (mCacheLRU.front() == &nodeManagerNode)
+    {
+        return; // already the most recently used
+    }
+
     removeNodeCacheLRU_internal(node.get());
-    node->mNodePosition->second.mLRUPosition = mCacheLRU.insert(mCacheLRU.begin(), node);
+    mCacheLRU.pushFront(nodeManagerNode, node);
     unLoadNodeFromCacheLRU(); // check if it's necessary unload nodes
     // setfingerprint again to force to insert into NodeManager::mFingerPrints
     // only nodes in LRU are at NodeManager::mFingerPrints
@@ -2173,26 +2697,105 @@ void NodeManager::insertNodeCacheLRU_internal(std::shared_ptr<Node> node)
 void NodeManager::unLoadNodeFromCacheLRU()
 {
     assert(mMutex.owns_lock() && "Mutex should be locked by this thread");
+    if (mCacheLRU.size() <= mCacheLRUMaxSize)
+    {
+        return;
+    }
+
+    // Evicted nodes are released in a batch, once the LRU is consistent again
+    sharedNode_vector evicted;
+    evicted.reserve(static_cast<size_t>(mCacheLRU.size() - mCacheLRUMaxSize));
     while (mCacheLRU.size() > mCacheLRUMaxSize)
     {
-        std::shared_ptr<Node> node = mCacheLRU.back();
+        std::shared_ptr<Node> node = mCacheLRU.remove(*mCacheLRU.back());
         removeFingerprint(node.get(), true);
-        node->mNodePosition->second.mLRUPosition = invalidCacheLRUPos();
-        mCacheLRU.pop_back();
+        evicted.push_back(std::move(node));
     }
+
+    mCacheLRUEvictions += evicted.size();
 }
 
 void NodeManager::removeNodeCacheLRU_internal(Node* node)
 {
     assert(mMutex.owns_lock() && "Mutex should be locked by this thread");
     if (!node || node->mNodePosition == mNodes.end() ||
-        node->mNodePosition->second.mLRUPosition == mCacheLRU.end())
+        !node->mNodePosition->second.isInCacheLRU())
     {
         return;
     }
 
-    mCacheLRU.erase(node->mNodePosition->second.mLRUPosition);
-    node->mNodePosition->second.mLRUPosition = invalidCacheLRUPos();
+    mCacheLRU.remove(node->mNodePosition->second);
+}
+
+void NodeManager::NodeCacheLRU::pushFront(NodeManagerNode& nodeManagerNode,
+                                          std::shared_ptr<Node> node)
+{
+    assert(!nodeManagerNode.isInCacheLRU() && node);
+    nodeManagerNode.mLRUNode = std::move(node);
+    nodeManagerNode.mLRUPrev = nullptr;
+    nodeManagerNode.mLRUNext = mFront;
+    if (mFront)
+    {
+        mFront->mLRUPrev = &nodeManagerNode;
+    }
+    else
+    {
+        mBack = &nodeManagerNode;
+    }
+    mFront = &nodeManagerNode;
+    ++mSize;
+}
+
+std::shared_ptr<Node> NodeManager::NodeCacheLRU::remove(NodeManagerNode& nodeManagerNode)
+{
+    assert(nodeManagerNode.isInCacheLRU());
+    if (nodeManagerNode.mLRUPrev)
+    {
+        nodeManagerNode.mLRUPrev->mLRUNext = nodeManagerNode.mLRUNext;
+    }
+    else
+    {
+        mFront = nodeManagerNode.mLRUNext;
+    }
+
+    if (nodeManagerNode.mLRUNext)
+    {
+        nodeManagerNode.mLRUNext->mLRUPrev = nodeManagerNode.mLRUPrev;
+    }
+    else
+    {
+        mBack = nodeManagerNode.mLRUPrev;
+    }
+
+    nodeManagerNode.mLRUPrev = nullptr;
+    nodeManagerNode.mLRUNext = nullptr;
+    --mSize;
+    return std::move(nodeManagerNode.mLRUNode);
+}
+
+void NodeManager::NodeCacheLRU::clear()
+{
+    sharedNode_vector nodes;
+    nodes.reserve(static_cast<size_t>(mSize));
+    while (mFront)
+    {
+        nodes.push_back(remove(*mFront));
+    }
+}
+
+NodeManagerNode* NodeManager::NodeCacheLRU::front() const
+{
+    return mFront;
+}
+
+NodeManagerNode* NodeManager::NodeCacheLRU::back() const
+{
+    return mBack;
+}
+
+uint64_t NodeManager::NodeCacheLRU::size() const
+{
+    return mSize;
 }
 
 void NodeManager::removeNodePendingApplyKeys_internal(const Node* node)
@@ -2211,6 +2814,8 @@ NodeCounter NodeManager::getCounterOfRootNodes_internal()
 {
     assert(mMutex.owns_lock());
 
+    flushTreeCounters_internal();
+
     NodeCounter c;
 
     // if not logged in yet, node counters are not available
@@ -2250,6 +2855,12 @@ void NodeManager::updateCounter_internal(std::shared_ptr<Node> n, std::shared_pt
 {
     assert(mMutex.owns_lock());
 
+    if (mOutdatedTreeCounters.count(n->nodeHandle()))
+    {
+        // the counter of 'n' is about to be moved to its new ancestors
+        flushTreeCounters_internal();
+    }
+
     NodeCounter nc = n->getCounter();
     updateTreeCounter(oldParent, nc, DECREASE, nullptr);
 
@@ -2303,8 +2914,7 @@ FingerprintPosition NodeManager::insertFingerprint_internal(Node* node)
         return mFingerPrintsNoMtime.end();
     }
 
-    if (auto it = mNodes.find(node->nodeHandle());
-        it == mNodes.end() || it->second.mLRUPosition == invalidCacheLRUPos())
+    if (auto it = mNodes.find(node->nodeHandle()); it == mNodes.end() || !it->second.isInCacheLRU())
     {
         return mFingerPrintsNoMtime.end();
     }
@@ -2342,12 +2952,6 @@ FingerprintPosition NodeManager::invalidFingerprintPos()
     return mFingerPrintsNoMtime.end();
 }
 
-std::list<std::shared_ptr<Node> >::const_iterator NodeManager::invalidCacheLRUPos() const
-{
-    // no locking for this one, it returns a constant
-    return mCacheLRU.end();
-}
-
 void NodeManager::dumpNodes()
 {
     LockGuard g(mMutex);
@@ -2373,7 +2977,7 @@ void NodeManager::dumpNodes_internal()
         }
     }
 
-    mTable->createIndexes(mClient.mEnableSearchDBIndexes, mClient.mEnableLexicographicDBIndexes);
+    scheduleIndexes();
     mInitialized = true;
 }
 
@@ -2393,13 +2997,29 @@ void NodeManager::saveNodeInDb_internal(Node *node)
         return;
     }
 
-    putNodeInDb(node);
+    assert(!mNodeToWriteInDb || mNodeToWriteInDb.get() == node);
+    std::shared_ptr<Node> sharedNode =
+        mNodeToWriteInDb ? std::move(mNodeToWriteInDb) : getNodeInRAM(node->nodeHandle());
 
-    if (mNodeToWriteInDb)   // not to be kept in memory
+    if (!mClient.fetchingnodes || sharedNode.get() != node)
     {
-        assert(mNodeToWriteInDb.get() == node);
-        mNodeToWriteInDb.reset();
+        putFetchedNodesInDb_internal();
+        putNodeInDb(node);
+        return;
     }
+
+    // written in batches. The nodes not kept in memory live in the buffer until then
+    mFetchedNodesToPut.push_back(std::move(sharedNode));
+    if (mFetchedNodesToPut.size() >= FETCHED_NODES_PER_PUT)
+    {
+        putFetchedNodesInDb_internal();
+    }
+}
+
+void NodeManager::putFetchedNodesInDb_internal()
+{
+    assert(mMutex.owns_lock());
+    putNodesInDb(mFetchedNodesToPut);
 }
 
 uint64_t NodeManager::getNumberNodesInRam() const
@@ -2424,6 +3044,7 @@ void NodeManager::addChild_internal(NodeHandle parent, NodeHandle child, Node* n
 {
     assert(mMutex.owns_lock());
 
+    std::unique_lock lookupLock(mNodesLookupMutex);
     auto pair = mNodes.emplace(parent, NodeManagerNode(*this, parent));
     // The NodeManagerNode could have been added in add node, only update the child
     if (!pair.first->second.mChildren)
@@ -2470,6 +3091,7 @@ shared_ptr<Node> NodeManager::getNodeFromDataBase(NodeHandle handle)
 
     shared_ptr<Node> node = nullptr;
     NodeSerialized nodeSerialized;
+putFetchedNodesInDb_internal();
     if (mTable->getNode(handle, nodeSerialized))
     {
         node = getNodeFromNodeSerialized(nodeSerialized);
@@ -2565,6 +3187,31 @@ void NodeManager::putNodeInDb(Node* node) const
         return;
     }
 
+    prepareNodeForDb(node);
+    mTable->put(node);
+}
+
+void NodeManager::putNodesInDb(sharedNode_vector& nodes) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    std::vector<Node*> batch;
+    batch.reserve(nodes.size());
+    for (auto& node: nodes)
+    {
+        prepareNodeForDb(node.get());
+        batch.push_back(node.get());
+    }
+
+    mTable->putBatch(batch);
+    nodes.clear();
+}
+
+void NodeManager::prepareNodeForDb(Node* node) const
+{
     if (node->attrstring)
     {
         // Last attempt to decrypt the node before storing it.
@@ -2576,8 +3223,6 @@ void NodeManager::putNodeInDb(Node* node) const
             mNoKeyLogger.log(*node);
         }
     }
-
-    mTable->put(node);
 }
 
 size_t NodeManager::nodeNotifySize() const
@@ -0,0 +1,497 @@
+/**
+ * @file nodetreesnapshot.cpp
+ * @brief Read-only image of the node tree, memory-mapped on session resumption
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include "mega/nodetreesnapshot.h"
+
+#include "mega/filesystem.h"
+#include "mega/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mega {
+
+// Layout of the file, in native byte order:
+//   Header
+//   Record[numNodes]     sorted by handle
+//   uint32_t[numNodes]   indexes of the records grouped by parent (children of each record)
+//   uint32_t[numShared]  indexes of the records with shares or links
+//   char[namesSize]      names of the nodes, not NUL-terminated
+struct NodeTreeSnapshot::Header
+{
+    static constexpr uint32_t MAGIC = 0x544E474D; // "MGNT"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t scsn;
+    uint64_t roots[3]; // ROOTNODE, VAULTNODE and RUBBISHNODE
+    uint32_t numNodes;
+    uint32_t numShared;
+    uint64_t namesSize;
+};
+
+struct NodeTreeSnapshot::Record
+{
+    uint64_t handle;
+    uint64_t parent;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t firstChild;
+    uint32_t numChildren;
+    uint32_t numFileChildren;
+    int8_t type;
+    uint8_t share;
+    uint8_t padding[2];
+};
+
+namespace
+{
+constexpr size_t NUM_ROOTS = 3;
+
+// handles read from the file are not trusted
+NodeHandle handleFromFile(uint64_t h)
+{
+    return NodeHandle().set6byte(h == UNDEF ? UNDEF : h & 0xFFFFFFFFFFFF);
+}
+
+void unmap(const char* data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+}
+}
+
+NodeTreeSnapshot::NodeTreeSnapshot(const char* data, size_t size):
+    mData(data),
+    mSize(size)
+{
+    static_assert(sizeof(Header) == 56 && alignof(Header) == 8,
+                  "Node tree snapshot header layout changed");
+    static_assert(sizeof(Record) == 40 && alignof(Record) == 8,
+                  "Node tree snapshot record layout changed");
+}
+
+NodeTreeSnapshot::~NodeTreeSnapshot()
+{
+    unmap(mData, mSize);
+}
+
+bool NodeTreeSnapshot::write(FileSystemAccess& fsAccess,
+                             const LocalPath& path,
+                             handle scsn,
+                             std::vector<NodeTreeEntry>&& entries)
+{
+    if (entries.size() >= std::numeric_limits<uint32_t>::max())
+    {
+        LOG_warn << "Too many nodes for the node tree snapshot: " << entries.size();
+        return false;
+    }
+
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const NodeTreeEntry& a, const NodeTreeEntry& b)
+              {
+                  return a.handle.as8byte() < b.handle.as8byte();
+              });
+
+    Header header{};
+    header.magic = Header::MAGIC;
+    header.version = Header::VERSION;
+    header.scsn = scsn;
+    std::fill(std::begin(header.roots), std::end(header.roots), UNDEF);
+    header.numNodes = static_cast<uint32_t>(entries.size());
+
+    std::vector<Record> records(entries.size());
+    std::vector<uint32_t> shared;
+    std::string names;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const NodeTreeEntry& entry = entries[i];
+        if (names.size() + entry.name.size() > std::numeric_limits<uint32_t>::max())
+        {
+            LOG_warn << "Too many names for the node tree snapshot";
+            return false;
+        }
+
+        Record& record = records[i];
+        record.handle = entry.handle.as8byte();
+        record.parent = entry.parent.as8byte();
+        record.nameOffset = static_cast<uint32_t>(names.size());
+        record.nameLength = static_cast<uint32_t>(entry.name.size());
+        record.type = static_cast<int8_t>(entry.type);
+        record.share = static_cast<uint8_t>(entry.share);
+        names.append(entry.name);
+
+        if (entry.share != NO_SHARES)
+        {
+            shared.push_back(static_cast<uint32_t>(i));
+        }
+
+        if (entry.type >= ROOTNODE && entry.type <= RUBBISHNODE)
+        {
+            header.roots[entry.type - ROOTNODE] = record.handle;
+        }
+    }
+    header.numShared = static_cast<uint32_t>(shared.size());
+    header.namesSize = names.size();
+
+    // children are grouped by parent, and each parent points to its group
+    std::vector<uint32_t> children(records.size());
+    std::iota(children.begin(), children.end(), 0u);
+    std::stable_sort(children.begin(),
+                     children.end(),
+                     [&records](uint32_t a, uint32_t b)
+                     {
+                         return records[a].parent < records[b].parent;
+                     });
+
+    for (size_t first = 0; first < children.size();)
+    {
+        const uint64_t parent = records[children[first]].parent;
+        size_t last = first;
+        uint32_t numFiles = 0;
+        for (; last < children.size() && records[children[last]].parent == parent; ++last)
+        {
+            numFiles += records[children[last]].type == FILENODE;
+        }
+
+        auto it = std::lower_bound(records.begin(),
+                                   records.end(),
+                                   parent,
+                                   [](const Record& r, uint64_t h)
+                                   {
+                                       return r.handle < h;
+                                   });
+        if (it != records.end() && it->handle == parent)
+        {
+            it->firstChild = static_cast<uint32_t>(first);
+            it->numChildren = static_cast<uint32_t>(last - first);
+            it->numFileChildren = numFiles;
+        }
+        first = last;
+    }
+
+    // written aside and renamed, so an interrupted write leaves no partial snapshot behind
+    LocalPath tmpPath = path;
+    tmpPath.append(LocalPath::fromRelativePath(".tmp"));
+
+    auto fa = fsAccess.newfileaccess();
+    if (!fa->fopen(tmpPath, OPEN_WRONLY, FSLogging::logOnError) || !fa->ftruncate())
+    {
+        return false;
+    }
+
+    m_off_t pos = 0;
+    auto put = [&fa, &pos](const void* data, size_t length)
+    {
+        if (!length)
+        {
+            return true;
+        }
+        if (!fa->fwrite(data, static_cast<unsigned long>(length), pos))
+        {
+            return false;
+        }
+        pos += static_cast<m_off_t>(length);
+        return true;
+    };
+
+    bool written = put(&header, sizeof(header)) &&
+                   put(records.data(), records.size() * sizeof(Record)) &&
+                   put(children.data(), children.size() * sizeof(uint32_t)) &&
+                   put(shared.data(), shared.size() * sizeof(uint32_t)) &&
+                   put(names.data(), names.size());
+    fa.reset();
+
+    if (!written || !fsAccess.renamelocal(tmpPath, path, true))
+    {
+        LOG_err << "Unable to write the node tree snapshot to " << path;
+        fsAccess.unlinklocal(tmpPath);
+        return false;
+    }
+
+    LOG_debug << "Node tree snapshot written: " << records.size() << " nodes, "
+              << static_cast<uint64_t>(pos) << " bytes";
+    return true;
+}
+
+std::unique_ptr<NodeTreeSnapshot> NodeTreeSnapshot::open(const LocalPath& path, handle scsn)
+{
+    const auto platformPath = path.asPlatformEncoded(false);
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(platformPath.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) ||
+        static_cast<uint64_t>(fileSize.QuadPart) < sizeof(Header) ||
+        static_cast<uint64_t>(fileSize.QuadPart) > std::numeric_limits<size_t>::max())
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    // the view keeps the file mapped after the handles are closed
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        return nullptr;
+    }
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!data)
+    {
+        return nullptr;
+    }
+#else
+    int fd = ::open(platformPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || static_cast<uint64_t>(st.st_size) < sizeof(Header) ||
+        static_cast<uint64_t>(st.st_size) > std::numeric_limits<size_t>::max())
+    {
+        close(fd);
+        return nullptr;
+    }
+    size = static_cast<size_t>(st.st_size);
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    data = static_cast<const char*>(mapped);
+#endif
+
+    std::unique_ptr<NodeTreeSnapshot> snapshot(new NodeTreeSnapshot(data, size));
+
+    const Header& header = snapshot->header();
+    if (header.magic != Header::MAGIC || header.version != Header::VERSION)
+    {
+        LOG_warn << "Node tree snapshot discarded: unknown format";
+        return nullptr;
+    }
+
+    const uint64_t expectedSize = sizeof(Header) + uint64_t(header.numNodes) * sizeof(Record) +
+                                  (uint64_t(header.numNodes) + header.numShared) * sizeof(uint32_t);
+    if (header.namesSize > size || expectedSize + header.namesSize != size)
+    {
+        LOG_warn << "Node tree snapshot discarded: unexpected size";
+        return nullptr;
+    }
+
+    if (header.scsn != scsn)
+    {
+        LOG_debug << "Node tree snapshot discarded: outdated";
+        return nullptr;
+    }
+
+    LOG_debug << "Node tree snapshot mapped: " << header.numNodes << " nodes";
+    return snapshot;
+}
+
+const NodeTreeSnapshot::Header& NodeTreeSnapshot::header() const
+{
+    return *reinterpret_cast<const Header*>(mData);
+}
+
+const NodeTreeSnapshot::Record* NodeTreeSnapshot::records() const
+{
+    return reinterpret_cast<const Record*>(mData + sizeof(Header));
+}
+
+const uint32_t* NodeTreeSnapshot::children() const
+{
+    return reinterpret_cast<const uint32_t*>(records() + header().numNodes);
+}
+
+const uint32_t* NodeTreeSnapshot::shared() const
+{
+    return children() + header().numNodes;
+}
+
+const char* NodeTreeSnapshot::names() const
+{
+    return reinterpret_cast<const char*>(shared() + header().numShared);
+}
+
+size_t NodeTreeSnapshot::numNodes() const
+{
+    return header().numNodes;
+}
+
+const NodeTreeSnapshot::Record* NodeTreeSnapshot::find(NodeHandle h) const
+{
+    const Record* begin = records();
+    const Record* end = begin + header().numNodes;
+    const uint64_t value = h.as8byte();
+    const Record* it = std::lower_bound(begin,
+                                        end,
+                                        value,
+                                        [](const Record& r, uint64_t v)
+                                        {
+                                            return r.handle < v;
+                                        });
+    return it != end && it->handle == value ? it : nullptr;
+}
+
+bool NodeTreeSnapshot::contains(NodeHandle h) const
+{
+    return find(h) != nullptr;
+}
+
+std::optional<size_t> NodeTreeSnapshot::numChildren(NodeHandle parent,
+                                                    std::optional<nodetype_t> type) const
+{
+    const Record* record = find(parent);
+    if (!record)
+    {
+        return std::nullopt;
+    }
+
+    const uint32_t numFiles = std::min(record->numFileChildren, record->numChildren);
+    if (type == FILENODE)
+    {
+        return numFiles;
+    }
+    if (type == FOLDERNODE)
+    {
+        return record->numChildren - numFiles;
+    }
+    return record->numChildren;
+}
+
+std::optional<bool> NodeTreeSnapshot::isAncestor(NodeHandle node, NodeHandle ancestor) const
+{
+    const Record* record = find(node);
+    if (!record)
+    {
+        return std::nullopt;
+    }
+
+    // bounded, in case of a cycle in a corrupt file
+    for (size_t depth = 0; record && depth < header().numNodes; ++depth)
+    {
+        if (ancestor == record->parent)
+        {
+            return true;
+        }
+        record = find(handleFromFile(record->parent));
+    }
+    return false;
+}
+
+std::optional<NodeHandle> NodeTreeSnapshot::childByNameType(NodeHandle parent,
+                                                            const std::string& name,
+                                                            nodetype_t type) const
+{
+    const Record* record = find(parent);
+    if (!record)
+    {
+        return std::nullopt;
+    }
+
+    const Header& h = header();
+    const uint32_t* childIndexes = children();
+    const uint64_t last = std::min<uint64_t>(uint64_t(record->firstChild) + record->numChildren,
+                                             h.numNodes);
+    for (uint64_t i = record->firstChild; i < last; ++i)
+    {
+        if (childIndexes[i] >= h.numNodes)
+        {
+            continue;
+        }
+
+        const Record& child = records()[childIndexes[i]];
+        if (child.type == type && child.nameLength == name.size() &&
+            uint64_t(child.nameOffset) + child.nameLength <= h.namesSize &&
+            !memcmp(names() + child.nameOffset, name.data(), name.size()))
+        {
+            return handleFromFile(child.handle);
+        }
+    }
+    return NodeHandle();
+}
+
+std::vector<NodeHandle> NodeTreeSnapshot::rootNodes() const
+{
+    std::vector<NodeHandle> nodes;
+    for (size_t i = 0; i < NUM_ROOTS; ++i)
+    {
+        const NodeHandle root = handleFromFile(header().roots[i]);
+        if (!root.isUndef())
+        {
+            nodes.push_back(root);
+        }
+    }
+    return nodes;
+}
+
+std::vector<NodeHandle> NodeTreeSnapshot::nodesWithSharesOrLink(ShareType_t shareType) const
+{
+    const Header& h = header();
+    const uint32_t* indexes = shared();
+
+    std::vector<NodeHandle> nodes;
+    for (uint32_t i = 0; i < h.numShared; ++i)
+    {
+        if (indexes[i] < h.numNodes && (records()[indexes[i]].share & shareType))
+        {
+            nodes.push_back(handleFromFile(records()[indexes[i]].handle));
+        }
+    }
+    return nodes;
+}
+
+} // namespace mega
@@ -67,6 +67,13 @@ void ScStreamingParser::init()
     mFilters.emplace("{[a{\"a",
                      [this](JSON* json)
                      {
+                         if (mClient.sc_sliceExhausted(mLastAPDeletedNode.get()))
+                         {
+                             // resume from this action packet in the next call to exec()
+                             releaseLock();
+                             return JSONSplitter::CallbackResult::PAUSED;
+                         }
+
                          mClient.sc_updateStats();
 
                          mActionName = json->getnameid(json->pos + 1);
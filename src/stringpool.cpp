@@ -0,0 +1,229 @@
+/**
+ * @file stringpool.cpp
+ * @brief Immutable refcounted strings, optionally interned in a pool
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include "mega/stringpool.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace mega {
+
+// Counter, owner and characters in a single allocation
+struct SharedString::Entry
+{
+    std::atomic<uint32_t> refs{1};
+    StringPool* pool = nullptr;
+    size_t size = 0;
+    char data[1];
+
+    static Entry* create(std::string_view s, StringPool* pool)
+    {
+        void* p = ::operator new(offsetof(Entry, data) + s.size() + 1);
+        auto* e = new (p) Entry;
+        e->pool = pool;
+        e->size = s.size();
+        if (!s.empty())
+        {
+            memcpy(e->data, s.data(), s.size());
+        }
+        e->data[s.size()] = '\0';
+        return e;
+    }
+
+    static void destroy(Entry* e)
+    {
+        e->~Entry();
+        ::operator delete(e);
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(data, size);
+    }
+
+    static size_t allocationSize(size_t size)
+    {
+        return offsetof(Entry, data) + size + 1;
+    }
+};
+
+SharedString::SharedString(std::string_view s):
+    mEntry(Entry::create(s, nullptr))
+{}
+
+SharedString::SharedString(Entry* entry):
+    mEntry(entry)
+{}
+
+SharedString::SharedString(const SharedString& other):
+    mEntry(other.mEntry)
+{
+    if (mEntry)
+    {
+        mEntry->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SharedString::SharedString(SharedString&& other) noexcept:
+    mEntry(other.mEntry)
+{
+    other.mEntry = nullptr;
+}
+
+SharedString& SharedString::operator=(const SharedString& other)
+{
+    if (mEntry != other.mEntry)
+    {
+        SharedString copy(other);
+        release();
+        std::swap(mEntry, copy.mEntry);
+    }
+    return *this;
+}
+
+SharedString& SharedString::operator=(SharedString&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        std::swap(mEntry, other.mEntry);
+    }
+    return *this;
+}
+
+SharedString::~SharedString()
+{
+    release();
+}
+
+const char* SharedString::c_str() const
+{
+    return mEntry ? mEntry->data : nullptr;
+}
+
+std::string_view SharedString::view() const
+{
+    return mEntry ? mEntry->view() : std::string_view();
+}
+
+size_t SharedString::size() const
+{
+    return mEntry ? mEntry->size : 0;
+}
+
+void SharedString::release()
+{
+    if (!mEntry)
+    {
+        return;
+    }
+
+    if (mEntry->pool)
+    {
+        mEntry->pool->release(mEntry);
+    }
+    else if (mEntry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Entry::destroy(mEntry);
+    }
+
+    mEntry = nullptr;
+}
+
+StringPool::~StringPool()
+{
+    // strings still referenced are detached and freed by their last handle
+    std::lock_guard<std::mutex> g(mMutex);
+    for (auto& [view, entry]: mEntries)
+    {
+        entry->pool = nullptr;
+    }
+}
+
+SharedString StringPool::intern(std::string_view s)
+{
+    std::lock_guard<std::mutex> g(mMutex);
+
+    auto it = mEntries.find(s);
+    if (it != mEntries.end())
+    {
+        it->second->refs.fetch_add(1, std::memory_order_relaxed);
+        return SharedString(it->second);
+    }
+
+    auto* entry = SharedString::Entry::create(s, this);
+    mEntries.emplace(entry->view(), entry);
+    return SharedString(entry);
+}
+
+void StringPool::release(SharedString::Entry* entry)
+{
+    // Other handles remain: no need to lock. The counter only drops to zero with the mutex
+    // locked, so intern() can't hand out an entry that is being removed.
+    auto refs = entry->refs.load(std::memory_order_relaxed);
+    while (refs > 1)
+    {
+        if (entry->refs.compare_exchange_weak(refs,
+                                              refs - 1,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> g(mMutex);
+    if (entry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        [[maybe_unused]] auto erased = mEntries.erase(entry->view());
+        assert(erased == 1);
+        SharedString::Entry::destroy(entry);
+    }
+}
+
+StringPool::Stats StringPool::stats() const
+{
+    std::lock_guard<std::mutex> g(mMutex);
+
+    // a hash table node holds the key, the value, the hash and the link to the next one
+    constexpr size_t nodeSize = sizeof(std::pair<const std::string_view, SharedString::Entry*>) +
+                                2 * sizeof(void*);
+
+    Stats s;
+    s.strings = mEntries.size();
+    s.bytes = sizeof(*this) + mEntries.bucket_count() * sizeof(void*);
+    for (const auto& [view, entry]: mEntries)
+    {
+        s.references += entry->refs.load(std::memory_order_relaxed);
+        s.bytes += nodeSize + SharedString::Entry::allocationSize(entry->size);
+    }
+    return s;
+}
+
+StringPool& StringPool::nodeNames()
+{
+    // never destroyed: MegaNode objects can outlive everything else in the process
+    static StringPool* pool = new StringPool;
+    return *pool;
+}
+
+} // namespace mega
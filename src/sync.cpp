@@ -190,7 +190,7 @@ bool SyncPath::appendRowNames(const SyncRow& row, FileSystemType filesystemType)
     }
     else if (row.syncNode)
     {
-        cloudPath += row.syncNode->toName_of_localname;
+        cloudPath += row.syncNode->toName_of_localname.view();
     }
     else if (row.fsNode)
     {
@@ -215,7 +215,7 @@ bool SyncPath::appendRowNames(const SyncRow& row, FileSystemType filesystemType)
     }
     else if (row.syncNode)
     {
-        syncPath += row.syncNode->toName_of_localname;
+        syncPath += row.syncNode->toName_of_localname.view();
     }
     else if (row.fsNode)
     {
@@ -788,6 +788,10 @@ Sync::Sync(UnifiedSync& us, const std::string& logname, SyncError& e):
               << " and root folder id: "
               << us.mConfig.mLocalPathFsid;
 
+    // before loading the LocalNodes: it's part of the order of their children
+    mCaseInsensitive = determineCaseInsenstivity(false);
+    LOG_debug << "Sync case insensitivity for " << mLocalPath << " is " << mCaseInsensitive;
+
     // load LocalNodes from cache (only for internal syncs)
     us.mConfig.mDatabaseExists = shouldHaveDatabase() && openOrCreateDb(
                                                              [this](DBError error)
@@ -799,9 +803,6 @@ Sync::Sync(UnifiedSync& us, const std::string& logname, SyncError& e):
 
     us.mConfig.mRunState = SyncRunState::Run;
 
-    mCaseInsensitive = determineCaseInsenstivity(false);
-    LOG_debug << "Sync case insensitivity for " << mLocalPath << " is " << mCaseInsensitive;
-
     // Increment counter of active syncs.
     ++syncs.mNumSyncsActive;
 }
@@ -820,7 +821,9 @@ Sync::~Sync()
     // unlock tmp lock
     tmpfa.reset();
 
+    // Write what the journal still holds.
     // Deleting localnodes after this will not remove them from the db.
+    cachenodes();
     statecachetable.reset();
 
     // This will recursively delete all LocalNodes in the sync.
@@ -900,18 +903,36 @@ void Sync::addstatecachechildren(uint32_t parent_dbid, idlocalnode_map* tmap, Lo
 
     auto range = tmap->equal_range(parent_dbid);
 
-    // remove processed elements as we go, so we can then clean the database at the end.
-    for (auto it = range.first; it != tmap->end() && it->first == parent_dbid; it = tmap->erase(it))
+    // Add the children in the order of p->children, so each one is just appended to it.
+    // The sort is stable: duplicates keep their order in the db (see below)
+    vector<pair<string, LocalNode*>> ordered;
+    for (auto it = range.first; it != range.second; ++it)
     {
-        LocalNode* const l = it->second;
+        ordered.emplace_back(it->second->localname.toName(*syncs.fsaccess), it->second);
+    }
+    std::stable_sort(ordered.begin(),
+                     ordered.end(),
+                     [this](const pair<string, LocalNode*>& a, const pair<string, LocalNode*>& b)
+                     {
+                         return SortedChildIndex<LocalNode>::compare(a.first,
+                                                                     a.second->localname,
+                                                                     b.first,
+                                                                     b.second->localname,
+                                                                     mCaseInsensitive) < 0;
+                     });
 
-        auto preExisting = p->children.find(l->localname);
+    // remove processed elements, so we can then clean the database at the end.
+    tmap->erase(range.first, range.second);
+
+    for (auto& [name, l] : ordered)
+    {
+        auto preExisting = p->children.find(l->localname, name, mCaseInsensitive);
         if (preExisting != p->children.end())
         {
             // tidying up from prior versions of the SDK which might have duplicate LocalNodes
-            LOG_debug << "Removing duplicate LocalNode: " << preExisting->second->debugGetParentList();
-            delete preExisting->second;   // also detaches and preps removal from db
-            assert(p->children.find(l->localname) == p->children.end());
+            LOG_debug << "Removing duplicate LocalNode: " << (*preExisting)->debugGetParentList();
+            delete *preExisting;   // also detaches and preps removal from db
+            assert(p->children.find(l->localname, name, mCaseInsensitive) == p->children.end());
             // l will be added in its place.  Later entries were the ones used by the old algorithm
         }
 
@@ -920,7 +941,7 @@ void Sync::addstatecachechildren(uint32_t parent_dbid, idlocalnode_map* tmap, Lo
         newpath.appendWithSeparator(l->localname, true);
 
         handle fsid = l->fsid_lastSynced;
-        m_off_t size = l->syncedFingerprint.size;
+        m_off_t size = l->syncedFingerprint().size;
 
         // clear localname to force newnode = true in setnameparent
         l->localname.clear();
@@ -939,7 +960,9 @@ void Sync::addstatecachechildren(uint32_t parent_dbid, idlocalnode_map* tmap, Lo
 
         l->init(l->type, p, newpath, nullptr);
 
-        l->syncedFingerprint.size = size;
+        FileFingerprint syncedFingerprint = l->syncedFingerprint();
+        syncedFingerprint.size = size;
+        l->setSyncedFingerprint(syncedFingerprint);
         l->setSyncedFsid(fsid, syncs.localnodeBySyncedFsid, l->localname, std::move(shortname));
         l->setSyncedNodeHandle(l->syncedCloudNodeHandle);
         l->oneTimeUseSyncedFingerprintInScan = true;
@@ -947,7 +970,7 @@ void Sync::addstatecachechildren(uint32_t parent_dbid, idlocalnode_map* tmap, Lo
         if (!l->slocalname_in_db)
         {
             statecacheadd(l);
-            if (insertq.size() > 50000)
+            if (mStateCacheJournal.size() > 50000)
             {
                 DBTableTransactionCommitter committer(statecachetable);
                 cachenodes();  // periodically output updated nodes with shortname updates, so people who restart megasync still make progress towards a fast startup
@@ -1032,13 +1055,7 @@ void Sync::statecachedel(LocalNode* l)
         return;
     }
 
-    if (l->dbid && statecachetable)
-    {
-        statecachetable->del(l->dbid);
-    }
-    l->dbid = 0;
-
-    insertq.erase(l);
+    mStateCacheJournal.remove(l, syncs.waiter->ds);
 }
 
 // insert LocalNode into DB cache
@@ -1058,57 +1075,93 @@ void Sync::statecacheadd(LocalNode* l)
         return;
     }
 
-    insertq.insert(l);
     assert(l != localroot.get());
     assert(l->parent);
+    mStateCacheJournal.add(l, syncs.waiter->ds);
 }
 
 void Sync::cachenodes()
 {
     assert(syncs.onSyncThread());
 
-    // Purge the queues if we have no state cache.
+    // Purge the journal if we have no state cache.
     if (!statecachetable)
     {
-        insertq.clear();
+        mStateCacheJournal.clear();
         return;
     }
 
-    if (insertq.size())
+    if (mStateCacheJournal.empty())
     {
-        LOG_debug << syncname << "Saving LocalNode database with " << insertq.size() << " additions";
+        return;
+    }
 
-        DBTableTransactionCommitter committer(statecachetable);
+    // everything pending goes in a single transaction
+    DBTableTransactionCommitter committer(statecachetable);
 
-        // additions - we iterate until completion or until we get stuck
-        bool added;
+    const auto pending = mStateCacheJournal.size();
+    assert(!SymmCipher::isZeroKey(syncs.syncKey.key, sizeof(syncs.syncKey.key)));
+    const auto written = mStateCacheJournal.flush(*statecachetable,
+                                                  MegaClient::CACHEDLOCALNODE,
+                                                  syncs.syncKey,
+                                                  localroot.get(),
+                                                  syncs.waiter->ds);
+
+    const auto& stats = mStateCacheJournal.stats();
+    LOG_debug << syncname << "Saved LocalNode database: " << written << " written of " << pending
+              << " pending (" << stats.recordsWritten << " written and "
+              << stats.recordsDeleted << " deleted for " << stats.changes << " changes, "
+              << stats.absorbed << " absorbed)";
+
+    if (!mStateCacheJournal.empty())
+    {
+        LOG_err << "LocalNode caching did not complete";
+        assert(false);
+    }
+}
+
+void Sync::cachenodesIfDue()
+{
+    assert(syncs.onSyncThread());
 
-        do {
-            added = false;
+    const bool idle = !localroot->scanRequired() && !localroot->syncRequired() &&
+                      !localroot->mightHaveMoves();
 
-            for (set<LocalNode*>::iterator it = insertq.begin(); it != insertq.end(); )
+    if (!statecachetable || mStateCacheJournal.due(syncs.waiter->ds, idle))
+    {
+        cachenodes();
+    }
+}
+
+void Sync::compactLocalNodeNames()
+{
+    assert(syncs.onSyncThread());
+
+    if (!localroot || !mLocalNodeNames.wantsCompaction())
+    {
+        return;
+    }
+
+    auto before = mLocalNodeNames.stats();
+
+    // every LocalNode of the sync is in the tree below localroot
+    mLocalNodeNames.compact(
+        [this](auto&& move)
+        {
+            vector<LocalNode*> pending{localroot.get()};
+            while (!pending.empty())
             {
-                assert((*it)->type >= 0);
-                assert((*it)->sync == this);
-                assert((*it)->parent->parent || (*it)->parent == localroot.get());
-                if ((*it)->parent->dbid || (*it)->parent == localroot.get())
-                {
-                    // add once we know the parent dbid so that the parent/child structure is correct in db
-                    assert(!SymmCipher::isZeroKey(syncs.syncKey.key, sizeof(syncs.syncKey.key)));
-                    statecachetable->put(MegaClient::CACHEDLOCALNODE, *it, &syncs.syncKey);
-                    insertq.erase(it++);
-                    added = true;
-                }
-                else it++;
+                auto* node = pending.back();
+                pending.pop_back();
+
+                move(node->toName_of_localname);
+                pending.insert(pending.end(), node->children.begin(), node->children.end());
             }
-        } while (added);
+        });
 
-        if (insertq.size())
-        {
-            LOG_err << "LocalNode caching did not complete";
-            assert(false);
-        }
-    }
+    LOG_debug << syncname << "Compacted the names of " << before.names << " LocalNodes from "
+              << before.allocatedBytes << " to " << mLocalNodeNames.stats().allocatedBytes
+              << " bytes";
 }
 
 void Sync::changestate(SyncError newSyncError, bool newEnableFlag, bool notifyApp, bool keepSyncDb)
@@ -1317,9 +1370,8 @@ LocalNode* Sync::localnodebypath(LocalNode* l, const LocalPath& localpath, Local
             *parent = l;
         }
 
-        localnode_map::iterator it;
-        if ((it = l->children.find(component)) == l->children.end()
-            && (it = l->schildren.find(component)) == l->schildren.end())
+        LocalNode* child = l->childbyname(&component);
+        if (!child)
         {
             // no full match: store residual path, return NULL with the
             // matching component LocalNode in parent
@@ -1336,7 +1388,7 @@ LocalNode* Sync::localnodebypath(LocalNode* l, const LocalPath& localpath, Local
             return NULL;
         }
 
-        l = it->second;
+        l = child;
     }
 
     // full match: no residual path, return corresponding LocalNode
@@ -2313,7 +2365,7 @@ bool Sync::checkLocalPathForMovesRenames(SyncRow& row, SyncRow& parentRow, SyncP
                             syncNode.type,
                             fsfp,
                             cloudRootOwningUser,
-                            syncNode.syncedFingerprint,
+                            syncNode.syncedFingerprint(),
                             FileFingerprint{}};
 
                         return syncs.findLocalNodeByScannedFsid(syncNode.fsid_lastSynced,
@@ -2549,9 +2601,9 @@ bool Sync::checkLocalPathForMovesRenames(SyncRow& row, SyncRow& parentRow, SyncP
                     // But for this case we are reusing this existing LocalNode and it may be a folder with children
                     // Those children should be removed, should this whole operation succeed.  Make a list
                     // and remove them if the cloud actions succeed.
-                    for (auto& c : row.syncNode->children)
+                    for (auto* c : row.syncNode->children)
                     {
-                        movePtr->priorChildrenToRemove[c.second->localname] = c.second;
+                        movePtr->priorChildrenToRemove[c->localname] = c;
                     }
                 }
 
@@ -2832,7 +2884,7 @@ bool Sync::checkForCompletedFolderCreateHere(SyncRow& row,
 
             row.syncNode->setSyncedNodeHandle(row.cloudNode->handle); //  we could set row.cloudNode->handle, but then we would not download after move if the file was both moved and updated;
             row.syncNode->setSyncedFsid(folderCreate->originalFsid, syncs.localnodeBySyncedFsid, row.syncNode->localname, nullptr);  // setting the synced fsid enables chained moves
-            row.syncNode->syncedFingerprint = row.cloudNode->fingerprint;
+            row.syncNode->setSyncedFingerprint(row.cloudNode->fingerprint);
 
             folderCreate.reset();
             row.syncNode->trimRareFields();
@@ -3028,7 +3080,7 @@ bool Sync::processCompletedUploadFromHere(SyncRow& row,
                      << " [Num uploads: " << row.syncNode->uploadCounter() << "]"
                      << logTriplet(row, fullPath);
         row.syncNode->setSyncedFsid(upload->sourceFsid, syncs.localnodeBySyncedFsid, row.syncNode->localname, row.syncNode->cloneShortname());
-        row.syncNode->syncedFingerprint = *upload;
+        row.syncNode->setSyncedFingerprint(*upload);
         row.syncNode->setSyncedNodeHandle(upload->upsyncResultHandle);
         statecacheadd(row.syncNode);
 
@@ -3102,7 +3154,7 @@ bool Sync::checkForCompletedCloudMoveToHere(SyncRow& row,
                 // That way, if that row had some other sync aspect needed
                 // (such as upload from an edit-then-move case, and the sync performs the move first)
                 // then we will detect that same operation at this new row.
-                row.syncNode->syncedFingerprint = sourceSyncNode->syncedFingerprint;
+                row.syncNode->setSyncedFingerprint(sourceSyncNode->syncedFingerprint());
 
                 // remove fsid (and handle) from source node, so we don't detect
                 // that as a move source anymore
@@ -3127,7 +3179,7 @@ bool Sync::checkForCompletedCloudMoveToHere(SyncRow& row,
                 // In that case, migrating the transfer to the target node (and updating its path)
                 // would transiently rename it, confusing clients/listeners and potentially causing
                 // duplicate uploads.  In this scenario, keep the transfer on the source node.
-                sourceSyncNode->syncedFingerprint = FileFingerprint();
+                sourceSyncNode->setSyncedFingerprint(FileFingerprint());
                 sourceSyncNode->setSyncedFsid(UNDEF, syncs.localnodeBySyncedFsid, sourceSyncNode->localname, sourceSyncNode->cloneShortname());
                 sourceSyncNode->setSyncedNodeHandle(NodeHandle());
                 sourceSyncNode->sync->statecacheadd(sourceSyncNode);
@@ -3181,11 +3233,11 @@ bool Sync::checkForCompletedCloudMoveToHere(SyncRow& row,
                 // TODO: however, there is a risk of name collisions - probably we should use a multimap for LocalNode::children.
                 for (auto& oldc : moveHerePtr->priorChildrenToRemove)
                 {
-                    for (auto& c : row.syncNode->children)
+                    for (auto* c : row.syncNode->children)
                     {
-                        if (c.first == oldc.first && c.second == oldc.second)
+                        if (c->localname == oldc.first && c == oldc.second)
                         {
-                            delete c.second; // removes itself from the parent map
+                            delete c; // removes itself from the parent's children
                             break;
                         }
                     }
@@ -3613,7 +3665,7 @@ bool Sync::checkCloudPathForMovesRenames(SyncRow& row, SyncRow& parentRow, SyncP
             childrenToDeleteOnFunctionExit.reset(new LocalNode(this));
             while (!row.syncNode->children.empty())
             {
-                auto* child = row.syncNode->children.begin()->second;
+                auto* child = *row.syncNode->children.begin();
                 child->setnameparent(childrenToDeleteOnFunctionExit.get(), child->localname, child->cloneShortname());
             }
         }
@@ -3683,7 +3735,7 @@ bool Sync::checkCloudPathForMovesRenames(SyncRow& row, SyncRow& parentRow, SyncP
                     row.syncNode->slocalname = row.fsNode->cloneShortname();
 
                     row.syncNode->setSyncedFsid(row.fsNode->fsid, syncs.localnodeBySyncedFsid, row.fsNode->localname, row.fsNode->cloneShortname());
-                    row.syncNode->syncedFingerprint = row.fsNode->fingerprint;
+                    row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
                     row.syncNode->setSyncedNodeHandle(row.cloudNode->handle);
                     statecacheadd(row.syncNode);
                 }
@@ -5018,11 +5070,11 @@ void Syncs::getSyncStatusInfoInThread(handle backupID,
 
             // Directories don't have a size.
             if (node.type == FILENODE)
-                info.mTotalSyncedBytes += static_cast<size_t>(node.syncedFingerprint.size);
+                info.mTotalSyncedBytes += static_cast<size_t>(node.syncedFingerprint().size);
 
             // Process children, if any.
-            for (auto& childIt : node.children)
-                tally(info, *childIt.second);
+            for (auto* child : node.children)
+                tally(info, *child);
         }
 
         const Sync& mSync;
@@ -7261,6 +7313,7 @@ void Syncs::locallogout_inThread(bool removecaches, bool keepSyncsConfigFile, bo
             if (sync->statecachetable)
             {
                 if (removecaches) sync->statecachetable->remove();
+                else sync->cachenodes();
                 sync->statecachetable.reset();
             }
         }
@@ -7565,21 +7618,23 @@ void SyncRow::inferOrCalculateChildSyncRows(bool wasSynced, vector<SyncRow>& chi
             // Otherwise, we can reconstruct the filesystem entries from the LocalNodes
             fsChildren.reserve(syncNode->children.size() + 50);  // leave some room for others to be added in syncItem()
 
-            for (auto &childIt : syncNode->children)
+            // in the order of the children, so they don't have to be sorted again
+            syncNode->children.sort(syncNode->sync->mCaseInsensitive);
+
+            for (auto* child : syncNode->children)
             {
-                assert(childIt.first == childIt.second->localname);
                 if (belowRemovedFsNode)
                 {
-                    if (childIt.second->fsid_asScanned != UNDEF)
+                    if (child->fsid_asScanned != UNDEF)
                     {
-                        childIt.second->setScannedFsid(UNDEF, localnodeByScannedFsid, LocalPath(), FileFingerprint());
-                        childIt.second->scannedFingerprint = FileFingerprint();
-                        childIt.second->realScannedFingerprint = FileFingerprint();
+                        child->setScannedFsid(UNDEF, localnodeByScannedFsid, LocalPath(), FileFingerprint());
+                        child->setScannedFingerprint(FileFingerprint());
+                        child->setRealScannedFingerprint(FileFingerprint());
                     }
                 }
-                else if (childIt.second->fsid_asScanned != UNDEF)
+                else if (child->fsid_asScanned != UNDEF)
                 {
-                    fsChildren.emplace_back(childIt.second->getScannedFSDetails());
+                    fsChildren.emplace_back(child->getScannedFSDetails());
                 }
             }
 
@@ -7850,26 +7905,26 @@ void SyncRow::reassignFingerprints()
         return;
     }
 
-    if (syncNode->realScannedFingerprint != fsNode->fingerprint)
+    if (syncNode->realScannedFingerprint() != fsNode->fingerprint)
     {
-        syncNode->realScannedFingerprint = fsNode->fingerprint;
+        syncNode->setRealScannedFingerprint(fsNode->fingerprint);
     }
 
 #ifdef __ANDROID__
     // In Android is not possible set mtime when file is download
     // Update fsNode->fingerprint with syncNode->syncedFingerprint in case they only have mtime
     // different This means it has scanned but it is already synced Real value that it is obtained
-    // from file system is stored at syncNode->realScannedFingerprint
-    if (syncNode->syncedFingerprint.isvalid &&
-        syncNode->syncedFingerprint.equalExceptMtimeAndIsValid(fsNode->fingerprint))
+    // from file system is stored at syncNode->realScannedFingerprint()
+    if (syncNode->syncedFingerprint().isvalid &&
+        syncNode->syncedFingerprint().equalExceptMtimeAndIsValid(fsNode->fingerprint))
     {
-        fsNode->fingerprint.mtime = syncNode->syncedFingerprint.mtime;
+        fsNode->fingerprint.mtime = syncNode->syncedFingerprint().mtime;
     }
 #endif
 
-    if (syncNode->scannedFingerprint != fsNode->fingerprint)
+    if (syncNode->scannedFingerprint() != fsNode->fingerprint)
     {
-        syncNode->scannedFingerprint = fsNode->fingerprint;
+        syncNode->setScannedFingerprint(fsNode->fingerprint);
     }
 }
 
@@ -8045,94 +8100,92 @@ auto Sync::computeSyncTriplets(vector<CloudNode>& cloudNodes, const LocalNode& s
 
     CodeCounter::ScopeTimer rst(syncs.mClient.performanceStats.computeSyncTripletsTime);
 
-    vector<SyncRow> triplets;
-    triplets.reserve(cloudNodes.size() + syncParent.children.size() + fsNodes.size());
-
-    for (auto& cn : cloudNodes)          triplets.emplace_back(&cn, nullptr, nullptr);
-    for (auto& sn : syncParent.children) triplets.emplace_back(nullptr, sn.second, nullptr);
-    for (auto& fsn : fsNodes)            triplets.emplace_back(nullptr, nullptr, &fsn);
+    // Although it would be great to efficiently compare cloud names in utf8 directly against filesystem names
+    // in utf16, without any conversions or copied and manipulated strings, unfortunately we have
+    // a few obstacles to that.  Mainly, that the utf8 encoding can differ - especially on Mac
+    // where they normalize the names that go to the filesystem, but with a different normalization
+    // than we chose for the Node names.  In order to compare these effectively and efficiently
+    // we pretty much have to first duplicate and convert both strings to a single utf8 normalization first.
+    // Cloud names may contain escapes, the others are as in the filesystem.
+    struct Name
+    {
+        std::string_view name;
+        bool unescaping;
+    };
 
-    auto tripletCompare = [this](const SyncRow& lhs, const SyncRow& rhs) -> int {
+    auto compareNames = [this](const Name& lhs, const Name& rhs)
+    {
         // Sanity.
-        assert(!lhs.fsNode || !lhs.fsNode->localname.empty());
-        assert(!rhs.fsNode || !rhs.fsNode->localname.empty());
-        assert(!lhs.syncNode || !lhs.syncNode->localname.empty());
-        assert(!rhs.syncNode || !rhs.syncNode->localname.empty());
+        assert(!lhs.name.empty() && !rhs.name.empty());
+        return compareUtf(lhs.name, lhs.unescaping, rhs.name, rhs.unescaping, mCaseInsensitive);
+    };
+
+    auto cloudName = [](const CloudNode& node) { return Name{node.name, true}; };
+    auto syncName = [](const LocalNode* node) { return Name{node->toName_of_localname, false}; };
+    auto fsName = [this](FSNode& node) { return Name{node.toName_of_localname(*syncs.fsaccess), false}; };
+
+    // The LocalNodes are kept in this order.  The cloud and filesystem children are sorted
+    // here, in place: a scan kept in lastFolderScan is only sorted on the first visit.
+    auto cloudLess = [&](const CloudNode& lhs, const CloudNode& rhs)
+    {
+        return compareNames(cloudName(lhs), cloudName(rhs)) < 0;
+    };
+    if (!std::is_sorted(cloudNodes.begin(), cloudNodes.end(), cloudLess))
+    {
+        std::sort(cloudNodes.begin(), cloudNodes.end(), cloudLess);
+    }
+
+    auto fsLess = [&](FSNode& lhs, FSNode& rhs)
+    {
+        return compareNames(fsName(lhs), fsName(rhs)) < 0;
+    };
+    if (!std::is_sorted(fsNodes.begin(), fsNodes.end(), fsLess))
+    {
+        std::sort(fsNodes.begin(), fsNodes.end(), fsLess);
+    }
+
+    syncParent.children.sort(mCaseInsensitive);
 
-        // Although it would be great to efficiently compare cloud names in utf8 directly against filesystem names
-        // in utf16, without any conversions or copied and manipulated strings, unfortunately we have
-        // a few obstacles to that.  Mainly, that the utf8 encoding can differ - especially on Mac
-        // where they normalize the names that go to the filesystem, but with a different normalization
-        // than we chose for the Node names.  In order to compare these effectively and efficiently
-        // we pretty much have to first duplicate and convert both strings to a single utf8 normalization first.
+    vector<SyncRow> triplets;
+    triplets.reserve(cloudNodes.size() + syncParent.children.size() + fsNodes.size());
 
-        if (lhs.cloudNode)
+    // Merge the three: each set is made of all the entries named like the smallest next one
+    auto cloudIt = cloudNodes.begin();
+    auto syncIt = syncParent.children.begin();
+    auto fsIt = fsNodes.begin();
+
+    while (cloudIt != cloudNodes.end() || syncIt != syncParent.children.end() || fsIt != fsNodes.end())
+    {
+        std::optional<Name> smallest;
+        auto consider = [&](const Name& name)
         {
-            if (rhs.cloudNode)
+            if (!smallest || compareNames(name, *smallest) < 0)
             {
-                return compareUtf(lhs.cloudNode->name, true, rhs.cloudNode->name, true, mCaseInsensitive);
+                smallest = name;
             }
-            else if (rhs.syncNode)
-            {
-                return compareUtf(lhs.cloudNode->name, true, rhs.syncNode->toName_of_localname, false, mCaseInsensitive);
-            }
-            else // rhs.fsNode
-            {
-                return compareUtf(lhs.cloudNode->name, true, rhs.fsNode->toName_of_localname(*syncs.fsaccess), false, mCaseInsensitive);
-            }
-        }
-        else if (lhs.syncNode)
+        };
+
+        if (cloudIt != cloudNodes.end()) consider(cloudName(*cloudIt));
+        if (syncIt != syncParent.children.end()) consider(syncName(*syncIt));
+        if (fsIt != fsNodes.end()) consider(fsName(*fsIt));
+
+        auto setStart = triplets.size();
+
+        for (; cloudIt != cloudNodes.end() && !compareNames(cloudName(*cloudIt), *smallest); ++cloudIt)
         {
-            if (rhs.cloudNode)
-            {
-                return compareUtf(lhs.syncNode->toName_of_localname, false, rhs.cloudNode->name, true, mCaseInsensitive);
-            }
-            else if (rhs.syncNode)
-            {
-                return compareUtf(lhs.syncNode->toName_of_localname, false, rhs.syncNode->toName_of_localname, false, mCaseInsensitive);
-            }
-            else // rhs.fsNode
-            {
-                return compareUtf(lhs.syncNode->toName_of_localname, false, rhs.fsNode->toName_of_localname(*syncs.fsaccess), false, mCaseInsensitive);
-            }
+            triplets.emplace_back(&*cloudIt, nullptr, nullptr);
         }
-        else // lhs.fsNode
+        for (; syncIt != syncParent.children.end() && !compareNames(syncName(*syncIt), *smallest); ++syncIt)
         {
-            if (rhs.cloudNode)
-            {
-                return compareUtf(lhs.fsNode->toName_of_localname(*syncs.fsaccess), false, rhs.cloudNode->name, true, mCaseInsensitive);
-            }
-            else if (rhs.syncNode)
-            {
-                return compareUtf(lhs.fsNode->toName_of_localname(*syncs.fsaccess), false, rhs.syncNode->toName_of_localname, false, mCaseInsensitive);
-            }
-            else // rhs.fsNode
-            {
-                return compareUtf(lhs.fsNode->toName_of_localname(*syncs.fsaccess), false, rhs.fsNode->toName_of_localname(*syncs.fsaccess), false, mCaseInsensitive);
-            }
+            triplets.emplace_back(nullptr, *syncIt, nullptr);
         }
-    };
-
-    std::sort(triplets.begin(), triplets.end(),
-           [=](const SyncRow& lhs, const SyncRow& rhs)
-           { return tripletCompare(lhs, rhs) < 0; });
-
-    auto currSet = triplets.begin();
-    auto end  = triplets.end();
-
-    while (currSet != end)
-    {
-        // Determine the next set that are all comparator-equal
-        auto nextSet = currSet;
-        ++nextSet;
-        while (nextSet != end && 0 == tripletCompare(*currSet, *nextSet))
+        for (; fsIt != fsNodes.end() && !compareNames(fsName(*fsIt), *smallest); ++fsIt)
         {
-            ++nextSet;
+            triplets.emplace_back(nullptr, nullptr, &*fsIt);
         }
 
-        combineTripletSet(currSet, nextSet);
-
-        currSet = nextSet;
+        assert(triplets.size() > setStart);
+        combineTripletSet(triplets.begin() + static_cast<std::ptrdiff_t>(setStart), triplets.end());
     }
 
     auto newEnd = std::remove_if(triplets.begin(), triplets.end(), [](SyncRow& row){ return row.empty(); });
@@ -8154,11 +8207,14 @@ bool Sync::inferRegeneratableTriplets(vector<CloudNode>& cloudChildren, const Lo
     auto cloudHandleLess = [](const CloudNode& a, const CloudNode& b){ return a.handle < b.handle; };
     std::sort(cloudChildren.begin(), cloudChildren.end(), cloudHandleLess);
 
-    for (auto& child : syncParent.children)
+    // the rows are in the same order as computed ones
+    syncParent.children.sort(mCaseInsensitive);
+
+    for (auto* child : syncParent.children)
     {
 
         CloudNode compareTo;
-        compareTo.handle = child.second->syncedCloudNodeHandle;
+        compareTo.handle = child->syncedCloudNodeHandle;
         auto iters = std::equal_range(cloudChildren.begin(), cloudChildren.end(), compareTo, cloudHandleLess);
 
         if (std::distance(iters.first, iters.second) != 1)
@@ -8176,15 +8232,15 @@ bool Sync::inferRegeneratableTriplets(vector<CloudNode>& cloudChildren, const Lo
             return false;
         }
 
-        if (child.second->fsid_asScanned == UNDEF ||
-           (!child.second->scannedFingerprint.isvalid && child.second->type == FILENODE))
+        if (child->fsid_asScanned == UNDEF ||
+           (!child->scannedFingerprint().isvalid && child->type == FILENODE))
         {
             // we haven't scanned yet, or the scans don't match up with LocalNodes yet
             return false;
         }
 
-        inferredFsNodes.push_back(child.second->getScannedFSDetails());
-        inferredRows.emplace_back(node, child.second, &inferredFsNodes.back());
+        inferredFsNodes.push_back(child->getScannedFSDetails());
+        inferredRows.emplace_back(node, child, &inferredFsNodes.back());
     }
     return true;
 }
@@ -8304,7 +8360,7 @@ bool Sync::recursiveSync(SyncRow& row, SyncPath& fullPath, bool belowRemovedClou
     if (!row.fsNode || belowRemovedFsNode)
     {
         row.syncNode->scanAgain = TREE_RESOLVED;
-        row.syncNode->realScannedFingerprint = FileFingerprint();
+        row.syncNode->setRealScannedFingerprint(FileFingerprint());
         row.syncNode->setScannedFsid(UNDEF, syncs.localnodeByScannedFsid, LocalPath(), FileFingerprint());
         syncHere = row.syncNode->parent ? row.syncNode->parent->scanAgain < TREE_ACTION_HERE : true;
         recurseHere = false;  // If we need to scan, we need the folder to exist first - revisit later
@@ -8545,12 +8601,7 @@ bool Sync::recursiveSync(SyncRow& row, SyncPath& fullPath, bool belowRemovedClou
                             {
                                 // We keep the immediately excluded node (parent folder is not excluded), but remove anything below it
                                 LOG_debug << syncname << "Removing " << s->children.size() << " child LocalNodes from excluded " << s->getLocalPath();
-                                vector<LocalNode*> cs;
-                                cs.reserve(s->children.size());
-                                for (auto& child: s->children)
-                                {
-                                    cs.push_back(child.second);
-                                }
+                                vector<LocalNode*> cs(s->children.begin(), s->children.end());
                                 // this technique might seem a bit roundabout, but deletion will cause these to
                                 // remove themselves from s->children. // we can't have that happening while we iterate that map.
                                 for (auto p : cs)
@@ -8766,29 +8817,27 @@ bool Sync::recursiveSync(SyncRow& row, SyncPath& fullPath, bool belowRemovedClou
     // Flags for this row could have been set during calls to the node
     // If we skipped a child node this time (or if not), the set-parent
     // flags let us know if future actions are needed at this level
-    for (auto& child : row.syncNode->children)
+    for (auto* child : row.syncNode->children)
     {
-        assert(child.first == child.second->localname);
-
-        if (child.second->exclusionState() == ES_EXCLUDED)
+        if (child->exclusionState() == ES_EXCLUDED)
         {
             continue;
         }
 
-        if (child.second->type > FILENODE)
+        if (child->type > FILENODE)
         {
-            row.syncNode->scanAgain = updateTreestateFromChild(row.syncNode->scanAgain, child.second->scanAgain);
-            row.syncNode->syncAgain = updateTreestateFromChild(row.syncNode->syncAgain, child.second->syncAgain);
+            row.syncNode->scanAgain = updateTreestateFromChild(row.syncNode->scanAgain, child->scanAgain);
+            row.syncNode->syncAgain = updateTreestateFromChild(row.syncNode->syncAgain, child->syncAgain);
         }
-        row.syncNode->checkMovesAgain = updateTreestateFromChild(row.syncNode->checkMovesAgain, child.second->checkMovesAgain);
-        row.syncNode->conflicts = updateTreestateFromChild(row.syncNode->conflicts, child.second->conflicts);
+        row.syncNode->checkMovesAgain = updateTreestateFromChild(row.syncNode->checkMovesAgain, child->checkMovesAgain);
+        row.syncNode->conflicts = updateTreestateFromChild(row.syncNode->conflicts, child->conflicts);
 
-        if (child.second->parentSetScanAgain) row.syncNode->setScanAgain(false, true, false, 0);
-        if (child.second->parentSetCheckMovesAgain) row.syncNode->setCheckMovesAgain(false, true, false);
-        if (child.second->parentSetSyncAgain) row.syncNode->setSyncAgain(false, true, false);
-        if (child.second->parentSetContainsConflicts) row.syncNode->setContainsConflicts(false, true, false);
+        if (child->parentSetScanAgain) row.syncNode->setScanAgain(false, true, false, 0);
+        if (child->parentSetCheckMovesAgain) row.syncNode->setCheckMovesAgain(false, true, false);
+        if (child->parentSetSyncAgain) row.syncNode->setSyncAgain(false, true, false);
+        if (child->parentSetContainsConflicts) row.syncNode->setContainsConflicts(false, true, false);
 
-        child.second->parentSetScanAgain = false;  // we should only use this one once
+        child->parentSetScanAgain = false;  // we should only use this one once
     }
 
     // keep sync overlay icons up to date as we recurse (including the sync root node)
@@ -9184,23 +9233,23 @@ bool Sync::syncItem_checkDownloadCompletion(SyncRow& row, SyncRow& parentRow, Sy
                      << logTriplet(row, fullPath);
 
         assert((downloadPtr->mtimeAppliedOnDisk &&
-                row.syncNode->realScannedFingerprint == row.syncNode->scannedFingerprint) ||
+                row.syncNode->realScannedFingerprint() == row.syncNode->scannedFingerprint()) ||
                (!downloadPtr->mtimeAppliedOnDisk &&
-                row.syncNode->realScannedFingerprint.equalExceptMtime(
-                    row.syncNode->scannedFingerprint)));
+                row.syncNode->realScannedFingerprint().equalExceptMtime(
+                    row.syncNode->scannedFingerprint())));
 
         [[maybe_unused]] const bool isNewFsNode =
             row.fsNode->fingerprint.mtime == downloadPtr->mtime;
         assert(isNewFsNode || row.fsNode->fingerprint.equalExceptMtime(*downloadPtr));
 
-        if (row.syncNode->syncedFingerprint.isvalid)
+        if (row.syncNode->syncedFingerprint().isvalid)
         {
-            assert(row.syncNode->syncedFingerprint.size == row.fsNode->fingerprint.size);
-            assert(row.syncNode->syncedFingerprint.crc == row.fsNode->fingerprint.crc);
+            assert(row.syncNode->syncedFingerprint().size == row.fsNode->fingerprint.size);
+            assert(row.syncNode->syncedFingerprint().crc == row.fsNode->fingerprint.crc);
             assert(!isNewFsNode ||
-                   (row.syncNode->syncedFingerprint.mtime != row.fsNode->fingerprint.mtime));
+                   (row.syncNode->syncedFingerprint().mtime != row.fsNode->fingerprint.mtime));
             assert(
-                row.syncNode->syncedFingerprint.equalExceptMtime(row.syncNode->scannedFingerprint));
+                row.syncNode->syncedFingerprint().equalExceptMtime(row.syncNode->scannedFingerprint()));
         }
         assert(FSNode::debugConfirmOnDiskFingerprintOrLogWhy(*syncs.fsaccess,
                                                              fullPath.localPath,
@@ -9214,13 +9263,13 @@ bool Sync::syncItem_checkDownloadCompletion(SyncRow& row, SyncRow& parentRow, Sy
         row.syncNode->resetTransfer(nullptr);
 
         row.fsNode->fingerprint.mtime = downloadPtr->mtime;
-        row.syncNode->syncedFingerprint = row.fsNode->fingerprint;
-        row.syncNode->scannedFingerprint = row.fsNode->fingerprint;
+        row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
+        row.syncNode->setScannedFingerprint(row.fsNode->fingerprint);
         if (downloadPtr->mtimeAppliedOnDisk)
         {
             // realScannedFingerprint remains the actual filesystem value,
             // as mtime was applied we need to update it.
-            row.syncNode->realScannedFingerprint = row.fsNode->fingerprint;
+            row.syncNode->setRealScannedFingerprint(row.fsNode->fingerprint);
         }
 
         statecacheadd(row.syncNode);
@@ -9310,18 +9359,20 @@ bool Sync::syncItem_checkDownloadCompletion(SyncRow& row, SyncRow& parentRow, Sy
             // Mark the row as synced with the original Node downloaded, so that
             // we can chain any cloud moves/renames that occurred in the meantime
             row.syncNode->setSyncedFsid(row.fsNode->fsid, syncs.localnodeBySyncedFsid, row.fsNode->localname, row.fsNode->cloneShortname());
-            row.syncNode->realScannedFingerprint = row.fsNode->fingerprint;
+            row.syncNode->setRealScannedFingerprint(row.fsNode->fingerprint);
             row.fsNode->fingerprint.mtime = downloadPtr->mtime;
-            row.syncNode->syncedFingerprint = row.fsNode->fingerprint;
+            row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
             // It has been scanned previously to receive syncItem_checkDownloadCompletion.
             // At scannedFingerprint we have a fingerprint with mtime from file system.
             // Set mtime that is received at download
-            if (row.syncNode->scannedFingerprint == row.syncNode->realScannedFingerprint)
+            if (row.syncNode->scannedFingerprint() == row.syncNode->realScannedFingerprint())
             {
-                row.syncNode->scannedFingerprint.mtime = row.fsNode->fingerprint.mtime;
+                auto scannedFingerprint = row.syncNode->scannedFingerprint();
+                scannedFingerprint.mtime = row.fsNode->fingerprint.mtime;
+                row.syncNode->setScannedFingerprint(scannedFingerprint);
             }
 
-            if (row.syncNode->syncedFingerprint != row.syncNode->realScannedFingerprint)
+            if (row.syncNode->syncedFingerprint() != row.syncNode->realScannedFingerprint())
             {
                 SYNC_verbose << syncname
                              << "mtime hasn't been set correctly at fs file (usually Android)";
@@ -9711,12 +9762,7 @@ bool Sync::syncItem(SyncRow& row, SyncRow& parentRow, SyncPath& fullPath, PerFol
                 if (!s->children.empty())
                 {
                     LOG_debug << syncname << "syncItem removing child LocalNodes from excluded " << s->getLocalPath();
-                    vector<LocalNode*> cs;
-                    cs.resize(s->children.size());
-                    for (auto& i : s->children)
-                    {
-                        cs.push_back(i.second);
-                    }
+                    vector<LocalNode*> cs(s->children.begin(), s->children.end());
                     for (auto p : cs)
                     {
                         delete p;
@@ -9834,8 +9880,8 @@ bool Sync::syncItem(SyncRow& row, SyncRow& parentRow, SyncPath& fullPath, PerFol
                 if (!cloudSyncNodeEqual || !fsSyncNodeEqual)
                 {
                     // syncNode is outdated, so update syncedFingerprint
-                    row.syncNode->syncedFingerprint = row.fsNode->fingerprint;
-                    assert(row.syncNode->syncedFingerprint == row.cloudNode->fingerprint);
+                    row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
+                    assert(row.syncNode->syncedFingerprint() == row.cloudNode->fingerprint);
                     statecacheadd(row.syncNode);
                 }
 
@@ -9855,13 +9901,13 @@ bool Sync::syncItem(SyncRow& row, SyncRow& parentRow, SyncPath& fullPath, PerFol
                                  "They're likely within the 2-second tolerance. Side with the "
                                  "newer mtime will be picked [cloudNode.mtime = "
                               << row.cloudNode->fingerprint.mtime
-                              << ", syncNode.mtime = " << row.syncNode->syncedFingerprint.mtime
+                              << ", syncNode.mtime = " << row.syncNode->syncedFingerprint().mtime
                               << ", fsNode.mtime = " << row.fsNode->fingerprint.mtime << "]";
                     assert(
                         (abs(row.cloudNode->fingerprint.mtime -
-                             row.syncNode->syncedFingerprint.mtime) <= FS_MTIME_TOLERANCE_SECS) &&
+                             row.syncNode->syncedFingerprint().mtime) <= FS_MTIME_TOLERANCE_SECS) &&
                         (abs(row.fsNode->fingerprint.mtime -
-                             row.syncNode->syncedFingerprint.mtime) <= FS_MTIME_TOLERANCE_SECS) &&
+                             row.syncNode->syncedFingerprint().mtime) <= FS_MTIME_TOLERANCE_SECS) &&
                         "Mtime-only mismatch detected for both sides considered equal within "
                         "the 2-second tolerance, but one side is not within the 2-second "
                         "tolerance with syncNode!!!");
@@ -9961,7 +10007,7 @@ bool Sync::syncItem(SyncRow& row, SyncRow& parentRow, SyncPath& fullPath, PerFol
                                  << "Node is a recent upload, while the FSFile is already updated: "
                                  << fullPath.cloudPath << logTriplet(row, fullPath);
                     row.syncNode->setSyncedNodeHandle(row.cloudNode->handle);
-                    row.syncNode->syncedFingerprint = row.cloudNode->fingerprint;
+                    row.syncNode->setSyncedFingerprint(row.cloudNode->fingerprint);
                     row.syncNode->transferSP.reset();
                     return false;
                 }
@@ -10063,7 +10109,7 @@ bool Sync::syncItem(SyncRow& row, SyncRow& parentRow, SyncPath& fullPath, PerFol
             SYNC_verbose << syncname << "Node is a recent upload, sync node present, source FS file is no longer here: " << fullPath.cloudPath << logTriplet(row, fullPath);
             row.syncNode->setSyncedNodeHandle(row.cloudNode->handle);
             row.syncNode->setSyncedFsid(uploadPtr->sourceFsid, syncs.localnodeBySyncedFsid, uploadPtr->sourceLocalname, nullptr);
-            row.syncNode->syncedFingerprint  = row.cloudNode->fingerprint;
+            row.syncNode->setSyncedFingerprint(row.cloudNode->fingerprint);
             row.syncNode->transferSP.reset();
             return false;
         }
@@ -10301,7 +10347,7 @@ bool Sync::resolve_checkMoveDownloadComplete(SyncRow& row, SyncPath& fullPath)
 
     // Consider us synced with the local disk.
     target->setSyncedFsid(movePtr->sourceFsid, syncs.localnodeBySyncedFsid, row.fsNode->localname, row.fsNode->cloneShortname());
-    target->syncedFingerprint = movePtr->sourceFingerprint;
+    target->setSyncedFingerprint(movePtr->sourceFingerprint);
     target->sync->statecacheadd(target);
 
     // Terminate the transfer if we're not a match with the local disk.
@@ -10369,11 +10415,11 @@ bool Sync::resolve_checkMoveComplete(SyncRow& row, SyncRow& /*parentRow*/, SyncP
         // TODO: however, there is a risk of name collisions - probably we should use a multimap for LocalNode::children.
         for (auto& oldc : movePtr->priorChildrenToRemove)
         {
-            for (auto& c : row.syncNode->children)
+            for (auto* c : row.syncNode->children)
             {
-                if (c.first == oldc.first && c.second == oldc.second)
+                if (c->localname == oldc.first && c == oldc.second)
                 {
-                    delete c.second; // removes itself from the parent map
+                    delete c; // removes itself from the parent's children
                     break;
                 }
             }
@@ -10434,7 +10480,7 @@ bool Sync::resolve_rowMatched(SyncRow& row, SyncRow& parentRow, SyncPath& fullPa
         row.syncNode->setSyncedFsid(row.fsNode->fsid, syncs.localnodeBySyncedFsid, row.fsNode->localname, row.fsNode->cloneShortname());
         row.syncNode->setSyncedNodeHandle(row.cloudNode->handle);
 
-        row.syncNode->syncedFingerprint = row.fsNode->fingerprint;
+        row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
 
         if (row.syncNode->transferSP)
         {
@@ -10515,8 +10561,8 @@ bool Sync::makeSyncNode_fromFS(SyncRow& row, SyncRow& parentRow, SyncPath& fullP
 
     if (row.fsNode->type == FILENODE)
     {
-        row.syncNode->scannedFingerprint = row.fsNode->fingerprint;
-        row.syncNode->realScannedFingerprint = row.fsNode->fingerprint;
+        row.syncNode->setScannedFingerprint(row.fsNode->fingerprint);
+        row.syncNode->setRealScannedFingerprint(row.fsNode->fingerprint);
     }
 
     if (considerSynced)
@@ -10524,7 +10570,7 @@ bool Sync::makeSyncNode_fromFS(SyncRow& row, SyncRow& parentRow, SyncPath& fullP
         // we should be careful about considering synced, eg this might be a node moved from somewhere else
         SYNC_verbose << "Considering this node synced on fs side already: " << toHandle(row.fsNode->fsid);
         row.syncNode->setSyncedFsid(row.fsNode->fsid, syncs.localnodeBySyncedFsid, row.fsNode->localname, row.fsNode->cloneShortname());
-        row.syncNode->syncedFingerprint  = row.fsNode->fingerprint;
+        row.syncNode->setSyncedFingerprint(row.fsNode->fingerprint);
     }
 
     if (row.syncNode->type > FILENODE)
@@ -10550,7 +10596,7 @@ bool Sync::resolve_makeSyncNode_fromCloud(SyncRow& row, SyncRow& parentRow, Sync
 
     if (row.cloudNode->type == FILENODE)
     {
-        row.syncNode->syncedFingerprint = row.cloudNode->fingerprint;
+        row.syncNode->setSyncedFingerprint(row.cloudNode->fingerprint);
     }
     row.syncNode->init(row.cloudNode->type, parentRow.syncNode, fullPath.localPath, nullptr);
 
@@ -10564,7 +10610,7 @@ bool Sync::resolve_makeSyncNode_fromCloud(SyncRow& row, SyncRow& parentRow, Sync
         SYNC_verbose << syncname << "Node is a recent upload, but source FS file is no longer here: " << fullPath.cloudPath << logTriplet(row, fullPath);
         row.syncNode->setSyncedNodeHandle(row.cloudNode->handle);
         row.syncNode->setSyncedFsid(uploadPtr->sourceFsid, syncs.localnodeBySyncedFsid, uploadPtr->sourceLocalname, nullptr);
-        row.syncNode->syncedFingerprint  = row.cloudNode->fingerprint;
+        row.syncNode->setSyncedFingerprint(row.cloudNode->fingerprint);
         return false;
     }
 
@@ -10689,7 +10735,7 @@ bool Sync::resolve_delSyncNode(SyncRow& row, SyncRow& parentRow, SyncPath& fullP
             const NodeMatchByFSIDAttributes syncNodeAttributes{row.syncNode->type,
                                                                fsfp(),
                                                                cloudRootOwningUser,
-                                                               row.syncNode->syncedFingerprint,
+                                                               row.syncNode->syncedFingerprint(),
                                                                FileFingerprint{}};
             const auto [sourceFsidExclusionUnknown, fsElsewhere] =
                 syncs.findLocalNodeByScannedFsid(row.syncNode->fsid_lastSynced,
@@ -10960,8 +11006,8 @@ bool Sync::resolve_upsync(SyncRow& row,
                     return false;
 
                 LOG_debug << syncname << "Uploading file " << fullPath.localPath << logTriplet(row, fullPath);
-                assert(row.syncNode->scannedFingerprint.isvalid); // LocalNodes for files always have a valid fingerprint
-                assert(row.syncNode->scannedFingerprint == row.fsNode->fingerprint);
+                assert(row.syncNode->scannedFingerprint().isvalid); // LocalNodes for files always have a valid fingerprint
+                assert(row.syncNode->scannedFingerprint() == row.fsNode->fingerprint);
 
                 // if it's just a case change in a case insensitive name, use the updated
                 // uppercase/lowercase
@@ -11169,7 +11215,7 @@ bool Sync::resolve_upsync(SyncRow& row,
             if (parentRow.cloudNode)
             {
                 // there can't be a matching cloud node in this row (for folders), so just toName() is correct
-                string foldername = row.syncNode->toName_of_localname;
+                string foldername(row.syncNode->toName_of_localname.view());
 
                 LOG_verbose << syncname << "Creating cloud node for: " << fullPath.localPath << " as " << foldername << logTriplet(row, fullPath);
                 // while the operation is in progress sync() will skip over the parent folder
@@ -11558,7 +11604,7 @@ bool Sync::resolve_userIntervention(SyncRow& row, SyncPath& fullPath)
         SYNC_verbose_timed
             << "Both sides mismatch since last sync! Fingerprint debug [size:mtime:CRC] : "
             << "Cloud -> " << row.cloudNode->fingerprint.fingerprintDebugString() << ". "
-            << "SyncNode -> " << row.syncNode->syncedFingerprint.fingerprintDebugString() << ". "
+            << "SyncNode -> " << row.syncNode->syncedFingerprint().fingerprintDebugString() << ". "
             << "Local -> " << row.fsNode->fingerprint.fingerprintDebugString() << ". "
             << "Immediate: " << immediateStall << " at " << logTriplet(row, fullPath);
 
@@ -11843,24 +11889,20 @@ std::pair<bool, LocalNode*>
 void Syncs::setSyncedFsidReused(const fsfp_t& fsfp, const handle fsid)
 {
     assert(onSyncThread());
-    for (auto range = localnodeBySyncedFsid.equal_range(fsid);
-         range.first != range.second;
-         ++range.first)
+    for (auto* localNode: localnodeBySyncedFsid.values(fsid))
     {
-        if (range.first->second->sync->fsfp() == fsfp)
-            range.first->second->fsidSyncedReused = true;
+        if (localNode->sync->fsfp() == fsfp)
+            localNode->fsidSyncedReused = true;
     }
 }
 
 void Syncs::setScannedFsidReused(const fsfp_t& fsfp, const handle fsid)
 {
     assert(onSyncThread());
-    for (auto range = localnodeByScannedFsid.equal_range(fsid);
-        range.first != range.second;
-        ++range.first)
+    for (auto* localNode: localnodeByScannedFsid.values(fsid))
     {
-        if (range.first->second->sync->fsfp() == fsfp)
-            range.first->second->fsidScannedReused = true;
+        if (localNode->sync->fsfp() == fsfp)
+            localNode->fsidScannedReused = true;
     }
 }
 
@@ -11884,14 +11926,12 @@ bool Syncs::findLocalNodeByNodeHandle(NodeHandle h, LocalNode*& sourceSyncNodeOr
     assert(onSyncThread());
     if (h.isUndef()) return false;
 
-    auto range = localnodeByNodeHandle.equal_range(h);
-
-    for (auto it = range.first; it != range.second; ++it)
+    for (auto* localNode: localnodeByNodeHandle.values(h))
     {
-        switch (it->second->exclusionState())
+        switch (localNode->exclusionState())
         {
         case ES_INCLUDED: break;
-        case ES_UNKNOWN:  LOG_verbose << mClient.clientname << "findLocalNodeByNodeHandle - unknown exclusion with that handle " << h << " at: " << it->second->getLocalPath();
+        case ES_UNKNOWN:  LOG_verbose << mClient.clientname << "findLocalNodeByNodeHandle - unknown exclusion with that handle " << h << " at: " << localNode->getLocalPath();
                           unsureDueToUnknownExclusionMoveSource = true;
                           continue;
         case ES_EXCLUDED: continue;
@@ -11899,16 +11939,16 @@ bool Syncs::findLocalNodeByNodeHandle(NodeHandle h, LocalNode*& sourceSyncNodeOr
         }
 
         // check the file/folder actually exists (with same fsid) on disk for this LocalNode
-        LocalPath lp = it->second->getLocalPath();
+        LocalPath lp = localNode->getLocalPath();
 
-        if (it->second->fsid_lastSynced != UNDEF &&
-            it->second->fsid_lastSynced == fsaccess->fsidOf(lp, false, false, FSLogging::logExceptFileNotFound))
+        if (localNode->fsid_lastSynced != UNDEF &&
+            localNode->fsid_lastSynced == fsaccess->fsidOf(lp, false, false, FSLogging::logExceptFileNotFound))
         {
-            sourceSyncNodeCurrent = it->second;
+            sourceSyncNodeCurrent = localNode;
         }
         else
         {
-            sourceSyncNodeOriginal = it->second;
+            sourceSyncNodeOriginal = localNode;
         }
     }
 
@@ -11919,7 +11959,7 @@ bool Syncs::findLocalNodeByNodeHandle(NodeHandle h, LocalNode*& sourceSyncNodeOr
             sourceSyncNodeOriginal->type,
             sourceSyncNodeOriginal->sync->fsfp(),
             sourceSyncNodeOriginal->sync->cloudRootOwningUser,
-            sourceSyncNodeOriginal->syncedFingerprint,
+            sourceSyncNodeOriginal->syncedFingerprint(),
             FileFingerprint{}};
         std::tie(unsureDueToUnknownExclusionMoveSource, sourceSyncNodeCurrent) =
             findLocalNodeByScannedFsid(sourceSyncNodeOriginal->fsid_lastSynced,
@@ -12106,7 +12146,7 @@ bool Sync::resolve_fsNodeGone(SyncRow& row, SyncRow& /*parentRow*/, SyncPath& fu
                 const NodeMatchByFSIDAttributes syncNodeAttributes{syncNode.type,
                                                                    fsfp,
                                                                    cloudRootOwningUser,
-                                                                   syncNode.syncedFingerprint,
+                                                                   syncNode.syncedFingerprint(),
                                                                    FileFingerprint{}};
                 return syncs.findLocalNodeByScannedFsid(syncNode.fsid_lastSynced,
                                                         syncNodeAttributes,
@@ -12254,7 +12294,7 @@ bool Sync::resolve_fsNodeGone(SyncRow& row, SyncRow& /*parentRow*/, SyncPath& fu
 
                     // Node's no longer associated with any file.
                     s.setScannedFsid(UNDEF, syncs.localnodeByScannedFsid, LocalPath(), FileFingerprint());
-                    s.scannedFingerprint = FileFingerprint();
+                    s.setScannedFingerprint(FileFingerprint());
                     s.setSyncedFsid(UNDEF, syncs.localnodeBySyncedFsid, s.localname, nullptr);
 
                     // Persist above changes.
@@ -12305,8 +12345,8 @@ bool Sync::syncEqual(const CloudNode& n, const LocalNode& ln)
     if (n.type != ln.type) return false;
     if (n.type != FILENODE) return true;
     assert(n.fingerprint.isvalid);
-    return ln.syncedFingerprint.isvalid &&
-            n.fingerprint == ln.syncedFingerprint;  // size, mtime, crc
+    return ln.syncedFingerprint().isvalid &&
+            n.fingerprint == ln.syncedFingerprint();  // size, mtime, crc
 }
 
 bool Sync::syncEqual(const FSNode& fsn, const LocalNode& ln)
@@ -12317,8 +12357,8 @@ bool Sync::syncEqual(const FSNode& fsn, const LocalNode& ln)
     if (fsn.type != ln.type) return false;
     if (fsn.type != FILENODE) return true;
     assert(fsn.fingerprint.isvalid);
-    return ln.syncedFingerprint.isvalid &&
-            fsn.fingerprint == ln.syncedFingerprint;  // size, mtime, crc
+    return ln.syncedFingerprint().isvalid &&
+            fsn.fingerprint == ln.syncedFingerprint();  // size, mtime, crc
 }
 
 std::future<size_t> Syncs::triggerPeriodicScanEarly(handle backupID)
@@ -12456,9 +12496,9 @@ void Syncs::processTriggerHandles()
 
         for (;;)
         {
-            auto range = localnodeByNodeHandle.equal_range(h);
+            auto range = localnodeByNodeHandle.values(h);
 
-            if (range.first == range.second)
+            if (range.empty())
             {
                 // corresponding sync node not found.
                 // this could be a move target though, to a syncNode we have not created yet
@@ -12483,11 +12523,11 @@ void Syncs::processTriggerHandles()
             else
             {
                 // we are already being called with the handle of the parent of the thing that changed
-                for (auto it = range.first; it != range.second; ++it)
+                for (auto* localNode: range)
                 {
                     auto& syncs = *this;
-                    SYNC_verbose << mClient.clientname << "Triggering sync flag for " << it->second->getLocalPath() << (recurse ? " recursive" : "");
-                    it->second->setSyncAgain(false, true, recurse);
+                    SYNC_verbose << mClient.clientname << "Triggering sync flag for " << localNode->getLocalPath() << (recurse ? " recursive" : "");
+                    localNode->setSyncAgain(false, true, recurse);
                 }
             }
             break;
@@ -13907,7 +13947,8 @@ void Syncs::syncLoop()
                         // Lock syncVecMutexlock again
                         syncVecMutexlock.lock();
 
-                        sync->cachenodes();
+                        sync->cachenodesIfDue();
+                        sync->compactLocalNodeNames();
                     }
                 }
 
@@ -14537,11 +14578,8 @@ void Syncs::proclocaltree(LocalNode* n, LocalTreeProc* tp)
 
     if (n->type > FILENODE)
     {
-        for (localnode_map::iterator it = n->children.begin(); it != n->children.end(); )
+        for (auto* child : n->children)
         {
-            assert(it->first == it->second->localname);
-            LocalNode *child = it->second;
-            it++;
             proclocaltree(child, tp);
         }
     }
@@ -14749,7 +14787,7 @@ bool Syncs::isDefinitelyExcluded(const pair<std::shared_ptr<Node>, Sync*>& root,
             break;
 
         // Name doesn't match so we'll have to check by remote path.
-        if (node->toName_of_localname != i->second)
+        if (node->toName_of_localname.view() != i->second)
             break;
 
         // Children are definitely excluded if their parent is.
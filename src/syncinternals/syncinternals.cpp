@@ -83,8 +83,8 @@ bool FindLocalNodeByFSIDPredicate::operator()(LocalNode& localNode)
         localNode.sync->cloudRootOwningUser,
         getFingerprint(localNode),
         (mScannedOrSyncedCtxt == ScannedOrSyncedContext::SCANNED) ?
-            localNode.realScannedFingerprint :
-            localNode.syncedFingerprint};
+            localNode.realScannedFingerprint() :
+            localNode.syncedFingerprint()};
     const SourceNodeMatchByFSIDContext sourceContext{isFsidReused(localNode),
                                                      localNode.exclusionState()};
 
@@ -151,23 +151,21 @@ void FindLocalNodeByFSIDPredicate::logMsg(const std::string& msg,
 
 // Finds a LocalNode by its File System ID (FSID) in a specified map.
 // The functionality is documented for the public method findLocalNodeByFsid()
-fsid_localnode_map::const_iterator
-    findLocalNodeByFsid_if(const fsid_localnode_map& fsidLocalnodeMap,
-                           FindLocalNodeByFSIDPredicate& predicate)
+LocalNode* findLocalNodeByFsid_if(const fsid_localnode_map& fsidLocalnodeMap,
+                                  FindLocalNodeByFSIDPredicate& predicate)
 {
     if (predicate.fsid() == UNDEF)
     {
         LOG_debug << " - FSID is undef, skipping";
-        return std::end(fsidLocalnodeMap);
+        return nullptr;
     }
 
     // Iterate over all nodes with the given FSID
-    const auto [begin, end] = fsidLocalnodeMap.equal_range(predicate.fsid());
+    const auto [begin, end] = fsidLocalnodeMap.values(predicate.fsid());
     const auto it = std::find_if(begin,
                                  end,
-                                 [&predicate](const auto& pair) -> bool
+                                 [&predicate](LocalNode* localNode) -> bool
                                  {
-                                     const auto& localNode = pair.second;
                                      if (!localNode || !localNode->sync)
                                      {
                                          assert(false && "Invalid LocalNode or its sync");
@@ -176,14 +174,13 @@ fsid_localnode_map::const_iterator
                                      return predicate(*localNode);
                                  });
     predicate.resetEarlyExit();
-    return it == end ? std::end(fsidLocalnodeMap) : it;
+    return it == end ? nullptr : *it;
 }
 
 std::pair<bool, LocalNode*> findLocalNodeByFsid(const fsid_localnode_map& fsidLocalnodeMap,
                                                 FindLocalNodeByFSIDPredicate&& predicate)
 {
-    const auto it = findLocalNodeByFsid_if(fsidLocalnodeMap, predicate);
-    const auto& matchedNodePtr = it != std::end(fsidLocalnodeMap) ? it->second : nullptr;
+    auto matchedNodePtr = findLocalNodeByFsid_if(fsidLocalnodeMap, predicate);
 
     return {predicate.foundExclusionUnknown(), matchedNodePtr};
 }
@@ -0,0 +1,103 @@
+/**
+ * @file syncnamearena.cpp
+ * @brief Storage for the names of the LocalNodes of a sync.
+ */
+
+#ifdef ENABLE_SYNC
+
+#include "mega/syncinternals/syncnamearena.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace mega
+{
+
+namespace
+{
+// large enough for a few thousand names, small enough not to matter for tiny syncs
+constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+// below this, released names are left alone
+constexpr size_t MIN_RELEASED_TO_COMPACT = 1024 * 1024;
+} // namespace
+
+size_t SyncNameArena::Name::size() const
+{
+    if (!mData)
+    {
+        return 0;
+    }
+
+    uint32_t size;
+    memcpy(&size, mData - sizeof(size), sizeof(size));
+    return size;
+}
+
+void SyncNameArena::assign(Name& name, std::string_view value)
+{
+    release(name);
+
+    if (value.empty())
+    {
+        return;
+    }
+
+    assert(value.size() <= UINT32_MAX);
+    const auto bytes = footprint(value.size());
+
+    char* p;
+    if (bytes > BLOCK_SIZE / 4)
+    {
+        // a block of its own, so the free space of the current one is not lost
+        mBlocks.emplace_back(new char[bytes]);
+        p = mBlocks.back().get();
+        mStats.allocatedBytes += bytes;
+    }
+    else
+    {
+        if (mFreeSize < bytes)
+        {
+            mBlocks.emplace_back(new char[BLOCK_SIZE]);
+            mFree = mBlocks.back().get();
+            mFreeSize = BLOCK_SIZE;
+            mStats.allocatedBytes += BLOCK_SIZE;
+        }
+        p = mFree;
+        mFree += bytes;
+        mFreeSize -= bytes;
+    }
+
+    const auto size = static_cast<uint32_t>(value.size());
+    memcpy(p, &size, sizeof(size));
+    memcpy(p + sizeof(size), value.data(), value.size());
+    name = Name(p + sizeof(size));
+
+    ++mStats.names;
+    mStats.usedBytes += bytes;
+}
+
+void SyncNameArena::release(Name& name)
+{
+    if (name.empty())
+    {
+        return;
+    }
+
+    const auto bytes = footprint(name.size());
+    assert(mStats.names && mStats.usedBytes >= bytes);
+    --mStats.names;
+    mStats.usedBytes -= bytes;
+    mStats.releasedBytes += bytes;
+    name = Name();
+}
+
+bool SyncNameArena::wantsCompaction() const
+{
+    return mStats.releasedBytes >= MIN_RELEASED_TO_COMPACT &&
+           mStats.releasedBytes > mStats.usedBytes;
+}
+
+} // namespace mega
+
+#endif // ENABLE_SYNC
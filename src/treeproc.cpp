@@ -119,6 +119,19 @@ void LocalTreeProcMove::proc(FileSystemAccess&, LocalNode* localnode)
     if (newsync != localnode->sync)
     {
         localnode->sync->statecachedel(localnode);
+
+        // the name goes to the arena of its new sync
+        SyncNameArena::Name name;
+        newsync->mLocalNodeNames.assign(name, localnode->toName_of_localname);
+        localnode->sync->mLocalNodeNames.release(localnode->toName_of_localname);
+        localnode->toName_of_localname = name;
+
+        if (localnode->sync->mCaseInsensitive != newsync->mCaseInsensitive)
+        {
+            // the children are kept in the order of the sync's case sensitivity
+            localnode->children.resort(newsync->mCaseInsensitive);
+        }
+
         localnode->sync = newsync;
         newsync->statecacheadd(localnode);
     }
@@ -343,7 +343,7 @@ void CacheableWriter::serializeexpansionflags(bool b0, bool b1, bool b2, bool b3
 }
 
 
-CacheableReader::CacheableReader(const string& d)
+CacheableReader::CacheableReader(std::string_view d)
     : ptr(d.data())
     , end(ptr + d.size())
     , fieldnum(0)
@@ -3849,6 +3849,55 @@ bool likeCompare(const char* pattern, const char* str, const UChar32 esc, bool s
                                             stripAccents));
 }
 
+std::string foldCaseAndAccents(const std::string& text)
+{
+    // same decomposition as foldCaseAccentEqual() with stripAccents
+    const auto options =
+        static_cast<utf8proc_option_t>(UTF8PROC_CASEFOLD | UTF8PROC_COMPOSE | UTF8PROC_NULLTERM |
+                                       UTF8PROC_STABLE | UTF8PROC_STRIPMARK);
+    std::array<utf8proc_int32_t, 8> decomposed;
+    utf8proc_uint8_t encoded[4];
+
+    std::string folded;
+    folded.reserve(text.size());
+
+    auto data = reinterpret_cast<const utf8proc_uint8_t*>(text.data());
+    auto remaining = static_cast<utf8proc_ssize_t>(text.size());
+    while (remaining > 0)
+    {
+        utf8proc_int32_t codePoint;
+        const utf8proc_ssize_t length = utf8proc_iterate(data, remaining, &codePoint);
+        if (length <= 0)
+        {
+            // invalid UTF-8: keep the byte as is
+            folded.push_back(static_cast<char>(*data));
+            ++data;
+            --remaining;
+            continue;
+        }
+        data += length;
+        remaining -= length;
+
+        const auto capacity = static_cast<utf8proc_ssize_t>(decomposed.size());
+        utf8proc_ssize_t count =
+            utf8proc_decompose_char(codePoint, decomposed.data(), capacity, options, nullptr);
+        if (count < 0 || count > capacity)
+        {
+            decomposed[0] = codePoint;
+            count = 1;
+        }
+
+        for (utf8proc_ssize_t i = 0; i < count; ++i)
+        {
+            const utf8proc_ssize_t bytes =
+                utf8proc_encode_char(decomposed[static_cast<size_t>(i)], encoded);
+            folded.append(reinterpret_cast<const char*>(encoded), static_cast<size_t>(bytes));
+        }
+    }
+
+    return folded;
+}
+
 // Get the current process ID
 unsigned long getCurrentPid()
 {
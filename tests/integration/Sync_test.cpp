@@ -813,11 +813,11 @@ public:
                 return false;
 
             // Queue children.
-            for (auto& childIt : node.children)
+            for (auto* child : node.children)
             {
                 // But only those that've been written to disk.
-                if (childIt.second->dbid)
-                    pending.emplace_back(childIt.second);
+                if (child->dbid)
+                    pending.emplace_back(child);
             }
         }
 
@@ -933,9 +933,9 @@ private:
         // Is the node's parent-child linkage consistent with the cache?
         size_t nChildren = 0;
 
-        for (auto& childIt : node.children)
+        for (auto* childPtr : node.children)
         {
-            auto& child = *childIt.second;
+            auto& child = *childPtr;
 
             // Skip children that haven't been written to disk.
             if (!child.dbid)
@@ -981,8 +981,8 @@ private:
         auto& entry = *mNodeMap.at(node.dbid);
 
         // This attribute is only meaningful for files.
-        auto& lfp = node.syncedFingerprint;
-        auto& rfp = entry.syncedFingerprint;
+        auto& lfp = node.syncedFingerprint();
+        auto& rfp = entry.syncedFingerprint();
 
         if (lfp.isvalid != rfp.isvalid)
         {
@@ -3578,12 +3578,12 @@ bool StandardClient::recursiveConfirm(Model::ModelNode* mn, LocalNode* n, int& d
 
         ms.emplace(m->fsName(), m.get());
     }
-    for (auto& n2 : n->children)
+    for (auto* n2 : n->children)
     {
-        if (skipIgnoreFile && n2.second->isIgnoreFile())
+        if (skipIgnoreFile && n2->isIgnoreFile())
             continue;
 
-        ns.emplace(n2.second->localname.toPath(false), n2.second); // todo: should LocalNodes marked as deleted actually have been removed by now?
+        ns.emplace(n2->localname.toPath(false), n2); // todo: should LocalNodes marked as deleted actually have been removed by now?
     }
 
     int matched = 0;
@@ -11379,9 +11379,9 @@ struct TwoWaySyncSymmetryCase
 
         if (node.type == FILENODE) return;
 
-        for (const auto& childIt : node.children)
+        for (const auto* child : node.children)
         {
-            PrintLocalTree(*childIt.second);
+            PrintLocalTree(*child);
         }
     }
 
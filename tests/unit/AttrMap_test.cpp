@@ -19,9 +19,12 @@
 #include <gtest/gtest.h>
 #include <mega/attrmap.h>
 
+#include <algorithm>
+#include <chrono>
 #include <map>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using namespace mega;
 
@@ -113,3 +116,128 @@ TEST(AttrMap, applyUpdatesWithNestedFields)
     expected = toAttrMap({{"b", "hello"}, {"c", "world"}});
     EXPECT_EQ(baseMap.map, expected.map);
 }
+
+TEST(AttrMap, entriesAreKeptSortedByName)
+{
+    const auto n = AttrMap::string2nameid("n");
+    const auto c = AttrMap::string2nameid("c");
+    const auto lbl = AttrMap::string2nameid("lbl");
+    const auto fav = AttrMap::string2nameid("fav");
+
+    attr_map m;
+    m[n] = "name";
+    m[lbl] = "1";
+    m[c] = "fingerprint";
+    EXPECT_FALSE(m.emplace(n, "other").second);
+    EXPECT_TRUE(m.emplace(fav, "1").second);
+
+    std::map<nameid, std::string> expected{{n, "name"}, {lbl, "1"}, {c, "fingerprint"}, {fav, "1"}};
+    ASSERT_EQ(m.size(), expected.size());
+    EXPECT_TRUE(std::equal(m.begin(),
+                           m.end(),
+                           expected.begin(),
+                           [](const auto& a, const auto& b)
+                           {
+                               return a.first == b.first && a.second == b.second;
+                           }));
+
+    EXPECT_EQ(m.at(n), "name");
+    EXPECT_THROW(m.at(AttrMap::string2nameid("t")), std::out_of_range);
+    EXPECT_EQ(m.find(AttrMap::string2nameid("t")), m.end());
+
+    EXPECT_EQ(m.erase(lbl), 1u);
+    EXPECT_EQ(m.erase(lbl), 0u);
+    EXPECT_FALSE(m.contains(lbl));
+    expected.erase(lbl);
+
+    // equality does not depend on the insertion order
+    EXPECT_EQ(m, attr_map(std::move(expected)));
+}
+
+namespace
+{
+// attributes as typically found in a node: name, fingerprint and sometimes label/favourite
+std::vector<std::pair<nameid, std::string>> makeNodeAttributes(size_t i)
+{
+    std::vector<std::pair<nameid, std::string>> attrs{
+        {AttrMap::string2nameid("n"), "file_" + std::to_string(i) + ".jpg"},
+        {AttrMap::string2nameid("c"), "Q2hlY2tzdW1GaW5nZXJwcmludAbCdEfGh"}};
+    if (i % 3 == 0)
+    {
+        attrs.emplace_back(AttrMap::string2nameid("lbl"), "2");
+    }
+    if (i % 5 == 0)
+    {
+        attrs.emplace_back(AttrMap::string2nameid("fav"), "1");
+    }
+    return attrs;
+}
+
+// the heap taken by the entries of a std::map: a tree node per entry
+// (3 pointers and the colour, rounded up) plus the value
+size_t treeBytes(const std::map<nameid, std::string>& m)
+{
+    return sizeof(m) + m.size() * (32 + sizeof(std::pair<const nameid, std::string>));
+}
+
+// a single block for all the entries, with the capacity doubling as they are added
+size_t flatBytes(const attr_map& m)
+{
+    size_t capacity = m.empty() ? 0 : 1;
+    while (capacity < m.size())
+    {
+        capacity *= 2;
+    }
+    return sizeof(m) + capacity * sizeof(attr_map::value_type);
+}
+} // namespace
+
+// Memory and time taken to load and query the attributes of many nodes, compared with std::map.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(AttrMap, DISABLED_PerfNodeAttributesLoad)
+{
+    constexpr size_t NODES = 1000000;
+    std::vector<std::vector<std::pair<nameid, std::string>>> source;
+    source.reserve(NODES);
+    for (size_t i = 0; i < NODES; ++i)
+    {
+        source.emplace_back(makeNodeAttributes(i));
+    }
+
+    const auto n = AttrMap::string2nameid("n");
+    const auto fav = AttrMap::string2nameid("fav");
+
+    auto load = [&](auto& maps, size_t& bytes, size_t& found, auto sizeOf)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        maps.resize(NODES);
+        for (size_t i = 0; i < NODES; ++i)
+        {
+            for (const auto& [k, v]: source[i])
+            {
+                maps[i][k] = v;
+            }
+        }
+        for (const auto& m: maps)
+        {
+            found += m.find(n) != m.end();
+            found += m.find(fav) != m.end();
+            bytes += sizeOf(m);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    };
+
+    size_t treeTotal = 0, treeFound = 0;
+    std::vector<std::map<nameid, std::string>> trees;
+    const auto treeMs = load(trees, treeTotal, treeFound, treeBytes);
+
+    size_t flatTotal = 0, flatFound = 0;
+    std::vector<attr_map> flats;
+    const auto flatMs = load(flats, flatTotal, flatFound, flatBytes);
+
+    EXPECT_EQ(treeFound, flatFound);
+    GTEST_LOG_(INFO) << "AttrMap load+lookup [" << NODES << " nodes]: std::map " << treeMs
+                     << " ms, ~" << treeTotal / NODES << " bytes/node; attr_map " << flatMs
+                     << " ms, ~" << flatTotal / NODES << " bytes/node";
+}
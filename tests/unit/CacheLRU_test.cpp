@@ -28,6 +28,8 @@
 #include <mega/user.h>
 #include <mega/utils.h>
 
+#include <deque>
+
 class CacheLRU: public testing::Test
 {
 protected:
@@ -718,6 +720,34 @@ TEST_F(CacheLRU, getChildren)
     ASSERT_EQ(children.size(), numNodesForFolder[0]);
 }
 
+// During fetchnodes the nodes are written to the DB in batches: the ones pending to be written
+// must still be found by the look-ups, which read them from the DB
+TEST_F(CacheLRU, getNodesSavedWhileFetching)
+{
+    auto rootNode = init(8);
+    auto& nodeMgr = mClient->mNodeManager;
+    auto folder = addNode(mega::nodetype_t::FOLDERNODE, rootNode, false, true);
+
+    mClient->fetchingnodes = true;
+    constexpr uint32_t numFiles = 20;
+    std::vector<mega::NodeHandle> handles;
+    for (uint32_t i = 0; i < numFiles; i++)
+    {
+        // below the first level of the Cloud Drive, so not kept in RAM
+        handles.push_back(addNode(mega::nodetype_t::FILENODE, folder, false, true)->nodeHandle());
+    }
+
+    ASSERT_EQ(nodeMgr.getNumberOfChildrenFromNode(folder->nodeHandle()), numFiles);
+    for (const auto& handle: handles)
+    {
+        auto node = nodeMgr.getNodeByHandle(handle);
+        ASSERT_NE(node, nullptr);
+        ASSERT_EQ(node->parentHandle(), folder->nodeHandle());
+    }
+    ASSERT_EQ(nodeMgr.getChildren(folder.get()).size(), numFiles);
+    mClient->fetchingnodes = false;
+}
+
 TEST_F(CacheLRU, getNodeByHandle)
 {
     auto rootNode = init(8);
@@ -764,18 +794,192 @@ TEST_F(CacheLRU, getNodeByHandle)
     // Node at RAM and LRU
     auto auxiliarNode = nodeMgr.getNodeByHandle(lasttNodeHandle);
     ASSERT_NE(auxiliarNode, nullptr);
-    ASSERT_NE(auxiliarNode->mNodePosition->second.mLRUPosition, nodeMgr.invalidCacheLRUPos());
+    ASSERT_TRUE(auxiliarNode->mNodePosition->second.isInCacheLRU());
     node = nodeMgr.getNodeByHandle(lasttNodeHandle);
     ASSERT_EQ(auxiliarNode.get(), node.get());
 
     // Node at RAM, no at LRU
     // ASSERT_NE(client->mNodeManager.getNodeInRAM(nodeInRAMHandle).get(), nullptr);
     ASSERT_NE(nodeInRAM, nullptr);
-    ASSERT_EQ(nodeInRAM->mNodePosition->second.mLRUPosition, nodeMgr.invalidCacheLRUPos());
+    ASSERT_FALSE(nodeInRAM->mNodePosition->second.isInCacheLRU());
     node = nodeMgr.getNodeByHandle(nodeInRAMHandle);
     ASSERT_EQ(nodeInRAM.get(), node.get());
 }
 
+TEST_F(CacheLRU, getNodeByHandleFromSeveralThreads)
+{
+    auto rootNode = init(8);
+    auto folder = addNode(mega::nodetype_t::FOLDERNODE, rootNode, false, true);
+
+    std::vector<std::shared_ptr<mega::Node>> nodes;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        nodes.push_back(addNode(mega::nodetype_t::FILENODE,
+                                folder,
+                                true,
+                                false,
+                                [this](mega::Node& file)
+                                {
+                                    file.size = static_cast<m_off_t>(mIndex);
+                                    file.attrs.map = std::map<mega::nameid, std::string>{
+                                        {110, "name" + std::to_string(mIndex)}};
+                                }));
+    }
+
+    // Nodes loaded in RAM are resolved to the same objects from any thread
+    auto& nodeMgr = mClient->mNodeManager;
+    std::atomic<unsigned> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+    {
+        readers.emplace_back(
+            [&nodeMgr, &nodes, &mismatches]()
+            {
+                for (int i = 0; i < 1000; i++)
+                {
+                    for (const auto& n: nodes)
+                    {
+                        if (nodeMgr.getNodeByHandle(n->nodeHandle()) != n)
+                        {
+                            ++mismatches;
+                        }
+                    }
+                }
+            });
+    }
+
+    for (auto& reader: readers)
+    {
+        reader.join();
+    }
+    ASSERT_EQ(mismatches, 0u);
+
+    // A removed node isn't returned anymore, even if the app still keeps a reference to it
+    std::shared_ptr<mega::Node> removedNode = nodes.back();
+    mega::NodeHandle removedHandle = removedNode->nodeHandle();
+    nodes.pop_back();
+    removedNode->changed.removed = true;
+    nodeMgr.notifyNode(removedNode);
+    nodeMgr.notifyPurge();
+    ASSERT_EQ(nodeMgr.getNodeByHandle(removedHandle), nullptr);
+}
+
+TEST_F(CacheLRU, getNodeByHandleWhileNodesChange)
+{
+    auto rootNode = init(8);
+    auto folder = addNode(mega::nodetype_t::FOLDERNODE, rootNode, false, true);
+
+    std::vector<std::shared_ptr<mega::Node>> nodes;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        nodes.push_back(addNode(mega::nodetype_t::FILENODE, folder, true, false));
+    }
+
+    // Readers look nodes up without mMutex while this thread adds nodes, loads evicted ones
+    // from the DB and purges them, changing the entries of mNodes (run with ENABLE_TSAN)
+    auto& nodeMgr = mClient->mNodeManager;
+    std::atomic<uint64_t> newest{mega::UNDEF};
+    std::atomic<bool> writing{true};
+    std::atomic<unsigned> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+    {
+        readers.emplace_back(
+            [&nodeMgr, &nodes, &newest, &writing, &mismatches]()
+            {
+                while (writing)
+                {
+                    for (const auto& n: nodes)
+                    {
+                        if (nodeMgr.getNodeByHandle(n->nodeHandle()) != n)
+                        {
+                            ++mismatches;
+                        }
+                    }
+
+                    // added a moment ago, and maybe purged already
+                    mega::NodeHandle handle;
+                    handle.set6byte(newest);
+                    auto node = nodeMgr.getNodeByHandle(handle);
+                    if (node && node->nodeHandle() != handle)
+                    {
+                        ++mismatches;
+                    }
+                }
+            });
+    }
+
+    std::deque<mega::NodeHandle> parked;
+    for (int i = 0; i < 300; i++)
+    {
+        auto file = addNode(mega::nodetype_t::FILENODE, folder, true, false);
+        nodeMgr.notifyPurge();
+        newest = file->nodeHandle().as8byte();
+        parked.push_back(file->nodeHandle());
+        file.reset();
+
+        // evicted from the LRU by now: loaded again from the DB, and purged
+        if (parked.size() > mLruSize + 1)
+        {
+            auto old = nodeMgr.getNodeByHandle(parked.front());
+            parked.pop_front();
+            if (!old)
+            {
+                ++mismatches;
+                continue;
+            }
+            old->changed.removed = true;
+            nodeMgr.notifyNode(old);
+            nodeMgr.notifyPurge();
+        }
+    }
+    writing = false;
+
+    for (auto& reader: readers)
+    {
+        reader.join();
+    }
+    ASSERT_EQ(mismatches, 0u);
+}
+
+TEST_F(CacheLRU, cacheLRUStats)
+{
+    auto rootNode = init(4);
+    auto folder = addNode(mega::nodetype_t::FOLDERNODE, rootNode, false, true);
+
+    auto& nodeMgr = mClient->mNodeManager;
+    std::vector<mega::NodeHandle> handles;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        handles.push_back(addNode(mega::nodetype_t::FILENODE,
+                                  folder,
+                                  true,
+                                  false,
+                                  [this](mega::Node& file)
+                                  {
+                                      file.size = static_cast<m_off_t>(mIndex);
+                                  })
+                              ->nodeHandle());
+    }
+    // Only the last nodes fit in the LRU, the rest have been evicted
+    ASSERT_EQ(numNodesInCacheLru(), mLruSize);
+    const auto initial = nodeMgr.getCacheLRUStats();
+    ASSERT_GE(initial.evictions, handles.size() - mLruSize);
+
+    // Most recent node is in RAM: hit
+    ASSERT_NE(nodeMgr.getNodeByHandle(handles.back()), nullptr);
+    auto stats = nodeMgr.getCacheLRUStats();
+    ASSERT_EQ(stats.hits, initial.hits + 1);
+    ASSERT_EQ(stats.misses, initial.misses);
+
+    // First node was evicted: miss, it's loaded from DB and other nodes are evicted
+    ASSERT_NE(nodeMgr.getNodeByHandle(handles.front()), nullptr);
+    stats = nodeMgr.getCacheLRUStats();
+    ASSERT_EQ(stats.misses, initial.misses + 1);
+    ASSERT_GT(stats.evictions, initial.evictions);
+    ASSERT_EQ(numNodesInCacheLru(), mLruSize);
+}
+
 TEST_F(CacheLRU, childNodeByNameType)
 {
     auto rootNode = init(8);
@@ -157,8 +157,7 @@ protected:
     // Convenience: is node currently in the LRU cache?
     bool isInLru(const std::shared_ptr<Node>& node) const
     {
-        return node && node->mNodePosition->second.mLRUPosition !=
-                           mClient->mNodeManager.invalidCacheLRUPos();
+        return node && node->mNodePosition->second.isInCacheLRU();
     }
 
     // Configures the two knobs that drive which path childNodeByNameType
@@ -303,7 +302,7 @@ TEST_F(ChildNodeLookupTest, SmallDir_TraversalDoesNotUpdateLruForNonMatched)
     // at least one would have been pulled back in.
     for (Node* c: evictedBefore)
     {
-        EXPECT_EQ(c->mNodePosition->second.mLRUPosition, nodeMgr().invalidCacheLRUPos())
+        EXPECT_FALSE(c->mNodePosition->second.isInCacheLRU())
             << "Traversal must not re-insert non-matched node '" << c->displayname()
             << "' into LRU";
     }
@@ -83,6 +83,11 @@ public:
         return 0;
     }
 
+    bool getNodeTreeEntries(std::vector<mega::NodeTreeEntry>&) override
+    {
+        return false;
+    }
+
     bool getChildren(const mega::NodeSearchFilter&,
                      int,
                      std::vector<std::pair<mega::NodeHandle, mega::NodeSerialized>>&,
@@ -172,13 +177,42 @@ public:
     {}
 
     void createIndexes(bool /*enableIndexesForSearching*/,
-                       bool /*enableIndexesForLexicographicalList*/) override
+                       bool /*enableIndexesForLexicographicalList*/,
+                       bool /*enableFullTextIndex*/,
+                       bool /*enableAncestorIndex*/) override
+    {}
+
+    void scheduleIndexes(bool /*enableIndexesForSearching*/,
+                         bool /*enableIndexesForLexicographicalList*/,
+                         bool /*enableFullTextIndex*/,
+                         bool /*enableAncestorIndex*/) override
     {}
 
+    bool createNextPendingIndex() override
+    {
+        return false;
+    }
+
+    bool isIndexReady(mega::NodesIndex) const override
+    {
+        return true;
+    }
+
+    void dropIndexesForBulkLoad() override {}
+
     void dropSearchDBIndexes() override {}
 
     void dropLexicographicDBIndexes() override {}
 
+    void dropFullTextDBIndex() override {}
+
+    void dropAncestorDBIndex() override {}
+
+    std::unique_ptr<mega::DBTableNodesReader> acquireReader() override
+    {
+        return nullptr;
+    }
+
     bool put(uint32_t, char*, unsigned) override
     {
         return false;
@@ -189,6 +223,11 @@ public:
         return false;
         //throw NotImplemented{__func__};
     }
+    bool putBatch(const std::vector<mega::Node*>&) override
+    {
+        return false;
+        //throw NotImplemented{__func__};
+    }
     bool del(uint32_t) override
     {
         return false;
@@ -0,0 +1,256 @@
+/**
+ * @file HandleMultiIndex_test.cpp
+ * @brief Unit tests for HandleMultiIndex
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include <gtest/gtest.h>
+#include <mega/handlemultiindex.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace mega;
+
+namespace
+{
+struct Item
+{
+    int id = 0;
+};
+
+using Index = HandleMultiIndex<uint64_t, Item>;
+
+std::vector<Item*> valuesOf(const Index& index, uint64_t key)
+{
+    std::vector<Item*> values;
+    for (auto* value: index.values(key))
+    {
+        values.push_back(value);
+    }
+    return values;
+}
+} // namespace
+
+TEST(HandleMultiIndex, FindsEveryValueOfAKey)
+{
+    std::vector<Item> items(1000);
+    Index index;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        items[i].id = static_cast<int>(i);
+        index.insert(i * 4096, &items[i]);
+    }
+    ASSERT_EQ(index.size(), items.size());
+
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        EXPECT_EQ(valuesOf(index, i * 4096), std::vector<Item*>{&items[i]});
+    }
+    EXPECT_FALSE(index.contains(1));
+    EXPECT_TRUE(index.values(4096 * 1000).empty());
+    EXPECT_TRUE(Index().values(0).empty());
+}
+
+TEST(HandleMultiIndex, RepeatedKeysKeepTheirOrder)
+{
+    // the same fsid on several filesystems, mixed with many other keys
+    std::vector<Item> items(5000);
+    std::multimap<uint64_t, Item*> expected;
+    Index index;
+    std::mt19937 rng(3);
+    for (auto& item: items)
+    {
+        uint64_t key = rng() % 300;
+        index.insert(key, &item);
+        expected.emplace(key, &item);
+    }
+
+    // removing some of them, the index grows and shrinks
+    for (size_t i = 0; i < items.size(); i += 3)
+    {
+        auto range = expected.equal_range(static_cast<uint64_t>(i) % 300);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == &items[i])
+            {
+                EXPECT_TRUE(index.erase(it->first, it->second));
+                expected.erase(it);
+                break;
+            }
+        }
+    }
+
+    for (uint64_t key = 0; key < 300; ++key)
+    {
+        std::vector<Item*> inOrder;
+        auto range = expected.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            inOrder.push_back(it->second);
+        }
+        EXPECT_EQ(valuesOf(index, key), inOrder) << "key " << key;
+    }
+    EXPECT_EQ(index.size(), expected.size());
+}
+
+TEST(HandleMultiIndex, EraseOnlyThatValue)
+{
+    Item a, b, c;
+    Index index;
+    index.insert(7, &a);
+    index.insert(7, &b);
+    index.insert(8, &c);
+
+    EXPECT_FALSE(index.erase(8, &a));
+    EXPECT_FALSE(index.erase(9, &c));
+    EXPECT_TRUE(index.erase(7, &a));
+    EXPECT_FALSE(index.erase(7, &a));
+    EXPECT_EQ(valuesOf(index, 7), std::vector<Item*>{&b});
+    EXPECT_EQ(valuesOf(index, 8), std::vector<Item*>{&c});
+
+    index.clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_FALSE(index.contains(8));
+}
+
+TEST(HandleMultiIndex, ReleasesMemoryWhenEmptied)
+{
+    std::vector<Item> items(100000);
+    Index index;
+    const auto emptyBytes = index.memoryUsage();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        index.insert(i, &items[i]);
+    }
+    const auto fullBytes = index.memoryUsage();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        ASSERT_TRUE(index.erase(i, &items[i]));
+    }
+    EXPECT_TRUE(index.empty());
+    EXPECT_LT(index.memoryUsage(), fullBytes / 1000);
+    EXPECT_GE(index.memoryUsage(), emptyBytes);
+}
+
+namespace
+{
+// glibc-like heap block for an allocation of 'n' bytes
+size_t heapBlock(size_t n)
+{
+    return std::max<size_t>(32, (n + 8 + 15) & ~size_t(15));
+}
+
+// fsids as inode numbers: mostly consecutive, a few of them repeated by other filesystems
+std::vector<uint64_t> makeFsids(size_t count)
+{
+    std::vector<uint64_t> fsids;
+    fsids.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        fsids.push_back(i % 50 ? 1000000 + i : 1000000 + i / 50);
+    }
+    std::shuffle(fsids.begin(), fsids.end(), std::mt19937(5));
+    return fsids;
+}
+} // namespace
+
+// Memory and time taken by the index of the LocalNodes by fsid for syncs of 1M and 5M files, as
+// std::multimap and as HandleMultiIndex: adding all of them, looking them up (as move detection
+// does) and removing them.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(HandleMultiIndex, DISABLED_ReportMemoryAndLookups)
+{
+    using ms = std::chrono::duration<double, std::milli>;
+
+    for (size_t nodes: {1000000u, 5000000u})
+    {
+        const auto fsids = makeFsids(nodes);
+        std::vector<Item> items(nodes);
+
+        std::multimap<uint64_t, Item*> tree;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodes; ++i)
+        {
+            tree.emplace(fsids[i], &items[i]);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        size_t treeFound = 0;
+        for (auto fsid: fsids)
+        {
+            auto range = tree.equal_range(fsid);
+            treeFound += static_cast<size_t>(std::distance(range.first, range.second));
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodes; ++i)
+        {
+            auto range = tree.equal_range(fsids[i]);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == &items[i])
+                {
+                    tree.erase(it);
+                    break;
+                }
+            }
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        const size_t treeBytes =
+            sizeof(tree) + nodes * heapBlock(4 * sizeof(void*) + sizeof(std::pair<uint64_t, Item*>));
+
+        Index index;
+        auto t4 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodes; ++i)
+        {
+            index.insert(fsids[i], &items[i]);
+        }
+        auto t5 = std::chrono::steady_clock::now();
+        size_t indexFound = 0;
+        for (auto fsid: fsids)
+        {
+            for (auto* item: index.values(fsid))
+            {
+                ++indexFound;
+                (void)item;
+            }
+        }
+        auto t6 = std::chrono::steady_clock::now();
+        const size_t indexBytes = index.memoryUsage();
+        for (size_t i = 0; i < nodes; ++i)
+        {
+            index.erase(fsids[i], &items[i]);
+        }
+        auto t7 = std::chrono::steady_clock::now();
+
+        ASSERT_EQ(treeFound, indexFound);
+        ASSERT_TRUE(tree.empty());
+        ASSERT_TRUE(index.empty());
+
+        GTEST_LOG_(INFO) << "Fsid index of " << nodes << " LocalNodes: std::multimap ~"
+                         << treeBytes / nodes << " bytes/node, insert " << ms(t1 - t0).count()
+                         << " ms, lookup " << ms(t2 - t1).count() << " ms, erase "
+                         << ms(t3 - t2).count() << " ms; HandleMultiIndex ~"
+                         << indexBytes / nodes << " bytes/node, insert " << ms(t5 - t4).count()
+                         << " ms, lookup " << ms(t6 - t5).count() << " ms, erase "
+                         << ms(t7 - t6).count() << " ms";
+    }
+}
@@ -0,0 +1,261 @@
+/**
+ * @file LocalNodeLayout_test.cpp
+ * @brief Tests for the compact storage of the names and fingerprints of the LocalNodes.
+ */
+
+#ifdef ENABLE_SYNC
+
+#include <gtest/gtest.h>
+#include <mega/node.h>
+#include <mega/syncinternals/scannedfingerprints.h>
+#include <mega/syncinternals/syncnamearena.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mega;
+
+namespace
+{
+
+FileFingerprint makeFingerprint(m_off_t size, m_time_t mtime)
+{
+    FileFingerprint fingerprint;
+    fingerprint.size = size;
+    fingerprint.mtime = mtime;
+    fingerprint.crc = {1, 2, 3, static_cast<int32_t>(size)};
+    fingerprint.isvalid = true;
+    return fingerprint;
+}
+
+} // namespace
+
+TEST(ScannedFingerprints, BlankUntilScanned)
+{
+    FileFingerprint synced;
+    ScannedFingerprints fingerprints;
+
+    EXPECT_FALSE(fingerprints.scanned(synced).isvalid);
+    EXPECT_FALSE(fingerprints.realScanned(synced).isvalid);
+    EXPECT_EQ(fingerprints.allocatedBytes(), 0u);
+}
+
+TEST(ScannedFingerprints, SharedWithTheSyncedOne)
+{
+    auto synced = makeFingerprint(100, 1000);
+    ScannedFingerprints fingerprints;
+
+    fingerprints.setScanned(synced, synced);
+    EXPECT_EQ(&fingerprints.scanned(synced), &synced);
+    EXPECT_EQ(&fingerprints.realScanned(synced), &synced);
+    EXPECT_EQ(fingerprints.allocatedBytes(), 0u);
+}
+
+TEST(ScannedFingerprints, CopiedWhenTheSyncedOneChanges)
+{
+    auto synced = makeFingerprint(100, 1000);
+    ScannedFingerprints fingerprints;
+    fingerprints.setScanned(synced, synced);
+
+    // the file was uploaded again: the scan keeps its value
+    auto next = makeFingerprint(200, 2000);
+    fingerprints.syncedChanging(synced, next);
+    auto previous = synced;
+    synced = next;
+    fingerprints.syncedChanged(synced);
+
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.scanned(synced), previous));
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.realScanned(synced), previous));
+    EXPECT_EQ(fingerprints.allocatedBytes(), sizeof(FileFingerprint));
+
+    // and shares it again once they match
+    fingerprints.setScanned(next, synced);
+    EXPECT_EQ(&fingerprints.scanned(synced), &synced);
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.realScanned(synced), previous));
+
+    fingerprints.setRealScanned(next, synced);
+    EXPECT_EQ(&fingerprints.realScanned(synced), &synced);
+    EXPECT_EQ(fingerprints.allocatedBytes(), 0u);
+}
+
+TEST(ScannedFingerprints, RealScannedKeptApartOnlyWhenDifferent)
+{
+    auto synced = makeFingerprint(100, 1000);
+    ScannedFingerprints fingerprints;
+    fingerprints.setScanned(synced, synced);
+
+    // as on Android, where the mtime of a download can't be set on disk
+    auto onDisk = makeFingerprint(100, 1500);
+    fingerprints.setRealScanned(onDisk, synced);
+    EXPECT_EQ(&fingerprints.scanned(synced), &synced);
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.realScanned(synced), onDisk));
+    EXPECT_EQ(fingerprints.allocatedBytes(), sizeof(FileFingerprint));
+
+    // a new scan doesn't change what the filesystem reported
+    auto rescanned = makeFingerprint(300, 3000);
+    fingerprints.setScanned(rescanned, synced);
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.scanned(synced), rescanned));
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.realScanned(synced), onDisk));
+
+    fingerprints.setRealScanned(rescanned, synced);
+    EXPECT_EQ(&fingerprints.realScanned(synced), &fingerprints.scanned(synced));
+    EXPECT_EQ(fingerprints.allocatedBytes(), sizeof(FileFingerprint));
+}
+
+TEST(ScannedFingerprints, SettingScannedKeepsTheRealOne)
+{
+    auto synced = makeFingerprint(100, 1000);
+    ScannedFingerprints fingerprints;
+    fingerprints.setScanned(synced, synced);
+
+    fingerprints.setScanned(FileFingerprint(), synced);
+    EXPECT_FALSE(fingerprints.scanned(synced).isvalid);
+    EXPECT_TRUE(ScannedFingerprints::same(fingerprints.realScanned(synced), synced));
+
+    fingerprints.setRealScanned(FileFingerprint(), synced);
+    EXPECT_FALSE(fingerprints.realScanned(synced).isvalid);
+    EXPECT_EQ(fingerprints.allocatedBytes(), 0u);
+}
+
+TEST(SyncNameArena, AssignAndRelease)
+{
+    SyncNameArena arena;
+    SyncNameArena::Name a, b, empty;
+
+    arena.assign(a, "photo.jpg");
+    arena.assign(b, std::string(100000, 'x'));
+    arena.assign(empty, "");
+
+    EXPECT_EQ(a.view(), "photo.jpg");
+    EXPECT_EQ(b.size(), 100000u);
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.view(), "");
+    EXPECT_EQ(arena.stats().names, 2u);
+
+    // renamed
+    arena.assign(a, "photo (1).jpg");
+    EXPECT_EQ(a.view(), "photo (1).jpg");
+    EXPECT_EQ(arena.stats().names, 2u);
+    EXPECT_GT(arena.stats().releasedBytes, 0u);
+
+    arena.release(a);
+    arena.release(b);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(arena.stats().names, 0u);
+    EXPECT_EQ(arena.stats().usedBytes, 0u);
+}
+
+TEST(SyncNameArena, CompactKeepsTheNamesInUse)
+{
+    SyncNameArena arena;
+    std::vector<SyncNameArena::Name> names(100000);
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        arena.assign(names[i], "file_" + std::to_string(i) + ".txt");
+    }
+    EXPECT_FALSE(arena.wantsCompaction());
+
+    // most of the files are removed
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (i % 10)
+        {
+            arena.release(names[i]);
+        }
+    }
+    ASSERT_TRUE(arena.wantsCompaction());
+    const auto allocated = arena.stats().allocatedBytes;
+
+    arena.compact(
+        [&names](auto&& move)
+        {
+            for (auto& name: names)
+            {
+                move(name);
+            }
+        });
+
+    EXPECT_FALSE(arena.wantsCompaction());
+    EXPECT_EQ(arena.stats().names, names.size() / 10);
+    EXPECT_EQ(arena.stats().releasedBytes, 0u);
+    EXPECT_LT(arena.stats().allocatedBytes, allocated / 5);
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (i % 10)
+        {
+            EXPECT_TRUE(names[i].empty());
+        }
+        else
+        {
+            EXPECT_EQ(names[i].view(), "file_" + std::to_string(i) + ".txt");
+        }
+    }
+}
+
+namespace
+{
+// glibc-like heap block for an allocation of 'n' bytes
+size_t heapBlock(size_t n)
+{
+    return std::max<size_t>(32, (n + 8 + 15) & ~size_t(15));
+}
+
+// heap bytes of a std::string holding 'size' characters (libstdc++ keeps up to 15 inline)
+size_t stringHeapBytes(size_t size)
+{
+    return size <= 15 ? 0 : heapBlock(size + 1);
+}
+} // namespace
+
+// Bytes per synced file taken by the names and scanned fingerprints of the LocalNodes, stored in
+// the sync's arena and shared with the synced fingerprint, compared with a std::string and two
+// fingerprints inline in every LocalNode.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(LocalNodeLayout, DISABLED_ReportBytesPerSyncedFile)
+{
+    constexpr size_t nodes = 1000000;
+
+    SyncNameArena arena;
+    std::vector<SyncNameArena::Name> names(nodes);
+    std::vector<std::unique_ptr<ScannedFingerprints>> fingerprints;
+    fingerprints.reserve(nodes);
+    std::vector<FileFingerprint> synced;
+    synced.reserve(nodes);
+
+    size_t stringBytes = 0;
+    size_t separateFingerprintBytes = 0;
+    for (size_t i = 0; i < nodes; ++i)
+    {
+        // camera-like names, and a few files modified since they were synced
+        auto name = "IMG_" + std::to_string(20000000 + i) + ".jpg";
+        arena.assign(names[i], name);
+        stringBytes += stringHeapBytes(name.size());
+
+        synced.push_back(makeFingerprint(static_cast<m_off_t>(i), 1000));
+        fingerprints.emplace_back(new ScannedFingerprints);
+        fingerprints.back()->setScanned(
+            i % 100 ? synced.back() : makeFingerprint(static_cast<m_off_t>(i), 2000),
+            synced.back());
+        separateFingerprintBytes += fingerprints.back()->allocatedBytes();
+    }
+
+    const size_t arenaBytes = arena.stats().allocatedBytes;
+    const size_t nameBytes = sizeof(SyncNameArena::Name) + arenaBytes / nodes;
+    const size_t inlineNameBytes = sizeof(std::string) + stringBytes / nodes;
+    const size_t fingerprintBytes =
+        sizeof(ScannedFingerprints) + separateFingerprintBytes / nodes;
+    const size_t inlineFingerprintBytes = 2 * sizeof(FileFingerprint);
+
+    GTEST_LOG_(INFO) << "sizeof(LocalNode) " << sizeof(LocalNode) << " bytes (it would be "
+                     << sizeof(LocalNode) - sizeof(SyncNameArena::Name) + sizeof(std::string) -
+                            sizeof(ScannedFingerprints) + inlineFingerprintBytes
+                     << " with the name and scanned fingerprints inline)";
+    GTEST_LOG_(INFO) << "Per synced file of " << nodes << ": name " << nameBytes
+                     << " bytes in the arena vs " << inlineNameBytes
+                     << " as std::string, scanned fingerprints " << fingerprintBytes
+                     << " bytes vs " << inlineFingerprintBytes << " inline";
+}
+
+#endif // ENABLE_SYNC
@@ -566,3 +566,42 @@ TEST(MegaApi, UseCurrentPathIfNoBasePathIsGiven)
 
     ASSERT_STREQ(std::filesystem::current_path().string().c_str(), megaApi.getBasePath());
 }
+
+TEST(MegaApi, MegaNode_namesSharedWhenInterning)
+{
+    auto makeNode = [](const char* name)
+    {
+        string nodekey(FILENODEKEYLENGTH, '\0');
+        string fileattrstring;
+        return unique_ptr<MegaNode>(new MegaNodePrivate(name,
+                                                        FILENODE,
+                                                        10,
+                                                        0,
+                                                        0,
+                                                        1,
+                                                        &nodekey,
+                                                        &fileattrstring,
+                                                        nullptr,
+                                                        nullptr,
+                                                        INVALID_HANDLE));
+    };
+
+    auto first = makeNode("Thumbs.db");
+    auto second = makeNode("Thumbs.db");
+    ASSERT_STREQ(first->getName(), "Thumbs.db");
+    ASSERT_NE(first->getName(), second->getName());
+
+    MegaApi::enableNodeNameInterning(true);
+    auto third = makeNode("Thumbs.db");
+    auto fourth = makeNode("Thumbs.db");
+    unique_ptr<MegaNode> copy(first->copy());
+    MegaApi::enableNodeNameInterning(false);
+
+    ASSERT_STREQ(third->getName(), "Thumbs.db");
+    ASSERT_EQ(third->getName(), fourth->getName());
+    ASSERT_EQ(third->getName(), copy->getName());
+
+    // a node without name
+    auto unnamed = makeNode(nullptr);
+    ASSERT_EQ(unnamed->getName(), nullptr);
+}
@@ -0,0 +1,326 @@
+/**
+ * @file NodeCounter_test.cpp
+ * @brief Unit tests for the folder counters kept by NodeManager
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include "mega.h"
+#include "utils.h"
+
+#include <gtest/gtest.h>
+#include <mega/megaapp.h>
+#include <mega/megaclient.h>
+#include <mega/treeproc.h>
+
+#include <chrono>
+#include <limits>
+#include <random>
+
+using namespace mega;
+
+class NodeCounterTest: public testing::Test
+{
+protected:
+    MegaApp mApp;
+    NodeManager::MissingParentNodes mMissingParentNodes;
+    std::shared_ptr<MegaClient> mClient;
+    std::shared_ptr<Node> mRoot;
+    std::vector<std::shared_ptr<Node>> mFolders;
+    std::vector<std::shared_ptr<Node>> mFiles;
+    uint64_t mIndex = 1;
+
+    void SetUp() override
+    {
+        auto dbAccess = new SqliteDbAccess(LocalPath::fromAbsolutePath("."));
+        mClient = mt::makeClient(mApp, dbAccess);
+        mClient->sid =
+            "AWA5YAbtb4JO-y2zWxmKZpSe5-6XM7CTEkA-3Nv7J4byQUpOazdfSC1ZUFlS-kah76gPKUEkTF9g7MeE";
+        mClient->opensctable();
+        // every node stays in RAM, with its parent
+        mClient->mNodeManager.setCacheLRUMaxSize(std::numeric_limits<uint64_t>::max());
+
+        mRoot = addNode(ROOTNODE, nullptr);
+        addNode(VAULTNODE, nullptr);
+        addNode(RUBBISHNODE, nullptr);
+    }
+
+    void TearDown() override
+    {
+        mFolders.clear();
+        mFiles.clear();
+        mRoot.reset();
+        mClient.reset();
+    }
+
+    std::shared_ptr<Node> addNode(nodetype_t type,
+                                  const std::shared_ptr<Node>& parent,
+                                  m_off_t size = 0)
+    {
+        auto& nodeRef = mt::makeNode(*mClient, type, NodeHandle().set6byte(mIndex++), parent.get());
+        std::shared_ptr<Node> node(&nodeRef);
+        if (type == FILENODE)
+        {
+            node->size = size;
+            NodeCounter nc;
+            nc.files = 1;
+            nc.storage = size;
+            node->setCounter(nc);
+        }
+
+        const bool isRoot = !parent;
+        mClient->mNodeManager.addNode(node, !isRoot, isRoot, mMissingParentNodes);
+        mClient->mNodeManager.saveNodeInDb(node.get());
+
+        if (type == FILENODE)
+        {
+            mFiles.push_back(node);
+        }
+        else if (type == FOLDERNODE)
+        {
+            mFolders.push_back(node);
+        }
+        return node;
+    }
+
+    // two levels of folders with files spread among them
+    void buildTree(size_t numTopFolders, size_t numSubfolders, size_t numFiles, std::mt19937& rng)
+    {
+        for (size_t i = 0; i < numTopFolders; ++i)
+        {
+            auto folder = addNode(FOLDERNODE, mRoot);
+            for (size_t j = 0; j < numSubfolders; ++j)
+            {
+                addNode(FOLDERNODE, folder);
+            }
+        }
+
+        for (size_t i = 0; i < numFiles; ++i)
+        {
+            addNode(FILENODE, mFolders[rng() % mFolders.size()], static_cast<m_off_t>(i + 1));
+        }
+        mClient->mNodeManager.notifyPurge();
+    }
+
+    static bool isAncestor(const Node* ancestor, const Node* n)
+    {
+        for (; n; n = n->parent.get())
+        {
+            if (n == ancestor)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // check the counters of all the folders against the ones computed from the tree in RAM
+    void checkCounters()
+    {
+        std::map<const Node*, NodeCounter> expected;
+        auto account = [&expected](const Node* n, const NodeCounter& own)
+        {
+            for (; n; n = n->parent.get())
+            {
+                expected[n] += own;
+            }
+        };
+
+        for (const auto& folder: mFolders)
+        {
+            if (!folder->changed.removed)
+            {
+                NodeCounter own;
+                own.folders = 1;
+                account(folder.get(), own);
+            }
+        }
+        for (const auto& file: mFiles)
+        {
+            if (!file->changed.removed)
+            {
+                account(file.get(), file->getCounter());
+            }
+        }
+
+        for (const auto& n: mFolders)
+        {
+            if (n->changed.removed)
+            {
+                continue;
+            }
+            const NodeCounter actual = mClient->mNodeManager.getNodeCounter(*n);
+            const NodeCounter& exp = expected[n.get()];
+            EXPECT_EQ(actual.files, exp.files) << n->nodehandle;
+            EXPECT_EQ(actual.folders, exp.folders) << n->nodehandle;
+            EXPECT_EQ(actual.storage, exp.storage) << n->nodehandle;
+        }
+
+        const NodeCounter rootCounter = mClient->mNodeManager.getNodeCounter(*mRoot);
+        EXPECT_EQ(rootCounter.files, expected[mRoot.get()].files);
+        EXPECT_EQ(rootCounter.folders, expected[mRoot.get()].folders);
+        EXPECT_EQ(rootCounter.storage, expected[mRoot.get()].storage);
+    }
+
+    // move random files and folders to random folders, as `t` action packets would do
+    void randomMoves(size_t numMoves, std::mt19937& rng)
+    {
+        for (size_t i = 0; i < numMoves; ++i)
+        {
+            const bool moveFolder = rng() % 4 == 0;
+            const auto& n = moveFolder ? mFolders[rng() % mFolders.size()] :
+                                         mFiles[rng() % mFiles.size()];
+            const auto& target = mFolders[rng() % mFolders.size()];
+            if (isAncestor(n.get(), target.get()))
+            {
+                continue;
+            }
+            n->setparent(target);
+        }
+    }
+};
+
+TEST_F(NodeCounterTest, DeferredMovesKeepCountersConsistent)
+{
+    std::mt19937 rng(1234);
+    buildTree(4, 3, 300, rng);
+    checkCounters();
+
+    randomMoves(500, rng);
+    mClient->mNodeManager.flushTreeCounters();
+    checkCounters();
+
+    // flushing again with nothing pending changes nothing
+    mClient->mNodeManager.flushTreeCounters();
+    checkCounters();
+}
+
+TEST_F(NodeCounterTest, CountersReadBeforeFlushAreUpToDate)
+{
+    std::mt19937 rng(42);
+    buildTree(3, 3, 200, rng);
+
+    // counters of random folders are read in the middle of the moves, flushing on demand
+    for (size_t round = 0; round < 50; ++round)
+    {
+        randomMoves(20, rng);
+
+        const auto& folder = mFolders[rng() % mFolders.size()];
+        NodeCounter expected;
+        expected.folders = 1;
+        for (const auto& n: mFolders)
+        {
+            if (n != folder && isAncestor(folder.get(), n.get()))
+            {
+                ++expected.folders;
+            }
+        }
+        for (const auto& n: mFiles)
+        {
+            if (isAncestor(folder.get(), n.get()))
+            {
+                expected += n->getCounter();
+            }
+        }
+
+        const NodeCounter actual = mClient->mNodeManager.getNodeCounter(*folder);
+        EXPECT_EQ(actual.files, expected.files) << "round " << round;
+        EXPECT_EQ(actual.folders, expected.folders) << "round " << round;
+        EXPECT_EQ(actual.storage, expected.storage) << "round " << round;
+    }
+
+    const NodeCounter roots = mClient->mNodeManager.getCounterOfRootNodes();
+    EXPECT_EQ(roots.files, mFiles.size());
+    EXPECT_EQ(roots.folders, mFolders.size());
+    checkCounters();
+}
+
+TEST_F(NodeCounterTest, RemovedSubtreeUpdatesAncestors)
+{
+    std::mt19937 rng(7);
+    buildTree(3, 4, 200, rng);
+
+    randomMoves(100, rng);
+
+    // as a `d` action packet would do
+    TreeProcDel td;
+    mClient->proctree(mFolders.front(), &td);
+
+    mClient->mNodeManager.notifyPurge();
+    checkCounters();
+}
+
+// Replay of a bulk move in a shared folder: thousands of `t` packets moving files between two
+// folders deep in the tree, followed by the deletion of the target.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST_F(NodeCounterTest, DISABLED_PerfMassiveMovesReplay)
+{
+    constexpr size_t NUM_FILES = 20000;
+    constexpr size_t DEPTH = 8;
+
+    auto makeChain = [this](std::shared_ptr<Node> parent)
+    {
+        for (size_t i = 0; i < DEPTH; ++i)
+        {
+            parent = addNode(FOLDERNODE, parent);
+        }
+        return parent;
+    };
+
+    auto source = makeChain(mRoot);
+    auto target = makeChain(mRoot);
+    for (size_t i = 0; i < NUM_FILES; ++i)
+    {
+        addNode(FILENODE, source, static_cast<m_off_t>(i + 1));
+    }
+    mClient->mNodeManager.notifyPurge();
+
+    auto replay = [this](const std::shared_ptr<Node>& to, bool deferred)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto& file: mFiles)
+        {
+            file->setparent(to);
+            if (!deferred)
+            {
+                // as if every move was committed on its own
+                mClient->mNodeManager.flushTreeCounters();
+            }
+        }
+        mClient->mNodeManager.flushTreeCounters();
+        mClient->mNodeManager.notifyPurge();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    };
+
+    const auto eagerMs = replay(target, false);
+    checkCounters();
+    const auto deferredMs = replay(source, true);
+    checkCounters();
+
+    auto t0 = std::chrono::steady_clock::now();
+    TreeProcDel td;
+    mClient->proctree(source, &td);
+    mClient->mNodeManager.notifyPurge();
+    auto t1 = std::chrono::steady_clock::now();
+    const auto deleteMs = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    checkCounters();
+
+    GTEST_LOG_(INFO) << "Moves of " << NUM_FILES << " files " << DEPTH
+                     << " levels deep: flushed one by one " << eagerMs << " ms, deferred " << deferredMs
+                     << " ms; deletion of the subtree " << deleteMs << " ms";
+}
@@ -0,0 +1,222 @@
+/**
+ * @file NodeHandleMap_test.cpp
+ * @brief Unit tests (and benchmark against std::map) for NodeHandleMap
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include <gtest/gtest.h>
+#include <mega/nodehandlemap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace mega;
+
+namespace
+{
+
+NodeHandle makeHandle(uint64_t h)
+{
+    return NodeHandle().set6byte(h);
+}
+
+// Element type similar to NodeManagerNode: not copyable, not default-constructible
+struct Element
+{
+    Element(int value):
+        mValue(value)
+    {}
+    Element(Element&&) = default;
+    Element(const Element&) = delete;
+
+    int mValue;
+};
+
+template<typename Fn>
+long long measureUs(Fn&& fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+}
+
+} // namespace
+
+TEST(NodeHandleMap, EmplaceFindErase)
+{
+    NodeHandleMap<Element> m;
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.find(makeHandle(1)), m.end());
+
+    auto [it, inserted] = m.emplace(makeHandle(1), Element(10));
+    ASSERT_TRUE(inserted);
+    ASSERT_EQ(it->first, makeHandle(1));
+    ASSERT_EQ(it->second.mValue, 10);
+
+    // existing keys are not overwritten
+    auto [it2, inserted2] = m.emplace(makeHandle(1), Element(20));
+    ASSERT_FALSE(inserted2);
+    ASSERT_EQ(it2, it);
+    ASSERT_EQ(it2->second.mValue, 10);
+    ASSERT_EQ(m.size(), 1u);
+
+    m.erase(it);
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.find(makeHandle(1)), m.end());
+    ASSERT_EQ(m.erase(makeHandle(1)), 0u);
+}
+
+TEST(NodeHandleMap, IteratorsAreStableAcrossRehash)
+{
+    NodeHandleMap<Element> m;
+    auto first = m.emplace(makeHandle(42), Element(42)).first;
+    Element* firstAddress = &first->second;
+
+    for (int i = 1; i <= 10000; ++i)
+    {
+        m.emplace(makeHandle(42 + static_cast<uint64_t>(i)), Element(i));
+    }
+
+    ASSERT_GT(m.bucket_count(), 16u);
+    ASSERT_EQ(m.find(makeHandle(42)), first);
+    ASSERT_EQ(&first->second, firstAddress);
+    ASSERT_EQ(first->second.mValue, 42);
+}
+
+TEST(NodeHandleMap, MatchesStdMap)
+{
+    NodeHandleMap<Element> m;
+    std::map<NodeHandle, int> reference;
+    std::mt19937_64 rng(12345);
+
+    // small key space, so there are plenty of collisions, updates and erasures
+    for (int i = 0; i < 200000; ++i)
+    {
+        NodeHandle h = makeHandle(rng() % 5000);
+        int value = static_cast<int>(rng() % 1000);
+        switch (rng() % 3)
+        {
+            case 0:
+            case 1:
+                ASSERT_EQ(m.emplace(h, Element(value)).second,
+                          reference.emplace(h, value).second);
+                break;
+            case 2:
+                ASSERT_EQ(m.erase(h), reference.erase(h));
+                break;
+        }
+    }
+
+    ASSERT_EQ(m.size(), reference.size());
+    for (const auto& [h, value]: reference)
+    {
+        auto it = m.find(h);
+        ASSERT_NE(it, m.end());
+        ASSERT_EQ(it->second.mValue, value);
+    }
+
+    // iteration visits every element once
+    std::set<NodeHandle> visited;
+    for (auto& [h, element]: m)
+    {
+        ASSERT_TRUE(visited.insert(h).second);
+    }
+    ASSERT_EQ(visited.size(), reference.size());
+
+    m.clear();
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(m.begin(), m.end());
+    ASSERT_EQ(m.bucket_count(), 0u);
+}
+
+// Benchmark of NodeHandleMap against std::map (the previous NodeManager::mNodes).
+// Reports timings and estimated memory through GTEST_LOG_(INFO). No assertions on timings.
+TEST(DISABLED_NodeHandleMapPerf, CompareWithStdMap)
+{
+    constexpr size_t NUM_NODES = 1000000;
+    // Size of a std::map node on top of the value: 3 pointers + color, plus malloc header
+    constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*) + 2 * sizeof(void*);
+
+    std::mt19937_64 rng(1);
+    std::vector<NodeHandle> handles(NUM_NODES);
+    for (auto& h: handles)
+    {
+        h = makeHandle(rng() & 0xFFFFFFFFFFFFull); // 48-bit random, as node handles
+    }
+    std::vector<NodeHandle> lookups(handles);
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+
+    long long found = 0;
+
+    std::map<NodeHandle, Element> stdMap;
+    auto mapInsert = measureUs(
+        [&]()
+        {
+            for (auto h: handles)
+                stdMap.emplace(h, Element(1));
+        });
+    auto mapLookup = measureUs(
+        [&]()
+        {
+            for (auto h: lookups)
+                found += stdMap.find(h)->second.mValue;
+        });
+    size_t mapBytes = stdMap.size() * (sizeof(std::map<NodeHandle, Element>::value_type) +
+                                       MAP_NODE_OVERHEAD);
+    auto mapErase = measureUs(
+        [&]()
+        {
+            for (auto h: lookups)
+                stdMap.erase(h);
+        });
+
+    NodeHandleMap<Element> hashMap;
+    auto hashInsert = measureUs(
+        [&]()
+        {
+            for (auto h: handles)
+                hashMap.emplace(h, Element(1));
+        });
+    auto hashLookup = measureUs(
+        [&]()
+        {
+            for (auto h: lookups)
+                found += hashMap.find(h)->second.mValue;
+        });
+    size_t hashBytes = hashMap.bucket_count() * (sizeof(uint64_t) + sizeof(size_t)) +
+                       hashMap.size() * sizeof(std::optional<NodeHandleMap<Element>::value_type>);
+    auto hashErase = measureUs(
+        [&]()
+        {
+            for (auto h: lookups)
+                hashMap.erase(h);
+        });
+
+    ASSERT_EQ(found, static_cast<long long>(2 * NUM_NODES));
+
+    GTEST_LOG_(INFO) << NUM_NODES << " nodes. std::map: insert " << mapInsert << " us, lookup "
+                     << mapLookup << " us, erase " << mapErase << " us, ~" << mapBytes / 1024
+                     << " KB";
+    GTEST_LOG_(INFO) << NUM_NODES << " nodes. NodeHandleMap: insert " << hashInsert
+                     << " us, lookup " << hashLookup << " us, erase " << hashErase << " us, ~"
+                     << hashBytes / 1024 << " KB";
+}
@@ -0,0 +1,313 @@
+/**
+ * @file NodeTreeSnapshot_test.cpp
+ * @brief Unit tests for the snapshot of the node tree used upon session resumption
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include "mega.h"
+#include "utils.h"
+
+#include <gtest/gtest.h>
+#include <mega/megaapp.h>
+#include <mega/megaclient.h>
+#include <mega/nodetreesnapshot.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdfs.h>
+
+namespace fs = std::filesystem;
+using namespace mega;
+
+namespace
+{
+
+constexpr handle SCSN = 0x0102030405060708;
+
+class NodeTreeSnapshotTest: public testing::Test
+{
+protected:
+    FSACCESS_CLASS mFsAccess;
+    fs::path mTestDir;
+    LocalPath mPath;
+
+    // root
+    //   A (outshare and link)
+    //     B
+    //     f1
+    //       f1 version
+    //     f2
+    // vault
+    // rubbish
+    // C (inshare, without parent)
+    NodeHandle mRoot = nodeHandle(1);
+    NodeHandle mVault = nodeHandle(2);
+    NodeHandle mRubbish = nodeHandle(3);
+    NodeHandle mA = nodeHandle(10);
+    NodeHandle mB = nodeHandle(11);
+    NodeHandle mF1 = nodeHandle(12);
+    NodeHandle mF1Version = nodeHandle(13);
+    NodeHandle mF2 = nodeHandle(14);
+    NodeHandle mC = nodeHandle(20);
+
+    void SetUp() override
+    {
+        const auto* info = testing::UnitTest::GetInstance()->current_test_info();
+        mTestDir = fs::temp_directory_path() / "mega_NodeTreeSnapshotTest" / info->name();
+        std::error_code ec;
+        fs::remove_all(mTestDir, ec);
+        fs::create_directories(mTestDir);
+        mPath = LocalPath::fromAbsolutePath(path_u8string(mTestDir / "snapshot.tree"));
+    }
+
+    void TearDown() override
+    {
+        std::error_code ec;
+        fs::remove_all(mTestDir, ec);
+    }
+
+    static NodeHandle nodeHandle(uint64_t h)
+    {
+        return NodeHandle().set6byte(h);
+    }
+
+    static NodeTreeEntry
+        entry(NodeHandle h, NodeHandle parent, nodetype_t type, std::string name, int share = 0)
+    {
+        NodeTreeEntry e;
+        e.handle = h;
+        e.parent = parent;
+        e.type = type;
+        e.share = share;
+        e.name = std::move(name);
+        return e;
+    }
+
+    std::vector<NodeTreeEntry> tree() const
+    {
+        // not sorted: the snapshot takes care of it
+        return {entry(mF2, mA, FILENODE, "f2"),
+                entry(mRoot, NodeHandle(), ROOTNODE, ""),
+                entry(mC, NodeHandle(), FOLDERNODE, "C", IN_SHARES),
+                entry(mF1Version, mF1, FILENODE, "f1"),
+                entry(mA, mRoot, FOLDERNODE, "A", OUT_SHARES | LINK),
+                entry(mVault, NodeHandle(), VAULTNODE, ""),
+                entry(mB, mA, FOLDERNODE, "B"),
+                entry(mRubbish, NodeHandle(), RUBBISHNODE, ""),
+                entry(mF1, mA, FILENODE, "f1")};
+    }
+};
+
+TEST_F(NodeTreeSnapshotTest, AnswersTreeQueries)
+{
+    ASSERT_TRUE(NodeTreeSnapshot::write(mFsAccess, mPath, SCSN, tree()));
+    auto snapshot = NodeTreeSnapshot::open(mPath, SCSN);
+    ASSERT_TRUE(snapshot);
+
+    EXPECT_EQ(snapshot->numNodes(), 9u);
+    EXPECT_TRUE(snapshot->contains(mF1Version));
+    EXPECT_FALSE(snapshot->contains(nodeHandle(99)));
+
+    EXPECT_EQ(snapshot->numChildren(mA), 3u);
+    EXPECT_EQ(snapshot->numChildren(mA, FILENODE), 2u);
+    EXPECT_EQ(snapshot->numChildren(mA, FOLDERNODE), 1u);
+    EXPECT_EQ(snapshot->numChildren(mF1), 1u); // versions are children
+    EXPECT_EQ(snapshot->numChildren(mB), 0u);
+    EXPECT_EQ(snapshot->numChildren(mRoot), 1u);
+    EXPECT_FALSE(snapshot->numChildren(nodeHandle(99)));
+
+    EXPECT_EQ(snapshot->isAncestor(mF1Version, mRoot), true);
+    EXPECT_EQ(snapshot->isAncestor(mB, mA), true);
+    EXPECT_EQ(snapshot->isAncestor(mA, mB), false);
+    EXPECT_EQ(snapshot->isAncestor(mA, mA), false);
+    EXPECT_EQ(snapshot->isAncestor(mC, mRoot), false);
+    EXPECT_FALSE(snapshot->isAncestor(nodeHandle(99), mRoot));
+
+    EXPECT_EQ(snapshot->childByNameType(mA, "f1", FILENODE), mF1);
+    EXPECT_EQ(snapshot->childByNameType(mA, "B", FOLDERNODE), mB);
+    EXPECT_EQ(snapshot->childByNameType(mA, "B", FILENODE), NodeHandle());
+    EXPECT_EQ(snapshot->childByNameType(mA, "f", FILENODE), NodeHandle());
+    EXPECT_EQ(snapshot->childByNameType(mB, "f1", FILENODE), NodeHandle());
+    EXPECT_FALSE(snapshot->childByNameType(nodeHandle(99), "f1", FILENODE));
+
+    EXPECT_EQ(snapshot->rootNodes(), (std::vector<NodeHandle>{mRoot, mVault, mRubbish}));
+    EXPECT_EQ(snapshot->nodesWithSharesOrLink(IN_SHARES), std::vector<NodeHandle>{mC});
+    EXPECT_EQ(snapshot->nodesWithSharesOrLink(OUT_SHARES), std::vector<NodeHandle>{mA});
+    EXPECT_EQ(snapshot->nodesWithSharesOrLink(LINK), std::vector<NodeHandle>{mA});
+    EXPECT_TRUE(snapshot->nodesWithSharesOrLink(PENDING_OUTSHARES).empty());
+}
+
+TEST_F(NodeTreeSnapshotTest, OverwritesPreviousSnapshot)
+{
+    ASSERT_TRUE(NodeTreeSnapshot::write(mFsAccess, mPath, SCSN, tree()));
+    ASSERT_TRUE(NodeTreeSnapshot::write(mFsAccess,
+                                        mPath,
+                                        SCSN + 1,
+                                        {entry(mRoot, NodeHandle(), ROOTNODE, "")}));
+
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN));
+    auto snapshot = NodeTreeSnapshot::open(mPath, SCSN + 1);
+    ASSERT_TRUE(snapshot);
+    EXPECT_EQ(snapshot->numNodes(), 1u);
+    EXPECT_EQ(snapshot->numChildren(mRoot), 0u);
+}
+
+TEST_F(NodeTreeSnapshotTest, DiscardsOutdatedOrMalformedFiles)
+{
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN)); // missing
+
+    ASSERT_TRUE(NodeTreeSnapshot::write(mFsAccess, mPath, SCSN, tree()));
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN + 1)); // outdated
+
+    const fs::path path = mTestDir / "snapshot.tree";
+    const auto size = fs::file_size(path);
+    fs::resize_file(path, size - 1);
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN)); // truncated
+
+    fs::resize_file(path, size + 8);
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN)); // trailing data
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << std::string(size, 'x');
+    }
+    EXPECT_FALSE(NodeTreeSnapshot::open(mPath, SCSN)); // not a snapshot
+}
+
+// The snapshot written from the DB answers as the node tree loaded from it
+TEST(NodeTreeSnapshotDbTest, WrittenFromTheNodesInTheDB)
+{
+    const fs::path dir = fs::temp_directory_path() / "mega_NodeTreeSnapshotTest" / "db";
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir);
+
+    MegaApp app;
+    auto client =
+        mt::makeClient(app, new SqliteDbAccess(LocalPath::fromAbsolutePath(path_u8string(dir))));
+    client->sid =
+        "AWA5YAbtb4JO-y2zWxmKZpSe5-6XM7CTEkA-3Nv7J4byQUpOazdfSC1ZUFlS-kah76gPKUEkTF9g7MeE";
+    client->opensctable();
+    client->mNodeManager.setCacheLRUMaxSize(std::numeric_limits<uint64_t>::max());
+
+    NodeManager::MissingParentNodes missingParentNodes;
+    std::vector<std::shared_ptr<Node>> nodes;
+    uint64_t index = 1;
+    auto addNode = [&](nodetype_t type, Node* parent)
+    {
+        std::shared_ptr<Node> node(
+            &mt::makeNode(*client, type, NodeHandle().set6byte(index++), parent));
+        client->mNodeManager.addNode(node, parent != nullptr, !parent, missingParentNodes);
+        client->mNodeManager.saveNodeInDb(node.get());
+        nodes.push_back(node);
+        return node.get();
+    };
+
+    Node* root = addNode(ROOTNODE, nullptr);
+    addNode(VAULTNODE, nullptr);
+    addNode(RUBBISHNODE, nullptr);
+    Node* folder = addNode(FOLDERNODE, root);
+    Node* subfolder = addNode(FOLDERNODE, folder);
+    for (int i = 0; i < 5; ++i)
+    {
+        addNode(FILENODE, i % 2 ? folder : subfolder);
+    }
+    client->mNodeManager.notifyPurge();
+
+    ASSERT_TRUE(client->mNodeManager.writeNodeTreeSnapshot(*client->fsaccess,
+                                                           client->mNodeTreeSnapshotPath,
+                                                           SCSN));
+    auto snapshot = NodeTreeSnapshot::open(client->mNodeTreeSnapshotPath, SCSN);
+    ASSERT_TRUE(snapshot);
+
+    EXPECT_EQ(snapshot->numNodes(), nodes.size());
+    for (const auto& n: nodes)
+    {
+        EXPECT_EQ(snapshot->numChildren(n->nodeHandle()),
+                  client->mNodeManager.getNumberOfChildrenFromNode(n->nodeHandle()));
+        EXPECT_EQ(snapshot->isAncestor(n->nodeHandle(), root->nodeHandle()), n->parent != nullptr);
+    }
+    EXPECT_EQ(snapshot->numChildren(folder->nodeHandle(), FILENODE), 2u);
+    EXPECT_EQ(snapshot->numChildren(subfolder->nodeHandle(), FILENODE), 3u);
+    EXPECT_EQ(snapshot->rootNodes().size(), 3u);
+
+    snapshot.reset();
+    nodes.clear();
+    client.reset();
+    fs::remove_all(dir, ec);
+}
+
+// Queries answered by the snapshot of a large account, right after mapping it.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST_F(NodeTreeSnapshotTest, DISABLED_PerfOpenAndQuery)
+{
+    constexpr uint64_t NUM_FOLDERS = 50000;
+    constexpr uint64_t FILES_PER_FOLDER = 20;
+    constexpr uint64_t FIRST_FOLDER = 100;
+
+    std::vector<NodeTreeEntry> entries{entry(mRoot, NodeHandle(), ROOTNODE, "")};
+    uint64_t next = FIRST_FOLDER + NUM_FOLDERS;
+    for (uint64_t i = 0; i < NUM_FOLDERS; ++i)
+    {
+        // a chain of folders 10 levels deep every 10 folders
+        const NodeHandle folder = nodeHandle(FIRST_FOLDER + i);
+        const NodeHandle parent = i % 10 ? nodeHandle(FIRST_FOLDER + i - 1) : mRoot;
+        entries.push_back(entry(folder, parent, FOLDERNODE, "folder" + std::to_string(i)));
+        for (uint64_t j = 0; j < FILES_PER_FOLDER; ++j)
+        {
+            entries.push_back(
+                entry(nodeHandle(next++), folder, FILENODE, "file" + std::to_string(j) + ".jpg"));
+        }
+    }
+    const size_t numNodes = entries.size();
+
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point from)
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - from).count();
+    };
+
+    auto t0 = clock::now();
+    ASSERT_TRUE(NodeTreeSnapshot::write(mFsAccess, mPath, SCSN, std::move(entries)));
+    const double writeMs = ms(t0);
+
+    t0 = clock::now();
+    auto snapshot = NodeTreeSnapshot::open(mPath, SCSN);
+    const double openMs = ms(t0);
+    ASSERT_TRUE(snapshot);
+
+    t0 = clock::now();
+    size_t found = 0;
+    for (uint64_t i = 0; i < NUM_FOLDERS; ++i)
+    {
+        const NodeHandle folder = nodeHandle(FIRST_FOLDER + i);
+        found += snapshot->numChildren(folder).value_or(0) > 0;
+        found += snapshot->isAncestor(folder, mRoot).value_or(false);
+        found += !snapshot->childByNameType(folder, "file7.jpg", FILENODE)->isUndef();
+    }
+    const double queryMs = ms(t0);
+    EXPECT_EQ(found, 3 * NUM_FOLDERS);
+
+    GTEST_LOG_(INFO) << "Snapshot of " << numNodes << " nodes: written in " << writeMs
+                     << " ms, mapped in " << openMs << " ms, " << 3 * NUM_FOLDERS
+                     << " queries in " << queryMs << " ms";
+}
+
+} // namespace
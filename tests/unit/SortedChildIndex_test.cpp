@@ -0,0 +1,474 @@
+/**
+ * @file SortedChildIndex_test.cpp
+ * @brief Tests for the sorted index of the children of a LocalNode.
+ */
+
+#ifdef ENABLE_SYNC
+
+#include <gtest/gtest.h>
+#include <mega/syncinternals/sortedchildindex.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mega;
+
+namespace
+{
+
+/**
+ * @brief The members of a LocalNode used by the index.
+ */
+struct TestChild
+{
+    explicit TestChild(const std::string& name):
+        localname(LocalPath::fromRelativePath(name)),
+        toName_of_localname(name)
+    {}
+
+    LocalPath localname;
+    std::string toName_of_localname;
+};
+
+using Index = SortedChildIndex<TestChild>;
+
+std::vector<std::unique_ptr<TestChild>> makeChildren(const std::vector<std::string>& names)
+{
+    std::vector<std::unique_ptr<TestChild>> children;
+    for (const auto& name: names)
+    {
+        children.emplace_back(std::make_unique<TestChild>(name));
+    }
+    return children;
+}
+
+std::vector<std::string> namesOf(const Index& index)
+{
+    std::vector<std::string> names;
+    for (const auto* child: index)
+    {
+        names.push_back(child->toName_of_localname);
+    }
+    return names;
+}
+
+Index::iterator find(Index& index, const std::string& name, bool caseInsensitive)
+{
+    return index.find(LocalPath::fromRelativePath(name), name, caseInsensitive);
+}
+
+} // namespace
+
+TEST(SortedChildIndex, KeepsChildrenInNameOrder)
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i)
+    {
+        names.push_back("file" + std::to_string(i));
+    }
+    auto children = makeChildren(names);
+    std::shuffle(children.begin(), children.end(), std::mt19937(7));
+
+    Index index;
+    for (auto& child: children)
+    {
+        index.insert(child.get(), false);
+    }
+    ASSERT_EQ(index.size(), names.size());
+
+    // all of them can be found, sorted or not
+    for (const auto& name: names)
+    {
+        auto it = find(index, name, false);
+        ASSERT_NE(it, index.end());
+        EXPECT_EQ((*it)->toName_of_localname, name);
+    }
+    EXPECT_EQ(find(index, "file1000", false), index.end());
+
+    index.sort(false);
+    EXPECT_TRUE(index.isSorted());
+    std::sort(names.begin(), names.end());
+    EXPECT_EQ(namesOf(index), names);
+}
+
+TEST(SortedChildIndex, CaseInsensitiveOrderKeepsNamesApart)
+{
+    auto children = makeChildren({"b", "A", "c", "a", "B"});
+
+    Index index;
+    for (auto& child: children)
+    {
+        index.insert(child.get(), true);
+    }
+    index.sort(true);
+
+    // equal names when ignoring case are adjacent, ordered by localname
+    EXPECT_EQ(namesOf(index), (std::vector<std::string>{"A", "a", "B", "b", "c"}));
+
+    auto it = find(index, "a", true);
+    ASSERT_NE(it, index.end());
+    EXPECT_EQ(*it, children[3].get());
+    EXPECT_EQ(find(index, "C", true), index.end());
+}
+
+// The children of a folder moved between a case sensitive and a case insensitive sync
+// (see LocalTreeProcMove) are sorted again for the sync they go to
+TEST(SortedChildIndex, ResortForAnotherCaseSensitivity)
+{
+    auto children = makeChildren({"c", "B", "a", "D", "b"});
+
+    for (bool caseInsensitive: {true, false})
+    {
+        Index index;
+        for (auto& child: children)
+        {
+            index.insert(child.get(), !caseInsensitive);
+        }
+        index.sort(!caseInsensitive);
+        // the first child removed, so there is a skipped entry to drop as well
+        index.erase(find(index, caseInsensitive ? "B" : "a", !caseInsensitive));
+
+        index.resort(caseInsensitive);
+        EXPECT_TRUE(index.isSorted());
+        EXPECT_EQ(namesOf(index),
+                  caseInsensitive ? (std::vector<std::string>{"a", "b", "c", "D"}) :
+                                    (std::vector<std::string>{"B", "D", "b", "c"}));
+
+        // the index works as one built with the case sensitivity of the new sync
+        for (const auto& child: children)
+        {
+            const auto& name = child->toName_of_localname;
+            const bool removed = name == (caseInsensitive ? "B" : "a");
+            EXPECT_EQ(find(index, name, caseInsensitive) == index.end(), removed) << name;
+        }
+
+        auto late = makeChildren({"C", "A"});
+        for (auto& child: late)
+        {
+            index.insert(child.get(), caseInsensitive);
+        }
+        index.sort(caseInsensitive);
+        EXPECT_EQ(namesOf(index),
+                  caseInsensitive ? (std::vector<std::string>{"A", "a", "b", "C", "c", "D"}) :
+                                    (std::vector<std::string>{"A", "B", "C", "D", "b", "c"}));
+    }
+}
+
+TEST(SortedChildIndex, InsertReplacesTheSameLocalname)
+{
+    auto children = makeChildren({"a", "b", "a"});
+
+    Index index;
+    for (auto& child: children)
+    {
+        index.insert(child.get(), false);
+    }
+
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(*find(index, "a", false), children[2].get());
+}
+
+TEST(SortedChildIndex, EraseAnywhere)
+{
+    std::vector<std::string> names;
+    for (char c = 'a'; c <= 'z'; ++c)
+    {
+        names.emplace_back(1, c);
+    }
+    auto children = makeChildren(names);
+
+    Index index;
+    for (auto& child: children)
+    {
+        index.insert(child.get(), false);
+    }
+
+    // an unsorted tail, too short to be merged
+    auto late = makeChildren({"Z", "M"});
+    for (auto& child: late)
+    {
+        index.insert(child.get(), false);
+    }
+    EXPECT_FALSE(index.isSorted());
+
+    index.erase(find(index, "a", false)); // first
+    index.erase(find(index, "z", false)); // last sorted
+    index.erase(find(index, "m", false)); // middle
+    index.erase(find(index, "Z", false)); // tail
+
+    EXPECT_EQ(index.size(), names.size() - 2);
+    for (auto name: {"a", "z", "m", "Z"})
+    {
+        EXPECT_EQ(find(index, name, false), index.end());
+    }
+    EXPECT_NE(find(index, "M", false), index.end());
+    EXPECT_NE(find(index, "b", false), index.end());
+
+    index.sort(false);
+    auto sorted = namesOf(index);
+    EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+
+    // removing all of them in order, as the sync does for a removed folder
+    while (!index.empty())
+    {
+        index.erase(index.begin());
+    }
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.begin(), index.end());
+}
+
+TEST(SortedChildIndex, EraseScatteredChildren)
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i)
+    {
+        names.push_back("file" + std::to_string(100000 + i));
+    }
+    auto children = makeChildren(names);
+
+    Index index;
+    for (auto& child: children)
+    {
+        index.insert(child.get(), false);
+    }
+    ASSERT_TRUE(index.isSorted());
+
+    // a third of them, anywhere but the first, in no particular order
+    std::vector<size_t> erased;
+    for (size_t i = 1; i < names.size(); i += 3)
+    {
+        erased.push_back(i);
+    }
+    std::shuffle(erased.begin(), erased.end(), std::mt19937(3));
+
+    std::vector<bool> present(names.size(), true);
+    for (size_t n = 0; n < erased.size(); ++n)
+    {
+        index.erase(find(index, names[erased[n]], false));
+        present[erased[n]] = false;
+
+        // the others are still found while the empty slots pile up (or after dropping them)
+        if (n % 50 == 0 || n + 1 == erased.size())
+        {
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                auto it = find(index, names[i], false);
+                ASSERT_EQ(it != index.end(), present[i]) << names[i] << " after " << n;
+                if (present[i])
+                {
+                    EXPECT_EQ(*it, children[i].get());
+                }
+            }
+        }
+    }
+    EXPECT_EQ(index.size(), names.size() - erased.size());
+
+    std::vector<std::string> remaining;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (present[i])
+        {
+            remaining.push_back(names[i]);
+        }
+    }
+    EXPECT_EQ(namesOf(index), remaining);
+    EXPECT_EQ(std::vector<TestChild*>(index.begin(), index.end()).size(), remaining.size());
+
+    // added again, they go to the tail and are merged among the others
+    for (size_t n = 0; n < 5; ++n)
+    {
+        index.insert(children[erased[n]].get(), false);
+        remaining.push_back(names[erased[n]]);
+    }
+    EXPECT_FALSE(index.isSorted());
+    EXPECT_NE(find(index, names[erased[0]], false), index.end());
+    index.sort(false);
+    std::sort(remaining.begin(), remaining.end());
+    EXPECT_EQ(namesOf(index), remaining);
+
+    // and all the others removed from the end, as LocalNode::deleteChildren() does
+    while (!index.empty())
+    {
+        index.erase(std::prev(index.end()));
+    }
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.begin(), index.end());
+}
+
+namespace
+{
+// The rows of a folder, as computed by Sync::computeSyncTriplets: a cloud node, LocalNode and
+// filesystem node with the same name (any of them may be missing).
+struct Row
+{
+    const std::string* cloud = nullptr;
+    const TestChild* sync = nullptr;
+    const std::string* fs = nullptr;
+
+    const std::string& name() const
+    {
+        return cloud ? *cloud : (sync ? sync->toName_of_localname : *fs);
+    }
+};
+
+int compareNames(const std::string& a, const std::string& b)
+{
+    return compareUtf(a, false, b, false, false);
+}
+
+// before: all the entries sorted together, then grouped by name
+size_t rowsBySortingAll(std::vector<std::string>& cloud,
+                        std::map<LocalPath, TestChild*>& syncChildren,
+                        std::vector<std::string>& fs)
+{
+    std::vector<Row> rows;
+    rows.reserve(cloud.size() + syncChildren.size() + fs.size());
+    for (auto& c: cloud)
+        rows.push_back(Row{&c, nullptr, nullptr});
+    for (auto& s: syncChildren)
+        rows.push_back(Row{nullptr, s.second, nullptr});
+    for (auto& f: fs)
+        rows.push_back(Row{nullptr, nullptr, &f});
+
+    std::sort(rows.begin(),
+              rows.end(),
+              [](const Row& a, const Row& b)
+              {
+                  return compareNames(a.name(), b.name()) < 0;
+              });
+
+    size_t sets = 0;
+    for (auto i = rows.begin(); i != rows.end(); ++sets)
+    {
+        auto j = i + 1;
+        while (j != rows.end() && !compareNames(i->name(), j->name()))
+            ++j;
+        i = j;
+    }
+    return sets;
+}
+
+// now: the LocalNodes are in order already, the others are sorted apart, and the three merged
+size_t rowsByMerging(std::vector<std::string>& cloud,
+                     const Index& syncChildren,
+                     std::vector<std::string>& fs)
+{
+    auto less = [](const std::string& a, const std::string& b)
+    {
+        return compareNames(a, b) < 0;
+    };
+    if (!std::is_sorted(cloud.begin(), cloud.end(), less))
+        std::sort(cloud.begin(), cloud.end(), less);
+    if (!std::is_sorted(fs.begin(), fs.end(), less))
+        std::sort(fs.begin(), fs.end(), less);
+    syncChildren.sort(false);
+
+    std::vector<Row> rows;
+    rows.reserve(cloud.size() + syncChildren.size() + fs.size());
+
+    auto c = cloud.begin();
+    auto s = syncChildren.begin();
+    auto f = fs.begin();
+    size_t sets = 0;
+    while (c != cloud.end() || s != syncChildren.end() || f != fs.end())
+    {
+        const std::string* smallest = nullptr;
+        auto consider = [&](const std::string& name)
+        {
+            if (!smallest || compareNames(name, *smallest) < 0)
+                smallest = &name;
+        };
+        if (c != cloud.end())
+            consider(*c);
+        if (s != syncChildren.end())
+            consider((*s)->toName_of_localname);
+        if (f != fs.end())
+            consider(*f);
+
+        for (; c != cloud.end() && !compareNames(*c, *smallest); ++c)
+            rows.push_back(Row{&*c, nullptr, nullptr});
+        for (; s != syncChildren.end() && !compareNames((*s)->toName_of_localname, *smallest); ++s)
+            rows.push_back(Row{nullptr, *s, nullptr});
+        for (; f != fs.end() && !compareNames(*f, *smallest); ++f)
+            rows.push_back(Row{nullptr, nullptr, &*f});
+        ++sets;
+    }
+    return sets;
+}
+} // namespace
+
+// Time taken to match up the cloud, LocalNode and filesystem children of wide folders, as
+// Sync::computeSyncTriplets did (all sorted together) and does (sorted index plus merge). The
+// first visit of a scan sorts it; the next ones find it sorted already.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(SortedChildIndex, DISABLED_ReportComputeSyncTripletsOnWideFolders)
+{
+    using ms = std::chrono::duration<double, std::milli>;
+
+    for (size_t width: {1000u, 20000u, 200000u})
+    {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < width; ++i)
+        {
+            names.push_back("IMG_" + std::to_string(1000000 + i * 7919 % width) + ".jpg");
+        }
+        auto children = makeChildren(names);
+
+        std::map<LocalPath, TestChild*> childMap;
+        Index index;
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto& child: children)
+        {
+            childMap.emplace(child->localname, child.get());
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (auto& child: children)
+        {
+            index.insert(child.get(), false);
+        }
+        index.sort(false);
+        auto t2 = std::chrono::steady_clock::now();
+
+        // as the sync adds them: in order
+        Index appended;
+        for (auto* child: index)
+        {
+            appended.insert(child, false);
+        }
+        auto t2b = std::chrono::steady_clock::now();
+        ASSERT_TRUE(appended.isSorted());
+
+        std::vector<std::string> cloud(names.rbegin(), names.rend());
+        std::vector<std::string> fs = names;
+        std::shuffle(fs.begin(), fs.end(), std::mt19937(1));
+
+        auto cloud1 = cloud, fs1 = fs;
+        auto t3 = std::chrono::steady_clock::now();
+        auto setsBefore = rowsBySortingAll(cloud1, childMap, fs1);
+        auto t4 = std::chrono::steady_clock::now();
+        auto cloud2 = cloud, fs2 = fs;
+        auto setsFirst = rowsByMerging(cloud2, index, fs2);
+        auto t5 = std::chrono::steady_clock::now();
+        auto cloud3 = cloud;
+        auto setsNext = rowsByMerging(cloud3, index, fs2);
+        auto t6 = std::chrono::steady_clock::now();
+
+        ASSERT_EQ(setsBefore, width);
+        ASSERT_EQ(setsFirst, width);
+        ASSERT_EQ(setsNext, width);
+
+        GTEST_LOG_(INFO) << "Folder of " << width << " children: build map " << ms(t1 - t0).count()
+                         << " ms, index " << ms(t2 - t1).count() << " ms (in order "
+                         << ms(t2b - t2).count() << " ms); triplets sorting all "
+                         << ms(t4 - t3).count() << " ms, merging (scan unsorted) "
+                         << ms(t5 - t4).count() << " ms, merging (scan sorted) "
+                         << ms(t6 - t5).count() << " ms";
+    }
+}
+
+#endif
@@ -114,7 +114,10 @@ protected:
         // Build indexes after bulk-insert for realistic query benchmarking
         // (both the search-index set and the lexicographic-sort index set).
         if (auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get()))
-            sa->createIndexes(/*enableSearch=*/true, /*enableLexi=*/true);
+            sa->createIndexes(/*enableSearch=*/true,
+                              /*enableLexi=*/true,
+                              /*enableFullText=*/false,
+                              /*enableAncestors=*/false);
     }
 
     void TearDown() override
@@ -255,7 +258,7 @@ protected:
         }
 
         // Additional files in rubbish — 1/10 of Cloud Drive file count. These
-        // match the same MIME distribution so they appear in the mimetypeVirtual
+        // match the same MIME distribution so they appear in the mimetypeStored
         // index but MUST be excluded by the filesRoot filter. Exercises the
         // "index match rate but filter rejects" path.
         const int rubbishCount = NUM_TOP_FOLDERS * NUM_SUB_PER_TOP * NUM_FILES_PER_SUB / 10;
@@ -1221,6 +1224,321 @@ TEST_F(DISABLED_SqliteNodesPerfTest, PerfRemoveNode)
                      << " iters, total " << us << " us, avg " << us / SIMPLE_ITERS << " us/iter";
 }
 
+// ─── 33. put vs putBatch ─────────────────────────────────────────────────────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfPutVsPutBatch)
+{
+    auto* table = nodesTable();
+    ASSERT_NE(table, nullptr);
+
+    constexpr size_t NUM_NODES = 1200;
+    ASSERT_GE(mFileHandles.size(), NUM_NODES);
+
+    sharedNode_vector nodes;
+    std::vector<Node*> batch;
+    for (size_t i = 0; i < NUM_NODES; ++i)
+    {
+        nodes.push_back(mClient->mNodeManager.getNodeByHandle(mFileHandles[i]));
+        ASSERT_NE(nodes.back(), nullptr);
+        batch.push_back(nodes.back().get());
+    }
+
+    const long long usPut = measureUs(COMPLEX_ITERS,
+                                      [&]
+                                      {
+                                          for (Node* n: batch)
+                                          {
+                                              table->put(n);
+                                          }
+                                          mClient->sctable->commit();
+                                      });
+
+    const long long usBatch = measureUs(COMPLEX_ITERS,
+                                        [&]
+                                        {
+                                            table->putBatch(batch);
+                                            mClient->sctable->commit();
+                                        });
+
+    GTEST_LOG_(INFO) << "put(Node*) x " << NUM_NODES << ": " << COMPLEX_ITERS << " iters, total "
+                     << usPut << " us, avg " << usPut / COMPLEX_ITERS << " us/iter";
+    GTEST_LOG_(INFO) << "putBatch(" << NUM_NODES << " nodes): " << COMPLEX_ITERS
+                     << " iters, total " << usBatch << " us, avg " << usBatch / COMPLEX_ITERS
+                     << " us/iter";
+}
+
+// ─── 34. searchNodes with the full-text index (from root, filter by name) ────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfSearchNodes_FromRoot_FilterByName_FullText)
+{
+    auto* table = nodesTable();
+    ASSERT_NE(table, nullptr);
+
+    table->createIndexes(/*enableSearch=*/true,
+                         /*enableLexi=*/true,
+                         /*enableFullText=*/true,
+                         /*enableAncestors=*/false);
+    if (!table->isIndexReady(NodesIndex::FULL_TEXT))
+    {
+        GTEST_SKIP() << "SQLite without FTS5 trigram tokenizer";
+    }
+
+    NodeSearchFilter filter;
+    filter.byAncestors({mRootHandle.as8byte(), UNDEF, UNDEF});
+    filter.byName("file_0_0"); // same as PerfSearchNodes_FromRoot_FilterByName
+
+    const long long us =
+        measureUs(COMPLEX_ITERS,
+                  [&]
+                  {
+                      std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+                      CancelToken ct;
+                      NodeSearchPage page{0, 0};
+                      table->searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, ct, page);
+                  });
+
+    std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+    CancelToken ct;
+    NodeSearchPage page{0, 0};
+    table->searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, ct, page);
+
+    GTEST_LOG_(INFO) << "searchNodes [full-text index] (from root, filter name='file_0_0') ["
+                     << nodes.size() << " results]: " << COMPLEX_ITERS << " iters, total " << us
+                     << " us, avg " << us / COMPLEX_ITERS << " us/iter";
+}
+
+// ─── 35. isAncestor with the ancestor index (deep and wide trees) ────────────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfIsAncestor_AncestorIndex_DeepAndWide)
+{
+    auto* table = nodesTable();
+    ASSERT_NE(table, nullptr);
+
+    constexpr int DEEP_LEVELS = 200;
+    constexpr int WIDE_CHILDREN = 5000;
+
+    auto rootNode = mClient->mNodeManager.getNodeByHandle(mRootHandle);
+    ASSERT_NE(rootNode, nullptr);
+
+    // deep: a chain of folders below the root, with a file at the bottom
+    auto parent = rootNode;
+    for (int i = 0; i < DEEP_LEVELS; ++i)
+    {
+        parent = addNode(FOLDERNODE, parent, "Deep_" + std::to_string(i));
+    }
+    const NodeHandle deepLeaf = addNode(FILENODE, parent, "deep_leaf.txt")->nodeHandle();
+
+    // wide: a folder with many files
+    auto wideFolder = addNode(FOLDERNODE, rootNode, "Wide");
+    NodeHandle wideLeaf;
+    for (int i = 0; i < WIDE_CHILDREN; ++i)
+    {
+        wideLeaf = addNode(FILENODE, wideFolder, "wide_" + std::to_string(i) + ".txt")
+                       ->nodeHandle();
+    }
+
+    auto measure = [&](NodeHandle node)
+    {
+        EXPECT_TRUE(table->isAncestor(node, mRootHandle, CancelToken{}));
+        return measureUs(SIMPLE_ITERS,
+                         [&]
+                         {
+                             table->isAncestor(node, mRootHandle, CancelToken{});
+                         });
+    };
+
+    const long long usDeepWalk = measure(deepLeaf);
+    const long long usWideWalk = measure(wideLeaf);
+
+    const auto start = std::chrono::steady_clock::now();
+    table->createIndexes(/*enableSearch=*/true,
+                         /*enableLexi=*/true,
+                         /*enableFullText=*/false,
+                         /*enableAncestors=*/true);
+    const auto usCreate = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+    ASSERT_TRUE(table->isIndexReady(NodesIndex::ANCESTORS));
+
+    const long long usDeepIndex = measure(deepLeaf);
+    const long long usWideIndex = measure(wideLeaf);
+
+    // maintenance: moving the wide folder re-links all the files below it
+    auto topFolder = mClient->mNodeManager.getNodeByHandle(mTopFolderHandles.front());
+    ASSERT_NE(topFolder, nullptr);
+    const long long usMove = measureUs(2,
+                                       [&, i = 0]() mutable
+                                       {
+                                           wideFolder->parenthandle = (i++ % 2) ?
+                                                                          mRootHandle.as8byte() :
+                                                                          topFolder->nodehandle;
+                                           table->put(wideFolder.get());
+                                       });
+    EXPECT_TRUE(table->isAncestor(wideLeaf, mRootHandle, CancelToken{}));
+
+    GTEST_LOG_(INFO) << "isAncestor (" << DEEP_LEVELS << " levels deep → root): " << SIMPLE_ITERS
+                     << " iters, walking up " << usDeepWalk / SIMPLE_ITERS
+                     << " us/iter, ancestor index " << usDeepIndex / SIMPLE_ITERS << " us/iter";
+    GTEST_LOG_(INFO) << "isAncestor (1 of " << WIDE_CHILDREN << " siblings → root): "
+                     << SIMPLE_ITERS << " iters, walking up " << usWideWalk / SIMPLE_ITERS
+                     << " us/iter, ancestor index " << usWideIndex / SIMPLE_ITERS << " us/iter";
+    GTEST_LOG_(INFO) << "ancestor index: created in " << usCreate << " us, moving a folder with "
+                     << WIDE_CHILDREN << " files " << usMove / 2 << " us";
+}
+
+// ─── 36. Node::unserialize of rows read from the DB ─────────────────────────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfUnserializeNodes)
+{
+    auto* table = nodesTable();
+    ASSERT_NE(table, nullptr);
+
+    std::vector<NodeSerialized> rows;
+    for (const NodeHandle& h: mFileHandles)
+    {
+        NodeSerialized ns;
+        ASSERT_TRUE(table->getNode(h, ns));
+        rows.push_back(std::move(ns));
+    }
+    ASSERT_FALSE(rows.empty());
+
+    size_t decoded = 0;
+    const long long us = measureUs(COMPLEX_ITERS / 10,
+                                   [&]
+                                   {
+                                       decoded = 0;
+                                       std::list<std::unique_ptr<NewShare>> ownNewshares;
+                                       for (const NodeSerialized& ns: rows)
+                                       {
+                                           auto n = Node::unserialize(*mClient,
+                                                                      ns.mNode,
+                                                                      false,
+                                                                      ownNewshares);
+                                           NodeCounter nc(ns.mNodeCounter);
+                                           decoded += n && nc.files == 1;
+                                       }
+                                   });
+
+    EXPECT_EQ(decoded, rows.size());
+    GTEST_LOG_(INFO) << "Node::unserialize + NodeCounter [" << rows.size()
+                     << " file rows]: " << COMPLEX_ITERS / 10 << " iters, total " << us
+                     << " us, avg " << us * 1000 / (COMPLEX_ITERS / 10) / long(rows.size())
+                     << " ns/node";
+}
+
+// ─── 37. searchNodes by category: index seek + walk up vs walk down ─────────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfSearchNodes_FromRoot_ByCategory_IndexVsWalk)
+{
+    auto* table = nodesTable();
+    ASSERT_NE(table, nullptr);
+
+    // a rare category: one pdf per sub-folder (~1% of the files)
+    for (const NodeHandle& h: mSubFolderHandles)
+    {
+        auto subFolder = mClient->mNodeManager.getNodeByHandle(h);
+        ASSERT_NE(subFolder, nullptr);
+        addNode(FILENODE, subFolder, "report_" + std::to_string(h.as8byte()) + ".pdf");
+    }
+
+    const std::vector<std::pair<MimeType_t, const char*>> categories{
+        {MIME_TYPE_PDF, "PDF (~1%)"},
+        {MIME_TYPE_VIDEO, "VIDEO (~10%)"},
+        {MIME_TYPE_PHOTO, "PHOTO (~50%)"},
+    };
+
+    auto searchAll = [&](MimeType_t category, std::vector<NodeHandle>& handles)
+    {
+        NodeSearchFilter filter;
+        filter.byAncestors({mRootHandle.as8byte(), UNDEF, UNDEF});
+        filter.byCategory(category);
+
+        std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+        CancelToken ct;
+        NodeSearchPage page{0, 0};
+        table->searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, ct, page);
+
+        handles.clear();
+        for (const auto& node: nodes)
+            handles.push_back(node.first);
+    };
+
+    std::vector<long long> usIndex;
+    std::vector<std::vector<NodeHandle>> expected(categories.size());
+    for (size_t i = 0; i < categories.size(); ++i)
+    {
+        searchAll(categories[i].first, expected[i]);
+        std::vector<NodeHandle> handles;
+        usIndex.push_back(measureUs(COMPLEX_ITERS,
+                                    [&]
+                                    {
+                                        searchAll(categories[i].first, handles);
+                                    }));
+    }
+
+    // without the indexes for searching every category is matched walking down the tree
+    table->dropIndexesForBulkLoad();
+    ASSERT_FALSE(table->isIndexReady(NodesIndex::SEARCH));
+
+    for (size_t i = 0; i < categories.size(); ++i)
+    {
+        std::vector<NodeHandle> handles;
+        const long long usWalk = measureUs(COMPLEX_ITERS,
+                                           [&]
+                                           {
+                                               searchAll(categories[i].first, handles);
+                                           });
+        EXPECT_EQ(handles, expected[i]) << categories[i].second;
+
+        GTEST_LOG_(INFO) << "searchNodes (from root, " << categories[i].second << ") ["
+                         << handles.size() << " results]: " << COMPLEX_ITERS
+                         << " iters, walking down " << usWalk / COMPLEX_ITERS
+                         << " us/iter, with the category index " << usIndex[i] / COMPLEX_ITERS
+                         << " us/iter";
+    }
+}
+
+// ─── 38. NodeManager::saveNodeInDb out of and during fetchnodes ─────────────
+TEST_F(DISABLED_SqliteNodesPerfTest, PerfSaveNodesWhileFetching)
+{
+    constexpr size_t NUM_NODES = 1200;
+    ASSERT_GE(mFileHandles.size(), NUM_NODES);
+
+    sharedNode_vector nodes;
+    for (size_t i = 0; i < NUM_NODES; ++i)
+    {
+        nodes.push_back(mClient->mNodeManager.getNodeByHandle(mFileHandles[i]));
+        ASSERT_NE(nodes.back(), nullptr);
+    }
+
+    const auto saveNodes = [&](bool fetching)
+    {
+        mClient->fetchingnodes = fetching;
+        for (size_t i = 0; i + 1 < nodes.size(); ++i)
+        {
+            mClient->mNodeManager.saveNodeInDb(nodes[i].get());
+        }
+        // out of fetchnodes, it writes the nodes still buffered before the last one
+        mClient->fetchingnodes = false;
+        mClient->mNodeManager.saveNodeInDb(nodes.back().get());
+        mClient->sctable->commit();
+    };
+
+    const long long usOneByOne = measureUs(COMPLEX_ITERS,
+                                           [&]
+                                           {
+                                               saveNodes(false);
+                                           });
+
+    const long long usFetching = measureUs(COMPLEX_ITERS,
+                                           [&]
+                                           {
+                                               saveNodes(true);
+                                           });
+
+    GTEST_LOG_(INFO) << "saveNodeInDb x " << NUM_NODES << " (one put per node): " << COMPLEX_ITERS
+                     << " iters, total " << usOneByOne << " us, avg "
+                     << usOneByOne / COMPLEX_ITERS << " us/iter";
+    GTEST_LOG_(INFO) << "saveNodeInDb x " << NUM_NODES << " (fetchnodes, putBatch): "
+                     << COMPLEX_ITERS << " iters, total " << usFetching << " us, avg "
+                     << usFetching / COMPLEX_ITERS << " us/iter";
+}
+
 // ═══════════════════════════════════════════════════════════════════════════
 //  listAllNodesByPage – parameterised suite
 //
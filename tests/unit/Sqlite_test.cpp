@@ -10,6 +10,7 @@
 #include <mega/localpath.h>
 
 #include <filesystem>
+#include <map>
 #include <mega.h>
 #include <set>
 #include <sqlite3.h>
@@ -109,6 +110,54 @@ TEST(Sqlite, renameDB)
 
 #ifdef USE_SQLITE
 
+/**
+ * @brief Validate the LRU eviction and the counters of SqliteStatementCache
+ */
+TEST(Sqlite, StatementCache_EvictsLeastRecentlyUsed)
+{
+    sqlite3* db = nullptr;
+    ASSERT_EQ(sqlite3_open(":memory:", &db), SQLITE_OK);
+    const MrProper closeDb(
+        [db]()
+        {
+            sqlite3_close(db);
+        });
+
+    using Query = SqliteStatementCache::Query;
+    SqliteStatementCache cache{2};
+
+    auto acquire = [&cache, db](Query query, size_t shapeId)
+    {
+        sqlite3_stmt*& stmt = cache.acquire(query, shapeId);
+        const bool prepared = !stmt;
+        if (!stmt)
+        {
+            EXPECT_EQ(sqlite3_prepare_v2(db, "SELECT 1", -1, &stmt, nullptr), SQLITE_OK);
+        }
+        return prepared;
+    };
+
+    EXPECT_TRUE(acquire(Query::GET_CHILDREN, 1));
+    EXPECT_TRUE(acquire(Query::SEARCH_NODES, 1)); // same id, different query
+    EXPECT_FALSE(acquire(Query::GET_CHILDREN, 1));
+    EXPECT_EQ(cache.size(), 2u);
+
+    // SEARCH_NODES is the least recently used one
+    EXPECT_TRUE(acquire(Query::LIST_ALL_NODES_BY_PAGE, 7));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_FALSE(acquire(Query::GET_CHILDREN, 1));
+    EXPECT_TRUE(acquire(Query::SEARCH_NODES, 1));
+
+    EXPECT_EQ(cache.stats().prepares, 4u);
+    EXPECT_EQ(cache.stats().reuses, 2u);
+    EXPECT_EQ(cache.stats().evictions, 2u);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_TRUE(acquire(Query::GET_CHILDREN, 1));
+    cache.clear(); // statements must be finalized before closing the DB
+}
+
 /**
  * @brief Validate that opening a DB shaped like a previous schema version
  *        runs the column-migration path to completion.
@@ -258,6 +307,126 @@ TEST(Sqlite, MigratesOldNodesSchema)
     EXPECT_THAT(migratedCols, ::testing::UnorderedElementsAreArray(freshCols));
 }
 
+/**
+ * @brief The indexes of listAllNodesByPage() on the old mimetypeVirtual column are replaced
+ *
+ * Steps:
+ *  - Seed an on-disk DB with the `nodes` table and the listallnodesdefaultidx index of the
+ *    schema that computed the category of the nodes in a virtual column.
+ *  - Open via SqliteDbAccess::openTableWithNodes and create the indexes.
+ *  - Assert the old index is gone and the one on mimetypeStored has been created.
+ */
+TEST(Sqlite, ReplacesListAllIndexesOfOldSchema)
+{
+    auto dirPath = std::filesystem::current_path() / "nodes_listall_indexes_test";
+
+    const MrProper cleanUp(
+        [dirPath]()
+        {
+            std::filesystem::remove_all(dirPath);
+        });
+
+    std::filesystem::remove_all(dirPath);
+    std::filesystem::create_directory(dirPath);
+    LocalPath folderPath = LocalPath::fromAbsolutePath(path_u8string(dirPath));
+    SqliteDbAccess dbAccess{folderPath};
+
+    std::unique_ptr<FileSystemAccess> fsaccess{new FSACCESS_CLASS};
+    const std::string dbName{"nodes_listall_indexes"};
+    LocalPath dbLocalPath = dbAccess.databasePath(*fsaccess, dbName, DbAccess::DB_VERSION);
+    const std::string dbPathStr = dbLocalPath.toPath(false);
+
+    using SqliteHandle = std::unique_ptr<sqlite3, decltype(&sqlite3_close)>;
+
+    auto openSqlite = [](const std::string& path) -> std::pair<SqliteHandle, int>
+    {
+        sqlite3* raw = nullptr;
+        const int rc = sqlite3_open(path.c_str(), &raw);
+        return {SqliteHandle{raw, &sqlite3_close}, rc};
+    };
+
+    {
+        auto [dbGuard, openRc] = openSqlite(dbPathStr);
+        ASSERT_EQ(SQLITE_OK, openRc);
+
+        // the SDK registers getmimetype() on its own connections only
+        auto getMimetype = [](sqlite3_context* context, int, sqlite3_value**)
+        {
+            sqlite3_result_int(context, 0);
+        };
+        ASSERT_EQ(SQLITE_OK,
+                  sqlite3_create_function(dbGuard.get(),
+                                          "getmimetype",
+                                          1,
+                                          SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                                          nullptr,
+                                          getMimetype,
+                                          nullptr,
+                                          nullptr));
+
+        // Frozen, like oldSchema in MigratesOldNodesSchema: the columns up to the virtual one
+        // holding the category, and the index on it with the same name as the current one had
+        const char* oldSchema = "CREATE TABLE nodes ("
+                                " nodehandle int64 PRIMARY KEY NOT NULL,"
+                                " parenthandle int64,"
+                                " name text,"
+                                " fingerprint BLOB,"
+                                " origFingerprint BLOB,"
+                                " type tinyint,"
+                                " mimetypeVirtual tinyint AS (getmimetype(name)) VIRTUAL,"
+                                " share tinyint,"
+                                " fav tinyint,"
+                                " ctime int64,"
+                                " flags int64,"
+                                " counter BLOB NOT NULL,"
+                                " node BLOB NOT NULL);"
+                                "CREATE INDEX listallnodesdefaultidx on nodes "
+                                " (mimetypeVirtual, name, nodehandle)";
+        char* err = nullptr;
+        const int rc = sqlite3_exec(dbGuard.get(), oldSchema, nullptr, nullptr, &err);
+        const std::string errStr = err ? err : "";
+        sqlite3_free(err);
+        ASSERT_EQ(SQLITE_OK, rc) << "Failed to seed old schema: " << errStr;
+    }
+
+    PrnGen rng;
+    std::unique_ptr<DbTable> dbTable{
+        dbAccess.openTableWithNodes(rng, *fsaccess, dbName, 0, nullptr)};
+    ASSERT_TRUE(dbTable) << "openTableWithNodes() failed with the old schema";
+    auto* accountState = dynamic_cast<SqliteAccountState*>(dbTable.get());
+    ASSERT_NE(accountState, nullptr);
+    accountState->createIndexes(true,
+                                true,
+                                /*enableFullTextIndex=*/false,
+                                /*enableAncestorIndex=*/false);
+    EXPECT_TRUE(accountState->isIndexReady(NodesIndex::SEARCH));
+    dbTable.reset();
+
+    std::map<std::string, std::string> indexes; // name -> CREATE INDEX statement
+    {
+        auto [dbGuard, openRc] = openSqlite(dbPathStr);
+        ASSERT_EQ(SQLITE_OK, openRc);
+        sqlite3_stmt* stmt = nullptr;
+        const char* q = "SELECT name, sql FROM sqlite_master WHERE type = 'index' AND "
+                        "tbl_name = 'nodes' AND sql IS NOT NULL";
+        ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(dbGuard.get(), q, -1, &stmt, nullptr));
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            indexes.emplace(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    EXPECT_EQ(indexes.count("listallnodesdefaultidx"), 0u);
+    ASSERT_EQ(indexes.count("listallnodesdefaultmimeidx"), 1u);
+    EXPECT_THAT(indexes["listallnodesdefaultmimeidx"], ::testing::HasSubstr("mimetypeStored"));
+    for (const auto& [name, sql]: indexes)
+    {
+        EXPECT_THAT(sql, ::testing::Not(::testing::HasSubstr("mimetypeVirtual"))) << name;
+    }
+}
+
 #endif // USE_SQLITE
 
 // ─────────────────────────────────────────────────────────────────────────────
@@ -400,7 +569,10 @@ protected:
         populateDB();
 
         if (auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get()))
-            sa->createIndexes(/*enableSearch=*/true, /*enableLexi=*/true);
+            sa->createIndexes(/*enableSearch=*/true,
+                              /*enableLexi=*/true,
+                              /*enableFullText=*/false,
+                              /*enableAncestors=*/false);
     }
 
     void TearDown() override
@@ -1197,6 +1369,24 @@ TEST_F(ListAllNodesByPageTest, DefaultAsc_DocumentMime_PaginationMatchesReferenc
     }
 }
 
+// D6. Pages after the first one only differ in the bound values, so they reuse the
+//     same prepared statement instead of preparing it again.
+TEST_F(ListAllNodesByPageTest, Pagination_ReusesPreparedStatement)
+{
+    auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get());
+    ASSERT_NE(sa, nullptr);
+
+    const auto before = sa->getStatementCacheStats();
+    const auto paged = collectAllByPage(OrderByClause::DEFAULT_ASC, 5);
+    const auto after = sa->getStatementCacheStats();
+
+    ASSERT_EQ(paged.size(), static_cast<size_t>(NUM_FILES));
+    // first page (no cursor) and the rest (with cursor)
+    EXPECT_EQ(after.prepares - before.prepares, 2u);
+    // 4 full pages and the empty one
+    EXPECT_EQ(after.reuses - before.reuses, 3u);
+}
+
 // ═══════════════════════════════════════════════════════════════════════════
 //  Group E – Stability under concurrent modification
 // ═══════════════════════════════════════════════════════════════════════════
@@ -1957,7 +2147,7 @@ TEST_F(GroupedListAllNodesByPageTest, AllOrders_AllVisualMedia_PaginationMatches
 
 // ═══════════════════════════════════════════════════════════════════════════
 //  Group C – Simple path for individual MIME types that belong to groups
-//  Verifies that the non-grouped SQL path (mimetypeVirtual = ?) is exercised
+//  Verifies that the non-grouped SQL path (mimetypeStored = ?) is exercised
 //  correctly for MIME_TYPE_VIDEO and MIME_TYPE_PHOTO, which also appear as
 //  constituent members inside the ALL_VISUAL_MEDIA grouped path.
 // ═══════════════════════════════════════════════════════════════════════════
@@ -2506,6 +2696,421 @@ TEST_F(ListAllNodesByPageTest, LocationScope_IgnoredWhenExplicitAncestorsPresent
     EXPECT_EQ(got.count(hClean), 0u);
 }
 
+// putBatch() writes full batches with a multi-row statement and the remainder one by one.
+// Either way, nodes must be stored as put() does.
+TEST_F(SearchByPageTest, PutBatch_StoresAllNodes)
+{
+    auto* table = dynamic_cast<DBTableNodes*>(mClient->sctable.get());
+    ASSERT_NE(table, nullptr);
+    const uint64_t initialCount = table->getNumberOfNodes();
+
+    constexpr size_t numNodes = 150; // more than two full batches, plus remainder
+    std::vector<std::shared_ptr<Node>> nodes;
+    std::vector<Node*> batch;
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        Node& ref = mt::makeNode(*mClient,
+                                 FILENODE,
+                                 NodeHandle().set6byte(mNextHandle++),
+                                 nullptr);
+        nodes.emplace_back(&ref);
+        ref.parenthandle = mRootHandle.as8byte();
+        ref.attrs.map[kNameId] = "batch_" + std::to_string(i) + ".txt";
+        batch.push_back(&ref);
+    }
+
+    ASSERT_TRUE(table->putBatch(batch));
+    ASSERT_EQ(table->getNumberOfNodes(), initialCount + numNodes);
+
+    for (const auto& node: nodes)
+    {
+        NodeSerialized stored;
+        ASSERT_TRUE(table->getNode(node->nodeHandle(), stored));
+        std::string expected;
+        node->serialize(&expected);
+        EXPECT_EQ(stored.mNode, expected);
+    }
+
+    // Updating existing nodes replaces their rows
+    nodes.front()->attrs.map[kNameId] = "renamed.txt";
+    ASSERT_TRUE(table->putBatch(batch));
+    ASSERT_EQ(table->getNumberOfNodes(), initialCount + numNodes);
+    std::pair<NodeHandle, NodeSerialized> renamed;
+    EXPECT_TRUE(
+        table->childNodeByNameType(mRootHandle, "renamed.txt", FILENODE, renamed));
+}
+
+TEST_F(SearchByPageTest, DeferredIndexes_CreatedOneByOne)
+{
+    auto* table = dynamic_cast<DBTableNodes*>(mClient->sctable.get());
+    ASSERT_NE(table, nullptr);
+    const std::vector<NodesIndex> groups{NodesIndex::PARENT,
+                                         NodesIndex::FINGERPRINT,
+                                         NodesIndex::SEARCH,
+                                         NodesIndex::LEXICOGRAPHIC};
+
+    // SetUp() created all of them
+    for (NodesIndex group: groups)
+    {
+        EXPECT_TRUE(table->isIndexReady(group));
+    }
+    const uint64_t numChildren = table->getNumberOfChildren(hFilesRoot);
+    ASSERT_GT(numChildren, 0u);
+
+    table->dropIndexesForBulkLoad();
+    for (NodesIndex group: groups)
+    {
+        EXPECT_FALSE(table->isIndexReady(group));
+    }
+
+    table->scheduleIndexes(/*enableIndexesForSearching=*/true,
+                           /*enableIndexesForLexicographicalList=*/true,
+                           /*enableFullTextIndex=*/false,
+                           /*enableAncestorIndex=*/false);
+    EXPECT_FALSE(table->isIndexReady(NodesIndex::PARENT));
+
+    int numCalls = 1;
+    while (table->createNextPendingIndex())
+    {
+        ++numCalls;
+    }
+    EXPECT_GT(numCalls, static_cast<int>(groups.size()));
+    for (NodesIndex group: groups)
+    {
+        EXPECT_TRUE(table->isIndexReady(group));
+    }
+
+    // existing indexes are not scheduled again
+    table->scheduleIndexes(true, true, false, false);
+    EXPECT_FALSE(table->createNextPendingIndex());
+
+    // queries relying on the indexes return the same results
+    EXPECT_EQ(table->getNumberOfChildren(hFilesRoot), numChildren);
+}
+
+TEST_F(SearchByPageTest, FullTextIndex_SameResultsAsScan)
+{
+    auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get());
+    ASSERT_NE(sa, nullptr);
+    ASSERT_FALSE(sa->isIndexReady(NodesIndex::FULL_TEXT));
+
+    struct Query
+    {
+        std::string name;
+        NodeSearchFilter::BoolFilter sensitivity;
+    };
+
+    const std::vector<Query> queries{
+        {"file_1", NodeSearchFilter::BoolFilter::disabled},
+        {"FOLDER", NodeSearchFilter::BoolFilter::disabled},
+        {"*.jpg", NodeSearchFilter::BoolFilter::disabled},
+        {"*.jpg", NodeSearchFilter::BoolFilter::onlyTrue},
+        {"le_0?.t", NodeSearchFilter::BoolFilter::disabled},
+        {"head", NodeSearchFilter::BoolFilter::disabled}, // has versions
+        {"ab", NodeSearchFilter::BoolFilter::disabled}, // too short for the index
+        {"not_found", NodeSearchFilter::BoolFilter::disabled},
+    };
+
+    auto search = [sa, this](const Query& query)
+    {
+        NodeSearchFilter filter;
+        filter.byAncestors({mRootHandle.as8byte(), hVault.as8byte(), UNDEF});
+        filter.byName(query.name);
+        filter.bySensitivity(query.sensitivity);
+
+        std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+        EXPECT_TRUE(sa->searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, CancelToken{}, {0, 0}));
+
+        std::vector<NodeHandle> handles;
+        for (const auto& node: nodes)
+        {
+            handles.push_back(node.first);
+        }
+        return handles;
+    };
+
+    std::vector<std::vector<NodeHandle>> expected;
+    for (const auto& query: queries)
+    {
+        expected.push_back(search(query));
+    }
+    ASSERT_FALSE(expected.front().empty());
+
+    sa->createIndexes(true, true, /*enableFullTextIndex=*/true, /*enableAncestorIndex=*/false);
+    if (!sa->isIndexReady(NodesIndex::FULL_TEXT))
+    {
+        GTEST_SKIP() << "SQLite without FTS5 trigram tokenizer";
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        EXPECT_EQ(search(queries[i]), expected[i]) << queries[i].name;
+    }
+
+    // the index follows renames and removals
+    auto folderIt = std::find_if(mMeta.begin(),
+                                 mMeta.end(),
+                                 [](const auto& meta)
+                                 {
+                                     return meta.second.name == "Folder_A";
+                                 });
+    ASSERT_NE(folderIt, mMeta.end());
+    auto folder = mClient->mNodeManager.getNodeByHandle(NodeHandle().set6byte(folderIt->first));
+    ASSERT_NE(folder, nullptr);
+    folder->attrs.map[kNameId] = "Renamed_A";
+    ASSERT_TRUE(sa->put(folder.get()));
+    EXPECT_EQ(search({"renamed_a", NodeSearchFilter::BoolFilter::disabled}),
+              std::vector<NodeHandle>{folder->nodeHandle()});
+
+    ASSERT_TRUE(sa->remove(folder->nodeHandle()));
+    EXPECT_TRUE(search({"renamed_a", NodeSearchFilter::BoolFilter::disabled}).empty());
+}
+
+TEST_F(SearchByPageTest, AncestorIndex_SameResultsAsWalk)
+{
+    auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get());
+    ASSERT_NE(sa, nullptr);
+    ASSERT_FALSE(sa->isIndexReady(NodesIndex::ANCESTORS));
+
+    std::vector<NodeHandle> handles{NodeHandle()};
+    for (const auto& meta: mMeta)
+    {
+        handles.push_back(NodeHandle().set6byte(meta.first));
+    }
+
+    auto ancestorPairs = [sa, &handles]()
+    {
+        std::set<std::pair<NodeHandle, NodeHandle>> pairs;
+        for (NodeHandle node: handles)
+        {
+            for (NodeHandle ancestor: handles)
+            {
+                if (sa->isAncestor(node, ancestor, CancelToken{}))
+                {
+                    pairs.emplace(node, ancestor);
+                }
+            }
+        }
+        return pairs;
+    };
+
+    const auto expectedPairs = ancestorPairs();
+    const auto expectedPhotos = allMatchesAsSet(MIME_TYPE_PHOTO, OrderByClause::DEFAULT_ASC, false);
+    const auto expectedDocuments =
+        allMatchesAsSet(MIME_TYPE_DOCUMENT, OrderByClause::DEFAULT_ASC, false);
+    ASSERT_FALSE(expectedPairs.empty());
+    ASSERT_FALSE(expectedPhotos.empty());
+
+    sa->createIndexes(true, true, /*enableFullTextIndex=*/false, /*enableAncestorIndex=*/true);
+    ASSERT_TRUE(sa->isIndexReady(NodesIndex::ANCESTORS));
+
+    EXPECT_EQ(ancestorPairs(), expectedPairs);
+    EXPECT_EQ(allMatchesAsSet(MIME_TYPE_PHOTO, OrderByClause::DEFAULT_ASC, false), expectedPhotos);
+    EXPECT_EQ(allMatchesAsSet(MIME_TYPE_DOCUMENT, OrderByClause::DEFAULT_ASC, false),
+              expectedDocuments);
+
+    // the index follows moves, including the nodes below the moved one
+    auto folder = mClient->mNodeManager.getNodeByHandle(hNormalFolder);
+    ASSERT_NE(folder, nullptr);
+    folder->parenthandle = hVault.as8byte();
+    ASSERT_TRUE(sa->put(folder.get()));
+    EXPECT_TRUE(sa->isAncestor(hVersionV1, hVault, CancelToken{}));
+    EXPECT_TRUE(sa->isAncestor(hClean, hNormalFolder, CancelToken{}));
+    EXPECT_FALSE(sa->isAncestor(hClean, hFilesRoot, CancelToken{}));
+
+    // and removals: the nodes below aren't below the ancestors of the removed one anymore
+    ASSERT_TRUE(sa->remove(hNormalFolder));
+    EXPECT_TRUE(sa->isAncestor(hClean, hNormalFolder, CancelToken{}));
+    EXPECT_FALSE(sa->isAncestor(hClean, hVault, CancelToken{}));
+    EXPECT_FALSE(sa->isAncestor(hVersionV1, hVault, CancelToken{}));
+    EXPECT_TRUE(sa->isAncestor(hUnderSens, hFilesRoot, CancelToken{}));
+}
+
+TEST_F(SearchByPageTest, CategoryIndex_SameResultsAsScan)
+{
+    auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get());
+    ASSERT_NE(sa, nullptr);
+
+    // a few files of rare categories among many documents, so the index route is taken for them
+    auto root = mClient->mNodeManager.getNodeByHandle(mRootHandle);
+    auto normal = mClient->mNodeManager.getNodeByHandle(hNormalFolder);
+    ASSERT_NE(root, nullptr);
+    ASSERT_NE(normal, nullptr);
+    for (int i = 0; i < 60; ++i)
+    {
+        addNode(FILENODE, root, NodeMeta{"notes_" + std::to_string(i) + ".txt", FILENODE, 10});
+    }
+    const NodeHandle hPdf =
+        addNode(FILENODE, root, NodeMeta{"report.PDF", FILENODE, 20}, false)->nodeHandle();
+    addNode(FILENODE, normal, NodeMeta{"invoice.pdf", FILENODE, 30}, false);
+    NodeMeta sensitivePdf{"private.pdf", FILENODE, 40};
+    sensitivePdf.sensitive = true;
+    addNode(FILENODE, normal, sensitivePdf, false);
+    addNode(FILENODE, normal, NodeMeta{"table.csv", FILENODE, 50}, false);
+    addNode(FILENODE, root, NodeMeta{"song.mp3", FILENODE, 60}, false);
+
+    struct Query
+    {
+        MimeType_t category;
+        handle ancestor;
+        NodeSearchFilter::BoolFilter sensitivity;
+    };
+
+    const std::vector<Query> queries{
+        {MIME_TYPE_PDF, UNDEF, NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_PDF, hNormalFolder.as8byte(), NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_PDF, UNDEF, NodeSearchFilter::BoolFilter::onlyTrue},
+        {MIME_TYPE_SPREADSHEET, UNDEF, NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_MISC, UNDEF, NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_AUDIO, hNormalFolder.as8byte(), NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_ALL_DOCS, UNDEF, NodeSearchFilter::BoolFilter::disabled}, // not selective
+        {MIME_TYPE_PHOTO, UNDEF, NodeSearchFilter::BoolFilter::disabled},
+        {MIME_TYPE_VIDEO, UNDEF, NodeSearchFilter::BoolFilter::disabled},
+    };
+
+    auto search = [sa, this](const Query& query)
+    {
+        NodeSearchFilter filter;
+        if (query.ancestor == UNDEF)
+        {
+            filter.byAncestors({mRootHandle.as8byte(), hVault.as8byte(), UNDEF});
+        }
+        else
+        {
+            filter.byAncestors({query.ancestor, UNDEF, UNDEF});
+        }
+        filter.byCategory(query.category);
+        filter.bySensitivity(query.sensitivity);
+
+        std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+        EXPECT_TRUE(sa->searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, CancelToken{}, {0, 0}));
+
+        std::vector<NodeHandle> handles;
+        for (const auto& node: nodes)
+        {
+            handles.push_back(node.first);
+        }
+        return handles;
+    };
+
+    // without the indexes for searching, categories are matched while walking down the tree
+    sa->dropIndexesForBulkLoad();
+    ASSERT_FALSE(sa->isIndexReady(NodesIndex::SEARCH));
+
+    std::vector<std::vector<NodeHandle>> expected;
+    for (const auto& query: queries)
+    {
+        expected.push_back(search(query));
+    }
+    EXPECT_EQ(expected[0].size(), 3u);
+    EXPECT_EQ(expected[1].size(), 2u);
+    EXPECT_EQ(expected[2].size(), 2u);
+    EXPECT_EQ(expected[3].size(), 1u);
+    EXPECT_TRUE(expected[4].empty()); // a single category is stored: csv is a spreadsheet
+    EXPECT_TRUE(expected[5].empty());
+
+    sa->createIndexes(true, true, /*enableFullTextIndex=*/false, /*enableAncestorIndex=*/false);
+    ASSERT_TRUE(sa->isIndexReady(NodesIndex::SEARCH));
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        EXPECT_EQ(search(queries[i]), expected[i]) << "query " << i;
+    }
+
+    // the stored category follows renames
+    auto pdf = mClient->mNodeManager.getNodeByHandle(hPdf);
+    ASSERT_NE(pdf, nullptr);
+    pdf->attrs.map[kNameId] = "report.mp4";
+    ASSERT_TRUE(sa->put(pdf.get()));
+    EXPECT_EQ(search(queries[0]).size(), 2u);
+    EXPECT_EQ(search({MIME_TYPE_VIDEO, UNDEF, NodeSearchFilter::BoolFilter::disabled}),
+              std::vector<NodeHandle>{hPdf});
+}
+
+TEST_F(SearchByPageTest, Reader_SeesCommittedNodesOnly)
+{
+    auto* sa = dynamic_cast<SqliteAccountState*>(mClient->sctable.get());
+    ASSERT_NE(sa, nullptr);
+
+    auto search = [this](DBTableNodes& table, const std::string& name)
+    {
+        NodeSearchFilter filter;
+        filter.byAncestors({mRootHandle.as8byte(), hVault.as8byte(), UNDEF});
+        filter.byName(name);
+
+        std::vector<std::pair<NodeHandle, NodeSerialized>> nodes;
+        EXPECT_TRUE(
+            table.searchNodes(filter, OrderByClause::DEFAULT_ASC, nodes, CancelToken{}, {0, 0}));
+
+        std::vector<NodeHandle> handles;
+        for (const auto& node: nodes)
+        {
+            handles.push_back(node.first);
+        }
+        return handles;
+    };
+
+    // the nodes added by populateDB() are not committed yet
+    EXPECT_EQ(sa->acquireReader(), nullptr);
+
+    sa->commit();
+    sa->begin();
+
+    auto reader = sa->acquireReader();
+    ASSERT_NE(reader, nullptr);
+    const auto expected = search(*sa, "file_*");
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(search(reader->table(), "file_*"), expected);
+    EXPECT_TRUE(reader->isStillValid());
+
+    // a change invalidates the borrowed readers, and no other is lent until it's committed
+    auto folder = mClient->mNodeManager.getNodeByHandle(hNormalFolder);
+    ASSERT_NE(folder, nullptr);
+    folder->attrs.map[kNameId] = "renamed_folder";
+    ASSERT_TRUE(sa->put(folder.get()));
+    EXPECT_FALSE(reader->isStillValid());
+    EXPECT_TRUE(search(reader->table(), "renamed_folder").empty());
+    EXPECT_EQ(sa->acquireReader(), nullptr);
+    reader.reset();
+
+    sa->commit();
+    sa->begin();
+
+    reader = sa->acquireReader();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(search(reader->table(), "renamed_folder"), std::vector<NodeHandle>{hNormalFolder});
+    EXPECT_TRUE(reader->isStillValid());
+
+    // the readers are limited, and reused once given back
+    std::vector<std::unique_ptr<DBTableNodesReader>> readers;
+    while (readers.size() < 10)
+    {
+        auto other = sa->acquireReader();
+        if (!other)
+        {
+            break;
+        }
+        readers.push_back(std::move(other));
+    }
+    EXPECT_LT(readers.size(), 10u);
+    readers.clear();
+    EXPECT_NE(sa->acquireReader(), nullptr);
+
+    // NodeManager looks up in a reader and gets the same nodes as from the main connection
+    NodeSearchFilter filter;
+    filter.byAncestors({mRootHandle.as8byte(), hVault.as8byte(), UNDEF});
+    filter.byName("file_*");
+    std::vector<NodeHandle> found;
+    for (const auto& node: mClient->mNodeManager.searchNodes(filter,
+                                                            OrderByClause::DEFAULT_ASC,
+                                                            CancelToken{},
+                                                            NodeSearchPage{0, 0}))
+    {
+        found.push_back(node->nodeHandle());
+    }
+    EXPECT_EQ(found, expected);
+}
+
 } // anonymous namespace
 
 #endif // USE_SQLITE
@@ -0,0 +1,326 @@
+/**
+ * @file StateCacheJournal_test.cpp
+ * @brief Tests for the write-behind journal of the LocalNodes to be saved in a sync's database.
+ */
+
+#ifdef ENABLE_SYNC
+
+#include "DefaultedDbTable.h"
+
+#include <gtest/gtest.h>
+#include <mega/syncinternals/statecachejournal.h>
+#include <mega/utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mega;
+
+namespace
+{
+
+constexpr uint32_t RECORD_TYPE = 3;
+
+/**
+ * @brief The members of a LocalNode used by the journal.
+ */
+struct TestRecord: public Cacheable
+{
+    TestRecord(TestRecord* parent, const std::string& name):
+        parent(parent),
+        name(name)
+    {}
+
+    bool serialize(std::string* data) const override
+    {
+        data->append(std::to_string(parent ? parent->dbid : 0));
+        data->append(":");
+        data->append(name);
+        return true;
+    }
+
+    TestRecord* parent;
+    std::string name;
+};
+
+using Journal = StateCacheJournal<TestRecord>;
+
+/**
+ * @brief A table keeping its records in memory.
+ */
+class MemoryTable: public mt::DefaultedDbTable
+{
+public:
+    using DefaultedDbTable::DefaultedDbTable;
+    using DbTable::put;
+
+    bool put(uint32_t id, char* data, unsigned size) override
+    {
+        ++puts;
+        rows[id].assign(data, size);
+        return true;
+    }
+
+    bool del(uint32_t id) override
+    {
+        ++dels;
+        return rows.erase(id) > 0;
+    }
+
+    // the record with this dbid, decrypted
+    std::string record(uint32_t id, SymmCipher& key) const
+    {
+        auto it = rows.find(id);
+        if (it == rows.end())
+        {
+            return {};
+        }
+
+        auto data = it->second;
+        EXPECT_TRUE(PaddedCBC::decrypt(&data, &key));
+        return data;
+    }
+
+    std::map<uint32_t, std::string> rows;
+    size_t puts = 0;
+    size_t dels = 0;
+};
+
+class StateCacheJournalTest: public ::testing::Test
+{
+protected:
+    StateCacheJournalTest():
+        key(reinterpret_cast<const byte*>("0123456789abcdef")),
+        table(rng)
+    {}
+
+    size_t flush(Journal& journal, dstime now = 0)
+    {
+        return journal.flush(table, RECORD_TYPE, key, &root, now);
+    }
+
+    PrnGen rng;
+    SymmCipher key;
+    MemoryTable table;
+
+    // the sync root, which isn't stored
+    TestRecord root{nullptr, "root"};
+};
+
+} // namespace
+
+TEST_F(StateCacheJournalTest, RepeatedChangesAreWrittenOnce)
+{
+    TestRecord file(&root, "file");
+    Journal journal;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        journal.add(&file, i);
+    }
+    EXPECT_EQ(journal.size(), 1u);
+
+    EXPECT_EQ(flush(journal), 1u);
+    EXPECT_TRUE(journal.empty());
+    EXPECT_EQ(table.puts, 1u);
+    EXPECT_EQ(table.record(file.dbid, key), "0:file");
+
+    const auto& stats = journal.stats();
+    EXPECT_EQ(stats.changes, 10u);
+    EXPECT_EQ(stats.absorbed, 9u);
+    EXPECT_EQ(stats.recordsWritten, 1u);
+    EXPECT_EQ(stats.flushes, 1u);
+}
+
+TEST_F(StateCacheJournalTest, ParentsAreWrittenFirst)
+{
+    TestRecord folder(&root, "folder");
+    TestRecord subfolder(&folder, "subfolder");
+    TestRecord file(&subfolder, "file");
+    Journal journal;
+
+    // children first
+    journal.add(&file, 0);
+    journal.add(&subfolder, 0);
+    journal.add(&folder, 0);
+
+    EXPECT_EQ(flush(journal), 3u);
+    EXPECT_TRUE(journal.empty());
+    ASSERT_TRUE(folder.dbid && subfolder.dbid && file.dbid);
+    EXPECT_EQ(table.record(folder.dbid, key), "0:folder");
+    EXPECT_EQ(table.record(subfolder.dbid, key), std::to_string(folder.dbid) + ":subfolder");
+    EXPECT_EQ(table.record(file.dbid, key), std::to_string(subfolder.dbid) + ":file");
+}
+
+TEST_F(StateCacheJournalTest, RecordsWithoutStoredParentWait)
+{
+    TestRecord folder(&root, "folder");
+    TestRecord file(&folder, "file");
+    Journal journal;
+
+    journal.add(&file, 0);
+    EXPECT_EQ(flush(journal), 0u);
+    EXPECT_EQ(journal.size(), 1u);
+    EXPECT_FALSE(file.dbid);
+
+    journal.add(&folder, 0);
+    EXPECT_EQ(flush(journal), 2u);
+    EXPECT_TRUE(journal.empty());
+}
+
+TEST_F(StateCacheJournalTest, RemovedRecords)
+{
+    TestRecord stored(&root, "stored");
+    TestRecord unstored(&root, "unstored");
+    Journal journal;
+
+    journal.add(&stored, 0);
+    flush(journal);
+    const auto dbid = stored.dbid;
+    ASSERT_TRUE(table.rows.count(dbid));
+
+    // never written: nothing to do
+    journal.add(&unstored, 0);
+    journal.remove(&unstored, 0);
+    EXPECT_TRUE(journal.empty());
+
+    // updated and then removed: only deleted
+    journal.add(&stored, 0);
+    journal.remove(&stored, 0);
+    EXPECT_FALSE(stored.dbid);
+    EXPECT_EQ(journal.size(), 1u);
+
+    EXPECT_EQ(flush(journal), 0u);
+    EXPECT_FALSE(table.rows.count(dbid));
+    EXPECT_EQ(table.puts, 1u);
+    EXPECT_EQ(table.dels, 1u);
+
+    const auto& stats = journal.stats();
+    EXPECT_EQ(stats.changes, 4u);
+    EXPECT_EQ(stats.absorbed, 2u);
+    EXPECT_EQ(stats.recordsWritten + stats.recordsDeleted + stats.absorbed, stats.changes);
+}
+
+TEST_F(StateCacheJournalTest, DueWhenIdleOldOrLarge)
+{
+    Journal journal;
+    EXPECT_FALSE(journal.due(0, true));
+
+    TestRecord file(&root, "file");
+    journal.add(&file, 100);
+    EXPECT_TRUE(journal.due(100, true));
+    EXPECT_FALSE(journal.due(100 + Journal::MAX_DELAY_DS - 1, false));
+    EXPECT_TRUE(journal.due(100 + Journal::MAX_DELAY_DS, false));
+
+    // the delay counts from the oldest pending change
+    TestRecord other(&root, "other");
+    journal.add(&other, 120);
+    EXPECT_TRUE(journal.due(100 + Journal::MAX_DELAY_DS, false));
+
+    flush(journal, 200);
+    journal.add(&file, 300);
+    EXPECT_FALSE(journal.due(301, false));
+
+    std::vector<std::unique_ptr<TestRecord>> records;
+    while (journal.size() < Journal::MAX_PENDING)
+    {
+        records.emplace_back(new TestRecord(&root, std::to_string(records.size())));
+        journal.add(records.back().get(), 301);
+    }
+    EXPECT_TRUE(journal.due(301, false));
+}
+
+TEST_F(StateCacheJournalTest, LargeFlushesAreEncryptedInParallel)
+{
+    std::vector<std::unique_ptr<TestRecord>> folders, files;
+    Journal journal;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        folders.emplace_back(new TestRecord(&root, "folder" + std::to_string(i)));
+        for (size_t j = 0; j < 50; ++j)
+        {
+            files.emplace_back(new TestRecord(folders.back().get(), "file" + std::to_string(j)));
+            journal.add(files.back().get(), 0);
+        }
+        journal.add(folders.back().get(), 0);
+    }
+    ASSERT_GE(journal.size(), Journal::PARALLEL_ENCRYPTION_MIN);
+
+    EXPECT_EQ(flush(journal), folders.size() + files.size());
+    for (auto& file: files)
+    {
+        EXPECT_EQ(table.record(file->dbid, key),
+                  std::to_string(file->parent->dbid) + ":" + file->name);
+    }
+}
+
+// Records written for a sync whose files change several times between flushes (as in a first
+// scan followed by fingerprinting and uploads, or a mass rename), and the time taken to flush
+// them, compared with writing every change.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST_F(StateCacheJournalTest, DISABLED_ReportWritesAbsorbed)
+{
+    using ms = std::chrono::duration<double, std::milli>;
+
+    constexpr size_t nodes = 200000;
+    constexpr size_t changesPerNode = 4;
+
+    std::vector<std::unique_ptr<TestRecord>> records;
+    for (size_t i = 0; i < nodes; ++i)
+    {
+        records.emplace_back(
+            new TestRecord(&root, "IMG_" + std::to_string(20000000 + i) + ".jpg"));
+    }
+
+    // every change written
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t change = 0; change < changesPerNode; ++change)
+    {
+        for (auto& record: records)
+        {
+            table.put(RECORD_TYPE, record.get(), &key);
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    const auto directPuts = table.puts;
+
+    // through the journal: each walk of the sync (one per second) changes a batch of nodes
+    // for the first time, and the ones of the previous batches again
+    constexpr size_t nodesPerWalk = 5000;
+    constexpr size_t walks = nodes / nodesPerWalk + changesPerNode - 1;
+    table.puts = 0;
+    Journal journal;
+    auto t2 = std::chrono::steady_clock::now();
+    for (size_t walk = 0; walk < walks; ++walk)
+    {
+        const auto now = static_cast<dstime>(walk * 10);
+        for (size_t change = 0; change < changesPerNode && change <= walk; ++change)
+        {
+            const auto first = (walk - change) * nodesPerWalk;
+            for (auto i = first; i < std::min(nodes, first + nodesPerWalk); ++i)
+            {
+                journal.add(records[i].get(), now);
+            }
+        }
+        if (journal.due(now, false))
+        {
+            flush(journal, now);
+        }
+    }
+    flush(journal, static_cast<dstime>(walks * 10));
+    auto t3 = std::chrono::steady_clock::now();
+
+    const auto& stats = journal.stats();
+    GTEST_LOG_(INFO) << nodes << " LocalNodes changed " << changesPerNode
+                     << " times: " << directPuts << " records written one by one in "
+                     << ms(t1 - t0).count() << " ms; with the journal " << stats.recordsWritten
+                     << " written (" << stats.absorbed << " of " << stats.changes
+                     << " changes absorbed) in " << stats.flushes << " flushes, "
+                     << ms(t3 - t2).count() << " ms";
+}
+
+#endif // ENABLE_SYNC
@@ -0,0 +1,243 @@
+/**
+ * @file StringPool_test.cpp
+ * @brief Unit tests for SharedString and StringPool
+ *
+ * (c) 2013-2025 by Mega Limited, Auckland, New Zealand
+ *
+ * This file is part of the MEGA SDK - Client Access Engine.
+ *
+ * Applications using the MEGA API must present a valid application key
+ * and comply with the rules set forth in the Terms of Service.
+ *
+ * The MEGA SDK is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * @copyright Simplified (2-clause) BSD License.
+ *
+ * You should have received a copy of the license along with this
+ * program.
+ */
+
+#include <gtest/gtest.h>
+#include <mega/stringpool.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mega;
+
+TEST(StringPool, SharedStringOwnsItsCopy)
+{
+    SharedString null;
+    EXPECT_TRUE(null.isNull());
+    EXPECT_EQ(null.c_str(), nullptr);
+    EXPECT_EQ(null.size(), 0u);
+
+    std::string source = "index.html";
+    SharedString s(source);
+    source.clear();
+    EXPECT_FALSE(s.isNull());
+    EXPECT_STREQ(s.c_str(), "index.html");
+    EXPECT_EQ(s.view(), "index.html");
+
+    // copies share the string
+    SharedString copy = s;
+    EXPECT_TRUE(copy.sharesWith(s));
+    EXPECT_EQ(copy.c_str(), s.c_str());
+
+    // equal strings that are not interned are equal, but not shared
+    SharedString other("index.html");
+    EXPECT_EQ(other, s);
+    EXPECT_FALSE(other.sharesWith(s));
+    EXPECT_NE(other, null);
+
+    SharedString moved = std::move(copy);
+    EXPECT_TRUE(copy.isNull());
+    EXPECT_STREQ(moved.c_str(), "index.html");
+
+    SharedString empty("");
+    EXPECT_FALSE(empty.isNull());
+    EXPECT_STREQ(empty.c_str(), "");
+}
+
+TEST(StringPool, InternsEqualStringsOnce)
+{
+    StringPool pool;
+
+    auto a = pool.intern("Thumbs.db");
+    auto b = pool.intern(std::string("Thumbs") + ".db");
+    auto c = pool.intern(".DS_Store");
+
+    EXPECT_TRUE(a.sharesWith(b));
+    EXPECT_FALSE(a.sharesWith(c));
+    EXPECT_STREQ(b.c_str(), "Thumbs.db");
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.strings, 2u);
+    EXPECT_EQ(stats.references, 3u);
+    EXPECT_GT(stats.bytes, 0u);
+
+    // the last handle removes the string from the pool
+    a = SharedString();
+    EXPECT_EQ(pool.stats().strings, 2u);
+    b = c;
+    stats = pool.stats();
+    EXPECT_EQ(stats.strings, 1u);
+    EXPECT_EQ(stats.references, 2u);
+
+    // and interning it again adds a new copy
+    auto d = pool.intern("Thumbs.db");
+    EXPECT_EQ(pool.stats().strings, 2u);
+    EXPECT_STREQ(d.c_str(), "Thumbs.db");
+}
+
+TEST(StringPool, HandlesOutliveThePool)
+{
+    SharedString s;
+    {
+        StringPool pool;
+        s = pool.intern("desktop.ini");
+    }
+    EXPECT_STREQ(s.c_str(), "desktop.ini");
+
+    auto copy = s;
+    s = SharedString();
+    EXPECT_STREQ(copy.c_str(), "desktop.ini");
+}
+
+TEST(StringPool, ConcurrentInternAndRelease)
+{
+    StringPool pool;
+    const std::vector<std::string> names{"index.html", "Thumbs.db", ".DS_Store", "desktop.ini"};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&pool, &names]()
+            {
+                for (size_t i = 0; i < 20000; ++i)
+                {
+                    auto s = pool.intern(names[i % names.size()]);
+                    auto copy = s;
+                    ASSERT_EQ(copy.view(), names[i % names.size()]);
+                }
+            });
+    }
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.strings, 0u);
+    EXPECT_EQ(stats.references, 0u);
+}
+
+namespace
+{
+// glibc-like heap block for an allocation of 'n' bytes
+size_t heapBlock(size_t n)
+{
+    return std::max<size_t>(32, (n + 8 + 15) & ~size_t(15));
+}
+
+// name as a std::string (the attributes of a Node): heap only beyond the inline buffer
+size_t stdStringBytes(const std::string& s)
+{
+    return sizeof(std::string) + (s.size() > 15 ? heapBlock(s.size() + 1) : 0);
+}
+
+// name as a null-terminated copy (MegaNode without interning)
+size_t cStringBytes(const std::string& s)
+{
+    return sizeof(char*) + heapBlock(s.size() + 1);
+}
+
+// names of a backup-like tree: a share of them repeat in every folder, the rest are unique
+std::vector<std::string> makeNames(size_t count, unsigned repeatedPercent)
+{
+    static const std::vector<std::string> repeated{".DS_Store",
+                                                   "Thumbs.db",
+                                                   "desktop.ini",
+                                                   "index.html",
+                                                   "README.md",
+                                                   "package.json",
+                                                   "__init__.py",
+                                                   "node_modules",
+                                                   ".gitignore",
+                                                   "AlbumArtSmall.jpg",
+                                                   "Folder.jpg",
+                                                   "LICENSE.txt",
+                                                   "CMakeLists.txt",
+                                                   "com.apple.timemachine.supported",
+                                                   "IconCache.db"};
+
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i % 100 < repeatedPercent)
+        {
+            names.emplace_back(repeated[i % repeated.size()]);
+        }
+        else
+        {
+            names.emplace_back("IMG_20190312_" + std::to_string(100000 + i) + ".jpg");
+        }
+    }
+    return names;
+}
+} // namespace
+
+// Bytes per node taken by the names, as std::string, as separate copies and interned, for a tree
+// of unique names and for backup-like trees where some names repeat.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(StringPool, DISABLED_ReportBytesPerNode)
+{
+    constexpr size_t NODES = 1000000;
+
+    for (unsigned repeatedPercent: {0u, 30u, 60u, 90u})
+    {
+        const auto names = makeNames(NODES, repeatedPercent);
+
+        size_t stdBytes = 0, cBytes = 0;
+        for (const auto& name: names)
+        {
+            stdBytes += stdStringBytes(name);
+            cBytes += cStringBytes(name);
+        }
+
+        StringPool pool;
+        std::vector<SharedString> handles;
+        handles.reserve(NODES);
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto& name: names)
+        {
+            handles.emplace_back(pool.intern(name));
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        handles.clear();
+        auto t2 = std::chrono::steady_clock::now();
+
+        // the handles are released above, so the pool is filled again to measure it
+        for (const auto& name: names)
+        {
+            handles.emplace_back(pool.intern(name));
+        }
+        const auto stats = pool.stats();
+        const size_t internedBytes = NODES * sizeof(SharedString) + stats.bytes;
+
+        using ms = std::chrono::duration<double, std::milli>;
+        GTEST_LOG_(INFO) << "Node names [" << NODES << " nodes, " << repeatedPercent
+                         << "% repeated, " << stats.strings << " distinct]: std::string ~"
+                         << stdBytes / NODES << " bytes/node; copies ~" << cBytes / NODES
+                         << " bytes/node; interned ~" << internedBytes / NODES
+                         << " bytes/node (intern " << ms(t1 - t0).count() << " ms, release "
+                         << ms(t2 - t1).count() << " ms)";
+    }
+}
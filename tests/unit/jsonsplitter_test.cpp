@@ -23,6 +23,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+
 using namespace mega;
 
 class JSONSplitterTest: public ::testing::Test
@@ -1179,4 +1181,276 @@ TEST_F(JSONSplitterTest, ProcessNestedFilterWithPauseAtOuterObjectAndLeftMoreDat
     EXPECT_EQ(2, outerCallCount); // Outer "a" called second time
     EXPECT_THAT(capturedCValues, testing::ElementsAre("d"));
 }
-*/
\ No newline at end of file
+*/
+TEST_F(JSONSplitterTest, ProcessLongStringsWithEscapesAtEveryOffset)
+{
+    // long enough to span several vector blocks, with escapes falling at every alignment
+    std::string testJson = "{\"a\":[";
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 80; ++i)
+    {
+        std::string value = std::string(i, 'x') + "\\\"" + std::string(i % 7, 'y') + "\\\\";
+        expected.emplace_back(value);
+        testJson += (i ? ",\"" : "\"") + value + "\"";
+    }
+    testJson += "]}";
+
+    std::vector<std::string> captured;
+    filters["{[a\""] = createCallbackWithVector(captured);
+
+    auto consumed = splitter.processChunk(&filters, testJson.c_str());
+
+    EXPECT_EQ(consumed, static_cast<m_off_t>(testJson.length()));
+    EXPECT_TRUE(splitter.hasFinished());
+    EXPECT_FALSE(splitter.hasFailed());
+    EXPECT_EQ(captured, expected);
+}
+
+TEST(JSONTest, SkipString)
+{
+    // the scanner must behave the same wherever the string starts
+    for (size_t offset = 0; offset < 64; ++offset)
+    {
+        for (size_t length = 0; length < 80; ++length)
+        {
+            std::string data = std::string(offset, '"') + std::string(length, 'a') + "\\\"b\"c";
+            const char* start = data.c_str() + offset;
+            const char* end = JSON::skipString(start);
+            EXPECT_EQ(end - start, static_cast<ptrdiff_t>(length + 3)) << offset << " " << length;
+
+            // incomplete strings end at the terminator, even after an escape
+            data = std::string(offset, '"') + std::string(length, 'a') + "\\";
+            start = data.c_str() + offset;
+            EXPECT_EQ(JSON::skipString(start), data.c_str() + data.size());
+        }
+    }
+
+    std::string escapedBackslash = R"(ab\\"c)";
+    EXPECT_EQ(JSON::skipString(escapedBackslash.c_str()), escapedBackslash.c_str() + 4);
+}
+
+TEST(JSONTest, StoreBinaryDecodesFromTheBuffer)
+{
+    // "h" is a 6-byte handle, "k" 16 bytes and "a" an arbitrary length value
+    JSON json(R"({"h":"AQIDBAUG","k":"AAECAwQFBgcICQoLDA0ODw","a":"SGVsbG8","x":"AQIDBAUGBwg","z":1})");
+    ASSERT_TRUE(json.enterobject());
+
+    ASSERT_EQ(json.getnameid(), makeNameid("h"));
+    EXPECT_EQ(json.getNodeHandle(), NodeHandle().set6byte(0x060504030201));
+
+    ASSERT_EQ(json.getnameid(), makeNameid("k"));
+    byte key[16];
+    ASSERT_EQ(json.storebinary(key, sizeof(key)), 16);
+    for (byte i = 0; i < sizeof(key); ++i)
+    {
+        EXPECT_EQ(key[i], i);
+    }
+
+    ASSERT_EQ(json.getnameid(), makeNameid("a"));
+    std::string value;
+    ASSERT_TRUE(json.storebinary(&value));
+    EXPECT_EQ(value, "Hello");
+
+    // too long for a node handle: the value is skipped anyway
+    ASSERT_EQ(json.getnameid(), makeNameid("x"));
+    EXPECT_EQ(json.gethandle(6), UNDEF);
+
+    ASSERT_EQ(json.getnameid(), makeNameid("z"));
+    EXPECT_EQ(json.getint(), 1);
+    EXPECT_TRUE(json.leaveobject());
+}
+
+namespace
+{
+// Synthetic `f` payload: nodes shaped like the ones received from the API
+std::string makeFetchNodesPayload(size_t numNodes)
+{
+    std::string payload = R"({"f":[)";
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        const std::string h = std::to_string(10000000 + i);
+        if (i)
+        {
+            payload += ',';
+        }
+        payload += R"({"h":")" + h + R"(","p":"AbCdEfGh","u":"uHaNdLe0123","t":)" +
+                   (i % 10 ? "0" : "1") + R"(,"a":")" + std::string(96, 'A') + R"(","k":"uHaNdLe0123:)" +
+                   std::string(43, 'K') + R"(","s":)" + std::to_string(i * 1024) +
+                   R"(,"fa":"924:1*)" + std::string(11, 'F') + R"(","ts":1700000000})";
+    }
+    payload += R"(],"sn":"AbCdEfGhIjK"})";
+    return payload;
+}
+
+// Synthetic `sc` payload: node additions and attribute updates with escaped strings
+std::string makeActionPacketsPayload(size_t numPackets)
+{
+    std::string payload = R"({"w":"https://example.com/sc","sn":"AbCdEfGhIjK","a":[)";
+    for (size_t i = 0; i < numPackets; ++i)
+    {
+        if (i)
+        {
+            payload += ',';
+        }
+        if (i % 2)
+        {
+            payload += R"({"a":"u","n":")" + std::to_string(i) + R"(","u":"uHaNdLe0123","at":")" +
+                       std::string(64, 'Z') + R"(","ts":1700000000,"i":"a\"b\\c\/d"})";
+        }
+        else
+        {
+            payload += R"({"a":"t","t":{"f":[{"h":")" + std::to_string(i) +
+                       R"(","p":"AbCdEfGh","u":"uHaNdLe0123","t":0,"a":")" + std::string(96, 'A') +
+                       R"(","k":"uHaNdLe0123:)" + std::string(43, 'K') +
+                       R"(","s":1024,"ts":1700000000}]},"ou":"uHaNdLe0123","i":"AbCdEfGhIj"})";
+        }
+    }
+    payload += "]}";
+    return payload;
+}
+
+// The string scan that JSON used before vectorization, for comparison
+const char* skipStringBytewise(const char* ptr)
+{
+    bool escaped = false;
+    while (*ptr && (escaped || *ptr != '"'))
+    {
+        escaped = *ptr == '\\' && !escaped;
+        ptr++;
+    }
+    return ptr;
+}
+
+// walk every string of the payload with the given scanner
+template<typename Scanner>
+size_t walkStrings(const std::string& payload, Scanner&& scan)
+{
+    size_t strings = 0;
+    for (const char* ptr = payload.c_str(); *ptr; ++ptr)
+    {
+        if (*ptr == '"')
+        {
+            ptr = scan(ptr + 1);
+            ++strings;
+            if (!*ptr)
+            {
+                break;
+            }
+        }
+    }
+    return strings;
+}
+
+template<typename Fn>
+double measureMBps(size_t bytes, int iters, Fn&& fn)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        fn();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(t1 - t0).count();
+    return static_cast<double>(bytes) * iters / (1024.0 * 1024.0) / seconds;
+}
+} // namespace
+
+// Parsing throughput over synthetic `f` and `sc` payloads.
+// Disabled by default, run with --gtest_also_run_disabled_tests
+TEST(JSONTest, DISABLED_PerfParsingThroughput)
+{
+    constexpr int ITERS = 10;
+    const std::pair<const char*, std::string> payloads[] = {
+        {"f", makeFetchNodesPayload(100000)},
+        {"sc", makeActionPacketsPayload(100000)}};
+
+    for (const auto& [name, payload]: payloads)
+    {
+        size_t bytewiseStrings = 0;
+        size_t vectorStrings = 0;
+        const double bytewise = measureMBps(payload.size(),
+                                            ITERS,
+                                            [&]
+                                            {
+                                                bytewiseStrings =
+                                                    walkStrings(payload, skipStringBytewise);
+                                            });
+        const double vector = measureMBps(payload.size(),
+                                          ITERS,
+                                          [&]
+                                          {
+                                              vectorStrings =
+                                                  walkStrings(payload, JSON::skipString);
+                                          });
+        EXPECT_EQ(bytewiseStrings, vectorStrings);
+
+        const double storeobject = measureMBps(payload.size(),
+                                               ITERS,
+                                               [&]
+                                               {
+                                                   JSON json(payload);
+                                                   ASSERT_TRUE(json.storeobject());
+                                               });
+
+        size_t objects = 0;
+        const double splitter = measureMBps(
+            payload.size(),
+            ITERS,
+            [&]
+            {
+                JSONSplitter jsonSplitter;
+                std::map<std::string, JSONSplitter::FilterCallback> nodeFilters;
+                auto storeObject = [&objects](JSON* json)
+                {
+                    ++objects;
+                    return JSONSplitter::ResultFromBool(json->storeobject());
+                };
+                nodeFilters["{[f{"] = storeObject;
+                nodeFilters["{[a{"] = storeObject;
+                jsonSplitter.processChunk(&nodeFilters, payload.c_str());
+                ASSERT_TRUE(jsonSplitter.hasFinished());
+            });
+
+        // the binary fields of every node, as readnode() decodes them
+        size_t decoded = 0;
+        const double binary = measureMBps(
+            payload.size(),
+            ITERS,
+            [&]
+            {
+                JSON json(payload);
+                for (const char* ptr = payload.c_str(); (ptr = strstr(ptr, "{\"h\":")); ++ptr)
+                {
+                    json.pos = ptr + 1;
+                    byte key[FILENODEKEYLENGTH];
+                    handle h = UNDEF;
+                    for (nameid field; (field = json.getnameid()) != EOO;)
+                    {
+                        switch (field)
+                        {
+                            case makeNameid("h"):
+                            case makeNameid("p"):
+                                h = json.gethandle();
+                                break;
+                            case makeNameid("u"):
+                                h = json.gethandle(sizeof(handle));
+                                break;
+                            case makeNameid("a"):
+                                json.storebinary(key, sizeof(key));
+                                break;
+                            default:
+                                json.storeobject();
+                        }
+                    }
+                    decoded += h != UNDEF;
+                }
+            });
+
+        GTEST_LOG_(INFO) << name << " payload [" << payload.size() / 1024 << " KB, "
+                         << vectorStrings << " strings, " << objects / ITERS << " objects]: "
+                         << "string scan bytewise " << bytewise << " MB/s, vectorized " << vector
+                         << " MB/s; storeobject " << storeobject << " MB/s; JSONSplitter "
+                         << splitter << " MB/s; binary fields " << binary << " MB/s ("
+                         << decoded / ITERS << " nodes)";
+    }
+}
@@ -1,3 +1,4 @@
+#include "mega/base64.h"
 #include "mega/megaapp.h"
 #include "mega/megaclient.h"
 #include "mega/testhooks.h"
@@ -99,6 +100,79 @@ TEST_F(MegaClientTest, setMaxConnectionsAndPersistRejectsZero)
     EXPECT_EQ(client->setmaxconnectionsandpersist(uint8_t{0}), API_EARGS);
 }
 
+TEST_F(MegaClientTest, applykeyWithKeyDecryptedAheadMatchesApplykey)
+{
+    byte masterKey[SymmCipher::KEYLENGTH];
+    byte folderKey[FOLDERNODEKEYLENGTH];
+    for (size_t i = 0; i < sizeof(folderKey); ++i)
+    {
+        masterKey[i] = static_cast<byte>(i);
+        folderKey[i] = static_cast<byte>(0xF0 - i);
+    }
+    client->key.setkey(masterKey);
+    client->me = 0x0102030405060708;
+
+    // the attributes and the key of a folder, as received in `f`
+    SymmCipher folderCipher(folderKey);
+    string attrs;
+    MegaClient::makeattr(&folderCipher, &attrs, "\"n\":\"folder\"");
+    const string attrstring = Base64::btoa(attrs);
+
+    byte encryptedKey[FOLDERNODEKEYLENGTH];
+    client->key.ecb_encrypt(folderKey, encryptedKey, sizeof(encryptedKey));
+    const string nodeKey = string(Base64Str<MegaClient::USERHANDLE>(client->me)) + ":" +
+                           Base64::btoa(string(reinterpret_cast<char*>(encryptedKey),
+                                               sizeof(encryptedKey)));
+
+    auto makeFolder = [&](handle h)
+    {
+        auto n = std::make_shared<Node>(*client,
+                                        NodeHandle().set6byte(h),
+                                        NodeHandle(),
+                                        FOLDERNODE,
+                                        -1,
+                                        client->me,
+                                        nullptr,
+                                        0);
+        n->attrstring.reset(new string(attrstring));
+        n->setkeyfromjson(nodeKey.c_str());
+        return n;
+    };
+
+    auto serial = makeFolder(1);
+    ASSERT_TRUE(serial->applykey());
+
+    auto parallel = makeFolder(2);
+    byte cipherKey[SymmCipher::KEYLENGTH];
+    Node::DecryptedKey decrypted;
+    const char* key = parallel->findStableKey(cipherKey, decrypted.foreign);
+    ASSERT_NE(key, nullptr);
+    EXPECT_FALSE(decrypted.foreign);
+
+    SymmCipher sc;
+    ASSERT_TRUE(Node::decryptKey(key,
+                                 cipherKey,
+                                 parallel->type,
+                                 parallel->attrstring.get(),
+                                 sc,
+                                 decrypted));
+    ASSERT_TRUE(parallel->applykey(decrypted));
+
+    EXPECT_EQ(parallel->nodekey(), serial->nodekey());
+    EXPECT_EQ(parallel->attrs.map, serial->attrs.map);
+    EXPECT_FALSE(parallel->attrstring);
+    EXPECT_STREQ(parallel->displayname(), "folder");
+
+    // legacy share keys may arrive with the nodes of `f`: left to applykey()
+    auto inShare = makeFolder(3);
+    inShare->setkeyfromjson(
+        (string(Base64Str<MegaClient::NODEHANDLE>(handle{0x0A0B0C})) + ":" +
+         Base64::btoa(string(reinterpret_cast<char*>(encryptedKey), sizeof(encryptedKey))))
+            .c_str());
+    bool foreign = false;
+    EXPECT_EQ(inShare->findStableKey(cipherKey, foreign), nullptr);
+}
+
 #ifdef MEGASDK_DEBUG_TEST_HOOKS_ENABLED
 TEST_F(MegaClientTest, chooseScParsingMode_EnableAndDisableStreaming)
 {
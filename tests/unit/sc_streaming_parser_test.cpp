@@ -265,6 +265,54 @@ TEST_F(ScStreamingParserTest, ProcessChunks)
                         "Gt-009Sr-XA");
 }
 
+TEST_F(ScStreamingParserTest, ProcessInSlices)
+{
+    std::string json =
+        R"({"a":[{"a":"ua","isn":"xyp4UX7xFZ4","st":"!?>AmY:","u":"MOte1pKQgDI","ua":["^!prd"],"v":["Dvh72Rs7JBM"]},{"a":"ua","st":"!?>VwgM","u":"k-N5-o6LLkE","ua":["^!stbmp"],"v":["Gt-009Sr-XA"]}],"w":"https://g.api.mega.co.nz/wsc/5lhYq8nqzgIEE8j9OqymmA","sn":"Gt-009Sr-XA"})";
+
+    scStreamingParser->init();
+
+    // One action packet per call to exec()
+    client->mActionPacketsSlice.maxPackets = 1;
+    client->mActionPacketsSlice.maxTime = std::chrono::milliseconds(0);
+    client->mActionPacketsSlice.begin();
+
+    size_t consumed = (size_t)scStreamingParser->process(json.c_str());
+
+    ASSERT_TRUE(consumed > 0);
+    ASSERT_TRUE(scStreamingParser->hasStarted());
+    ASSERT_FALSE(scStreamingParser->isFinished());
+    ASSERT_FALSE(scStreamingParser->isFailed());
+    ASSERT_TRUE(scStreamingParser->isPaused());
+    ASSERT_TRUE(client->mActionPacketsSlice.yielded);
+    ASSERT_TRUE(client->scnotifyurl.empty());
+
+    // The position after the first action packet is kept
+    const char* isn = "xyp4UX7xFZ4";
+    handle isnHdl;
+    Base64::atob(isn, (byte*)&isnHdl, sizeof(isnHdl));
+    ASSERT_TRUE(client->scsn.getHandle() == isnHdl);
+
+    // Purge
+    json.erase(0, consumed);
+
+    // Budget spent: nothing else is applied in the same slice
+    consumed = (size_t)scStreamingParser->process(json.c_str());
+    ASSERT_TRUE(scStreamingParser->isPaused());
+    json.erase(0, consumed);
+
+    // Next slice
+    client->mActionPacketsSlice.begin();
+    ASSERT_FALSE(client->mActionPacketsSlice.yielded);
+
+    testFinishedProcess(scStreamingParser,
+                        *client.get(),
+                        json,
+                        "https://g.api.mega.co.nz/wsc/5lhYq8nqzgIEE8j9OqymmA",
+                        "Gt-009Sr-XA");
+    ASSERT_FALSE(client->mActionPacketsSlice.yielded);
+}
+
 TEST_F(ScStreamingParserTest, ProcessChunksByMove)
 {
     initNodes();